@@ -0,0 +1,209 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_ARG_CODEC_H_
+#define QXCORE_LOG_ARG_CODEC_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <absl/status/status.h>
+#include <absl/strings/string_view.h>
+#include "qxcore/log/fmt.h"
+
+namespace qxcore {
+namespace log {
+
+// 延迟格式化参数的类型标签
+//
+// 编码格式：[1 字节标签][定长值]，字符串为 [标签][4 字节长度][字节]。
+// 值按主机字节序原样拷贝，只在同一进程内解码。
+enum class ArgType : uint8_t {
+  kBool = 1,
+  kChar = 2,
+  kInt32 = 3,
+  kUInt32 = 4,
+  kInt64 = 5,
+  kUInt64 = 6,
+  kFloat = 7,
+  kDouble = 8,
+  kPointer = 9,
+  kString = 10,
+};
+
+// 延迟格式化的参数存储
+using FormatArgStore = fmt::dynamic_format_arg_store<fmt::format_context>;
+
+namespace internal {
+
+template<typename T>
+using DecayArg = std::decay_t<T>;
+
+template<typename T>
+constexpr bool kIsStringArg =
+    std::is_same_v<DecayArg<T>, const char*> ||
+    std::is_same_v<DecayArg<T>, char*> ||
+    std::is_same_v<DecayArg<T>, std::string> ||
+    std::is_same_v<DecayArg<T>, std::string_view> ||
+    std::is_same_v<DecayArg<T>, absl::string_view> ||
+    std::is_same_v<DecayArg<T>, fmt::string_view>;
+
+template<typename T>
+constexpr bool kIsPointerArg =
+    std::is_same_v<DecayArg<T>, void*> ||
+    std::is_same_v<DecayArg<T>, const void*>;
+
+// 参数对应的原生标签；无法原样拷贝的类型返回 kString（生产者侧预格式化）
+template<typename T>
+constexpr ArgType NativeArgType() {
+  using U = DecayArg<T>;
+  if constexpr (std::is_same_v<U, bool>) {
+    return ArgType::kBool;
+  } else if constexpr (std::is_same_v<U, char>) {
+    return ArgType::kChar;
+  } else if constexpr (std::is_integral_v<U> && std::is_signed_v<U>) {
+    return sizeof(U) <= 4 ? ArgType::kInt32 : ArgType::kInt64;
+  } else if constexpr (std::is_integral_v<U>) {
+    return sizeof(U) <= 4 ? ArgType::kUInt32 : ArgType::kUInt64;
+  } else if constexpr (std::is_same_v<U, float>) {
+    return ArgType::kFloat;
+  } else if constexpr (std::is_same_v<U, double>) {
+    return ArgType::kDouble;
+  } else if constexpr (kIsPointerArg<T>) {
+    return ArgType::kPointer;
+  } else {
+    return ArgType::kString;
+  }
+}
+
+template<typename T>
+absl::string_view StringArgView(const T& value) {
+  using U = DecayArg<T>;
+  if constexpr (std::is_array_v<T>) {
+    return absl::string_view(value);
+  } else if constexpr (std::is_same_v<U, const char*> ||
+                       std::is_same_v<U, char*>) {
+    return value == nullptr ? absl::string_view("(null)")
+                            : absl::string_view(value);
+  } else {
+    return absl::string_view(value.data(), value.size());
+  }
+}
+
+template<typename V>
+inline char* PutValue(char* dst, ArgType type, V value) {
+  *dst++ = static_cast<char>(type);
+  std::memcpy(dst, &value, sizeof(V));
+  return dst + sizeof(V);
+}
+
+inline char* PutString(char* dst, absl::string_view value) {
+  *dst++ = static_cast<char>(ArgType::kString);
+  uint32_t size = static_cast<uint32_t>(value.size());
+  std::memcpy(dst, &size, sizeof(size));
+  dst += sizeof(size);
+  std::memcpy(dst, value.data(), value.size());
+  return dst + value.size();
+}
+
+}  // namespace internal
+
+// 单个参数编码后的字节数
+template<typename T>
+size_t EncodedArgSize(const T& value) {
+  constexpr ArgType type = internal::NativeArgType<T>();
+  (void)value;
+  if constexpr (type == ArgType::kBool || type == ArgType::kChar) {
+    return 2;
+  } else if constexpr (type == ArgType::kInt32 || type == ArgType::kUInt32 ||
+                       type == ArgType::kFloat) {
+    return 5;
+  } else if constexpr (type == ArgType::kInt64 || type == ArgType::kUInt64 ||
+                       type == ArgType::kDouble || type == ArgType::kPointer) {
+    return 9;
+  } else if constexpr (internal::kIsStringArg<T>) {
+    return 5 + internal::StringArgView(value).size();
+  } else {
+    return 5 + fmt::formatted_size("{}", value);
+  }
+}
+
+// 全部参数编码后的字节数
+template<typename... Args>
+size_t EncodedArgsSize(const Args&... args) {
+  return (size_t{0} + ... + EncodedArgSize(args));
+}
+
+// 编码单个参数，返回写入后的位置；dst 必须至少有 EncodedArgSize 字节
+template<typename T>
+char* EncodeArg(char* dst, const T& value) {
+  using U = internal::DecayArg<T>;
+  constexpr ArgType type = internal::NativeArgType<T>();
+  if constexpr (type == ArgType::kBool) {
+    return internal::PutValue<uint8_t>(dst, type, value ? 1 : 0);
+  } else if constexpr (type == ArgType::kChar) {
+    return internal::PutValue<char>(dst, type, value);
+  } else if constexpr (type == ArgType::kInt32) {
+    return internal::PutValue<int32_t>(dst, type, static_cast<int32_t>(value));
+  } else if constexpr (type == ArgType::kUInt32) {
+    return internal::PutValue<uint32_t>(dst, type,
+                                        static_cast<uint32_t>(value));
+  } else if constexpr (type == ArgType::kInt64) {
+    return internal::PutValue<int64_t>(dst, type, static_cast<int64_t>(value));
+  } else if constexpr (type == ArgType::kUInt64) {
+    return internal::PutValue<uint64_t>(dst, type,
+                                        static_cast<uint64_t>(value));
+  } else if constexpr (type == ArgType::kFloat) {
+    return internal::PutValue<float>(dst, type, value);
+  } else if constexpr (type == ArgType::kDouble) {
+    return internal::PutValue<double>(dst, type, value);
+  } else if constexpr (type == ArgType::kPointer) {
+    return internal::PutValue<uint64_t>(
+        dst, type, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value)));
+  } else if constexpr (internal::kIsStringArg<T>) {
+    return internal::PutString(dst, internal::StringArgView(value));
+  } else {
+    static_assert(!std::is_pointer_v<U>,
+                  "only char and void pointers can be logged");
+    uint32_t size = static_cast<uint32_t>(fmt::formatted_size("{}", value));
+    *dst++ = static_cast<char>(ArgType::kString);
+    std::memcpy(dst, &size, sizeof(size));
+    dst += sizeof(size);
+    return fmt::format_to(dst, "{}", value);
+  }
+}
+
+// 编码全部参数，返回写入后的位置
+template<typename... Args>
+char* EncodeArgs(char* dst, const Args&... args) {
+  ((dst = EncodeArg(dst, args)), ...);
+  return dst;
+}
+
+// 解码 count 个参数并追加到 store，字符串以视图形式引用 data 中的字节，
+// 因此 data 在格式化完成前必须保持有效
+absl::Status DecodeArgs(const char* data, size_t size, size_t count,
+                        FormatArgStore& store);
+
+// 按 fmt 格式串和编码参数格式化到 out
+absl::Status FormatEncoded(absl::string_view fmt_str, const char* data,
+                           size_t size, size_t count, FormatArgStore& store,
+                           fmt::memory_buffer& out);
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_ARG_CODEC_H_
@@ -0,0 +1,165 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_ASYNC_WRITER_H_
+#define QXCORE_LOG_ASYNC_WRITER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <absl/status/status.h>
+#include <absl/strings/string_view.h>
+#include <spdlog/common.h>
+#include "qxcore/log/bounded_queue.h"
+#include "qxcore/log/callsite.h"
+#include "qxcore/log/logger_registry.h"
+#include "qxcore/log/log_level.h"
+#include "qxcore/log/log_options.h"
+#include "qxcore/log/tsc_clock.h"
+
+namespace qxcore {
+namespace log {
+
+class GroupCommitSink;
+
+// 异步写出统计
+struct AsyncStats {
+  uint64_t enqueued = 0;        // 成功入队的记录数
+  uint64_t dropped_newest = 0;  // kDropNewest 策略下丢弃的记录数
+  uint64_t dropped_oldest = 0;  // kDropOldest 策略下丢弃的记录数
+  uint64_t written = 0;         // 写线程已写出的记录数
+
+  uint64_t dropped() const { return dropped_newest + dropped_oldest; }
+
+  // 已入队但尚未写出的记录数（积压）
+  uint64_t pending() const {
+    uint64_t done = written + dropped_oldest;
+    return enqueued > done ? enqueued - done : 0;
+  }
+};
+
+// 队列中的一条已格式化记录
+//
+// 消息之后紧跟调用线程的日志上下文（见 log_context.h）。inline_data 指向
+// 构造时预分配的固定槽位，两者合计超出 inline_capacity 时使用 spill 保存，
+// 稳态下常规长度的消息不产生堆分配。
+struct AsyncRecord {
+  RecordTime time;                     // 写线程换算为墙上时间
+  size_t thread_id = 0;
+  LogLevel level = LogLevel::kInfo;
+  const Callsite* callsite = nullptr;  // 静态调用点，提供源码位置
+  LoggerId logger_id = kNoLoggerId;    // 命名日志器，决定记录的名字
+  uint32_t size = 0;
+  uint32_t context_size = 0;
+  uint32_t inline_capacity = 0;
+  char* inline_data = nullptr;
+  std::string spill;
+
+  bool is_inline() const { return size + context_size <= inline_capacity; }
+
+  absl::string_view payload() const {
+    return absl::string_view(is_inline() ? inline_data : spill.data(), size);
+  }
+
+  absl::string_view context() const {
+    return absl::string_view(
+        (is_inline() ? inline_data : spill.data()) + size, context_size);
+  }
+};
+
+// 异步写线程：从有界队列取出记录并写入 spdlog sinks
+class AsyncWriter {
+ public:
+  AsyncWriter(std::string logger_name, std::vector<spdlog::sink_ptr> sinks,
+              const AsyncOptions& options);
+  ~AsyncWriter();
+
+  AsyncWriter(const AsyncWriter&) = delete;
+  AsyncWriter& operator=(const AsyncWriter&) = delete;
+
+  // 校验配置
+  static absl::Status ValidateOptions(const AsyncOptions& options);
+
+  // 启动写线程
+  absl::Status start();
+
+  // 写出队列中剩余记录并停止写线程
+  void stop();
+
+  // 入队一条已格式化的消息，附带调用线程的日志上下文，按溢出策略处理
+  // 队列满的情况；返回 false 表示该消息被丢弃
+  bool enqueue(LogLevel level, absl::string_view payload,
+               const Callsite* callsite = nullptr,
+               LoggerId logger_id = kNoLoggerId,
+               RecordTime time = RecordTime::Now());
+
+  // 阻塞直到调用前入队的记录全部写出，然后刷新 sinks
+  void flush();
+
+  // 获取统计信息
+  AsyncStats stats() const;
+
+  // 队列中待写出记录数（近似值）
+  size_t pending() const { return queue_.size_approx(); }
+
+ private:
+  // 写线程主循环
+  void run();
+
+  // 取出并写出一条记录，队列为空时返回 false
+  bool write_one();
+
+  // 写出一条记录到所有 sinks
+  void write_record(const AsyncRecord& record);
+
+  // 处理挂起的 flush 请求
+  void handle_flush_requests();
+
+  // 唤醒处于休眠状态的写线程
+  void wake_writer();
+
+  std::string logger_name_;
+  std::vector<spdlog::sink_ptr> sinks_;
+  // 支持批量提交的 sinks，连续写出时按批累积
+  std::vector<GroupCommitSink*> batch_sinks_;
+  AsyncOptions options_;
+
+  BoundedQueue<AsyncRecord> queue_;
+  std::unique_ptr<char[]> arena_;
+
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+  std::atomic<bool> stopping_{false};
+  std::atomic<bool> sleeping_{false};
+
+  std::mutex mutex_;
+  std::condition_variable wake_cv_;
+  std::condition_variable flush_cv_;
+  size_t flush_target_ = 0;
+  size_t flushed_position_ = 0;
+
+  std::atomic<uint64_t> dropped_newest_{0};
+  std::atomic<uint64_t> dropped_oldest_{0};
+  std::atomic<uint64_t> written_{0};
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_ASYNC_WRITER_H_
@@ -0,0 +1,216 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_BINARY_LOG_H_
+#define QXCORE_LOG_BINARY_LOG_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <absl/container/flat_hash_map.h>
+#include <absl/status/status.h>
+#include <absl/strings/string_view.h>
+#include "qxcore/log/arg_codec.h"
+#include "qxcore/log/log_level.h"
+
+namespace qxcore {
+namespace log {
+
+// 二进制日志文件格式
+//
+// 文件由若干块组成，每块为 16 字节块头加负载：
+//   [uint32 magic][uint32 负载字节数][uint32 记录数][uint32 负载 CRC32C]
+// 负载由连续记录组成，每条记录以 1 字节类型开头：
+//   kFormatDef  varint ID, varint 长度, 格式串
+//   kLoggerDef  varint ID, varint 长度, 日志器名称
+//   kEvent      zigzag varint 时间差(ns), 级别, varint 日志器 ID,
+//               varint 格式串 ID, varint 线程 ID, varint 参数个数, 参数
+// 参数沿用 ArgType 标签：整数为 (zigzag) varint，浮点数原样存放，
+// 字符串为 varint 长度加字节。时间差以块为单位重新计算，首条事件相对 0。
+// 字典记录总是出现在首次引用它的事件之前，块头均按小端序写入。
+namespace binary_format {
+
+constexpr uint32_t kBlockMagic = 0x424c5851;  // "QXLB"
+constexpr size_t kBlockHeaderSize = 16;
+
+enum class RecordType : uint8_t {
+  kFormatDef = 1,
+  kLoggerDef = 2,
+  kEvent = 3,
+};
+
+}  // namespace binary_format
+
+// 一条未格式化的日志记录：格式串 ID 与 arg_codec 编码的参数
+struct RawLogRecord {
+  int64_t time_ns = 0;
+  LogLevel level = LogLevel::kInfo;
+  size_t thread_id = 0;
+  absl::string_view logger_name;
+  uint32_t format_id = 0;
+  absl::string_view format;
+  const char* args = nullptr;
+  size_t args_size = 0;
+  size_t arg_count = 0;
+};
+
+namespace internal {
+
+inline void PutVarint(std::string& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+inline uint64_t ZigZagEncode(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t ZigZagDecode(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// 读取 varint，数据不完整或超过 10 字节时返回 false
+inline bool GetVarint(const char*& cursor, const char* end, uint64_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 64 && cursor < end; shift += 7) {
+    uint8_t byte = static_cast<uint8_t>(*cursor++);
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace internal
+
+// 二进制日志写入器，按块缓冲并在块满或 flush 时写出
+//
+// 非线程安全，调用方负责串行化。
+class BinaryLogWriter {
+ public:
+  // block_size 为单块负载的目标字节数
+  explicit BinaryLogWriter(size_t block_size = 64 * 1024);
+  ~BinaryLogWriter();
+
+  BinaryLogWriter(const BinaryLogWriter&) = delete;
+  BinaryLogWriter& operator=(const BinaryLogWriter&) = delete;
+
+  // 打开输出文件，truncate 为 false 时追加到已有文件末尾
+  absl::Status open(const std::string& path, bool truncate = true);
+
+  // 写入一条未格式化记录
+  absl::Status append(const RawLogRecord& record);
+
+  // 以 "{}" 格式串写入一条已格式化的消息
+  absl::Status append_text(int64_t time_ns, LogLevel level, size_t thread_id,
+                           absl::string_view logger_name,
+                           absl::string_view message);
+
+  // 封闭当前块并刷新到操作系统
+  absl::Status flush();
+
+  // 写出剩余数据并关闭文件
+  absl::Status close();
+
+  bool is_open() const { return file_ != nullptr; }
+
+  // 已写出的字节数（含块头）
+  uint64_t bytes_written() const { return bytes_written_; }
+
+ private:
+  // 把当前块写入文件
+  absl::Status seal_block();
+
+  // 日志器 ID，首次出现时写入定义记录
+  uint32_t logger_id(absl::string_view name);
+
+  // 转写 arg_codec 编码的参数为紧凑格式
+  bool transcode_args(const char* data, size_t size, size_t count);
+
+  size_t block_size_;
+  std::FILE* file_ = nullptr;
+  std::string block_;
+  uint32_t block_records_ = 0;
+  int64_t last_time_ns_ = 0;
+  uint64_t bytes_written_ = 0;
+
+  std::vector<bool> defined_formats_;
+  absl::flat_hash_map<std::string, uint32_t> logger_ids_;
+  uint32_t text_format_id_ = 0;
+};
+
+// 解码后的一条日志
+struct BinaryLogEntry {
+  int64_t time_ns = 0;
+  LogLevel level = LogLevel::kInfo;
+  size_t thread_id = 0;
+  std::string logger_name;
+  std::string format;
+  std::string message;
+};
+
+// 二进制日志读取器
+class BinaryLogReader {
+ public:
+  BinaryLogReader() = default;
+  ~BinaryLogReader();
+
+  BinaryLogReader(const BinaryLogReader&) = delete;
+  BinaryLogReader& operator=(const BinaryLogReader&) = delete;
+
+  absl::Status open(const std::string& path);
+  void close();
+
+  // 读取下一条日志
+  //
+  // 正常读到文件末尾返回 OutOfRange；块头或负载不完整（如崩溃导致的
+  // 尾部截断）、CRC 校验失败或记录损坏时返回 DataLoss。
+  absl::Status next(BinaryLogEntry* entry);
+
+  // 已成功校验的块数
+  uint64_t blocks_read() const { return blocks_read_; }
+
+ private:
+  // 读取并校验下一个块
+  absl::Status read_block();
+
+  // 解析当前块中的下一条记录，遇到事件时填充 entry 并返回 true
+  absl::Status parse_record(BinaryLogEntry* entry, bool* is_event);
+
+  // 把紧凑格式的参数解码到 store
+  absl::Status decode_args(size_t count);
+
+  std::FILE* file_ = nullptr;
+  uint64_t file_offset_ = 0;
+  uint64_t blocks_read_ = 0;
+  std::string block_;
+  const char* cursor_ = nullptr;
+  const char* end_ = nullptr;
+  int64_t last_time_ns_ = 0;
+
+  std::vector<std::string> formats_;
+  std::vector<std::string> loggers_;
+  FormatArgStore store_;
+  fmt::memory_buffer buffer_;
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_BINARY_LOG_H_
@@ -0,0 +1,65 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_BINARY_SINK_H_
+#define QXCORE_LOG_BINARY_SINK_H_
+
+#include <mutex>
+#include <string>
+#include <absl/status/status.h>
+#include <spdlog/sinks/base_sink.h>
+#include "qxcore/log/binary_log.h"
+
+namespace qxcore {
+namespace log {
+
+// 可以直接接收未格式化记录的 sink
+//
+// 延迟格式化模式下写线程对这类 sink 跳过格式化，直接传递格式串 ID
+// 与编码参数。
+class RawRecordSink {
+ public:
+  virtual ~RawRecordSink() = default;
+  virtual void log_raw(const RawLogRecord& record) = 0;
+};
+
+// 以二进制格式写文件的 spdlog sink
+//
+// 普通 spdlog 记录以 "{}" 格式串加一个字符串参数保存，延迟格式化
+// 模式下通过 log_raw 保存原始参数。
+class BinaryFileSink : public spdlog::sinks::base_sink<std::mutex>,
+                       public RawRecordSink {
+ public:
+  explicit BinaryFileSink(size_t block_size = 64 * 1024);
+
+  // 打开输出文件
+  absl::Status open(const std::string& path, bool truncate = true);
+
+  void log_raw(const RawLogRecord& record) override;
+
+  // 已写出的字节数
+  uint64_t bytes_written();
+
+ protected:
+  void sink_it_(const spdlog::details::log_msg& msg) override;
+  void flush_() override;
+
+ private:
+  BinaryLogWriter writer_;
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_BINARY_SINK_H_
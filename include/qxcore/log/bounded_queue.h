@@ -0,0 +1,147 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_BOUNDED_QUEUE_H_
+#define QXCORE_LOG_BOUNDED_QUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace qxcore {
+namespace log {
+
+// 有界多生产者多消费者队列（Vyukov 算法）
+//
+// 槽位在构造时一次性分配并原地复用：生产者通过 fill 回调写入槽位，
+// 消费者通过 consume 回调读取槽位，稳态下不产生任何内存分配。
+template<typename T>
+class BoundedQueue {
+ public:
+  // capacity 会向上取整为 2 的幂，最小为 2
+  explicit BoundedQueue(size_t capacity)
+      : capacity_(RoundUpPowerOfTwo(capacity)),
+        mask_(capacity_ - 1),
+        cells_(new Cell[capacity_]) {
+    for (size_t i = 0; i < capacity_; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  // 尝试入队，队列满时返回 false；fill 的签名为 void(T&)
+  template<typename Fill>
+  bool try_push(Fill&& fill) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    std::forward<Fill>(fill)(cell->value);
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  // 尝试出队，队列空时返回 false；consume 的签名为 void(T&)
+  template<typename Consume>
+  bool try_pop(Consume&& consume) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff =
+          static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (diff == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    std::forward<Consume>(consume)(cell->value);
+    cell->sequence.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  // 直接访问槽位，仅用于构造后、并发使用前的初始化
+  T& slot(size_t index) { return cells_[index].value; }
+
+  size_t capacity() const { return capacity_; }
+
+  // 已被生产者占用的位置总数（单调递增）
+  size_t enqueue_position() const {
+    return enqueue_pos_.load(std::memory_order_acquire);
+  }
+
+  // 已被消费者占用的位置总数（单调递增）
+  size_t dequeue_position() const {
+    return dequeue_pos_.load(std::memory_order_acquire);
+  }
+
+  // 近似元素个数，仅用于统计
+  size_t size_approx() const {
+    size_t enq = enqueue_position();
+    size_t deq = dequeue_position();
+    return enq > deq ? enq - deq : 0;
+  }
+
+ private:
+  static constexpr size_t kCacheLineSize = 64;
+
+  struct alignas(kCacheLineSize) Cell {
+    std::atomic<size_t> sequence{0};
+    T value;
+  };
+
+  static size_t RoundUpPowerOfTwo(size_t value) {
+    size_t result = 2;
+    while (result < value) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  const size_t capacity_;
+  const size_t mask_;
+  std::unique_ptr<Cell[]> cells_;
+
+  alignas(kCacheLineSize) std::atomic<size_t> enqueue_pos_{0};
+  alignas(kCacheLineSize) std::atomic<size_t> dequeue_pos_{0};
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_BOUNDED_QUEUE_H_
@@ -0,0 +1,223 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef QXCORE_LOG_CALLSITE_H_
+#define QXCORE_LOG_CALLSITE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/string_view.h>
+#include "qxcore/log/log_level.h"
+
+namespace qxcore {
+namespace log {
+
+// 单个调用点的运行期开关
+enum class CallsiteOverride : uint8_t {
+  kNone = 0,      // 跟随日志器级别
+  kForceOn = 1,   // 忽略日志器级别始终记录
+  kForceOff = 2,  // 始终跳过
+};
+
+namespace internal {
+
+// 日志器是否声明 kRegistryLevel，即级别由 LoggerRegistry 按 ID 决定
+// （如 NamedLogger），不参与 CallsiteRegistry 的级别汇总
+template<typename Logger, typename = void>
+constexpr bool kUsesRegistryLevel = false;
+
+template<typename Logger>
+constexpr bool kUsesRegistryLevel<
+    Logger, std::void_t<decltype(Logger::kRegistryLevel)>> =
+    Logger::kRegistryLevel;
+
+}  // namespace internal
+
+// 日志调用点描述符
+//
+// 每个 QXLOG_* 宏展开处有一个常量初始化的静态实例，不需要动态初始化守卫；
+// 首次执行时向 CallsiteRegistry 注册。state_ 只在注册、级别变化和单独开关时
+// 写入，热路径只读，与其余只读字段共享缓存行不会产生伪共享。
+//
+// kDisabled 只表示低于全部 Log 日志器的级别；命名日志器的级别不汇总到
+// 注册表，这类调用点只跳过 kForcedOff，其余情况按日志器 ID 检查级别。
+class Callsite {
+ public:
+  enum State : uint8_t {
+    kForcedOff = 0,     // 单独关闭
+    kDisabled = 1,      // 低于全部 Log 日志器的级别
+    kLevelEnabled = 2,  // 可能启用，需要再检查日志器自身级别
+    kForced = 3,        // 单独打开，忽略日志器级别
+    kUnregistered = 4,  // 尚未注册
+  };
+
+  constexpr Callsite(const char* file, int line, const char* function,
+                     const char* format, LogLevel level)
+      : level_(level),
+        line_(line),
+        file_(file),
+        function_(function),
+        format_(format) {}
+
+  Callsite(const Callsite&) = delete;
+  Callsite& operator=(const Callsite&) = delete;
+
+  // 热路径：一次 relaxed 读取，返回 false 时可以直接跳过
+  bool maybe_enabled() const {
+    return state_.load(std::memory_order_relaxed) > kDisabled;
+  }
+
+  // 按日志器类型判断，供 QXLOG_* 宏在求值日志器表达式之前使用
+  template<typename Logger>
+  bool maybe_enabled() const {
+    if constexpr (internal::kUsesRegistryLevel<Logger>) {
+      return state_.load(std::memory_order_relaxed) != kForcedOff;
+    } else {
+      return maybe_enabled();
+    }
+  }
+
+  // maybe_enabled 为真之后判断 logger 是否应记录该调用点
+  template<typename Logger>
+  bool should_log(const Logger& logger) {
+    uint8_t state = state_.load(std::memory_order_relaxed);
+    if (state == kUnregistered) {
+      state = Register();
+    }
+    if constexpr (internal::kUsesRegistryLevel<Logger>) {
+      return state == kForced ||
+             (state != kForcedOff && logger.is_enabled(level_));
+    } else {
+      return state == kForced ||
+             (state == kLevelEnabled && logger.is_enabled(level_));
+    }
+  }
+
+  LogLevel level() const { return level_; }
+  int line() const { return line_; }
+  const char* file() const { return file_; }
+  const char* function() const { return function_; }
+  // 格式串原文，QXLOG_<LEVEL>_FN 调用点为 nullptr
+  const char* format() const { return format_; }
+  State state() const {
+    return static_cast<State>(state_.load(std::memory_order_relaxed));
+  }
+  CallsiteOverride override_value() const { return override_; }
+
+ private:
+  friend class CallsiteRegistry;
+
+  uint8_t Register();
+
+  std::atomic<uint8_t> state_{kUnregistered};
+  CallsiteOverride override_ = CallsiteOverride::kNone;  // 由注册表互斥锁保护
+  LogLevel level_;
+  int line_;
+  const char* file_;
+  const char* function_;
+  const char* format_;
+};
+
+// 调用点注册表
+//
+// 记录每个存活日志器的级别，调用点按其中最详细的级别计算开关；日志器
+// 级别变化时批量刷新全部调用点。一个调用点被多个级别不同的日志器使用时，
+// kLevelEnabled 状态下仍由日志器自身的级别做最终判断。
+class CallsiteRegistry {
+ public:
+  // 进程级全局实例
+  static CallsiteRegistry& Global();
+
+  // 设置（或新增）日志器的级别，owner 为日志器地址
+  void set_logger_level(const void* owner, LogLevel level);
+
+  // 移除日志器
+  void remove_logger(const void* owner);
+
+  // 单独打开或关闭调用点
+  //
+  // file 按路径后缀匹配，line 为 0 时匹配该文件中的全部调用点。规则保存在
+  // 注册表中，之后首次执行的调用点注册时同样生效；同一 file/line 的规则
+  // 互相替换，kNone 删除该规则，多条规则匹配时以最后设置的为准。返回当前
+  // 已注册调用点中匹配的数量。
+  size_t set_override(absl::string_view file, int line,
+                      CallsiteOverride value);
+
+  // 为匹配的调用点单独设置级别：调用点级别不低于 level 的单独打开，其余
+  // 单独关闭，与日志器级别无关；规则的保存、匹配和返回值同 set_override
+  size_t set_level_override(absl::string_view file, int line, LogLevel level);
+
+  // 清除全部单独开关
+  void clear_overrides();
+
+  // 遍历已注册的调用点
+  void for_each(const std::function<void(const Callsite&)>& fn) const;
+
+  // 已注册的调用点数量
+  size_t size() const;
+
+ private:
+  friend class Callsite;
+
+  // 注册调用点并返回其状态，重复注册时直接返回当前状态
+  uint8_t register_callsite(Callsite* callsite);
+
+  // 单独开关规则
+  struct OverrideRule {
+    std::string file;
+    int line;
+    bool has_level;  // 为 true 时按 level 决定开关，否则使用 value
+    LogLevel level;
+    CallsiteOverride value;
+  };
+
+  // 替换 file/line 上的规则（rule 为 nullptr 时删除）并刷新匹配的调用点
+  size_t update_rule(absl::string_view file, int line,
+                     const OverrideRule* rule);
+
+  // 按规则计算调用点的单独开关，调用方持有 mutex_
+  CallsiteOverride resolve_override(const Callsite& callsite) const;
+
+  // 按当前级别和单独开关计算调用点状态，调用方持有 mutex_
+  uint8_t compute_state(const Callsite& callsite) const;
+
+  // 重新计算最详细级别，变化时刷新全部调用点，调用方持有 mutex_
+  void refresh_locked();
+
+  // 没有日志器时的级别取值，高于任何 LogLevel
+  static constexpr int kNoLoggers = 6;
+
+  mutable std::mutex mutex_;
+  std::vector<Callsite*> callsites_;
+  std::vector<OverrideRule> rules_;
+  absl::flat_hash_map<const void*, LogLevel> loggers_;
+  int min_level_ = kNoLoggers;
+};
+
+inline uint8_t Callsite::Register() {
+  return CallsiteRegistry::Global().register_callsite(this);
+}
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_CALLSITE_H_
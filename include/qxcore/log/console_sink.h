@@ -0,0 +1,157 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef QXCORE_LOG_CONSOLE_SINK_H_
+#define QXCORE_LOG_CONSOLE_SINK_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <absl/strings/string_view.h>
+#include <spdlog/common.h>
+#include <spdlog/formatter.h>
+#include <spdlog/sinks/sink.h>
+
+namespace qxcore {
+namespace log {
+
+namespace internal {
+
+// 按 color_mode 判断 target 是否输出颜色码
+bool ShouldColorConsole(FILE* target, spdlog::color_mode mode);
+
+// 级别对应的 ANSI 颜色码
+absl::string_view ConsoleLevelColor(spdlog::level::level_enum level);
+
+// 颜色复位码
+absl::string_view ConsoleResetColor();
+
+}  // namespace internal
+
+// 复用格式化缓冲区的彩色控制台 sink
+//
+// 行为与 spdlog 的 stdout_color_sink_mt 一致：与其他控制台 sink 共用全局
+// 控制台锁，终端支持时为 %^...%$ 范围着色。颜色码为静态常量，格式化
+// 缓冲区在锁内复用，不超过预留长度的记录写出时不分配内存。
+class ConsoleSink : public spdlog::sinks::sink {
+ public:
+  // target 为 stdout 或 stderr，buffer_size 为预留的格式化缓冲区字节数
+  explicit ConsoleSink(FILE* target = stdout, size_t buffer_size = 8192,
+                       spdlog::color_mode mode = spdlog::color_mode::automatic);
+
+  ConsoleSink(const ConsoleSink&) = delete;
+  ConsoleSink& operator=(const ConsoleSink&) = delete;
+
+  void log(const spdlog::details::log_msg& msg) override;
+  void flush() override;
+  void set_pattern(const std::string& pattern) override;
+  void set_formatter(std::unique_ptr<spdlog::formatter> formatter) override;
+
+  // 是否输出颜色码
+  bool should_color() const { return should_color_; }
+
+ private:
+  void write_range(size_t begin, size_t end);
+
+  FILE* target_;
+  std::mutex& mutex_;
+  bool should_color_ = false;
+  std::unique_ptr<spdlog::formatter> formatter_;
+  spdlog::memory_buf_t buffer_;
+};
+
+// 非阻塞彩色控制台 sink
+//
+// 日志调用在本 sink 的锁内格式化，把带颜色码的文本追加到待写缓冲区后立即
+// 返回；独立的写线程换出缓冲区，在锁外写入 target。stdout 阻塞（如管道另一端
+// 读取缓慢）时只会填满缓冲区，放不下的记录被丢弃并计入 dropped()。两块缓冲区
+// 在构造时按 buffer_size 预留，稳态下不分配内存。
+//
+// 写线程绕过 stdio 直接写 target 的文件描述符，不持有 spdlog 的全局控制台锁，
+// target 阻塞不会拖住其他控制台 sink。文件状态标志与其他写者共享，因此不设置
+// O_NONBLOCK，而是 poll 等到可写后每次最多写 PIPE_BUF 字节、尽量在换行处截断；
+// 管道上这样的写入既不阻塞也不与其他写者交错。析构时最多再用 kFlushTimeout
+// 写出剩余文本，之后的文本丢弃并按行计入 dropped()。
+class NonBlockingConsoleSink : public spdlog::sinks::sink {
+ public:
+  // target 为 stdout 或 stderr，buffer_size 为待写缓冲区字节数，
+  // format_buffer_size 为预留的格式化缓冲区字节数
+  explicit NonBlockingConsoleSink(
+      FILE* target = stdout, size_t buffer_size = 1 << 20,
+      size_t format_buffer_size = 8192,
+      spdlog::color_mode mode = spdlog::color_mode::automatic);
+  ~NonBlockingConsoleSink() override;
+
+  NonBlockingConsoleSink(const NonBlockingConsoleSink&) = delete;
+  NonBlockingConsoleSink& operator=(const NonBlockingConsoleSink&) = delete;
+
+  void log(const spdlog::details::log_msg& msg) override;
+
+  // 等待已接收的文本写出，target 阻塞时最多等待 kFlushTimeout
+  void flush() override;
+
+  void set_pattern(const std::string& pattern) override;
+  void set_formatter(std::unique_ptr<spdlog::formatter> formatter) override;
+
+  // 是否输出颜色码
+  bool should_color() const { return should_color_; }
+
+  // 缓冲区已满、写入出错或析构时未能写出而被丢弃的记录数
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  static constexpr std::chrono::milliseconds kFlushTimeout{1000};
+
+ private:
+  // 写线程主循环
+  void run();
+
+  // 写出 output_，写入出错或析构期限已过时丢弃剩余文本
+  void write_output();
+
+  void append_range(size_t begin, size_t end);
+
+  FILE* target_;
+  int fd_;
+  const size_t capacity_;
+  bool should_color_ = false;
+
+  std::mutex mutex_;
+  std::condition_variable wake_cv_;
+  std::condition_variable drained_cv_;
+  std::unique_ptr<spdlog::formatter> formatter_;
+  spdlog::memory_buf_t buffer_;
+  std::string pending_;  // 待写出的文本
+  bool writing_ = false;  // 写线程正在写出换出的文本
+  // 在 mutex_ 内置位，写线程在锁外写入时也会检查
+  std::atomic<bool> stopping_{false};
+  std::chrono::steady_clock::time_point drain_deadline_;  // 先于 stopping_ 写入
+  std::atomic<uint64_t> dropped_{0};
+
+  // 仅写线程访问
+  std::string output_;
+
+  std::thread thread_;
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_CONSOLE_SINK_H_
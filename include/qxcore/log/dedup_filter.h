@@ -0,0 +1,163 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef QXCORE_LOG_DEDUP_FILTER_H_
+#define QXCORE_LOG_DEDUP_FILTER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <absl/hash/hash.h>
+#include <absl/status/status.h>
+#include <absl/strings/string_view.h>
+#include "qxcore/log/arg_codec.h"
+#include "qxcore/log/callsite.h"
+#include "qxcore/log/log_options.h"
+#include "qxcore/log/logger_registry.h"
+
+namespace qxcore {
+namespace log {
+
+// 一段被折叠的连续重复记录
+struct DedupRun {
+  const Callsite* callsite = nullptr;
+  LoggerId logger_id = kNoLoggerId;
+  // 首条之后被丢弃的条数
+  uint64_t repeats = 0;
+  // 首条到最后一条重复记录的纳秒数
+  int64_t span_nanos = 0;
+};
+
+// 连续重复记录折叠
+//
+// 每个线程只保留自己上一条记录的 (调用点, 日志器, 参数哈希)。新记录与之相同且
+// 仍在窗口内时只计数；否则结束当前重复段，由调用方先写出汇总再写出新记录。
+// 判定在格式化之前完成，重复记录的开销是一次参数哈希和一次比较。线程按首次
+// 调用的顺序分到 kSlots 个槽位之一，每个槽位有自己的锁，只在线程数超过槽位数
+// 或定时线程扫描时才会争用。
+//
+// start 之后后台线程定期结束已到窗口的重复段并交给回调写出，停止重复后汇总
+// 不会一直滞留到下一条记录。
+class DedupFilter {
+ public:
+  // 写出一段重复记录汇总的回调，在定时线程上调用
+  using SummaryCallback = std::function<void(const DedupRun&)>;
+
+  explicit DedupFilter(const DedupOptions& options);
+  ~DedupFilter();
+
+  DedupFilter(const DedupFilter&) = delete;
+  DedupFilter& operator=(const DedupFilter&) = delete;
+
+  static absl::Status ValidateOptions(const DedupOptions& options);
+
+  // 启动定时线程，到期的重复段经 emit 写出
+  absl::Status start(SummaryCallback emit);
+
+  // 停止并等待定时线程退出，之后不再调用回调
+  void stop();
+
+  // 检查一条记录，返回 true 表示与本线程上一条重复、应丢弃。返回 false 且
+  // finished->repeats 非零时，调用方须先写出该段的汇总再写出本条
+  bool admit(const Callsite* callsite, LoggerId logger_id, uint64_t args_hash,
+             DedupRun* finished);
+
+  // 结束全部线程进行中的重复段，每次取出一段，没有被丢弃的记录时返回
+  // false；flush 与 shutdown 前循环调用，避免汇总一直滞留
+  bool take(DedupRun* finished);
+
+  // 结束一段已到窗口的重复段，没有时返回 false；定时线程调用
+  bool take_expired(DedupRun* finished);
+
+  // 累计丢弃的记录数
+  uint64_t suppressed() const {
+    return suppressed_.load(std::memory_order_relaxed);
+  }
+
+  static constexpr size_t kSlots = 64;
+
+ private:
+  // 一个或多个线程的重复判定状态
+  struct alignas(64) Slot {
+    std::mutex mutex;
+    const Callsite* callsite = nullptr;
+    LoggerId logger_id = kNoLoggerId;
+    uint64_t args_hash = 0;
+    int64_t start_nanos = 0;
+    int64_t last_nanos = 0;
+    uint64_t repeats = 0;
+  };
+
+  // 当前线程的槽位
+  Slot& thread_slot();
+
+  // 扫描各槽位，结束第一段满足条件的重复段；expired_only 为 true 时只结束
+  // 已到窗口的
+  bool take_first(bool expired_only, DedupRun* finished);
+
+  static bool take_locked(Slot& slot, DedupRun* finished);
+
+  // 定时线程主循环
+  void run();
+
+  const int64_t window_nanos_;
+  const uint64_t id_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<size_t> next_slot_{0};
+  std::atomic<uint64_t> suppressed_{0};
+
+  SummaryCallback emit_;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+namespace internal {
+
+// 参数的可哈希形式：数值与指针原样，字符串取视图，其余类型格式化为文本
+template<typename T>
+auto DedupHashable(const T& value) {
+  constexpr ArgType type = NativeArgType<T>();
+  if constexpr (type != ArgType::kString) {
+    return value;
+  } else if constexpr (kIsStringArg<T>) {
+    return StringArgView(value);
+  } else {
+    return fmt::format("{}", value);
+  }
+}
+
+}  // namespace internal
+
+// 参数哈希，重复判定用
+template<typename... Args>
+uint64_t HashDedupArgs(const Args&... args) {
+  return absl::HashOf(internal::DedupHashable(args)...);
+}
+
+// 汇总消息，如 "\"venue {} down\" repeated 41 times over 350 ms"
+std::string FormatDedupSummary(const DedupRun& run);
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_DEDUP_FILTER_H_
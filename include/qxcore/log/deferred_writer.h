@@ -0,0 +1,268 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_DEFERRED_WRITER_H_
+#define QXCORE_LOG_DEFERRED_WRITER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <absl/status/status.h>
+#include <absl/strings/string_view.h>
+#include <spdlog/common.h>
+#include "qxcore/log/arg_codec.h"
+#include "qxcore/log/async_writer.h"
+#include "qxcore/log/binary_sink.h"
+#include "qxcore/log/callsite.h"
+#include "qxcore/log/format_registry.h"
+#include "qxcore/log/log_context.h"
+#include "qxcore/log/logger_registry.h"
+#include "qxcore/log/log_level.h"
+#include "qxcore/log/log_options.h"
+#include "qxcore/log/spsc_ring.h"
+#include "qxcore/log/tsc_clock.h"
+
+namespace qxcore {
+namespace log {
+
+// 延迟格式化记录头，紧跟编码后的参数与调用线程的日志上下文（见
+// log_context.h），上下文长度由记录长度减去参数长度得出
+struct DeferredRecordHeader {
+  // 记录标志位
+  static constexpr uint8_t kEventTime = 1;  // time 为调用方给定的 Unix 纳秒
+
+  uint64_t time;        // TSC 计数，带 kEventTime 时为事件时间
+  uint32_t format_id;   // FormatRegistry 中的格式串 ID
+  uint32_t args_size;   // 参数编码字节数
+  const Callsite* callsite;  // 静态调用点，可能为空
+  LoggerId logger_id;   // 命名日志器，kNoLoggerId 表示使用写线程的名字
+  uint8_t level;        // LogLevel
+  uint8_t arg_count;    // 参数个数
+  uint8_t flags;        // 记录标志位
+  uint8_t reserved;
+
+  RecordTime record_time() const {
+    return RecordTime{time, (flags & kEventTime) != 0};
+  }
+};
+static_assert(sizeof(DeferredRecordHeader) == 32,
+              "DeferredRecordHeader must stay 8-byte aligned");
+
+namespace internal {
+
+// 单个生产者线程的缓冲区，由生产者线程与写线程共享所有权
+struct DeferredThreadBuffer {
+  explicit DeferredThreadBuffer(size_t capacity) : ring(capacity) {}
+
+  SpscByteRing ring;
+  size_t thread_id = 0;
+
+  // 生产者线程退出后置位，写线程取空后回收
+  std::atomic<bool> abandoned{false};
+
+  // 所属写线程停止后置位，生产者线程据此清理本地引用
+  std::atomic<bool> closed{false};
+
+  // 仅由生产者线程写入
+  std::atomic<uint64_t> committed{0};
+  std::atomic<uint64_t> dropped{0};
+};
+
+// 线程本地的缓冲区表：记录当前线程在各写线程下注册的缓冲区
+struct DeferredThreadBuffers {
+  struct Entry {
+    uint64_t writer_id;
+    std::shared_ptr<DeferredThreadBuffer> buffer;
+  };
+
+  ~DeferredThreadBuffers() {
+    for (auto& entry : entries) {
+      entry.buffer->abandoned.store(true, std::memory_order_release);
+    }
+  }
+
+  // 最近一次使用的缓冲区，绝大多数进程只有一个日志器
+  uint64_t last_writer_id = 0;
+  DeferredThreadBuffer* last_buffer = nullptr;
+  std::vector<Entry> entries;
+};
+
+inline DeferredThreadBuffers& LocalDeferredBuffers() {
+  thread_local DeferredThreadBuffers buffers;
+  return buffers;
+}
+
+}  // namespace internal
+
+// 延迟格式化写线程
+//
+// 调用线程只把格式串 ID 和按类型编码的原始参数写入本线程的 SPSC 环形
+// 缓冲区，格式化与写出都在后台写线程完成。写线程按时间戳归并各线程
+// 的缓冲区，保证跨线程输出近似按时间有序。
+class DeferredWriter {
+ public:
+  DeferredWriter(std::string logger_name, std::vector<spdlog::sink_ptr> sinks,
+                 const AsyncOptions& options);
+  ~DeferredWriter();
+
+  DeferredWriter(const DeferredWriter&) = delete;
+  DeferredWriter& operator=(const DeferredWriter&) = delete;
+
+  // 校验配置
+  static absl::Status ValidateOptions(const AsyncOptions& options);
+
+  // 启动写线程
+  absl::Status start();
+
+  // 写出全部缓冲区中剩余记录并停止写线程
+  void stop();
+
+  // 记录一条日志
+  //
+  // 返回 false 表示记录超过线程缓冲区的单条上限，调用方需要自行同步写出；
+  // 按溢出策略被丢弃的记录仍返回 true。
+  template<typename... Args>
+  bool log(LogLevel level, absl::string_view fmt_str, const Args&... args) {
+    return log(nullptr, kNoLoggerId, level, RecordTime::Now(), fmt_str,
+               args...);
+  }
+
+  // 同上，附带调用点（提供源码位置）、命名日志器和记录时间
+  template<typename... Args>
+  bool log(const Callsite* callsite, LoggerId logger_id, LogLevel level,
+           RecordTime time, absl::string_view fmt_str, const Args&... args) {
+    static_assert(sizeof...(Args) <= 255, "too many log arguments");
+    size_t args_size = EncodedArgsSize(args...);
+    absl::string_view context = CurrentLogContext();
+    size_t total = sizeof(DeferredRecordHeader) + args_size + context.size();
+    internal::DeferredThreadBuffer* buffer = local_buffer();
+    if (total > buffer->ring.max_record_size()) {
+      return false;
+    }
+
+    char* dst = reserve(buffer, total);
+    if (dst == nullptr) {
+      return true;
+    }
+
+    DeferredRecordHeader header;
+    header.time = time.value;
+    header.format_id = InternFormatCached(fmt_str);
+    header.args_size = static_cast<uint32_t>(args_size);
+    header.callsite = callsite;
+    header.logger_id = logger_id;
+    header.level = static_cast<uint8_t>(LogLevelToInt(level));
+    header.arg_count = static_cast<uint8_t>(sizeof...(Args));
+    header.flags = time.is_event ? DeferredRecordHeader::kEventTime : 0;
+    header.reserved = 0;
+    std::memcpy(dst, &header, sizeof(header));
+    char* context_dst = EncodeArgs(dst + sizeof(header), args...);
+    std::memcpy(context_dst, context.data(), context.size());
+    buffer->ring.commit();
+
+    // 只有生产者线程写该计数，不需要原子读改写
+    buffer->committed.store(
+        buffer->committed.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+    if (sleeping_.load(std::memory_order_relaxed)) {
+      wake_writer();
+    }
+    return true;
+  }
+
+  // 阻塞直到调用前提交的记录全部写出，然后刷新 sinks
+  void flush();
+
+  // 获取统计信息；kDropOldest 在该模式下按 kDropNewest 处理并计入 dropped_newest
+  AsyncStats stats() const;
+
+ private:
+  using BufferPtr = std::shared_ptr<internal::DeferredThreadBuffer>;
+
+  // 获取当前线程在本写线程下的缓冲区，首次调用时注册
+  internal::DeferredThreadBuffer* local_buffer() {
+    internal::DeferredThreadBuffers& local = internal::LocalDeferredBuffers();
+    if (local.last_writer_id == id_) {
+      return local.last_buffer;
+    }
+    return register_thread(local);
+  }
+  internal::DeferredThreadBuffer* register_thread(
+      internal::DeferredThreadBuffers& local);
+
+  // 按溢出策略预留空间，记录被丢弃时返回 nullptr
+  char* reserve(internal::DeferredThreadBuffer* buffer, size_t size);
+
+  // 写线程主循环
+  void run();
+
+  // 从全部缓冲区中取出时间戳最小的一条记录并写出，全部为空时返回 false
+  bool write_one(std::vector<BufferPtr>& buffers);
+
+  // 格式化并写出一条记录
+  void write_record(const internal::DeferredThreadBuffer& buffer,
+                    absl::string_view record);
+
+  // 同步写线程持有的缓冲区列表并回收已退出且为空的线程缓冲区
+  void refresh_buffers(std::vector<BufferPtr>& buffers);
+
+  // 唤醒处于休眠状态的写线程
+  void wake_writer();
+
+  std::string logger_name_;
+  std::vector<spdlog::sink_ptr> sinks_;
+  // 需要格式化文本的 sinks 与直接接收原始记录的 sinks
+  std::vector<spdlog::sink_ptr> text_sinks_;
+  std::vector<std::pair<spdlog::sink_ptr, RawRecordSink*>> raw_sinks_;
+  // 支持批量提交的 sinks，连续写出时按批累积
+  std::vector<GroupCommitSink*> batch_sinks_;
+  AsyncOptions options_;
+  const uint64_t id_;
+  TscClock& clock_;
+
+  mutable std::mutex buffers_mutex_;
+  std::vector<BufferPtr> buffers_;
+  std::atomic<uint64_t> buffers_version_{0};
+  uint64_t retired_committed_ = 0;
+  uint64_t retired_dropped_ = 0;
+  std::atomic<uint64_t> written_{0};
+
+  std::thread thread_;
+  std::atomic<bool> running_{false};
+  std::atomic<bool> stopping_{false};
+  std::atomic<bool> sleeping_{false};
+
+  std::mutex mutex_;
+  std::condition_variable wake_cv_;
+  std::condition_variable flush_cv_;
+  std::atomic<uint64_t> flush_requested_{0};
+  uint64_t flush_completed_ = 0;
+
+  // 仅写线程访问
+  FormatArgStore arg_store_;
+  fmt::memory_buffer format_buffer_;
+  std::vector<const std::string*> format_cache_;
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_DEFERRED_WRITER_H_
@@ -0,0 +1,156 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_EPOCH_H_
+#define QXCORE_LOG_EPOCH_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace qxcore {
+namespace log {
+namespace internal {
+
+// 基于 epoch 的延迟回收（RCU 风格）
+//
+// 读者在临界区内访问共享对象，写者替换指针后调用 retire 登记旧对象，
+// 旧对象在所有可能观察到它的读者退出临界区后才会被释放。读者进入和
+// 退出临界区只写本线程独占的槽位，不获取任何锁。
+class EpochDomain {
+ public:
+  // 可同时持有独立槽位的线程数，超出的线程退化为共享计数
+  static constexpr size_t kMaxSlots = 256;
+
+  // 进程级全局实例
+  static EpochDomain& Global();
+
+  EpochDomain(const EpochDomain&) = delete;
+  EpochDomain& operator=(const EpochDomain&) = delete;
+
+  // 进入读临界区，可嵌套
+  void enter() {
+    ThreadState& state = LocalState();
+    if (state.nesting++ != 0) {
+      return;
+    }
+    if (state.slot == nullptr) {
+      acquire_slot(state);
+    }
+    if (state.slot != nullptr) {
+      state.slot->epoch.store(global_epoch_.load(std::memory_order_acquire),
+                              std::memory_order_relaxed);
+    } else {
+      overflow_readers_.fetch_add(1, std::memory_order_relaxed);
+    }
+    // 保证槽位写入先于临界区内对共享指针的读取对写者可见
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  }
+
+  // 退出读临界区
+  void exit() {
+    ThreadState& state = LocalState();
+    if (--state.nesting != 0) {
+      return;
+    }
+    if (state.slot != nullptr) {
+      state.slot->epoch.store(kQuiescent, std::memory_order_release);
+    } else {
+      overflow_readers_.fetch_sub(1, std::memory_order_release);
+    }
+  }
+
+  // 当前线程是否处于读临界区
+  bool in_critical_section() const { return LocalState().nesting != 0; }
+
+  // 登记待回收对象，deleter 在安全时调用；调用前共享指针必须已经替换
+  void retire(std::function<void()> deleter);
+
+  // 释放已经安全的对象，返回释放的数量
+  size_t reclaim();
+
+  // 等待此前登记的全部对象都可以安全释放并释放它们
+  //
+  // 当前线程处于读临界区时无法等待自己退出，只做一次 reclaim。
+  void synchronize();
+
+  // 待回收对象数量
+  size_t retired_count() const;
+
+ private:
+  static constexpr uint64_t kQuiescent = 0;
+  static constexpr size_t kCacheLineSize = 64;
+
+  struct alignas(kCacheLineSize) Slot {
+    std::atomic<uint64_t> epoch{kQuiescent};
+    std::atomic<bool> in_use{false};
+  };
+
+  struct ThreadState {
+    ~ThreadState();
+
+    Slot* slot = nullptr;
+    bool overflow = false;
+    int nesting = 0;
+  };
+
+  struct Retired {
+    uint64_t epoch;
+    std::function<void()> deleter;
+  };
+
+  EpochDomain();
+
+  static ThreadState& LocalState() {
+    thread_local ThreadState state;
+    return state;
+  }
+
+  // 为当前线程分配槽位，槽位耗尽时标记为共享计数
+  void acquire_slot(ThreadState& state);
+
+  // 所有活跃读者中最小的 epoch，没有活跃读者时返回 UINT64_MAX
+  uint64_t min_active_epoch() const;
+
+  // 在持有 retired_mutex_ 时释放安全对象，返回待调用的 deleter
+  std::vector<std::function<void()>> collect_locked();
+
+  std::atomic<uint64_t> global_epoch_{1};
+  std::atomic<uint64_t> overflow_readers_{0};
+  std::unique_ptr<Slot[]> slots_;
+
+  mutable std::mutex retired_mutex_;
+  std::vector<Retired> retired_;
+};
+
+}  // namespace internal
+
+// 读临界区守卫
+class EpochGuard {
+ public:
+  EpochGuard() { internal::EpochDomain::Global().enter(); }
+  ~EpochGuard() { internal::EpochDomain::Global().exit(); }
+
+  EpochGuard(const EpochGuard&) = delete;
+  EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_EPOCH_H_
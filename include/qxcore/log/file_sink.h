@@ -0,0 +1,57 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef QXCORE_LOG_FILE_SINK_H_
+#define QXCORE_LOG_FILE_SINK_H_
+
+#include <mutex>
+#include <string>
+#include <absl/status/status.h>
+#include <spdlog/common.h>
+#include <spdlog/details/file_helper.h>
+#include <spdlog/sinks/base_sink.h>
+
+namespace qxcore {
+namespace log {
+
+// 复用格式化缓冲区的文本文件 sink
+//
+// spdlog 自带的文件 sink 每条记录在栈上构造内联 250 字节的缓冲区，更长的
+// 记录每次都会分配；这里在 sink 锁内复用一块预留缓冲区，不超过预留长度
+// 的记录写出时不分配内存。
+class FileSink : public spdlog::sinks::base_sink<std::mutex> {
+ public:
+  // buffer_size 为预留的格式化缓冲区字节数
+  explicit FileSink(size_t buffer_size = 8192);
+
+  // 打开输出文件
+  absl::Status open(const std::string& path, bool truncate = true);
+
+  // 当前文件路径
+  std::string filename();
+
+ protected:
+  void sink_it_(const spdlog::details::log_msg& msg) override;
+  void flush_() override;
+
+ private:
+  spdlog::details::file_helper file_;
+  spdlog::memory_buf_t buffer_;
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_FILE_SINK_H_
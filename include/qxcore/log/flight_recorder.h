@@ -0,0 +1,211 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_FLIGHT_RECORDER_H_
+#define QXCORE_LOG_FLIGHT_RECORDER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <absl/status/status.h>
+#include <absl/strings/string_view.h>
+#include "qxcore/log/arg_codec.h"
+#include "qxcore/log/format_registry.h"
+#include "qxcore/log/log_level.h"
+#include "qxcore/log/log_options.h"
+#include "qxcore/log/tsc_clock.h"
+
+namespace qxcore {
+namespace log {
+
+// 飞行记录区的布局常量
+//
+// 区域为 [文件头][格式串表][线程环 0][线程环 1]...，全部自描述，可以在
+// 信号处理函数里或由另一个进程（读取 /dev/shm 文件）直接解析。
+namespace flight_format {
+
+constexpr uint32_t kMagic = 0x52465851;  // "QXFR"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 128;
+constexpr size_t kRingHeaderSize = 64;
+constexpr size_t kTableCapacity = 256 * 1024;
+
+// 记录标志位
+constexpr uint8_t kEventTime = 1;  // time 为调用方给定的 Unix 纳秒
+constexpr uint8_t kWritten = 2;    // 记录当时已由后端正常写出
+constexpr uint8_t kTruncated = 4;  // 参数超出槽位，只保留了格式串
+constexpr uint8_t kVerbatim = 8;   // 格式串即消息原文，不做替换
+
+}  // namespace flight_format
+
+namespace internal {
+
+// 区域文件头；原子成员均为无锁类型，可以放在共享内存中
+struct FlightHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t record_size;
+  uint32_t records_per_thread;
+  uint32_t max_threads;
+  uint32_t table_capacity;
+  std::atomic<uint32_t> threads;     // 已分配的线程环数
+  std::atomic<uint32_t> table_used;  // 格式串表已用字节
+  // 计数换算为 Unix 纳秒的参数，在初始化和每次转储时更新
+  std::atomic<uint64_t> clock_ticks;
+  std::atomic<int64_t> clock_nanos;
+  std::atomic<double> nanos_per_tick;
+  char name[64];
+};
+static_assert(sizeof(FlightHeader) <= flight_format::kHeaderSize,
+              "FlightHeader must fit in the reserved header");
+
+// 单个线程环的头部
+struct FlightRingHeader {
+  std::atomic<uint64_t> next;    // 下一条记录的序号，只由所属线程写
+  std::atomic<uint64_t> dumped;  // 已转储到日志的序号上限
+  std::atomic<uint32_t> thread_id;
+};
+static_assert(sizeof(FlightRingHeader) <= flight_format::kRingHeaderSize,
+              "FlightRingHeader must fit in the reserved ring header");
+
+// 单条记录的头部，之后为 arg_codec 编码的参数
+struct FlightSlotHeader {
+  // 记录序号加 1；所属线程写入期间为 0，读取方据此丢弃被改写的记录
+  std::atomic<uint64_t> sequence;
+  uint64_t time;       // TSC 计数，带 kEventTime 时为事件时间
+  uint32_t format_id;  // FormatRegistry 中的格式串 ID
+  uint16_t args_size;
+  uint8_t level;
+  uint8_t arg_count;
+  uint8_t flags;
+  uint8_t reserved[7];
+};
+static_assert(sizeof(FlightSlotHeader) == 32,
+              "FlightSlotHeader must stay 8-byte aligned");
+
+}  // namespace internal
+
+// 飞行记录器：在内存中保留每个线程最近的记录（包括低于日志级别、未写出的）
+//
+// 生产者只把格式串 ID 和原始参数编码进本线程的定长环形缓冲区，不格式化、
+// 不加锁。出错时（dump）把尚未写出的记录按时间顺序补写到日志；崩溃时由
+// 信号处理函数以异步信号安全的方式把全部记录写到文件描述符。
+class FlightRecorder {
+ public:
+  FlightRecorder() = default;
+  ~FlightRecorder();
+
+  FlightRecorder(const FlightRecorder&) = delete;
+  FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+  // 检查配置是否有效
+  static absl::Status ValidateOptions(const FlightRecorderOptions& options);
+
+  // 分配记录区；shm_path 非空时映射为共享文件，否则使用匿名内存
+  absl::Status init(const std::string& name,
+                    const FlightRecorderOptions& options);
+
+  // 记录一次调用；written 表示该记录同时由后端正常写出
+  template<typename... Args>
+  void record(LogLevel level, RecordTime time, bool written,
+              absl::string_view format, const Args&... args) {
+    internal::FlightRingHeader* ring = thread_ring();
+    if (ring == nullptr) {
+      return;
+    }
+    uint8_t flags = (time.is_event ? flight_format::kEventTime : 0) |
+                    (written ? flight_format::kWritten : 0);
+    size_t args_size = EncodedArgsSize(args...);
+    if (args_size > payload_capacity_) {
+      flags |= flight_format::kTruncated;
+      args_size = 0;
+    }
+    char* payload = begin_record(ring, level, time.value, format, flags,
+                                 static_cast<uint8_t>(sizeof...(Args)),
+                                 args_size);
+    if (args_size != 0) {
+      EncodeArgs(payload, args...);
+    }
+    end_record(ring, payload);
+  }
+
+  // 记录不做格式替换的原文消息
+  void record_verbatim(LogLevel level, RecordTime time, bool written,
+                       absl::string_view message);
+
+  // 该级别的记录是否应触发转储
+  bool should_dump(LogLevel level) const {
+    return dump_on_error_ && LogLevelToInt(level) >= LogLevelToInt(dump_level_);
+  }
+
+  // 按时间顺序输出尚未写出且未转储过的记录，返回输出的条数
+  using DumpFn = std::function<void(LogLevel level, int64_t unix_nanos,
+                                    absl::string_view message)>;
+  size_t dump(const DumpFn& emit);
+
+  // 以异步信号安全的方式把记录区中的全部记录写到 fd
+  void dump_to_fd(int fd) const;
+
+  // 解析 shm_path 留下的记录区文件并写到 fd（如进程被强制结束之后）
+  static absl::Status DumpFile(const std::string& path, int fd);
+
+  // 为 SIGSEGV、SIGBUS、SIGFPE、SIGILL 和 SIGABRT 安装处理函数：崩溃时把
+  // 全部记录写到 fd，再交还给原处理函数
+  void install_crash_handler(int fd);
+
+  // 本线程是否分到了线程环（超过 max_threads 的线程不记录）
+  bool thread_recorded() { return thread_ring() != nullptr; }
+
+ private:
+  internal::FlightRingHeader* thread_ring();
+  internal::FlightRingHeader* ring_at(uint32_t index) const;
+  char* begin_record(internal::FlightRingHeader* ring, LogLevel level,
+                     uint64_t time, absl::string_view format, uint8_t flags,
+                     uint8_t arg_count, size_t args_size);
+  // 发布 begin_record 返回的记录
+  void end_record(internal::FlightRingHeader* ring, char* payload) {
+    auto* slot = reinterpret_cast<internal::FlightSlotHeader*>(
+        payload - sizeof(internal::FlightSlotHeader));
+    uint64_t next = ring->next.load(std::memory_order_relaxed) + 1;
+    slot->sequence.store(next, std::memory_order_release);
+    ring->next.store(next, std::memory_order_release);
+  }
+  void export_format(uint32_t format_id, absl::string_view format);
+  void publish_clock();
+
+  uint64_t id_ = 0;
+  char* region_ = nullptr;
+  size_t region_size_ = 0;
+  internal::FlightHeader* header_ = nullptr;
+  size_t ring_size_ = 0;
+  size_t payload_capacity_ = 0;
+  bool dump_on_error_ = false;
+  LogLevel dump_level_ = LogLevel::kError;
+
+  // 已写入格式串表的 ID 位图，只增不减
+  std::unique_ptr<std::atomic<uint64_t>[]> exported_;
+  size_t exported_bits_ = 0;
+  std::mutex table_mutex_;
+  std::mutex dump_mutex_;
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_FLIGHT_RECORDER_H_
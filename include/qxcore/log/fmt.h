@@ -0,0 +1,37 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_FMT_H_
+#define QXCORE_LOG_FMT_H_
+
+// 统一的 fmt 引入点
+//
+// 启用 spdlog 时与 spdlog 共用同一份 fmt（内置或外部），避免同一进程中
+// 出现两份不同版本的 fmt 符号；否则使用 third_party/fmt。
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+#include <spdlog/fmt/fmt.h>
+#if defined(SPDLOG_FMT_EXTERNAL) || defined(SPDLOG_FMT_EXTERNAL_HO)
+#include <fmt/args.h>
+#else
+#include <spdlog/fmt/bundled/args.h>
+#endif
+#include <spdlog/fmt/compile.h>
+#else
+#include <fmt/args.h>
+#include <fmt/compile.h>
+#include <fmt/format.h>
+#endif
+
+#endif  // QXCORE_LOG_FMT_H_
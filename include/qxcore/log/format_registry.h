@@ -0,0 +1,87 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_FORMAT_REGISTRY_H_
+#define QXCORE_LOG_FORMAT_REGISTRY_H_
+
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <absl/container/flat_hash_map.h>
+#include <absl/strings/string_view.h>
+
+namespace qxcore {
+namespace log {
+
+// 格式串字典：把格式串内容映射为进程内稳定的整数 ID
+//
+// ID 从 0 开始连续分配，格式串内容在注册时被拷贝，调用方的字符串
+// 不需要具有静态生命周期。
+class FormatRegistry {
+ public:
+  // 进程级全局实例
+  static FormatRegistry& Global();
+
+  // 获取格式串对应的 ID，不存在时注册
+  uint32_t intern(absl::string_view fmt_str);
+
+  // 按 ID 查找格式串，ID 无效时返回 nullptr；返回的指针永久有效
+  const std::string* find(uint32_t id) const;
+
+  // 已注册的格式串数量
+  size_t size() const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::deque<std::string> formats_;
+  absl::flat_hash_map<absl::string_view, uint32_t> ids_;
+};
+
+// 带线程本地缓存的格式串 ID 查找
+//
+// 以格式串地址为键做直接映射缓存，命中后再比较内容，因此复用同一块
+// 缓冲区的动态格式串也不会拿到错误的 ID。
+inline uint32_t InternFormatCached(absl::string_view fmt_str) {
+  struct Entry {
+    const char* data = nullptr;
+    size_t size = 0;
+    const std::string* text = nullptr;
+    uint32_t id = 0;
+  };
+  constexpr size_t kCacheSize = 256;
+  thread_local Entry cache[kCacheSize];
+
+  Entry& entry =
+      cache[(reinterpret_cast<uintptr_t>(fmt_str.data()) >> 3) & (kCacheSize - 1)];
+  if (entry.text != nullptr && entry.data == fmt_str.data() &&
+      entry.size == fmt_str.size() &&
+      std::memcmp(entry.text->data(), fmt_str.data(), fmt_str.size()) == 0) {
+    return entry.id;
+  }
+
+  FormatRegistry& registry = FormatRegistry::Global();
+  uint32_t id = registry.intern(fmt_str);
+  entry.data = fmt_str.data();
+  entry.size = fmt_str.size();
+  entry.text = registry.find(id);
+  entry.id = id;
+  return id;
+}
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_FORMAT_REGISTRY_H_
@@ -0,0 +1,76 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef QXCORE_LOG_FORMAT_STRING_H_
+#define QXCORE_LOG_FORMAT_STRING_H_
+
+#include <type_traits>
+#include <absl/strings/string_view.h>
+#include "qxcore/log/fmt.h"
+
+// 编译期格式串
+//
+// QXLOG_FMT("...") 包装的字面量在编译期按实参类型校验（占位符越界、
+// 说明符与类型不匹配都会编译失败），并预先解析为格式化指令序列，运行期
+// 不再扫描格式串。QXLOG_* 宏会自动包装第一个参数。
+#define QXLOG_FMT(s) FMT_COMPILE(s)
+
+namespace qxcore {
+namespace log {
+
+// S 是否为 QXLOG_FMT 生成的编译期格式串
+template<typename S>
+constexpr bool kIsCompiledFormat =
+    fmt::is_compiled_string<std::decay_t<S>>::value;
+
+// 格式串原文；编译期格式串返回指向字面量的视图，地址在进程内稳定
+template<typename S>
+absl::string_view FormatView(const S& fmt_str) {
+  if constexpr (kIsCompiledFormat<S>) {
+    fmt::string_view view(fmt_str);
+    return absl::string_view(view.data(), view.size());
+  } else {
+    return absl::string_view(fmt_str);
+  }
+}
+
+// 按 fmt 语法格式化并追加到 buffer；运行期格式串出错时抛出 fmt::format_error
+template<typename S, typename... Args>
+void FormatTo(fmt::memory_buffer& buffer, const S& fmt_str,
+              const Args&... args) {
+  if constexpr (kIsCompiledFormat<S>) {
+    fmt::format_to(fmt::appender(buffer), fmt_str, args...);
+  } else {
+    absl::string_view view = FormatView(fmt_str);
+    fmt::vformat_to(fmt::appender(buffer),
+                    fmt::string_view(view.data(), view.size()),
+                    fmt::make_format_args(args...));
+  }
+}
+
+namespace internal {
+
+// 生产者线程复用的格式化缓冲区
+inline fmt::memory_buffer& ThreadFormatBuffer() {
+  thread_local fmt::memory_buffer buffer;
+  return buffer;
+}
+
+}  // namespace internal
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_FORMAT_STRING_H_
@@ -15,11 +15,16 @@
 #ifndef QXCORE_LOG_GLOG_BACKEND_H_
 #define QXCORE_LOG_GLOG_BACKEND_H_
 
+#include <atomic>
 #include <string>
 #include <absl/strings/string_view.h>
 #include <absl/status/status.h>
-#include <absl/strings/str_format.h>
+#include "qxcore/log/callsite.h"
+#include "qxcore/log/format_string.h"
 #include "qxcore/log/log_level.h"
+#include "qxcore/log/log_options.h"
+#include "qxcore/log/logger_registry.h"
+#include "qxcore/log/tsc_clock.h"
 
 namespace qxcore {
 namespace log {
@@ -28,18 +33,20 @@ namespace log {
 class GlogBackend {
  public:
   GlogBackend() = default;
-  ~GlogBackend() = default;
+  ~GlogBackend();
 
   // 禁用拷贝构造和赋值
   GlogBackend(const GlogBackend&) = delete;
   GlogBackend& operator=(const GlogBackend&) = delete;
   
-  // 移动构造和赋值
-  GlogBackend(GlogBackend&&) = default;
-  GlogBackend& operator=(GlogBackend&&) = default;
+  // 以地址注册到 CallsiteRegistry，禁用移动
+  GlogBackend(GlogBackend&&) = delete;
+  GlogBackend& operator=(GlogBackend&&) = delete;
 
   // 初始化日志系统
-  absl::Status init(const std::string& name, LogLevel level = LogLevel::kInfo);
+  // glog 自带写出线程模型，不支持 LogMode::kAsync
+  absl::Status init(const std::string& name, LogLevel level = LogLevel::kInfo,
+                    const LogOptions& options = LogOptions());
 
   // 设置日志级别
   absl::Status set_level(LogLevel level);
@@ -48,29 +55,67 @@ class GlogBackend {
   LogLevel get_level() const;
 
   // 检查日志级别是否启用
-  bool is_enabled(LogLevel level) const;
+  bool is_enabled(LogLevel level) const {
+    return initialized_.load(std::memory_order_acquire) &&
+           IsLogLevelEnabled(current_level_.load(std::memory_order_relaxed),
+                             level);
+  }
 
   // 基础日志接口
-  void log(LogLevel level, absl::string_view msg);
+  void log(LogLevel level, absl::string_view msg) {
+    if (is_enabled(level)) {
+      write(level, nullptr, kNoLoggerId, msg);
+    }
+  }
 
-  // 格式化日志接口
-  template<typename... Args>
-  void logf(LogLevel level, absl::string_view fmt_str, Args&&... args) {
-    if (!initialized_ || !is_enabled(level)) {
-      return;
+  // 调用点日志接口：级别已由调用点判断，源码位置交给 glog
+  void log(const Callsite& callsite, absl::string_view msg) {
+    if (initialized_.load(std::memory_order_acquire)) {
+      write(callsite.level(), &callsite, kNoLoggerId, msg);
     }
+  }
 
-    try {
-      // 对于没有参数的情况，直接使用原始字符串
-      if constexpr (sizeof...(args) == 0) {
-        log(level, fmt_str);
-      } else {
-        // 对于有参数的情况，使用 absl 格式化
-        std::string formatted = absl::StrFormat(fmt_str, std::forward<Args>(args)...);
-        log(level, formatted);
-      }
-    } catch (...) {
-      // 静默处理日志错误，避免异常传播
+  // 格式化日志接口，与 SpdlogBackend 使用相同的 fmt 语法
+  template<typename S, typename... Args>
+  void logf(LogLevel level, const S& fmt_str, Args&&... args) {
+    if (is_enabled(level)) {
+      writef(level, nullptr, kNoLoggerId, fmt_str, args...);
+    }
+  }
+
+  // 指定事件时间的格式化日志接口
+  //
+  // glog 的 LogMessage 总是自行读取时钟，无法接收外部时间戳，这里的
+  // time 被忽略，记录时间为写出时刻
+  template<typename S, typename... Args>
+  void logf(LogLevel level, EventTime /*time*/, const S& fmt_str,
+            Args&&... args) {
+    if (is_enabled(level)) {
+      writef(level, nullptr, kNoLoggerId, fmt_str, args...);
+    }
+  }
+
+  template<typename S, typename... Args>
+  void logf(const Callsite& callsite, const S& fmt_str, Args&&... args) {
+    if (initialized_.load(std::memory_order_acquire)) {
+      writef(callsite.level(), &callsite, kNoLoggerId, fmt_str, args...);
+    }
+  }
+
+  // 命名日志器接口：级别已由 LoggerRegistry 判断，消息前附加日志器名字；
+  // 与上同理，time 被忽略
+  void log_named(LoggerId logger_id, LogLevel level, const Callsite* callsite,
+                 RecordTime /*time*/, absl::string_view msg) {
+    if (initialized_.load(std::memory_order_acquire)) {
+      write(level, callsite, logger_id, msg);
+    }
+  }
+
+  template<typename S, typename... Args>
+  void logf_named(LoggerId logger_id, LogLevel level, const Callsite* callsite,
+                  RecordTime /*time*/, const S& fmt_str, Args&&... args) {
+    if (initialized_.load(std::memory_order_acquire)) {
+      writef(level, callsite, logger_id, fmt_str, args...);
     }
   }
 
@@ -81,13 +126,44 @@ class GlogBackend {
   void shutdown();
 
  private:
-  // 转换日志级别
+  // TRACE/DEBUG 还须满足 VLOG_IS_ON(--v=2/1)，其余级别总是为 true
+  static bool VerbosityEnabled(LogLevel level);
+
+  // 写出一条已通过级别检查的记录，未通过 VerbosityEnabled 的丢弃
+  void write(LogLevel level, const Callsite* callsite, LoggerId logger_id,
+             absl::string_view msg);
+
+  template<typename S, typename... Args>
+  void writef(LogLevel level, const Callsite* callsite, LoggerId logger_id,
+              const S& fmt_str, const Args&... args) {
+    // 对于没有参数的运行期字符串，直接使用原始字符串
+    if constexpr (sizeof...(Args) == 0 && !kIsCompiledFormat<S>) {
+      write(level, callsite, logger_id, FormatView(fmt_str));
+    } else {
+      // 未通过 --v 的 TRACE/DEBUG 不格式化
+      if (!VerbosityEnabled(level)) {
+        return;
+      }
+      try {
+        fmt::memory_buffer& buffer = internal::ThreadFormatBuffer();
+        buffer.clear();
+        FormatTo(buffer, fmt_str, args...);
+        write(level, callsite, logger_id,
+              absl::string_view(buffer.data(), buffer.size()));
+      } catch (...) {
+        // 静默处理日志错误，避免异常传播
+      }
+    }
+  }
+
+  // 转换日志级别：TRACE/DEBUG/INFO 为 GLOG_INFO（TRACE/DEBUG 另须 --v=2/1），
+  // CRITICAL 为 GLOG_ERROR，避免 GLOG_FATAL 终止进程
   static int ToGlogLevel(LogLevel level);
   static LogLevel FromGlogLevel(int level);
 
   std::string logger_name_;
-  LogLevel current_level_ = LogLevel::kInfo;
-  bool initialized_ = false;
+  std::atomic<LogLevel> current_level_{LogLevel::kInfo};
+  std::atomic<bool> initialized_{false};
 };
 
 }  // namespace log
@@ -0,0 +1,186 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef QXCORE_LOG_GROUP_COMMIT_SINK_H_
+#define QXCORE_LOG_GROUP_COMMIT_SINK_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/uio.h>
+#include <absl/status/status.h>
+#include <spdlog/common.h>
+#include <spdlog/formatter.h>
+#include <spdlog/sinks/sink.h>
+#include "qxcore/log/log_options.h"
+
+namespace qxcore {
+namespace log {
+
+// 批量提交统计
+struct GroupCommitStats {
+  uint64_t records = 0;      // 已提交的记录数
+  uint64_t batches = 0;      // 已提交的批次数
+  uint64_t write_calls = 0;  // 写入系统调用次数（writev 或 io_uring_enter）
+  uint64_t bytes = 0;        // 已写出的字节数
+  uint64_t errors = 0;       // 写入失败而丢弃的批次数
+};
+
+namespace internal {
+class UringWriter;
+}  // namespace internal
+
+// 把多条记录合并为一次 writev 的文本 sink
+//
+// 记录在锁内格式化后追加到暂存批次，由一个线程（leader）在锁外把整批用一次
+// writev 写出；写出期间其他线程继续追加到下一批，写完后 leader 接着提交
+// 新积累的记录。空闲时每条记录立即写出，负载越高每批越大，系统调用次数
+// 不随记录数线性增长。
+//
+// 异步与延迟写线程用 begin_batch/end_batch 标出连续写出的区间：区间内本线程
+// 的记录按 max_batch_bytes 与 max_batch_delay_us 累积，队列排空时 end_batch
+// 立即提交。其他线程（如绕过队列的高级别记录）的记录不等待，连同已暂存的
+// 记录一起立即写出。
+//
+// 文件输出在内核支持时经 io_uring 提交：leader 提交后不等待写入完成，下一次
+// 提交前才回收上一批，格式化与磁盘写入重叠。控制台输出直接写文件描述符，
+// 不经过 stdio 缓冲。写入失败的批次计入 errors 后丢弃，不抛出异常。
+class GroupCommitSink final : public spdlog::sinks::sink {
+ public:
+  // buffer_size 为预留的格式化缓冲区字节数
+  explicit GroupCommitSink(const GroupCommitOptions& options,
+                           size_t buffer_size = 8192);
+  ~GroupCommitSink() override;
+
+  GroupCommitSink(const GroupCommitSink&) = delete;
+  GroupCommitSink& operator=(const GroupCommitSink&) = delete;
+
+  // 校验配置
+  static absl::Status ValidateOptions(const GroupCommitOptions& options);
+
+  // 打开输出文件
+  absl::Status open(const std::string& path, bool truncate = true);
+
+  // 输出到控制台，行为与 ConsoleSink 相同：终端支持时为 %^...%$ 范围着色，
+  // 写出时持有 spdlog 全局控制台锁
+  absl::Status open_console(FILE* target = stdout,
+                            spdlog::color_mode mode =
+                                spdlog::color_mode::automatic);
+
+  void log(const spdlog::details::log_msg& msg) override;
+  // 提交暂存的记录并等待写入完成
+  void flush() override;
+  void set_pattern(const std::string& pattern) override;
+  void set_formatter(std::unique_ptr<spdlog::formatter> formatter) override;
+
+  // 写线程开始连续写出，之后本线程的记录按批次上限累积
+  void begin_batch();
+
+  // 写线程队列已排空，立即提交累积的记录
+  void end_batch();
+
+  // 当前文件路径，控制台输出时为空
+  std::string filename() const;
+
+  // 是否经 io_uring 提交
+  bool using_io_uring() const { return uring_ != nullptr; }
+
+  GroupCommitStats stats() const;
+
+ private:
+  // 单个暂存块的字节数；超过该长度的记录独占一块
+  static constexpr size_t kChunkSize = 64 * 1024;
+
+  // 一批记录：若干暂存块，写出时每块对应一个 iovec；块在清空后保留容量，
+  // 稳态下不分配内存
+  struct Batch {
+    std::vector<std::string> chunks;
+    size_t used_chunks = 0;
+    size_t bytes = 0;
+    uint64_t records = 0;
+    int64_t first_nanos = 0;
+
+    char* append(size_t size);
+    void clear();
+    bool empty() const { return records == 0; }
+  };
+
+  // 当前线程是否处于写线程的批次区间内
+  bool deferring() const;
+
+  // 是否应当立即提交暂存批次
+  bool should_commit(int64_t now_nanos) const;
+
+  // 成为 leader 提交暂存批次，直到没有需要立即提交的记录；drain 为 true 时
+  // 还等待 io_uring 上的写入完成。调用前持有锁且没有其他 leader
+  void commit_locked(std::unique_lock<std::mutex>& lock, bool drain);
+
+  // 在锁外写出一批，返回写入是否成功；submitted 返回是否已交给 io_uring
+  // 而尚未完成
+  bool write_batch(const Batch& batch, bool* submitted);
+
+  // 同步 writev 写出 skip 字节之后的部分，处理短写与 EINTR/EAGAIN
+  bool writev_all(const Batch& batch, size_t skip);
+
+  // 等待 io_uring 上一批写入完成并补写短写部分
+  bool reap_inflight();
+
+  void close_fd();
+
+  const size_t max_batch_bytes_;
+  const int64_t max_batch_delay_nanos_;
+  const bool use_io_uring_;
+
+  int fd_ = -1;
+  FILE* console_ = nullptr;
+  bool should_color_ = false;
+  std::string filename_;
+  std::unique_ptr<internal::UringWriter> uring_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable committed_cv_;
+  std::unique_ptr<spdlog::formatter> formatter_;
+  spdlog::memory_buf_t buffer_;
+  Batch staging_;
+  // leader 在锁外写出的批次
+  Batch outgoing_;
+  // 已提交给 io_uring、尚未确认完成的批次
+  Batch inflight_;
+  // leader 在锁外使用的 iovec 数组
+  std::vector<struct iovec> iov_;
+  bool committing_ = false;
+  // 暂存批次需要立即提交
+  bool pending_commit_ = false;
+  bool batch_active_ = false;
+  std::thread::id batch_thread_;
+
+  uint64_t records_ = 0;
+  uint64_t batches_ = 0;
+  uint64_t bytes_ = 0;
+  // leader 在锁外更新
+  std::atomic<uint64_t> write_calls_{0};
+  std::atomic<uint64_t> errors_{0};
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_GROUP_COMMIT_SINK_H_
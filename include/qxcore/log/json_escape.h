@@ -0,0 +1,72 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef QXCORE_LOG_JSON_ESCAPE_H_
+#define QXCORE_LOG_JSON_ESCAPE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <absl/strings/string_view.h>
+
+namespace qxcore {
+namespace log {
+
+// JSON 字符串转义与 UTF-8 校验
+//
+// x86-64 上按 CPU 支持选择 AVX2 或 SSE2 实现：逐 32/16 字节查找需要转义的
+// 字节（" \ 与控制字符），之间的内容整块拷贝；UTF-8 校验 AVX2 使用查表法
+// （Keiser & Lemire）整块判定，SSE2 整块跳过 ASCII 后逐字符校验。其他平台
+// 使用标量实现。
+
+// 转义后的最大字节数（含两侧引号）
+inline size_t MaxJsonStringSize(size_t size) { return size * 6 + 2; }
+
+// 把 text 写成 JSON 字符串（含两侧引号），返回写入后的位置；非法 UTF-8
+// 字节替换为 \ufffd。dst 至少有 MaxJsonStringSize(text.size()) 字节
+char* WriteJsonString(absl::string_view text, char* dst);
+
+// 追加到 fmt 缓冲区
+template<typename Buffer>
+void AppendJsonString(absl::string_view text, Buffer& out) {
+  size_t offset = out.size();
+  out.resize(offset + MaxJsonStringSize(text.size()));
+  char* end = WriteJsonString(text, out.data() + offset);
+  out.resize(static_cast<size_t>(end - out.data()));
+}
+
+// text 是否为合法 UTF-8
+bool IsValidUtf8(absl::string_view text);
+
+namespace internal {
+
+enum class SimdLevel : uint8_t {
+  kScalar = 0,
+  kSse2 = 1,
+  kAvx2 = 2,
+};
+
+// 当前 CPU 支持的最高实现
+SimdLevel DetectSimdLevel();
+
+// 指定实现，level 高于 DetectSimdLevel() 时行为未定义；供测试与基准对比
+char* WriteJsonString(absl::string_view text, char* dst, SimdLevel level);
+bool IsValidUtf8(absl::string_view text, SimdLevel level);
+
+}  // namespace internal
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_JSON_ESCAPE_H_
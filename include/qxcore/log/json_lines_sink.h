@@ -0,0 +1,61 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef QXCORE_LOG_JSON_LINES_SINK_H_
+#define QXCORE_LOG_JSON_LINES_SINK_H_
+
+#include <mutex>
+#include <string>
+#include <absl/status/status.h>
+#include <spdlog/common.h>
+#include <spdlog/details/file_helper.h>
+#include <spdlog/sinks/base_sink.h>
+#include "qxcore/log/structured.h"
+
+namespace qxcore {
+namespace log {
+
+// JSON Lines 文件 sink
+//
+// 每条记录写成一行 JSON 对象，忽略 pattern：
+//   {"ts":<Unix 纳秒>,"level":"info","logger":"trader","thread":123,
+//    "file":"a.cc","line":12,"msg":"order_ack","id":1,"px":101.25}
+// file/line 只在记录带源码位置时输出。结构化记录（见 structured.h）的字段
+// 按原始类型展开到顶层，msg 为事件名；普通记录的 msg 为消息文本。字符串按
+// JSON 转义，非法 UTF-8 字节替换为 \ufffd；非有限浮点数写成字符串。
+class JsonLinesSink : public spdlog::sinks::base_sink<std::mutex> {
+ public:
+  // buffer_size 为预留的格式化缓冲区字节数
+  explicit JsonLinesSink(size_t buffer_size = 8192);
+
+  // 打开输出文件
+  absl::Status open(const std::string& path, bool truncate = true);
+
+ protected:
+  void sink_it_(const spdlog::details::log_msg& msg) override;
+  void flush_() override;
+
+ private:
+  void append_field(const StructuredField& field);
+
+  spdlog::details::file_helper file_;
+  spdlog::memory_buf_t buffer_;
+  StructuredRecord record_;
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_JSON_LINES_SINK_H_
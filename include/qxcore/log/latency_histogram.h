@@ -0,0 +1,102 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_LATENCY_HISTOGRAM_H_
+#define QXCORE_LOG_LATENCY_HISTOGRAM_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <absl/numeric/bits.h>
+
+namespace qxcore {
+namespace log {
+
+// 延迟直方图，供基准测试和 qxlog_replay 统计分位数
+//
+// 按 2 的幂分段，每段再等分为 16 个子桶，相对误差不超过 1/16；小于 16 的
+// 值精确计数。单位由调用方决定（通常为 TscClock 计数），非线程安全，
+// 各线程分别记录后再合并。
+class LatencyHistogram {
+ public:
+  void record(uint64_t value) {
+    ++counts_[BucketOf(value)];
+    ++total_;
+  }
+
+  void merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < kBuckets; ++i) {
+      counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+  }
+
+  void clear() {
+    counts_.fill(0);
+    total_ = 0;
+  }
+
+  uint64_t count() const { return total_; }
+
+  // 分位 q（0 < q <= 1）所在桶的中点，没有样本时返回 0
+  double percentile(double q) const {
+    if (total_ == 0) {
+      return 0;
+    }
+    uint64_t rank = std::max<uint64_t>(
+        1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(total_))));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+      seen += counts_[i];
+      if (seen >= rank) {
+        return BucketMidpoint(i);
+      }
+    }
+    return BucketMidpoint(kBuckets - 1);
+  }
+
+ private:
+  static constexpr int kSubBits = 4;
+  static constexpr uint64_t kSubBuckets = uint64_t{1} << kSubBits;
+  static constexpr size_t kBuckets = (64 - kSubBits + 1) * kSubBuckets;
+
+  static size_t BucketOf(uint64_t value) {
+    if (value < kSubBuckets) {
+      return static_cast<size_t>(value);
+    }
+    int shift = absl::bit_width(value) - 1 - kSubBits;
+    return static_cast<size_t>((shift + 1) * kSubBuckets +
+                               ((value >> shift) & (kSubBuckets - 1)));
+  }
+
+  static double BucketMidpoint(size_t bucket) {
+    if (bucket < kSubBuckets) {
+      return static_cast<double>(bucket);
+    }
+    int shift = static_cast<int>(bucket / kSubBuckets) - 1;
+    double lower = std::ldexp(
+        static_cast<double>(kSubBuckets + bucket % kSubBuckets), shift);
+    return lower + std::ldexp(0.5, shift);
+  }
+
+  std::array<uint64_t, kBuckets> counts_{};
+  uint64_t total_ = 0;
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_LATENCY_HISTOGRAM_H_
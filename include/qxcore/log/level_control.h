@@ -0,0 +1,167 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_LEVEL_CONTROL_H_
+#define QXCORE_LOG_LEVEL_CONTROL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <absl/container/flat_hash_map.h>
+#include <absl/status/status.h>
+#include <absl/strings/string_view.h>
+#include "qxcore/log/callsite.h"
+#include "qxcore/log/log_level.h"
+
+namespace qxcore {
+namespace log {
+
+// 级别控制文件中的一条调用点规则
+struct CallsiteLevelRule {
+  std::string file;  // 路径后缀
+  int line = 0;      // 0 表示该文件中的全部调用点
+  bool has_level = false;  // 为 true 时按 level 设置，否则按 value
+  LogLevel level = LogLevel::kInfo;
+  CallsiteOverride value = CallsiteOverride::kNone;
+};
+
+// 解析后的级别控制文件
+struct LevelConfig {
+  bool has_global = false;
+  LogLevel global = LogLevel::kInfo;
+  std::vector<std::pair<std::string, LogLevel>> loggers;
+  std::vector<CallsiteLevelRule> callsites;
+};
+
+// 解析级别控制文件
+//
+// 每行一条 key = value，# 之后为注释：
+//   level = debug                     全局级别（已挂接的日志器和根日志器）
+//   logger.qx.md.feed = trace         命名日志器级别
+//   callsite.feed_handler.cc = debug  调用点级别，可带 :行号
+//   callsite.feed_handler.cc:42 = on  单独打开（on）、关闭（off）或跟随（default）
+// 出错时返回 InvalidArgument 并指出行号，config 内容不确定。
+absl::Status ParseLevelConfig(absl::string_view text, LevelConfig* config);
+
+// 级别控制线程的配置
+struct LevelControlOptions {
+  // 级别控制文件路径；非空时用 inotify 监视，文件写完或被替换后重新应用
+  std::string config_path;
+  // 处理 SIGUSR1（全局级别调详细一级）和 SIGUSR2（恢复配置的全局级别），
+  // 同一时刻只能有一个控制器处理信号
+  bool handle_signals = false;
+};
+
+// 运行期级别控制器
+//
+// 可选的后台线程等待控制文件变化或信号，把全局、命名日志器和调用点级别
+// 写入各自的原子变量；生产者仍然只做 relaxed 读取，不加锁也不感知控制器。
+// 控制文件是声明式的：每次重新应用时，上次设置过、本次不再出现的条目恢复
+// 原状（日志器恢复控制器首次修改之前的级别，命名日志器恢复控制器首次修改之前的显式
+// 级别或继承，调用点恢复跟随）。
+// 解析失败时保留已应用的级别，错误由 last_status 返回。
+class LevelController {
+ public:
+  LevelController() = default;
+  ~LevelController();
+
+  LevelController(const LevelController&) = delete;
+  LevelController& operator=(const LevelController&) = delete;
+
+  // 挂接受全局级别控制的日志器（Log<...> 或后端）。控制器首次修改其级别时
+  // 记录当时的级别作为恢复目标，恢复后清除；logger 必须在控制器停止之前
+  // 保持有效
+  template<typename Logger>
+  void attach(Logger* logger) {
+    add_target([logger](LogLevel level) { return logger->set_level(level); },
+               [logger] { return logger->get_level(); });
+  }
+
+  // 应用一次控制文件（存在时）并启动控制线程
+  absl::Status start(const LevelControlOptions& options);
+
+  // 停止控制线程并恢复原信号处理函数，已应用的级别保持不变
+  void stop();
+
+  // 立即读取并应用控制文件
+  absl::Status reload();
+
+  // 应用一份配置
+  absl::Status apply(const LevelConfig& config);
+
+  // 全局级别调详细一级（SIGUSR1）
+  void raise_verbosity();
+
+  // 恢复配置的全局级别（SIGUSR2）
+  void restore_verbosity();
+
+  // 最近一次重新应用的结果
+  absl::Status last_status() const;
+
+  // 控制线程已处理的事件数（文件变化和信号），供调用方等待生效
+  uint64_t handled_events() const {
+    return handled_events_.load(std::memory_order_acquire);
+  }
+
+ private:
+  struct Target {
+    std::function<absl::Status(LogLevel)> set_level;
+    std::function<LogLevel()> get_level;
+    // 控制器修改之前的级别，saved 为 false 时未被控制器修改
+    bool saved;
+    LogLevel saved_level;
+  };
+
+  void add_target(std::function<absl::Status(LogLevel)> set_level,
+                  std::function<LogLevel()> get_level);
+
+  // 调用方持有 mutex_
+  absl::Status apply_locked(const LevelConfig& config);
+  absl::Status set_global_locked(const LevelConfig& config);
+  void save_target_locked(Target& target);
+  void save_root_locked();
+
+  void run();
+
+  // 控制器首次修改命名日志器之前的显式级别
+  struct SavedLoggerLevel {
+    bool has_level;  // 为 false 时原本继承父节点
+    LogLevel level;
+  };
+
+  mutable std::mutex mutex_;
+  std::vector<Target> targets_;
+  LevelConfig applied_;
+  absl::flat_hash_map<std::string, SavedLoggerLevel> saved_loggers_;
+  bool root_saved_ = false;
+  LogLevel root_initial_ = LogLevel::kInfo;
+  absl::Status last_status_;
+
+  LevelControlOptions options_;
+  std::thread thread_;
+  int inotify_fd_ = -1;
+  int wake_fds_[2] = {-1, -1};
+  bool owns_signals_ = false;
+  std::atomic<uint64_t> handled_events_{0};
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_LEVEL_CONTROL_H_
@@ -17,9 +17,20 @@
 
 #include <string>
 #include <memory>
+#include <type_traits>
 #include <absl/strings/string_view.h>
 #include <absl/status/status.h>
+#include "qxcore/log/callsite.h"
+#include "qxcore/log/epoch.h"
+#include "qxcore/log/flight_recorder.h"
+#include "qxcore/log/format_string.h"
+#include "qxcore/log/log_context.h"
 #include "qxcore/log/log_level.h"
+#include "qxcore/log/log_options.h"
+#include "qxcore/log/logger_registry.h"
+#include "qxcore/log/rate_limit.h"
+#include "qxcore/log/structured.h"
+#include "qxcore/log/tsc_clock.h"
 
 namespace qxcore {
 namespace log {
@@ -34,18 +45,50 @@ class Log {
  public:
   // 构造函数
   Log() = default;
+
+  ~Log() {
+    if (recorder_ != nullptr) {
+      CallsiteRegistry::Global().remove_logger(this);
+    }
+  }
   
   // 禁用拷贝构造和赋值
   Log(const Log&) = delete;
   Log& operator=(const Log&) = delete;
   
-  // 移动构造和赋值
-  Log(Log&&) = default;
-  Log& operator=(Log&&) = default;
+  // 后端以地址注册到 CallsiteRegistry，禁用移动
+  Log(Log&&) = delete;
+  Log& operator=(Log&&) = delete;
 
   // 初始化日志系统
-  absl::Status init(const std::string& name, LogLevel level = LogLevel::kInfo) {
-    return backend_.init(name, level);
+  //
+  // 启用飞行记录器时，低于日志级别的调用也会进入记录器，调用点按 kTrace
+  // 注册，is_enabled 对所有级别返回 true
+  absl::Status init(const std::string& name, LogLevel level = LogLevel::kInfo,
+                    const LogOptions& options = LogOptions()) {
+    const FlightRecorderOptions& flight = options.flight_recorder;
+    if (flight.enabled()) {
+      absl::Status status = FlightRecorder::ValidateOptions(flight);
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    absl::Status status = backend_.init(name, level, options);
+    if (!status.ok() || !flight.enabled() || recorder_ != nullptr) {
+      return status;
+    }
+    auto recorder = std::make_unique<FlightRecorder>();
+    status = recorder->init(name, flight);
+    if (!status.ok()) {
+      backend_.shutdown();
+      return status;
+    }
+    if (flight.crash_handler) {
+      recorder->install_crash_handler(flight.crash_fd);
+    }
+    recorder_ = std::move(recorder);
+    CallsiteRegistry::Global().set_logger_level(this, LogLevel::kTrace);
+    return status;
   }
 
   // 设置日志级别
@@ -60,52 +103,125 @@ class Log {
 
   // 检查日志级别是否启用
   bool is_enabled(LogLevel level) const {
-    return backend_.is_enabled(level);
+    return recorder_ != nullptr || backend_.is_enabled(level);
   }
 
   // 基础日志接口
   void log(LogLevel level, absl::string_view msg) {
-    if (is_enabled(level)) {
-      backend_.log(level, msg);
+    if (recorder_ != nullptr) {
+      record_flight(level, RecordTime::Now(), backend_.is_enabled(level), msg);
     }
+    backend_.log(level, msg);
   }
 
   // 格式化日志接口
-  template<typename... Args>
-  void logf(LogLevel level, absl::string_view fmt_str, Args&&... args) {
-    if (is_enabled(level)) {
+  //
+  // fmt_str 使用 fmt 的 {} 语法。QXLOG_FMT("...") 包装的格式串在编译期
+  // 校验并预解析；普通字符串在运行期解析，出错时记录被丢弃。
+  //
+  // 参数全部为 kv() 字段时按结构化记录写出，fmt_str 为事件名：
+  //   logger.info("order_ack", kv("id", id), kv("px", px));
+  template<typename S, typename... Args>
+  void logf(LogLevel level, const S& fmt_str, Args&&... args) {
+    if constexpr (kIsStructured<Args...>) {
+      if (is_enabled(level)) {
+        log_structured(level, nullptr, FormatView(fmt_str), args...);
+      }
+    } else {
+      if (recorder_ != nullptr) {
+        record_flight(level, RecordTime::Now(), backend_.is_enabled(level),
+                      fmt_str, args...);
+      }
       backend_.logf(level, fmt_str, std::forward<Args>(args)...);
     }
   }
 
+  // 指定事件时间的格式化日志接口
+  //
+  // time 为调用方已知的 Unix 纳秒时间（如交易所或网卡硬件时间戳），记录
+  // 直接使用该时间，不读取时钟
+  template<typename S, typename... Args>
+  void logf(LogLevel level, EventTime time, const S& fmt_str, Args&&... args) {
+    static_assert(!kIsStructured<Args...>,
+                  "structured fields are not supported with EventTime");
+    if (recorder_ != nullptr) {
+      record_flight(level, RecordTime::Event(time), backend_.is_enabled(level),
+                    fmt_str, args...);
+    }
+    backend_.logf(level, time, fmt_str, std::forward<Args>(args)...);
+  }
+
+  // 调用点接口，供 QXLOG_* 宏使用：级别检查已由调用点完成，
+  // 源码位置随记录传给后端
+  template<typename S, typename... Args>
+  void logf(const Callsite& callsite, const S& fmt_str, Args&&... args) {
+    if constexpr (kIsStructured<Args...>) {
+      log_structured(callsite.level(), &callsite, FormatView(fmt_str), args...);
+    } else {
+      if (recorder_ != nullptr) {
+        // 调用点按 kTrace 注册，这里需要再按后端级别判断
+        bool written = backend_written(callsite);
+        record_flight(callsite.level(), RecordTime::Now(), written, fmt_str,
+                      args...);
+        if (!written) {
+          return;
+        }
+      }
+      backend_.logf(callsite, fmt_str, std::forward<Args>(args)...);
+    }
+  }
+
+  // 惰性日志接口：级别启用时才调用 fn 生成消息；启用飞行记录器时总会调用
+  template<typename Fn>
+  void log_lazy(LogLevel level, Fn&& fn) {
+    if (is_enabled(level)) {
+      log(level, std::forward<Fn>(fn)());
+    }
+  }
+
+  template<typename Fn>
+  void log_lazy(const Callsite& callsite, Fn&& fn) {
+    if (recorder_ != nullptr) {
+      auto&& msg = std::forward<Fn>(fn)();
+      bool written = backend_written(callsite);
+      record_flight(callsite.level(), RecordTime::Now(), written,
+                    absl::string_view(msg));
+      if (written) {
+        backend_.log(callsite, msg);
+      }
+      return;
+    }
+    backend_.log(callsite, std::forward<Fn>(fn)());
+  }
+
   // 便捷接口
-  template<typename... Args>
-  void trace(absl::string_view fmt_str, Args&&... args) {
+  template<typename S, typename... Args>
+  void trace(const S& fmt_str, Args&&... args) {
     logf(LogLevel::kTrace, fmt_str, std::forward<Args>(args)...);
   }
 
-  template<typename... Args>
-  void debug(absl::string_view fmt_str, Args&&... args) {
+  template<typename S, typename... Args>
+  void debug(const S& fmt_str, Args&&... args) {
     logf(LogLevel::kDebug, fmt_str, std::forward<Args>(args)...);
   }
 
-  template<typename... Args>
-  void info(absl::string_view fmt_str, Args&&... args) {
+  template<typename S, typename... Args>
+  void info(const S& fmt_str, Args&&... args) {
     logf(LogLevel::kInfo, fmt_str, std::forward<Args>(args)...);
   }
 
-  template<typename... Args>
-  void warn(absl::string_view fmt_str, Args&&... args) {
+  template<typename S, typename... Args>
+  void warn(const S& fmt_str, Args&&... args) {
     logf(LogLevel::kWarn, fmt_str, std::forward<Args>(args)...);
   }
 
-  template<typename... Args>
-  void error(absl::string_view fmt_str, Args&&... args) {
+  template<typename S, typename... Args>
+  void error(const S& fmt_str, Args&&... args) {
     logf(LogLevel::kError, fmt_str, std::forward<Args>(args)...);
   }
 
-  template<typename... Args>
-  void critical(absl::string_view fmt_str, Args&&... args) {
+  template<typename S, typename... Args>
+  void critical(const S& fmt_str, Args&&... args) {
     logf(LogLevel::kCritical, fmt_str, std::forward<Args>(args)...);
   }
 
@@ -116,11 +232,92 @@ class Log {
 
   // 关闭日志系统
   void shutdown() {
+    if (recorder_ != nullptr) {
+      CallsiteRegistry::Global().remove_logger(this);
+    }
     backend_.shutdown();
   }
 
+  // 把飞行记录器中尚未写出的记录按时间顺序补写到日志，返回补写的条数；
+  // 未启用飞行记录器时返回 0
+  size_t dump_flight_recorder() {
+    if (recorder_ == nullptr) {
+      return 0;
+    }
+    size_t count = recorder_->dump(
+        [this](LogLevel level, int64_t unix_nanos, absl::string_view msg) {
+          backend_.log_named(kNoLoggerId, level, nullptr,
+                             RecordTime::Event(EventTime(unix_nanos)), msg);
+        });
+    if (count != 0) {
+      backend_.flush();
+    }
+    return count;
+  }
+
+  // 飞行记录器，未启用时为 nullptr
+  FlightRecorder* flight_recorder() { return recorder_.get(); }
+
+  // 访问底层后端，用于后端特有的功能（如异步统计）
+  Backend& backend() { return backend_; }
+  const Backend& backend() const { return backend_; }
+
  private:
+  bool backend_written(const Callsite& callsite) const {
+    return callsite.state() == Callsite::kForced ||
+           backend_.is_enabled(callsite.level());
+  }
+
+  // 结构化记录：编码为结构化负载，后端不识别时先渲染为文本；级别检查
+  // 已由调用方完成。飞行记录器保存文本形式
+  template<typename... Fields>
+  void log_structured(LogLevel level, const Callsite* callsite,
+                      absl::string_view event, const Fields&... fields) {
+    absl::string_view msg;
+    try {
+      msg = internal::EncodeStructuredMessage(
+          !internal::kAcceptsStructured<Backend>, event, fields...);
+    } catch (...) {
+      // 静默处理日志错误，避免异常传播
+      return;
+    }
+    bool written = callsite != nullptr ? backend_written(*callsite)
+                                       : backend_.is_enabled(level);
+    if (recorder_ != nullptr) {
+      record_flight(level, RecordTime::Now(), written,
+                    StructuredPayloadText(msg));
+      if (!written) {
+        return;
+      }
+    }
+    if (callsite != nullptr) {
+      backend_.log(*callsite, msg);
+    } else {
+      backend_.log(level, msg);
+    }
+  }
+
+  // 写入飞行记录器；达到转储级别时先补写之前未写出的记录，再由调用方
+  // 正常写出本条
+  template<typename S, typename... Args>
+  void record_flight(LogLevel level, RecordTime time, bool written,
+                     const S& fmt_str, const Args&... args) {
+    try {
+      if constexpr (sizeof...(Args) == 0 && !kIsCompiledFormat<S>) {
+        recorder_->record_verbatim(level, time, written, FormatView(fmt_str));
+      } else {
+        recorder_->record(level, time, written, FormatView(fmt_str), args...);
+      }
+      if (recorder_->should_dump(level)) {
+        dump_flight_recorder();
+      }
+    } catch (...) {
+      // 静默处理日志错误，避免异常传播
+    }
+  }
+
   Backend backend_;
+  std::unique_ptr<FlightRecorder> recorder_;
 };
 
 }  // namespace log
@@ -149,28 +346,276 @@ namespace qxcore {
 namespace log {
 
 // 全局日志实例访问
+//
+// 读取为一次无锁的 acquire 加载。InitDefaultLogger 替换日志器后，旧实例在
+// 所有 EpochGuard 退出后释放；跨越替换持有引用时需要在 EpochGuard 内使用，
+// QXLOG_GLOBAL_* 宏会自动处理。
 DefaultLog& GetDefaultLogger();
 
-// 初始化全局日志器
-absl::Status InitDefaultLogger(const std::string& name, LogLevel level = LogLevel::kInfo);
+// 初始化（或替换）全局日志器
+absl::Status InitDefaultLogger(const std::string& name, LogLevel level = LogLevel::kInfo,
+                               const LogOptions& options = LogOptions());
 
 }  // namespace log
 }  // namespace qxcore
 
+// 编译期日志级别，与 LogLevel 的取值一致
+#define QXLOG_LEVEL_TRACE 0
+#define QXLOG_LEVEL_DEBUG 1
+#define QXLOG_LEVEL_INFO 2
+#define QXLOG_LEVEL_WARN 3
+#define QXLOG_LEVEL_ERROR 4
+#define QXLOG_LEVEL_CRITICAL 5
+#define QXLOG_LEVEL_OFF 6
+
+// 低于该级别的 QXLOG_* 调用在编译期移除，参数表达式不会被编译求值，
+// 由 CMake 选项 QXCORE_LOG_ACTIVE_LEVEL 设置
+#ifndef QXCORE_LOG_ACTIVE_LEVEL
+#define QXCORE_LOG_ACTIVE_LEVEL QXLOG_LEVEL_TRACE
+#endif
+
+// 每个调用点定义一个常量初始化的静态 Callsite，关闭时只有一次 relaxed 读取；
+// 先检查再求值日志器和参数，if/else 形式保证宏可以安全地用在不带花括号的 if 中
+#define QXLOG_CALL_(logger, level, format, method, ...)                    \
+  if (static ::qxcore::log::Callsite qxlog_callsite_(__FILE__, __LINE__,  \
+                                                     __func__, format,    \
+                                                     level);              \
+      !qxlog_callsite_.maybe_enabled<QXLOG_LOGGER_TYPE_(logger)>()) {      \
+  } else if (auto&& qxlog_logger_ = (logger);                              \
+             !qxlog_callsite_.should_log(qxlog_logger_)) {                 \
+  } else                                                                   \
+    qxlog_logger_.method(qxlog_callsite_, __VA_ARGS__)
+
+// 日志器表达式的类型，decltype 不求值表达式
+#define QXLOG_LOGGER_TYPE_(logger) ::std::decay_t<decltype(logger)>
+
+#define QXLOG_NOOP_() static_cast<void>(0)
+
+// 把宏参数中的格式串（第一个参数）包装为 QXLOG_FMT，其余参数原样保留；
+// 通过参数计数区分是否带格式参数，最多支持 31 个格式参数
+#define QXLOG_EXPAND_(x) x
+#define QXLOG_CAT_(a, b) QXLOG_CAT_IMPL_(a, b)
+#define QXLOG_CAT_IMPL_(a, b) a##b
+#define QXLOG_SELECT_ARITY_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11,   \
+                            _12, _13, _14, _15, _16, _17, _18, _19, _20,    \
+                            _21, _22, _23, _24, _25, _26, _27, _28, _29,    \
+                            _30, _31, _32, arity, ...)                      \
+  arity
+#define QXLOG_FMT_ARITY_(...)                                               \
+  QXLOG_EXPAND_(QXLOG_SELECT_ARITY_(__VA_ARGS__, N, N, N, N, N, N, N, N, N, \
+                                    N, N, N, N, N, N, N, N, N, N, N, N, N,  \
+                                    N, N, N, N, N, N, N, N, N, 1, unused))
+#define QXLOG_FMT_ARGS_(...) \
+  QXLOG_EXPAND_(QXLOG_CAT_(QXLOG_FMT_ARGS_, QXLOG_FMT_ARITY_(__VA_ARGS__))(__VA_ARGS__))
+#define QXLOG_FMT_HEAD_(...) QXLOG_EXPAND_(QXLOG_FMT_HEAD_IMPL_(__VA_ARGS__, unused))
+#define QXLOG_FMT_HEAD_IMPL_(format, ...) format
+#define QXLOG_FMT_ARGS_1(format) QXLOG_FMT(format)
+#define QXLOG_FMT_ARGS_N(format, ...) QXLOG_FMT(format), __VA_ARGS__
+
+// 全局日志宏：在 epoch 临界区内访问全局日志器，可与 InitDefaultLogger 并发
+#define QXLOG_GLOBAL_CALL_(macro, ...)                              \
+  do {                                                              \
+    ::qxcore::log::EpochGuard qxlog_epoch_guard_;                   \
+    macro(::qxcore::log::GetDefaultLogger(), __VA_ARGS__);          \
+  } while (0)
+
+// 限流调用点：在级别检查通过后再询问调用点自己的静态限流器，被限流的调用
+// 不求值参数也不格式化；放行时若此前有被丢弃的调用，在消息末尾追加
+// " [suppressed N]"
+#define QXLOG_LIMITED_CALL_(logger, level, limiter, limiter_args, ...)       \
+  if (static ::qxcore::log::Callsite qxlog_callsite_(                       \
+          __FILE__, __LINE__, __func__, QXLOG_FMT_HEAD_(__VA_ARGS__),       \
+          level);                                                           \
+      !qxlog_callsite_.maybe_enabled<QXLOG_LOGGER_TYPE_(logger)>()) {       \
+  } else if (auto&& qxlog_logger_ = (logger);                               \
+             !qxlog_callsite_.should_log(qxlog_logger_)) {                  \
+  } else if (static ::qxcore::log::limiter qxlog_limiter_ limiter_args;     \
+             false) {                                                       \
+  } else if (::qxcore::log::RatePermit qxlog_permit_ =                      \
+                 qxlog_limiter_.acquire();                                  \
+             !qxlog_permit_) {                                              \
+  } else if (qxlog_permit_.suppressed == 0)                                 \
+    qxlog_logger_.logf(qxlog_callsite_, QXLOG_FMT_ARGS_(__VA_ARGS__));      \
+  else                                                                      \
+    qxlog_logger_.logf(qxlog_callsite_,                                     \
+                       QXLOG_FMT_SUPPRESSED_(qxlog_permit_.suppressed,      \
+                                             __VA_ARGS__))
+
+// 与 QXLOG_FMT_ARGS_ 相同，但在格式串末尾追加被丢弃次数
+#define QXLOG_FMT_SUPPRESSED_(count, ...)                                  \
+  QXLOG_EXPAND_(QXLOG_CAT_(QXLOG_FMT_SUPPRESSED_,                          \
+                           QXLOG_FMT_ARITY_(__VA_ARGS__))(count, __VA_ARGS__))
+#define QXLOG_FMT_SUPPRESSED_1(count, format) \
+  QXLOG_FMT(format " [suppressed {}]"), count
+#define QXLOG_FMT_SUPPRESSED_N(count, format, ...) \
+  QXLOG_FMT(format " [suppressed {}]"), __VA_ARGS__, count
+
 // 日志宏定义
-#define QXLOG_TRACE(logger, ...) logger.trace(__VA_ARGS__)
-#define QXLOG_DEBUG(logger, ...) logger.debug(__VA_ARGS__)
-#define QXLOG_INFO(logger, ...)  logger.info(__VA_ARGS__)
-#define QXLOG_WARN(logger, ...)  logger.warn(__VA_ARGS__)
-#define QXLOG_ERROR(logger, ...) logger.error(__VA_ARGS__)
-#define QXLOG_CRITICAL(logger, ...) logger.critical(__VA_ARGS__)
-
-// 全局日志宏
-#define QXLOG_GLOBAL_TRACE(...) QXLOG_TRACE(qxcore::log::GetDefaultLogger(), __VA_ARGS__)
-#define QXLOG_GLOBAL_DEBUG(...) QXLOG_DEBUG(qxcore::log::GetDefaultLogger(), __VA_ARGS__)
-#define QXLOG_GLOBAL_INFO(...)  QXLOG_INFO(qxcore::log::GetDefaultLogger(), __VA_ARGS__)
-#define QXLOG_GLOBAL_WARN(...)  QXLOG_WARN(qxcore::log::GetDefaultLogger(), __VA_ARGS__)
-#define QXLOG_GLOBAL_ERROR(...) QXLOG_ERROR(qxcore::log::GetDefaultLogger(), __VA_ARGS__)
-#define QXLOG_GLOBAL_CRITICAL(...) QXLOG_CRITICAL(qxcore::log::GetDefaultLogger(), __VA_ARGS__)
+//
+// QXLOG_<LEVEL>(logger, fmt, args...)  级别启用时才求值参数；fmt 必须是字面量，
+//                                      在编译期按参数类型校验
+// QXLOG_<LEVEL>_FN(logger, fn)         级别启用时才调用 fn，fn 返回消息文本
+//
+// 限流变体，限流状态按调用点保存在静态原子变量中，fmt 中不能使用显式参数序号：
+// QXLOG_<LEVEL>_EVERY_N(logger, n, fmt, args...)    每 n 次记录一次
+// QXLOG_<LEVEL>_FIRST_N(logger, n, fmt, args...)    只记录前 n 次
+// QXLOG_<LEVEL>_EVERY_MS(logger, ms, fmt, args...)  每 ms 毫秒最多记录一次
+// QXLOG_<LEVEL>_RATE_LIMITED(logger, per_second, burst, fmt, args...)
+//                                      令牌桶，平均每秒 per_second 条，突发 burst 条
+#if QXCORE_LOG_ACTIVE_LEVEL <= QXLOG_LEVEL_TRACE
+#define QXLOG_TRACE(logger, ...) \
+  QXLOG_CALL_(logger, ::qxcore::log::LogLevel::kTrace, \
+              QXLOG_FMT_HEAD_(__VA_ARGS__), logf, QXLOG_FMT_ARGS_(__VA_ARGS__))
+#define QXLOG_TRACE_FN(logger, fn) \
+  QXLOG_CALL_(logger, ::qxcore::log::LogLevel::kTrace, nullptr, log_lazy, fn)
+#define QXLOG_GLOBAL_TRACE(...) QXLOG_GLOBAL_CALL_(QXLOG_TRACE, __VA_ARGS__)
+#define QXLOG_TRACE_EVERY_N(logger, n, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kTrace, EveryNLimiter, (n), __VA_ARGS__)
+#define QXLOG_TRACE_FIRST_N(logger, n, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kTrace, FirstNLimiter, (n), __VA_ARGS__)
+#define QXLOG_TRACE_EVERY_MS(logger, ms, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kTrace, EveryMsLimiter, (ms), __VA_ARGS__)
+#define QXLOG_TRACE_RATE_LIMITED(logger, per_second, burst, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kTrace, TokenBucketLimiter, \
+                      (per_second, burst), __VA_ARGS__)
+#else
+#define QXLOG_TRACE(logger, ...) QXLOG_NOOP_()
+#define QXLOG_TRACE_FN(logger, fn) QXLOG_NOOP_()
+#define QXLOG_GLOBAL_TRACE(...) QXLOG_NOOP_()
+#define QXLOG_TRACE_EVERY_N(logger, n, ...) QXLOG_NOOP_()
+#define QXLOG_TRACE_FIRST_N(logger, n, ...) QXLOG_NOOP_()
+#define QXLOG_TRACE_EVERY_MS(logger, ms, ...) QXLOG_NOOP_()
+#define QXLOG_TRACE_RATE_LIMITED(logger, per_second, burst, ...) QXLOG_NOOP_()
+#endif
+
+#if QXCORE_LOG_ACTIVE_LEVEL <= QXLOG_LEVEL_DEBUG
+#define QXLOG_DEBUG(logger, ...) \
+  QXLOG_CALL_(logger, ::qxcore::log::LogLevel::kDebug, \
+              QXLOG_FMT_HEAD_(__VA_ARGS__), logf, QXLOG_FMT_ARGS_(__VA_ARGS__))
+#define QXLOG_DEBUG_FN(logger, fn) \
+  QXLOG_CALL_(logger, ::qxcore::log::LogLevel::kDebug, nullptr, log_lazy, fn)
+#define QXLOG_GLOBAL_DEBUG(...) QXLOG_GLOBAL_CALL_(QXLOG_DEBUG, __VA_ARGS__)
+#define QXLOG_DEBUG_EVERY_N(logger, n, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kDebug, EveryNLimiter, (n), __VA_ARGS__)
+#define QXLOG_DEBUG_FIRST_N(logger, n, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kDebug, FirstNLimiter, (n), __VA_ARGS__)
+#define QXLOG_DEBUG_EVERY_MS(logger, ms, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kDebug, EveryMsLimiter, (ms), __VA_ARGS__)
+#define QXLOG_DEBUG_RATE_LIMITED(logger, per_second, burst, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kDebug, TokenBucketLimiter, \
+                      (per_second, burst), __VA_ARGS__)
+#else
+#define QXLOG_DEBUG(logger, ...) QXLOG_NOOP_()
+#define QXLOG_DEBUG_FN(logger, fn) QXLOG_NOOP_()
+#define QXLOG_GLOBAL_DEBUG(...) QXLOG_NOOP_()
+#define QXLOG_DEBUG_EVERY_N(logger, n, ...) QXLOG_NOOP_()
+#define QXLOG_DEBUG_FIRST_N(logger, n, ...) QXLOG_NOOP_()
+#define QXLOG_DEBUG_EVERY_MS(logger, ms, ...) QXLOG_NOOP_()
+#define QXLOG_DEBUG_RATE_LIMITED(logger, per_second, burst, ...) QXLOG_NOOP_()
+#endif
+
+#if QXCORE_LOG_ACTIVE_LEVEL <= QXLOG_LEVEL_INFO
+#define QXLOG_INFO(logger, ...) \
+  QXLOG_CALL_(logger, ::qxcore::log::LogLevel::kInfo, \
+              QXLOG_FMT_HEAD_(__VA_ARGS__), logf, QXLOG_FMT_ARGS_(__VA_ARGS__))
+#define QXLOG_INFO_FN(logger, fn) \
+  QXLOG_CALL_(logger, ::qxcore::log::LogLevel::kInfo, nullptr, log_lazy, fn)
+#define QXLOG_GLOBAL_INFO(...) QXLOG_GLOBAL_CALL_(QXLOG_INFO, __VA_ARGS__)
+#define QXLOG_INFO_EVERY_N(logger, n, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kInfo, EveryNLimiter, (n), __VA_ARGS__)
+#define QXLOG_INFO_FIRST_N(logger, n, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kInfo, FirstNLimiter, (n), __VA_ARGS__)
+#define QXLOG_INFO_EVERY_MS(logger, ms, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kInfo, EveryMsLimiter, (ms), __VA_ARGS__)
+#define QXLOG_INFO_RATE_LIMITED(logger, per_second, burst, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kInfo, TokenBucketLimiter, \
+                      (per_second, burst), __VA_ARGS__)
+#else
+#define QXLOG_INFO(logger, ...) QXLOG_NOOP_()
+#define QXLOG_INFO_FN(logger, fn) QXLOG_NOOP_()
+#define QXLOG_GLOBAL_INFO(...) QXLOG_NOOP_()
+#define QXLOG_INFO_EVERY_N(logger, n, ...) QXLOG_NOOP_()
+#define QXLOG_INFO_FIRST_N(logger, n, ...) QXLOG_NOOP_()
+#define QXLOG_INFO_EVERY_MS(logger, ms, ...) QXLOG_NOOP_()
+#define QXLOG_INFO_RATE_LIMITED(logger, per_second, burst, ...) QXLOG_NOOP_()
+#endif
+
+#if QXCORE_LOG_ACTIVE_LEVEL <= QXLOG_LEVEL_WARN
+#define QXLOG_WARN(logger, ...) \
+  QXLOG_CALL_(logger, ::qxcore::log::LogLevel::kWarn, \
+              QXLOG_FMT_HEAD_(__VA_ARGS__), logf, QXLOG_FMT_ARGS_(__VA_ARGS__))
+#define QXLOG_WARN_FN(logger, fn) \
+  QXLOG_CALL_(logger, ::qxcore::log::LogLevel::kWarn, nullptr, log_lazy, fn)
+#define QXLOG_GLOBAL_WARN(...) QXLOG_GLOBAL_CALL_(QXLOG_WARN, __VA_ARGS__)
+#define QXLOG_WARN_EVERY_N(logger, n, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kWarn, EveryNLimiter, (n), __VA_ARGS__)
+#define QXLOG_WARN_FIRST_N(logger, n, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kWarn, FirstNLimiter, (n), __VA_ARGS__)
+#define QXLOG_WARN_EVERY_MS(logger, ms, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kWarn, EveryMsLimiter, (ms), __VA_ARGS__)
+#define QXLOG_WARN_RATE_LIMITED(logger, per_second, burst, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kWarn, TokenBucketLimiter, \
+                      (per_second, burst), __VA_ARGS__)
+#else
+#define QXLOG_WARN(logger, ...) QXLOG_NOOP_()
+#define QXLOG_WARN_FN(logger, fn) QXLOG_NOOP_()
+#define QXLOG_GLOBAL_WARN(...) QXLOG_NOOP_()
+#define QXLOG_WARN_EVERY_N(logger, n, ...) QXLOG_NOOP_()
+#define QXLOG_WARN_FIRST_N(logger, n, ...) QXLOG_NOOP_()
+#define QXLOG_WARN_EVERY_MS(logger, ms, ...) QXLOG_NOOP_()
+#define QXLOG_WARN_RATE_LIMITED(logger, per_second, burst, ...) QXLOG_NOOP_()
+#endif
+
+#if QXCORE_LOG_ACTIVE_LEVEL <= QXLOG_LEVEL_ERROR
+#define QXLOG_ERROR(logger, ...) \
+  QXLOG_CALL_(logger, ::qxcore::log::LogLevel::kError, \
+              QXLOG_FMT_HEAD_(__VA_ARGS__), logf, QXLOG_FMT_ARGS_(__VA_ARGS__))
+#define QXLOG_ERROR_FN(logger, fn) \
+  QXLOG_CALL_(logger, ::qxcore::log::LogLevel::kError, nullptr, log_lazy, fn)
+#define QXLOG_GLOBAL_ERROR(...) QXLOG_GLOBAL_CALL_(QXLOG_ERROR, __VA_ARGS__)
+#define QXLOG_ERROR_EVERY_N(logger, n, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kError, EveryNLimiter, (n), __VA_ARGS__)
+#define QXLOG_ERROR_FIRST_N(logger, n, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kError, FirstNLimiter, (n), __VA_ARGS__)
+#define QXLOG_ERROR_EVERY_MS(logger, ms, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kError, EveryMsLimiter, (ms), __VA_ARGS__)
+#define QXLOG_ERROR_RATE_LIMITED(logger, per_second, burst, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kError, TokenBucketLimiter, \
+                      (per_second, burst), __VA_ARGS__)
+#else
+#define QXLOG_ERROR(logger, ...) QXLOG_NOOP_()
+#define QXLOG_ERROR_FN(logger, fn) QXLOG_NOOP_()
+#define QXLOG_GLOBAL_ERROR(...) QXLOG_NOOP_()
+#define QXLOG_ERROR_EVERY_N(logger, n, ...) QXLOG_NOOP_()
+#define QXLOG_ERROR_FIRST_N(logger, n, ...) QXLOG_NOOP_()
+#define QXLOG_ERROR_EVERY_MS(logger, ms, ...) QXLOG_NOOP_()
+#define QXLOG_ERROR_RATE_LIMITED(logger, per_second, burst, ...) QXLOG_NOOP_()
+#endif
+
+#if QXCORE_LOG_ACTIVE_LEVEL <= QXLOG_LEVEL_CRITICAL
+#define QXLOG_CRITICAL(logger, ...) \
+  QXLOG_CALL_(logger, ::qxcore::log::LogLevel::kCritical, \
+              QXLOG_FMT_HEAD_(__VA_ARGS__), logf, QXLOG_FMT_ARGS_(__VA_ARGS__))
+#define QXLOG_CRITICAL_FN(logger, fn) \
+  QXLOG_CALL_(logger, ::qxcore::log::LogLevel::kCritical, nullptr, log_lazy, fn)
+#define QXLOG_GLOBAL_CRITICAL(...) QXLOG_GLOBAL_CALL_(QXLOG_CRITICAL, __VA_ARGS__)
+#define QXLOG_CRITICAL_EVERY_N(logger, n, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kCritical, EveryNLimiter, (n), __VA_ARGS__)
+#define QXLOG_CRITICAL_FIRST_N(logger, n, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kCritical, FirstNLimiter, (n), __VA_ARGS__)
+#define QXLOG_CRITICAL_EVERY_MS(logger, ms, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kCritical, EveryMsLimiter, (ms), __VA_ARGS__)
+#define QXLOG_CRITICAL_RATE_LIMITED(logger, per_second, burst, ...) \
+  QXLOG_LIMITED_CALL_(logger, ::qxcore::log::LogLevel::kCritical, TokenBucketLimiter, \
+                      (per_second, burst), __VA_ARGS__)
+#else
+#define QXLOG_CRITICAL(logger, ...) QXLOG_NOOP_()
+#define QXLOG_CRITICAL_FN(logger, fn) QXLOG_NOOP_()
+#define QXLOG_GLOBAL_CRITICAL(...) QXLOG_NOOP_()
+#define QXLOG_CRITICAL_EVERY_N(logger, n, ...) QXLOG_NOOP_()
+#define QXLOG_CRITICAL_FIRST_N(logger, n, ...) QXLOG_NOOP_()
+#define QXLOG_CRITICAL_EVERY_MS(logger, ms, ...) QXLOG_NOOP_()
+#define QXLOG_CRITICAL_RATE_LIMITED(logger, per_second, burst, ...) QXLOG_NOOP_()
+#endif
 
 #endif  // QXCORE_LOG_LOG_H_
@@ -0,0 +1,117 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef QXCORE_LOG_LOG_CONTEXT_H_
+#define QXCORE_LOG_LOG_CONTEXT_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <absl/strings/string_view.h>
+#include "qxcore/log/structured.h"
+
+namespace qxcore {
+namespace log {
+
+namespace internal {
+
+// 线程本地的上下文栈
+struct LogContextState {
+  std::string text;             // 全部层渲染后的文本，层之间以空格分隔
+  std::vector<uint32_t> marks;  // 每层压栈前 text 的长度
+
+  // 写线程派发记录期间指向记录携带的上下文
+  bool has_record = false;
+  absl::string_view record;
+};
+
+inline LogContextState& ThreadLogContext() {
+  thread_local LogContextState state;
+  return state;
+}
+
+// 把结构化负载（见 structured.h）中的字段渲染为新的一层
+void PushLogContext(absl::string_view payload);
+
+void PopLogContext();
+
+// 正在格式化的记录的上下文：写线程上为记录携带的上下文，否则为当前线程的
+inline absl::string_view RecordLogContext() {
+  const LogContextState& state = ThreadLogContext();
+  return state.has_record ? state.record : absl::string_view(state.text);
+}
+
+// 写线程派发一条记录期间，把 RecordLogContext 切换为该记录携带的上下文
+class RecordContextScope {
+ public:
+  explicit RecordContextScope(absl::string_view context)
+      : state_(ThreadLogContext()),
+        saved_has_record_(state_.has_record),
+        saved_record_(state_.record) {
+    state_.has_record = true;
+    state_.record = context;
+  }
+
+  ~RecordContextScope() {
+    state_.has_record = saved_has_record_;
+    state_.record = saved_record_;
+  }
+
+  RecordContextScope(const RecordContextScope&) = delete;
+  RecordContextScope& operator=(const RecordContextScope&) = delete;
+
+ private:
+  LogContextState& state_;
+  bool saved_has_record_;
+  absl::string_view saved_record_;
+};
+
+}  // namespace internal
+
+// 当前线程的日志上下文文本 "键=值 ..."，没有上下文时为空
+inline absl::string_view CurrentLogContext() {
+  return internal::ThreadLogContext().text;
+}
+
+// 作用域内的日志上下文（MDC）
+//
+// 构造时把键值对按结构化字段的文本格式渲染一次并压入当前线程的上下文栈，
+// 析构时弹出；pattern 中的 %& 按字节拷贝整个栈的文本，不再逐条格式化：
+//
+//   ScopedLogContext context(kv("strategy", id), kv("account", account));
+//   QXLOG_INFO(logger, "order sent");  // pattern "%& %v" 输出
+//                                      // "strategy=7 account=A1 order sent"
+//
+// 异步与延迟格式化模式下，上下文在调用线程上随记录一起复制给写线程。
+// 对象必须在创建它的线程上按后进先出的顺序销毁。
+class ScopedLogContext {
+ public:
+  template<typename... Fields>
+  explicit ScopedLogContext(const KeyValue<Fields>&... fields) {
+    static_assert(sizeof...(Fields) > 0, "log context needs at least one field");
+    internal::PushLogContext(
+        internal::EncodeStructuredMessage(false, absl::string_view(), fields...));
+  }
+
+  ~ScopedLogContext() { internal::PopLogContext(); }
+
+  ScopedLogContext(const ScopedLogContext&) = delete;
+  ScopedLogContext& operator=(const ScopedLogContext&) = delete;
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_LOG_CONTEXT_H_
@@ -0,0 +1,254 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_LOG_OPTIONS_H_
+#define QXCORE_LOG_LOG_OPTIONS_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "qxcore/log/log_level.h"
+
+namespace qxcore {
+namespace log {
+
+// 默认文本日志格式（spdlog 标志语法）
+inline constexpr char kDefaultLogPattern[] =
+    "[%Y-%m-%d %H:%M:%S.%e] [%n] [%^%l%$] %v";
+
+// 日志工作模式
+enum class LogMode {
+  kSync = 0,   // 在调用线程上格式化并写出
+  kAsync = 1,  // 调用线程格式化后入队，由后台写线程写出
+  kDeferred = 2,  // 调用线程只编码原始参数，格式化与写出都在后台写线程
+};
+
+// 日志输出目标
+enum class LogOutput {
+  kConsoleAndFile = 0,  // 控制台与 <name>.log（或 binary_log_path）
+  kNull = 1,            // 丢弃全部记录，用于单独测量前端开销
+};
+
+// 异步队列满时的处理策略
+enum class OverflowPolicy {
+  kBlock = 0,       // 阻塞生产者直到队列有空位
+  kDropNewest = 1,  // 丢弃当前要写入的记录
+  kDropOldest = 2,  // 丢弃队列中最旧的记录
+};
+
+// 异步模式配置
+struct AsyncOptions {
+  // 队列容量（记录条数），会向上取整为 2 的幂
+  size_t queue_capacity = 8192;
+
+  // 每个队列槽位内联保存的消息字节数，超出部分退化为堆分配
+  size_t inline_message_size = 256;
+
+  // kDeferred 模式下每个生产者线程的缓冲区字节数，会向上取整为 2 的幂；
+  // 编码后超过其 1/4 的单条记录退回同步写出
+  size_t thread_buffer_size = 1 << 20;
+
+  // 队列满时的处理策略；kDeferred 模式下 kDropOldest 按 kDropNewest 处理
+  OverflowPolicy overflow_policy = OverflowPolicy::kBlock;
+
+  // 不低于 bypass_level 的记录绕过队列，在调用线程上直接写出
+  bool bypass_enabled = true;
+  LogLevel bypass_level = LogLevel::kError;
+};
+
+// 文本日志文件轮转配置
+//
+// max_file_size、interval_seconds 与 session_boundaries 都未设置时不轮转，
+// 每次启动截断 <name>.log；设置任一项后启动时保留上次的文件（见
+// rotating_file_sink.h）。
+struct RotationOptions {
+  // 单个文件的字节上限，0 表示不按大小轮转
+  size_t max_file_size = 0;
+
+  // 按本地零点对齐的轮转间隔秒数（如 3600、86400），须整除一天；0 表示不按
+  // 时间间隔轮转
+  int interval_seconds = 0;
+
+  // 交易时段边界，"HH:MM" 格式的本地时间，到达时轮转，如 {"08:45", "15:30"}
+  std::vector<std::string> session_boundaries;
+
+  // 时间间隔、时段边界和归档文件名使用的时区（IANA 名称）
+  std::string time_zone = "localtime";
+
+  // 新文件用 fallocate 预分配的字节数，0 时取 max_file_size
+  size_t preallocate_size = 0;
+
+  // 归档文件的总字节预算，超出时从最旧的开始删除；0 表示不清理
+  size_t max_total_size = 0;
+
+  bool enabled() const {
+    return max_file_size != 0 || interval_seconds != 0 ||
+           !session_boundaries.empty();
+  }
+};
+
+// 控制台输出配置
+struct ConsoleOptions {
+  // 控制台的级别阈值，低于该级别的记录只写入其他输出
+  LogLevel level = LogLevel::kTrace;
+
+  // 启用后控制台由独立线程写出（见 console_sink.h 中的 NonBlockingConsoleSink），
+  // 日志调用只把格式化后的文本放入缓冲区；缓冲区满时丢弃并计数，stdout 阻塞
+  // 不会拖慢日志调用。优先于 group_commit 的控制台批量提交
+  bool non_blocking = false;
+
+  // 非阻塞模式下待写出文本的缓冲区字节数
+  size_t buffer_size = 1 << 20;
+};
+
+// 批量提交配置（见 group_commit_sink.h）
+struct GroupCommitOptions {
+  // 启用后控制台与文本文件输出改为批量提交，不能与 rotation、
+  // mmap_segment_size 同时使用
+  bool enabled = false;
+
+  // 一批累积的字节上限，达到后立即提交；取值 [4KB, 64MB]
+  size_t max_batch_bytes = 256 * 1024;
+
+  // 写线程连续写出时一批最长的累积微秒数；队列排空时不等待直接提交
+  int max_batch_delay_us = 1000;
+
+  // 内核支持时文件输出经 io_uring 提交，写线程无需等待写入完成；
+  // 不支持时退回 writev
+  bool use_io_uring = true;
+};
+
+// 连续重复记录折叠配置（见 dedup_filter.h）
+struct DedupOptions {
+  // 启用后经 QXLOG_* 宏写出的记录与上一条记录的调用点、日志器和参数都相同时
+  // 只计数不写出，重复段结束时写出一条汇总
+  bool enabled = false;
+
+  // 一个重复段从首条记录起的最长毫秒数，到期后写出汇总并重新开始；
+  // 取值 [1, 3600000]
+  int window_ms = 1000;
+};
+
+// 共享内存传输配置（见 shm_backend.h）
+struct ShmOptions {
+  // 段文件所在目录，qxlogd 扫描同一目录
+  std::string directory = "/dev/shm/qxlog";
+
+  // 每个线程环的字节数，会向上取整为 2 的幂，最小 64KB；编码后超过其 1/4
+  // 的单条记录被丢弃
+  size_t ring_size = 1 << 20;
+
+  // 同时写日志的线程数上限，取值 [1, 1024]；线程退出后其环可被新线程复用
+  size_t max_threads = 64;
+
+  // 格式串、调用点和日志器名字典的字节数，写满后新格式串在调用线程上
+  // 格式化为文本传输
+  size_t dictionary_size = 1 << 20;
+
+  // 环满时的处理策略：kDropNewest 丢弃当前记录；kBlock 在 qxlogd 在线时
+  // 等待空位，离线时丢弃。不支持 kDropOldest
+  OverflowPolicy overflow_policy = OverflowPolicy::kDropNewest;
+
+  // flush 等待 qxlogd 写出并刷新的最长毫秒数
+  int flush_timeout_ms = 1000;
+};
+
+// 飞行记录器配置（见 flight_recorder.h）
+struct FlightRecorderOptions {
+  // 每个线程保留的最近记录条数，0 表示不启用
+  size_t records_per_thread = 0;
+
+  // 单条记录的槽位字节数（含 32 字节头），须为 8 的倍数且在 [64, 4096]
+  // 之间；参数编码后放不下的记录只保留格式串
+  size_t record_size = 256;
+
+  // 最多记录的线程数，之后创建的线程不记录，取值 [1, 512]
+  size_t max_threads = 64;
+
+  // 出现不低于 dump_level 的记录时，把之前未写出的记录补写到日志
+  bool dump_on_error = true;
+  LogLevel dump_level = LogLevel::kError;
+
+  // 非空时记录区映射到该文件（如 /dev/shm/app.flight），进程被强制结束后
+  // 仍可用 qxlog_flight 读取
+  std::string shm_path;
+
+  // 为致命信号安装处理函数，崩溃时把全部记录写到 crash_fd
+  bool crash_handler = false;
+  int crash_fd = 2;
+
+  bool enabled() const { return records_per_thread != 0; }
+};
+
+// 日志器初始化选项
+struct LogOptions {
+  LogMode mode = LogMode::kSync;
+  AsyncOptions async;
+
+  // 输出目标；kNull 时不创建任何文件，binary_log_path 与 pattern 不生效
+  LogOutput output = LogOutput::kConsoleAndFile;
+
+  // 控制台输出配置；glog 后端忽略
+  ConsoleOptions console;
+
+  // 文件输出（文本或二进制）的级别阈值；glog 后端忽略
+  LogLevel file_level = LogLevel::kTrace;
+
+  // 非空时文件输出改为二进制格式（见 binary_log.h），可用 qxlog_decode 还原为文本
+  std::string binary_log_path;
+
+  // 非空时另外把每条记录以 JSON Lines 写入该文件（见 json_lines_sink.h），
+  // 结构化字段保持原始类型；glog 后端忽略
+  std::string json_lines_path;
+
+  // JSON Lines 输出的级别阈值
+  LogLevel json_lines_level = LogLevel::kTrace;
+
+  // 文本日志文件的轮转配置；binary_log_path 非空时不生效，glog 后端忽略
+  RotationOptions rotation;
+
+  // 非零时文本文件输出改为按该字节数切分的内存映射分段（见 mmap_file_sink.h），
+  // 不能与 rotation 同时使用；binary_log_path 非空时不生效，glog 后端忽略
+  size_t mmap_segment_size = 0;
+
+  // 控制台与文本文件输出的批量提交配置；glog 后端忽略
+  GroupCommitOptions group_commit;
+
+  // 连续重复记录的折叠配置；glog 后端忽略
+  DedupOptions dedup;
+
+  // 每个 sink 预留的格式化缓冲区字节数，格式化后不超过该长度的记录写出时
+  // 不分配内存
+  size_t sink_buffer_size = 8192;
+
+  // 文本输出格式，支持的标志见 pattern_formatter.h，含其他标志时按 spdlog
+  // 原生格式处理；glog 后端使用 glog 自身的格式，忽略该选项
+  std::string pattern = kDefaultLogPattern;
+
+  // 非空时把每次日志调用的形状（调用点、级别、参数类型与长度、线程、到达
+  // 间隔）写入该文件，供 qxlog_replay 回放；采集会串行化日志调用，只用于
+  // 诊断。glog 后端忽略该选项
+  std::string capture_path;
+
+  // ShmBackend 的共享内存传输配置，其他后端忽略
+  ShmOptions shm;
+
+  // 飞行记录器配置；只记录经 Log 对象的调用，glog 后端同样支持
+  FlightRecorderOptions flight_recorder;
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_LOG_OPTIONS_H_
@@ -0,0 +1,153 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef QXCORE_LOG_LOGGER_REGISTRY_H_
+#define QXCORE_LOG_LOGGER_REGISTRY_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <absl/container/flat_hash_map.h>
+#include <absl/status/status.h>
+#include <absl/strings/string_view.h>
+#include "qxcore/log/log_level.h"
+
+namespace qxcore {
+namespace log {
+
+// 命名日志器 ID：注册表内的稳定下标，进程内不会复用
+using LoggerId = uint32_t;
+
+// 不对应任何命名日志器，后端使用自身名字写出
+constexpr LoggerId kNoLoggerId = 0xffffffffu;
+
+// 根节点（名字为空），所有命名日志器最终继承它的级别
+constexpr LoggerId kRootLoggerId = 0;
+
+// 分层命名日志器注册表
+//
+// 名字以点号分隔（如 qx.md.feed），注册时自动创建缺失的祖先节点。未显式
+// 设置级别的节点继承最近的已设置祖先，根节点默认 kInfo。注册与改级别在
+// 互斥锁下完成；按 ID 读取级别和名字无锁，节点按块分配，地址永不移动。
+// 每个节点 16 字节，名字单独存放。
+class LoggerRegistry {
+ public:
+  // 最多支持的命名日志器数量（含根节点）
+  static constexpr size_t kMaxLoggers = 65536;
+
+  // 进程级全局实例
+  static LoggerRegistry& Global();
+
+  LoggerRegistry();
+  ~LoggerRegistry();
+
+  LoggerRegistry(const LoggerRegistry&) = delete;
+  LoggerRegistry& operator=(const LoggerRegistry&) = delete;
+
+  // 获取名字对应的 ID，不存在时创建；名字为空或包含空段时返回 InvalidArgument
+  absl::Status get(absl::string_view name, LoggerId* id);
+
+  // 显式设置级别，未显式设置级别的子孙节点随之变化；节点不存在时创建
+  absl::Status set_level(absl::string_view name, LogLevel level);
+
+  // 清除显式级别，恢复继承；根节点恢复为 kInfo
+  absl::Status reset_level(absl::string_view name);
+
+  // 显式设置的级别，未显式设置（继承）或节点不存在时返回 false
+  bool explicit_level(absl::string_view name, LogLevel* level) const;
+
+  // 生效级别，ID 无效时返回 kCritical
+  LogLevel get_level(LoggerId id) const;
+
+  // 热路径：一次块表读取和一次级别读取，不加锁
+  bool is_enabled(LoggerId id, LogLevel level) const {
+    const Node* node = find(id);
+    return node != nullptr &&
+           static_cast<int>(level) >=
+               node->level.load(std::memory_order_relaxed);
+  }
+
+  // 完整名字，ID 无效时返回空视图；返回的视图永久有效
+  absl::string_view name(LoggerId id) const {
+    const Node* node = find(id);
+    return node != nullptr ? absl::string_view(*node->name)
+                           : absl::string_view();
+  }
+
+  // 父节点 ID，根节点或 ID 无效时返回 kNoLoggerId
+  LoggerId parent(LoggerId id) const {
+    const Node* node = find(id);
+    return node != nullptr ? node->parent : kNoLoggerId;
+  }
+
+  // 已注册的节点数量（含根节点）
+  size_t size() const { return size_.load(std::memory_order_acquire); }
+
+ private:
+  static constexpr size_t kChunkSize = 256;
+  static constexpr size_t kMaxChunks = kMaxLoggers / kChunkSize;
+  static constexpr int8_t kInheritLevel = -1;
+
+  struct Node {
+    std::atomic<int8_t> level{0};        // 生效级别
+    int8_t explicit_level = kInheritLevel;  // 显式级别，由 mutex_ 保护
+    LoggerId parent = kNoLoggerId;
+    const std::string* name = nullptr;
+  };
+
+  const Node* find(LoggerId id) const {
+    // 先与常量比较，kNoLoggerId 不必读取 size_
+    if (id >= kMaxLoggers || id >= size_.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    const Node* chunk =
+        chunks_[id / kChunkSize].load(std::memory_order_acquire);
+    return chunk + id % kChunkSize;
+  }
+
+  Node& node_locked(LoggerId id) {
+    return chunks_[id / kChunkSize].load(std::memory_order_relaxed)
+        [id % kChunkSize];
+  }
+
+  // 查找或创建节点及其祖先，调用方持有 mutex_
+  absl::Status get_locked(absl::string_view name, LoggerId* id);
+
+  // 追加一个节点，调用方持有 mutex_
+  LoggerId append_locked(absl::string_view name, LoggerId parent);
+
+  // 按 ID 顺序（父节点总在子节点之前）重新计算生效级别，调用方持有 mutex_
+  void propagate_locked();
+
+  mutable std::mutex mutex_;
+  std::atomic<Node*> chunks_[kMaxChunks];
+  std::atomic<size_t> size_{0};
+  std::deque<std::string> names_;
+  absl::flat_hash_map<absl::string_view, LoggerId> ids_;
+};
+
+// 记录使用的日志器名字：kNoLoggerId 返回 fallback（后端自身的名字）
+inline absl::string_view LoggerNameOr(LoggerId id, absl::string_view fallback) {
+  return id == kNoLoggerId ? fallback : LoggerRegistry::Global().name(id);
+}
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_LOGGER_REGISTRY_H_
@@ -0,0 +1,139 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_MMAP_FILE_SINK_H_
+#define QXCORE_LOG_MMAP_FILE_SINK_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <absl/status/status.h>
+#include <spdlog/formatter.h>
+#include <spdlog/sinks/sink.h>
+
+namespace qxcore {
+namespace log {
+
+// 写入内存映射分段文件的文本 sink
+//
+// 输出按 segment_size 切分为 <stem>.<NNNNNN>.log，序号接着目录中已有的最大
+// 序号递增。后台线程提前创建、预分配并映射（MAP_POPULATE）后续分段；生产者
+// 用原子操作预留区间后把格式化结果直接拷贝进映射区，稳态写路径不加锁、
+// 不做系统调用。放不下的记录从下一个分段开始，分段写满后由后台线程截掉
+// 未用的尾部、解除映射并关闭。后台线程无法创建或映射分段时（如磁盘已满）
+// 不再映射新分段，写到该分段的记录被丢弃并计入 dropped()，生产者不会阻塞。
+//
+// 拷贝完成的数据即进入页缓存，进程崩溃后仍会由内核写回；只有掉电或内核
+// 崩溃才需要 msync，后台线程按 sync_interval 发起异步写回。崩溃时尚未回收
+// 的分段保留全长、尾部为零字节，其后还有全零的预备分段，下次启动时逐个截掉
+// 零字节尾部并删除截断后为空的分段。
+class MmapFileSink final : public spdlog::sinks::sink {
+ public:
+  explicit MmapFileSink(size_t segment_size,
+                        std::chrono::milliseconds sync_interval =
+                            std::chrono::milliseconds(1000));
+  ~MmapFileSink() override;
+
+  MmapFileSink(const MmapFileSink&) = delete;
+  MmapFileSink& operator=(const MmapFileSink&) = delete;
+
+  // 检查分段大小（不小于 64KB）
+  static absl::Status ValidateSegmentSize(size_t segment_size);
+
+  // 以 path 去掉 ".log" 后缀的部分为前缀创建分段，映射首个分段后启动后台线程
+  absl::Status open(const std::string& path);
+
+  void log(const spdlog::details::log_msg& msg) override;
+  // 写入即进入页缓存，flush 只请求后台线程发起异步写回
+  void flush() override;
+  void set_pattern(const std::string& pattern) override;
+  void set_formatter(std::unique_ptr<spdlog::formatter> formatter) override;
+
+  // 当前写入的分段路径
+  std::string filename() const;
+
+  // 因超过分段大小或分段映射失败而丢弃的记录数
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+  // 已收尾（截掉未用尾部并关闭）的非空分段数
+  uint64_t completed_segments() const {
+    return completed_.load(std::memory_order_acquire);
+  }
+
+  // 分段文件路径
+  static std::string SegmentName(const std::string& stem, uint64_t sequence);
+
+ private:
+  // 同时映射的分段数：当前分段、预备分段与等待收尾的分段
+  static constexpr size_t kSlots = 4;
+  // 提前映射的分段数
+  static constexpr uint64_t kLookahead = 2;
+  static constexpr uint64_t kOpenSegment = ~uint64_t{0};
+  // failed_segment_ 的初值，表示没有映射失败
+  static constexpr uint64_t kNoFailedSegment = ~uint64_t{0};
+
+  struct alignas(64) Slot {
+    // 已映射的分段编号加 1，0 表示空闲
+    std::atomic<uint64_t> ready{0};
+    // 已拷贝完成的字节数
+    std::atomic<uint64_t> committed{0};
+    // 分段关闭后的有效字节数，未关闭时为 kOpenSegment
+    std::atomic<uint64_t> used{kOpenSegment};
+    char* base = nullptr;
+    int fd = -1;
+  };
+
+  // 等待分段映射完成，分段映射失败时返回 nullptr
+  char* wait_for_segment(uint64_t segment);
+  void close_segment(uint64_t segment, uint64_t used);
+  spdlog::formatter& thread_formatter(spdlog::memory_buf_t** buffer);
+
+  void run();
+  bool map_segment(uint64_t segment);
+  bool retire_segment(uint64_t segment, bool final);
+  void sync_active();
+
+  const uint64_t segment_size_;
+  const std::chrono::milliseconds sync_interval_;
+  const uint64_t id_;
+  std::string stem_;
+  uint64_t first_sequence_ = 1;
+
+  alignas(64) std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<uint64_t> completed_{0};
+  // 后台线程映射失败的分段编号，该分段及之后的记录全部丢弃
+  std::atomic<uint64_t> failed_segment_{kNoFailedSegment};
+  Slot slots_[kSlots];
+
+  mutable std::mutex formatter_mutex_;
+  std::unique_ptr<spdlog::formatter> formatter_;
+  std::atomic<uint64_t> formatter_generation_{0};
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool wake_ = false;
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_MMAP_FILE_SINK_H_
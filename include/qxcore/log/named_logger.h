@@ -0,0 +1,196 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef QXCORE_LOG_NAMED_LOGGER_H_
+#define QXCORE_LOG_NAMED_LOGGER_H_
+
+#include <type_traits>
+#include <utility>
+#include <absl/status/status.h>
+#include <absl/strings/string_view.h>
+#include "qxcore/log/log.h"
+#include "qxcore/log/logger_registry.h"
+
+namespace qxcore {
+namespace log {
+
+// 命名日志器
+//
+// 只保存一个 LoggerId，可以按值拷贝和长期保存。记录写入全局默认日志器的
+// sinks 并带上自己的名字，级别由 LoggerRegistry 按层级继承；写日志时
+// 不查找字符串也不加注册表锁。接口与 Log 一致，可以直接用于 QXLOG_* 宏。
+class NamedLogger {
+ public:
+  // 级别只由 LoggerRegistry 决定，调用点按 ID 检查（见 Callsite）
+  static constexpr bool kRegistryLevel = true;
+
+  // 默认构造的日志器不对应任何名字，所有级别都关闭
+  NamedLogger() = default;
+  explicit NamedLogger(LoggerId id) : id_(id) {}
+
+  LoggerId id() const { return id_; }
+
+  // 完整名字
+  absl::string_view name() const { return LoggerRegistry::Global().name(id_); }
+
+  // 显式设置级别，未显式设置级别的子孙日志器随之变化
+  absl::Status set_level(LogLevel level) {
+    if (id_ == kNoLoggerId) {
+      return absl::FailedPreconditionError("Logger has no name");
+    }
+    return LoggerRegistry::Global().set_level(name(), level);
+  }
+
+  // 生效级别
+  LogLevel get_level() const { return LoggerRegistry::Global().get_level(id_); }
+
+  // 检查日志级别是否启用
+  bool is_enabled(LogLevel level) const {
+    return LoggerRegistry::Global().is_enabled(id_, level);
+  }
+
+  // 基础日志接口
+  void log(LogLevel level, absl::string_view msg) {
+    if (is_enabled(level)) {
+      EpochGuard guard;
+      GetDefaultLogger().backend().log_named(id_, level, nullptr,
+                                             RecordTime::Now(), msg);
+    }
+  }
+
+  // 格式化日志接口；参数全部为 kv() 字段时按结构化记录写出，见 Log::logf
+  template<typename S, typename... Args>
+  void logf(LogLevel level, const S& fmt_str, Args&&... args) {
+    if (is_enabled(level)) {
+      EpochGuard guard;
+      if constexpr (kIsStructured<Args...>) {
+        log_structured(level, nullptr, FormatView(fmt_str), args...);
+      } else {
+        GetDefaultLogger().backend().logf_named(id_, level, nullptr,
+                                                RecordTime::Now(), fmt_str,
+                                                std::forward<Args>(args)...);
+      }
+    }
+  }
+
+  // 指定事件时间的格式化日志接口
+  template<typename S, typename... Args>
+  void logf(LogLevel level, EventTime time, const S& fmt_str, Args&&... args) {
+    static_assert(!kIsStructured<Args...>,
+                  "structured fields are not supported with EventTime");
+    if (is_enabled(level)) {
+      EpochGuard guard;
+      GetDefaultLogger().backend().logf_named(id_, level, nullptr,
+                                              RecordTime::Event(time), fmt_str,
+                                              std::forward<Args>(args)...);
+    }
+  }
+
+  // 调用点接口，供 QXLOG_* 宏使用
+  template<typename S, typename... Args>
+  void logf(const Callsite& callsite, const S& fmt_str, Args&&... args) {
+    EpochGuard guard;
+    if constexpr (kIsStructured<Args...>) {
+      log_structured(callsite.level(), &callsite, FormatView(fmt_str), args...);
+    } else {
+      GetDefaultLogger().backend().logf_named(id_, callsite.level(), &callsite,
+                                              RecordTime::Now(), fmt_str,
+                                              std::forward<Args>(args)...);
+    }
+  }
+
+  // 惰性日志接口
+  template<typename Fn>
+  void log_lazy(LogLevel level, Fn&& fn) {
+    if (is_enabled(level)) {
+      log(level, std::forward<Fn>(fn)());
+    }
+  }
+
+  template<typename Fn>
+  void log_lazy(const Callsite& callsite, Fn&& fn) {
+    EpochGuard guard;
+    GetDefaultLogger().backend().log_named(id_, callsite.level(), &callsite,
+                                           RecordTime::Now(),
+                                           std::forward<Fn>(fn)());
+  }
+
+  // 便捷接口
+  template<typename S, typename... Args>
+  void trace(const S& fmt_str, Args&&... args) {
+    logf(LogLevel::kTrace, fmt_str, std::forward<Args>(args)...);
+  }
+
+  template<typename S, typename... Args>
+  void debug(const S& fmt_str, Args&&... args) {
+    logf(LogLevel::kDebug, fmt_str, std::forward<Args>(args)...);
+  }
+
+  template<typename S, typename... Args>
+  void info(const S& fmt_str, Args&&... args) {
+    logf(LogLevel::kInfo, fmt_str, std::forward<Args>(args)...);
+  }
+
+  template<typename S, typename... Args>
+  void warn(const S& fmt_str, Args&&... args) {
+    logf(LogLevel::kWarn, fmt_str, std::forward<Args>(args)...);
+  }
+
+  template<typename S, typename... Args>
+  void error(const S& fmt_str, Args&&... args) {
+    logf(LogLevel::kError, fmt_str, std::forward<Args>(args)...);
+  }
+
+  template<typename S, typename... Args>
+  void critical(const S& fmt_str, Args&&... args) {
+    logf(LogLevel::kCritical, fmt_str, std::forward<Args>(args)...);
+  }
+
+ private:
+  // 结构化记录：编码为结构化负载，默认后端不识别时先渲染为文本；调用方
+  // 已完成级别检查并持有 EpochGuard
+  template<typename... Fields>
+  void log_structured(LogLevel level, const Callsite* callsite,
+                      absl::string_view event, const Fields&... fields) {
+    using Backend = std::decay_t<decltype(GetDefaultLogger().backend())>;
+    absl::string_view msg;
+    try {
+      msg = internal::EncodeStructuredMessage(
+          !internal::kAcceptsStructured<Backend>, event, fields...);
+    } catch (...) {
+      // 静默处理日志错误，避免异常传播
+      return;
+    }
+    GetDefaultLogger().backend().log_named(id_, level, callsite,
+                                           RecordTime::Now(), msg);
+  }
+
+  LoggerId id_ = kNoLoggerId;
+};
+
+// 获取（不存在时创建）命名日志器，名字无效时返回全部关闭的日志器；
+// 会加注册表锁，应在初始化阶段调用并保存结果
+inline NamedLogger GetLogger(absl::string_view name) {
+  LoggerId id = kNoLoggerId;
+  if (!LoggerRegistry::Global().get(name, &id).ok()) {
+    return NamedLogger();
+  }
+  return NamedLogger(id);
+}
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_NAMED_LOGGER_H_
@@ -0,0 +1,56 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_NULL_SINK_H_
+#define QXCORE_LOG_NULL_SINK_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <spdlog/formatter.h>
+#include <spdlog/sinks/sink.h>
+
+namespace qxcore {
+namespace log {
+
+// 丢弃全部记录的 sink
+//
+// 不格式化、不加锁，只对收到的记录计数，用于在基准测试中排除输出开销，
+// 单独测量前端（过滤、格式化、入队）的耗时。
+class NullSink final : public spdlog::sinks::sink {
+ public:
+  NullSink() = default;
+
+  NullSink(const NullSink&) = delete;
+  NullSink& operator=(const NullSink&) = delete;
+
+  void log(const spdlog::details::log_msg&) override {
+    records_.fetch_add(1, std::memory_order_relaxed);
+  }
+  void flush() override {}
+  void set_pattern(const std::string&) override {}
+  void set_formatter(std::unique_ptr<spdlog::formatter>) override {}
+
+  // 已收到的记录数
+  uint64_t records() const { return records_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> records_{0};
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_NULL_SINK_H_
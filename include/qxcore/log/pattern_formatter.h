@@ -0,0 +1,125 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef QXCORE_LOG_PATTERN_FORMATTER_H_
+#define QXCORE_LOG_PATTERN_FORMATTER_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <absl/status/status.h>
+#include <absl/strings/string_view.h>
+#include <spdlog/common.h>
+#include <spdlog/formatter.h>
+#include "qxcore/log/structured.h"
+
+namespace qxcore {
+namespace log {
+
+// 预编译的 spdlog 格式化器
+//
+// pattern 在构造时编译为操作序列，字面文本与秒级时间字段（%Y %m %d %H %M
+// %S %y %T %D）渲染进同一块文本，每秒只重新填写一次时间数字；%e/%f/%F
+// 按三位一组查表写入。级别名在构造时预先渲染。支持的标志：
+//   %Y %m %d %H %M %S %y %T %D  本地时间
+//   %e %f %F                    毫秒 / 微秒 / 纳秒
+//   %n %l %L %t %P %v %^ %$ %%  同 spdlog
+//   %s %g %# %! %@              源码位置
+//   %&                          日志上下文（见 log_context.h）
+// 结构化记录（见 structured.h）的 %v 渲染为 "事件名 键=值 ..."。
+// 不支持对齐与截断（如 %-8l）及其他标志，此时 Compile 返回 InvalidArgument。
+class PatternFormatter final : public spdlog::formatter {
+ public:
+  // 编译 pattern
+  static absl::Status Compile(absl::string_view pattern,
+                              std::unique_ptr<PatternFormatter>* formatter);
+
+  void format(const spdlog::details::log_msg& msg,
+              spdlog::memory_buf_t& dest) override;
+  std::unique_ptr<spdlog::formatter> clone() const override;
+
+  const std::string& pattern() const { return pattern_; }
+
+ private:
+  enum class OpType : uint8_t {
+    kText,            // text_ 中的字面文本与秒级时间字段
+    kMillis,
+    kMicros,
+    kNanos,
+    kName,
+    kLevel,
+    kShortLevel,
+    kThreadId,
+    kPayload,
+    kColorStart,
+    kColorEnd,
+    kSourceFile,
+    kShortFile,
+    kSourceLine,
+    kSourceFunc,
+    kSourceLocation,
+    kContext,
+  };
+
+  struct Op {
+    OpType type;
+    uint32_t offset = 0;  // kText：在 text_ 中的起始位置
+    uint32_t size = 0;    // kText：长度
+  };
+
+  // 需要每秒重新填写的时间字段
+  enum class TimeField : uint8_t {
+    kYear,
+    kShortYear,
+    kMonth,
+    kDay,
+    kHour,
+    kMinute,
+    kSecond,
+  };
+
+  struct TimeSlot {
+    TimeField field;
+    uint32_t offset;  // 在 text_ 中的位置
+  };
+
+  explicit PatternFormatter(std::string pattern);
+
+  // 追加字面文本或时间字段，与前一个 kText 操作相邻时合并
+  void append_text(absl::string_view text);
+  void append_time(TimeField field);
+  void append_op(OpType type);
+
+  // 按秒更新 text_ 中的时间字段
+  void update_time(int64_t seconds);
+
+  std::string pattern_;
+  std::vector<Op> ops_;
+  std::string text_;
+  std::vector<TimeSlot> time_slots_;
+  int64_t cached_seconds_ = -1;
+  absl::string_view level_names_[spdlog::level::n_levels];
+  StructuredRecord record_;
+};
+
+// 创建格式化器：优先使用 PatternFormatter，pattern 含不支持的标志时
+// 退回 spdlog::pattern_formatter，结构化记录同样渲染为文本
+std::unique_ptr<spdlog::formatter> MakeLogFormatter(const std::string& pattern);
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_PATTERN_FORMATTER_H_
@@ -0,0 +1,156 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef QXCORE_LOG_RATE_LIMIT_H_
+#define QXCORE_LOG_RATE_LIMIT_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include "qxcore/log/tsc_clock.h"
+
+namespace qxcore {
+namespace log {
+
+// 限流判定结果
+//
+// suppressed 为自上一条放行记录以来被丢弃的次数，只在 allowed 时有意义。
+struct RatePermit {
+  bool allowed;
+  uint64_t suppressed;
+
+  explicit operator bool() const { return allowed; }
+};
+
+namespace internal {
+
+// 限流使用的单调纳秒；走 TscClock 计数，避免热路径上的系统调用
+inline int64_t RateLimitNowNanos() {
+  if constexpr (TscClock::kUsesTsc) {
+    return static_cast<int64_t>(static_cast<double>(TscClock::ReadTicks()) *
+                                TscClock::Global().nanos_per_tick());
+  } else {
+    return static_cast<int64_t>(TscClock::ReadTicks());
+  }
+}
+
+}  // namespace internal
+
+// 以下限流器都是可常量初始化的字面类型，作为 QXLOG_*_EVERY_N 等宏展开处的
+// 静态对象使用，不需要动态初始化守卫。acquire 可被多个线程并发调用。
+
+// 每 n 次放行一次（第 1、n+1、2n+1... 次）
+class EveryNLimiter {
+ public:
+  constexpr explicit EveryNLimiter(uint64_t n) : n_(n == 0 ? 1 : n) {}
+
+  RatePermit acquire() {
+    uint64_t index = count_.fetch_add(1, std::memory_order_relaxed);
+    if (index % n_ != 0) {
+      return RatePermit{false, 0};
+    }
+    return RatePermit{true, index == 0 ? 0 : n_ - 1};
+  }
+
+ private:
+  const uint64_t n_;
+  std::atomic<uint64_t> count_{0};
+};
+
+// 只放行前 n 次
+class FirstNLimiter {
+ public:
+  constexpr explicit FirstNLimiter(uint64_t n) : n_(n) {}
+
+  RatePermit acquire() {
+    // 额度用完后只读不写，避免多线程争用同一缓存行
+    if (count_.load(std::memory_order_relaxed) >= n_) {
+      return RatePermit{false, 0};
+    }
+    uint64_t index = count_.fetch_add(1, std::memory_order_relaxed);
+    return RatePermit{index < n_, 0};
+  }
+
+ private:
+  const uint64_t n_;
+  std::atomic<uint64_t> count_{0};
+};
+
+// 每 ms 毫秒最多放行一次
+class EveryMsLimiter {
+ public:
+  constexpr explicit EveryMsLimiter(int64_t ms)
+      : interval_nanos_(ms * 1000000) {}
+
+  RatePermit acquire() {
+    int64_t now = internal::RateLimitNowNanos();
+    int64_t next = next_nanos_.load(std::memory_order_relaxed);
+    if (now < next ||
+        !next_nanos_.compare_exchange_strong(next, now + interval_nanos_,
+                                             std::memory_order_relaxed)) {
+      suppressed_.fetch_add(1, std::memory_order_relaxed);
+      return RatePermit{false, 0};
+    }
+    return RatePermit{true, suppressed_.exchange(0, std::memory_order_relaxed)};
+  }
+
+ private:
+  const int64_t interval_nanos_;
+  std::atomic<int64_t> next_nanos_{0};
+  std::atomic<uint64_t> suppressed_{0};
+};
+
+// 令牌桶：平均每秒 per_second 条，允许突发 burst 条
+//
+// 按 GCRA 实现，只维护一个理论到达时间 tat：放行一条推进 per_second 的倒数，
+// tat 超前当前时间不超过 (burst - 1) 个间隔时放行。
+class TokenBucketLimiter {
+ public:
+  constexpr TokenBucketLimiter(double per_second, uint64_t burst)
+      : interval_nanos_(per_second > 0
+                            ? static_cast<int64_t>(1e9 / per_second)
+                            : INT64_MAX / 4),
+        tolerance_nanos_(per_second > 0 && burst > 1
+                             ? interval_nanos_ * static_cast<int64_t>(burst - 1)
+                             : 0) {}
+
+  RatePermit acquire() {
+    int64_t now = internal::RateLimitNowNanos();
+    int64_t tat = tat_nanos_.load(std::memory_order_relaxed);
+    for (;;) {
+      int64_t base = std::max(tat, now);
+      if (base - now > tolerance_nanos_) {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return RatePermit{false, 0};
+      }
+      if (tat_nanos_.compare_exchange_weak(tat, base + interval_nanos_,
+                                           std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    return RatePermit{true, suppressed_.exchange(0, std::memory_order_relaxed)};
+  }
+
+ private:
+  const int64_t interval_nanos_;
+  const int64_t tolerance_nanos_;
+  std::atomic<int64_t> tat_nanos_{0};
+  std::atomic<uint64_t> suppressed_{0};
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_RATE_LIMIT_H_
@@ -0,0 +1,120 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_ROTATING_FILE_SINK_H_
+#define QXCORE_LOG_ROTATING_FILE_SINK_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <absl/status/status.h>
+#include <absl/time/time.h>
+#include <spdlog/common.h>
+#include <spdlog/sinks/base_sink.h>
+#include "qxcore/log/log_options.h"
+
+namespace qxcore {
+namespace log {
+
+// 按大小、时间间隔和交易时段边界轮转的文本文件 sink
+//
+// 当前文件始终为 path；轮转时把它改名为 <stem>.<YYYYmmdd-HHMMSS>.log
+// （时间为在 options.time_zone 下的关闭时刻）。打开、预分配、改名与按总字节
+// 预算清理旧文件都在后台线程完成：后台线程提前创建好下一个文件
+// （path + ".next"），写入线程到达轮转点时只交换文件句柄；备用文件尚未
+// 就绪时继续写当前文件，下一条记录再试，生产者不会等待文件系统元数据操作。
+// 启动时已存在的非空 path 先按其修改时间归档，不再被截断。
+class RotatingFileSink : public spdlog::sinks::base_sink<std::mutex> {
+ public:
+  // buffer_size 为预留的格式化缓冲区字节数
+  RotatingFileSink(const RotationOptions& options, size_t buffer_size = 8192);
+  ~RotatingFileSink() override;
+
+  // 检查轮转配置是否有效（时区可加载、时段边界为 HH:MM）
+  static absl::Status ValidateOptions(const RotationOptions& options);
+
+  // 打开 path 并启动后台线程；只能调用一次
+  absl::Status open(const std::string& path);
+
+  // 当前文件路径
+  std::string filename();
+
+  // 已完成的轮转次数
+  uint64_t rotations() const {
+    return rotations_.load(std::memory_order_acquire);
+  }
+
+  // 等待后台线程处理完已提交的归档、清理和备用文件创建
+  void wait_idle();
+
+  // 归档文件名，stem 为 path 去掉 ".log" 后缀的部分
+  static std::string ArchiveName(const std::string& stem, absl::Time time,
+                                 absl::TimeZone zone);
+
+  // now 之后最近的时间轮转点；未配置时间间隔和时段边界时返回
+  // absl::InfiniteFuture()
+  static absl::Time NextRotation(absl::Time now, const RotationOptions& options,
+                                 absl::TimeZone zone);
+
+ protected:
+  void sink_it_(const spdlog::details::log_msg& msg) override;
+  void flush_() override;
+
+ private:
+  // 待后台线程归档的文件
+  struct Retired {
+    std::FILE* file;
+    absl::Time closed;
+  };
+
+  void run();
+  std::FILE* open_spare();
+  void archive(const Retired& retired);
+  void enforce_budget();
+
+  const RotationOptions options_;
+  absl::TimeZone zone_;
+  std::string path_;
+  std::string stem_;
+
+  // 以下成员由 sink 锁保护
+  spdlog::memory_buf_t buffer_;
+  std::FILE* file_ = nullptr;
+  uint64_t file_size_ = 0;
+  absl::Time next_rotation_ = absl::InfiniteFuture();
+
+  // 后台线程创建好的备用文件，由写入线程取走
+  std::atomic<std::FILE*> spare_{nullptr};
+  std::atomic<uint64_t> rotations_{0};
+
+  std::mutex jobs_mutex_;
+  std::condition_variable jobs_cv_;
+  std::condition_variable idle_cv_;
+  std::deque<Retired> retired_;
+  bool spare_requested_ = false;
+  bool spare_failed_ = false;
+  bool busy_ = false;
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_ROTATING_FILE_SINK_H_
@@ -0,0 +1,179 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_SHM_BACKEND_H_
+#define QXCORE_LOG_SHM_BACKEND_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <absl/strings/string_view.h>
+#include <absl/status/status.h>
+#include "qxcore/log/callsite.h"
+#include "qxcore/log/format_string.h"
+#include "qxcore/log/log_level.h"
+#include "qxcore/log/log_options.h"
+#include "qxcore/log/logger_registry.h"
+#include "qxcore/log/shm_transport.h"
+#include "qxcore/log/tsc_clock.h"
+
+namespace qxcore {
+namespace log {
+
+// 共享内存传输后端
+//
+// 调用线程只把记录编码进共享内存段（见 shm_transport.h），格式化和全部
+// 文件 I/O 由独立的 qxlogd 进程完成，qxlogd 再把记录交给 spdlog 或 glog
+// 后端写出。使用 Log<ShmBackend>；LogOptions 中只有 shm 生效，mode、
+// output 与输出格式由 qxlogd 决定。qxlogd 不在线时记录留在段中，环满后
+// 按 shm.overflow_policy 处理。
+class ShmBackend {
+ public:
+  ShmBackend() = default;
+  ~ShmBackend();
+
+  // 禁用拷贝构造和赋值
+  ShmBackend(const ShmBackend&) = delete;
+  ShmBackend& operator=(const ShmBackend&) = delete;
+
+  // 以地址注册到 CallsiteRegistry，禁用移动
+  ShmBackend(ShmBackend&&) = delete;
+  ShmBackend& operator=(ShmBackend&&) = delete;
+
+  // 初始化日志系统，在 options.shm.directory 下创建段文件
+  absl::Status init(const std::string& name, LogLevel level = LogLevel::kInfo,
+                    const LogOptions& options = LogOptions());
+
+  // 设置日志级别
+  absl::Status set_level(LogLevel level);
+
+  // 获取当前日志级别
+  LogLevel get_level() const;
+
+  // 检查日志级别是否启用
+  bool is_enabled(LogLevel level) const {
+    return initialized_.load(std::memory_order_acquire) &&
+           IsLogLevelEnabled(current_level_.load(std::memory_order_relaxed),
+                             level);
+  }
+
+  // 基础日志接口
+  void log(LogLevel level, absl::string_view msg) {
+    if (is_enabled(level)) {
+      write(level, nullptr, kNoLoggerId, RecordTime::Now(), msg);
+    }
+  }
+
+  // 调用点日志接口：级别已由调用点判断，只检查是否已初始化
+  void log(const Callsite& callsite, absl::string_view msg) {
+    if (initialized_.load(std::memory_order_acquire)) {
+      write(callsite.level(), &callsite, kNoLoggerId, RecordTime::Now(), msg);
+    }
+  }
+
+  // 格式化日志接口：只编码格式串 ID 与原始参数，不带参数的运行期字符串
+  // 按原文传输
+  template<typename S, typename... Args>
+  void logf(LogLevel level, const S& fmt_str, Args&&... args) {
+    if (is_enabled(level)) {
+      writef(level, nullptr, kNoLoggerId, RecordTime::Now(), fmt_str, args...);
+    }
+  }
+
+  // 指定事件时间的格式化日志接口
+  template<typename S, typename... Args>
+  void logf(LogLevel level, EventTime time, const S& fmt_str, Args&&... args) {
+    if (is_enabled(level)) {
+      writef(level, nullptr, kNoLoggerId, RecordTime::Event(time), fmt_str,
+             args...);
+    }
+  }
+
+  template<typename S, typename... Args>
+  void logf(const Callsite& callsite, const S& fmt_str, Args&&... args) {
+    if (initialized_.load(std::memory_order_acquire)) {
+      writef(callsite.level(), &callsite, kNoLoggerId, RecordTime::Now(),
+             fmt_str, args...);
+    }
+  }
+
+  // 命名日志器接口：日志器名字随段字典传给 qxlogd
+  void log_named(LoggerId logger_id, LogLevel level, const Callsite* callsite,
+                 RecordTime time, absl::string_view msg) {
+    if (initialized_.load(std::memory_order_acquire)) {
+      write(level, callsite, logger_id, time, msg);
+    }
+  }
+
+  template<typename S, typename... Args>
+  void logf_named(LoggerId logger_id, LogLevel level, const Callsite* callsite,
+                  RecordTime time, const S& fmt_str, Args&&... args) {
+    if (initialized_.load(std::memory_order_acquire)) {
+      writef(level, callsite, logger_id, time, fmt_str, args...);
+    }
+  }
+
+  // 等待 qxlogd 写出此前的记录并刷新其输出，最多等待 shm.flush_timeout_ms；
+  // qxlogd 不在线时立即返回
+  void flush();
+
+  // 关闭日志系统：刷新后标记段已关闭，qxlogd 写完剩余记录后删除段文件
+  void shutdown();
+
+  // qxlogd 是否在线
+  bool daemon_alive() const;
+
+  // 段文件路径，未初始化时为空
+  std::string segment_path() const;
+
+  // 传输统计，未初始化时全部为 0
+  ShmStats stats() const;
+
+ private:
+  // 写出一条已通过级别检查的记录
+  void write(LogLevel level, const Callsite* callsite, LoggerId logger_id,
+             RecordTime time, absl::string_view msg) {
+    try {
+      producer_->write_text(level, callsite, logger_id, time, msg);
+    } catch (...) {
+      // 静默处理日志错误，避免异常传播
+    }
+  }
+
+  template<typename S, typename... Args>
+  void writef(LogLevel level, const Callsite* callsite, LoggerId logger_id,
+              RecordTime time, const S& fmt_str, const Args&... args) {
+    if constexpr (sizeof...(Args) == 0 && !kIsCompiledFormat<S>) {
+      write(level, callsite, logger_id, time, FormatView(fmt_str));
+    } else {
+      try {
+        producer_->write(level, callsite, logger_id, time, FormatView(fmt_str),
+                         args...);
+      } catch (...) {
+        // 静默处理日志错误，避免异常传播
+      }
+    }
+  }
+
+  // 关闭后仍保留，避免与并发的日志调用竞争
+  std::shared_ptr<ShmProducer> producer_;
+  int flush_timeout_ms_ = 1000;
+  std::atomic<LogLevel> current_level_{LogLevel::kInfo};
+  std::atomic<bool> initialized_{false};
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_SHM_BACKEND_H_
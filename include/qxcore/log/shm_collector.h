@@ -0,0 +1,128 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_SHM_COLLECTOR_H_
+#define QXCORE_LOG_SHM_COLLECTOR_H_
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+#include <absl/container/flat_hash_map.h>
+#include <absl/status/status.h>
+#include <absl/strings/string_view.h>
+#include "qxcore/log/arg_codec.h"
+#include "qxcore/log/callsite.h"
+#include "qxcore/log/log_level.h"
+#include "qxcore/log/logger_registry.h"
+#include "qxcore/log/shm_transport.h"
+#include "qxcore/log/tsc_clock.h"
+
+namespace qxcore {
+namespace log {
+
+// ShmLogCollector 写出记录的目标
+class ShmRecordHandler {
+ public:
+  virtual ~ShmRecordHandler() = default;
+
+  // 写出一条记录
+  //
+  // client 为生产者 init 时的名字；callsite 由收集器按字典重建，在该客户端
+  // 断开前有效；logger_id 已映射为本进程 LoggerRegistry 中的 ID
+  virtual void write(absl::string_view client, LogLevel level,
+                     const Callsite* callsite, LoggerId logger_id,
+                     RecordTime time, absl::string_view message) = 0;
+
+  // 生产者请求刷新
+  virtual void flush(absl::string_view client) = 0;
+
+  // 生产者已断开且记录已全部写出，段文件随后被删除；clean 为 false 表示
+  // 进程未调用 shutdown 就退出，dropped 为生产者侧丢弃的记录数
+  virtual void detach(absl::string_view client, int pid, bool clean,
+                      uint64_t dropped) = 0;
+};
+
+// 共享内存段的消费者端，供 qxlogd 使用
+//
+// 扫描目录中的段文件，按时间戳归并各线程环并交给 ShmRecordHandler。消费
+// 位置保存在段内，收集器重启后从上次写出的位置继续；生产者进程退出（按
+// pid 与启动时间判断）或调用 shutdown 后，写完剩余记录即删除段文件。
+// 同一目录只允许一个收集器，以目录下的 qxlogd.lock 文件锁互斥。
+class ShmLogCollector {
+ public:
+  ShmLogCollector(std::string directory, ShmRecordHandler* handler);
+  ~ShmLogCollector();
+
+  ShmLogCollector(const ShmLogCollector&) = delete;
+  ShmLogCollector& operator=(const ShmLogCollector&) = delete;
+
+  // 创建目录并取得文件锁，已有收集器运行时返回 AlreadyExists
+  absl::Status open();
+
+  // 轮询一次：必要时重新扫描目录，写出各段中已提交的记录，响应刷新
+  // 请求并回收已断开的生产者；返回写出的记录数
+  size_t poll();
+
+  // 解除全部映射并释放文件锁，不删除段文件
+  void close();
+
+  // 当前接管的段数量
+  size_t clients() const { return clients_.size(); }
+
+  // 累计写出的记录数
+  uint64_t written() const { return written_; }
+
+  // 目录扫描间隔
+  static constexpr std::chrono::milliseconds kScanInterval{100};
+
+  // 单次轮询中每个段最多写出的记录数
+  static constexpr size_t kMaxBatch = 65536;
+
+ private:
+  struct Client;
+
+  // 接管新出现的段，回收已断开的生产者
+  void scan();
+
+  // 映射段文件，尚未初始化完成或格式不符时返回 nullptr
+  std::unique_ptr<Client> attach(const std::string& path);
+
+  // 解析新追加的字典条目
+  void read_dictionary(Client& client);
+
+  // 按时间戳归并写出最多 limit 条记录
+  size_t drain(Client& client, size_t limit);
+
+  // 写出单条记录
+  void write_record(Client& client, const internal::ShmRecordHeader& header,
+                    const char* payload);
+
+  std::string directory_;
+  ShmRecordHandler* handler_;
+  int lock_fd_ = -1;
+  std::vector<std::unique_ptr<Client>> clients_;
+  std::chrono::steady_clock::time_point next_scan_{};
+  uint64_t written_ = 0;
+
+  FormatArgStore arg_store_;
+  fmt::memory_buffer format_buffer_;
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_SHM_COLLECTOR_H_
@@ -0,0 +1,399 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_SHM_TRANSPORT_H_
+#define QXCORE_LOG_SHM_TRANSPORT_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <absl/container/flat_hash_map.h>
+#include <absl/status/status.h>
+#include <absl/strings/string_view.h>
+#include "qxcore/log/arg_codec.h"
+#include "qxcore/log/callsite.h"
+#include "qxcore/log/format_registry.h"
+#include "qxcore/log/format_string.h"
+#include "qxcore/log/log_level.h"
+#include "qxcore/log/log_options.h"
+#include "qxcore/log/logger_registry.h"
+#include "qxcore/log/tsc_clock.h"
+
+namespace qxcore {
+namespace log {
+
+// 共享内存段的布局常量
+//
+// 每个 ShmBackend 创建一个段文件 <directory>/<name>.<pid>.<纳秒>.qxshm，
+// 布局为 [段头][字典][线程环 0][线程环 1]...。字典保存格式串、调用点和
+// 日志器名字，记录只携带其 ID；线程环为单生产者单消费者字节环，帧格式与
+// SpscByteRing 相同。
+namespace shm_format {
+
+constexpr uint32_t kMagic = 0x4d535851;  // "QXSM"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kHeaderSize = 256;
+constexpr size_t kRingHeaderSize = 128;
+constexpr size_t kFrameSize = 8;
+constexpr char kSegmentSuffix[] = ".qxshm";
+constexpr char kLockFile[] = "qxlogd.lock";
+
+// 帧标志
+constexpr uint32_t kPaddingFrame = 1;
+
+// 线程环状态
+constexpr uint32_t kRingFree = 0;
+constexpr uint32_t kRingOwned = 1;
+constexpr uint32_t kRingAbandoned = 2;  // 所属线程已退出，可被新线程接管
+
+// 字典条目类型，条目为 [kind][id][aux][size][字节]，按 8 字节对齐
+constexpr uint32_t kFormatEntry = 1;
+constexpr uint32_t kCallsiteEntry = 2;  // aux 为行号，字节为 级别 文件 \0 函数
+constexpr uint32_t kLoggerEntry = 3;
+
+// 记录标志
+constexpr uint8_t kEventTime = 1;  // time 为调用方给定的 Unix 纳秒
+constexpr uint8_t kVerbatim = 2;   // 参数区为已格式化的消息文本
+
+// 调用点 ID 0 表示没有调用点
+constexpr uint32_t kNoCallsiteId = 0;
+
+}  // namespace shm_format
+
+// 共享内存传输统计
+struct ShmStats {
+  uint64_t committed = 0;  // 写入段的记录数
+  uint64_t dropped = 0;    // 环满、超长或没有分到线程环而丢弃的记录数
+  uint64_t written = 0;    // qxlogd 已写出的记录数
+
+  // 已写入段但尚未写出的记录数（积压）
+  uint64_t pending() const {
+    return committed > written ? committed - written : 0;
+  }
+};
+
+class ShmProducer;
+
+namespace internal {
+
+// 段头；原子成员均为无锁类型，可以放在共享内存中
+struct ShmSegmentHeader {
+  std::atomic<uint32_t> magic;  // 初始化完成后最后写入
+  uint32_t version;
+  uint32_t max_threads;
+  uint32_t ring_capacity;
+  uint32_t dictionary_capacity;
+  int32_t pid;
+  uint64_t start_time;  // /proc/<pid>/stat 的启动时间，与 pid 一起识别进程
+  std::atomic<uint32_t> closed;           // 生产者已调用 shutdown
+  std::atomic<uint32_t> dictionary_used;  // 字典已用字节
+  std::atomic<uint64_t> unclaimed;        // 没有分到线程环而丢弃的记录
+  std::atomic<uint64_t> flush_requested;
+  std::atomic<uint64_t> flush_completed;
+  // qxlogd 在每次轮询时更新；生产者据此判断 qxlogd 是否在线
+  std::atomic<int64_t> daemon_heartbeat;  // Unix 纳秒
+  std::atomic<int32_t> daemon_pid;
+  char name[64];
+};
+static_assert(sizeof(ShmSegmentHeader) <= shm_format::kHeaderSize,
+              "ShmSegmentHeader must fit in the reserved header");
+
+// 线程环头部，生产者与消费者的字段分处两个缓存行
+struct ShmRingHeader {
+  std::atomic<uint64_t> write_pos;
+  std::atomic<uint32_t> state;
+  uint32_t reserved;
+  std::atomic<uint64_t> committed;
+  std::atomic<uint64_t> dropped;
+  uint64_t read_pos_cache;  // 仅所属线程使用
+
+  alignas(64) std::atomic<uint64_t> read_pos;
+  std::atomic<uint64_t> consumed;
+};
+static_assert(sizeof(ShmRingHeader) == shm_format::kRingHeaderSize,
+              "ShmRingHeader must match the reserved ring header");
+
+// 记录头，紧跟编码后的参数（或 kVerbatim 时的消息文本）
+struct ShmRecordHeader {
+  uint64_t time;         // TSC 计数，带 kEventTime 时为事件时间
+  uint32_t format_id;    // 生产者进程 FormatRegistry 中的 ID
+  uint32_t args_size;
+  uint32_t callsite_id;  // 段字典中的调用点 ID
+  uint32_t logger_id;    // 生产者进程的 LoggerId
+  uint32_t thread_id;
+  uint8_t level;
+  uint8_t arg_count;
+  uint8_t flags;
+  uint8_t reserved;
+};
+static_assert(sizeof(ShmRecordHeader) == 32,
+              "ShmRecordHeader must stay 8-byte aligned");
+
+// 线程本地的线程环表：记录当前线程在各段中占用的线程环
+struct ShmThreadRings {
+  struct Entry {
+    uint64_t producer_id;
+    std::shared_ptr<ShmProducer> producer;
+    ShmRingHeader* ring;  // 没有分到线程环时为 nullptr
+  };
+
+  ~ShmThreadRings();
+
+  // 最近一次使用的段，绝大多数进程只有一个
+  uint64_t last_id = 0;
+  ShmRingHeader* last_ring = nullptr;
+  uint32_t thread_id = 0;
+  std::vector<Entry> entries;
+};
+
+inline ShmThreadRings& LocalShmRings() {
+  thread_local ShmThreadRings rings;
+  return rings;
+}
+
+// 进程启动时间（/proc/<pid>/stat 第 22 项），读取失败时返回 0
+uint64_t ProcessStartTime(int pid);
+
+// pid 对应的进程是否仍在运行且启动时间一致（排除 pid 复用和僵尸进程）
+bool ProcessAlive(int pid, uint64_t start_time);
+
+}  // namespace internal
+
+// 共享内存段的生产者端
+//
+// 调用线程把记录头与 arg_codec 编码的参数写入本线程独占的线程环，首次
+// 使用的格式串、调用点和日志器名字追加到段字典。写路径不格式化、不加锁、
+// 不做系统调用；时间戳为原始 TSC 计数，由 qxlogd 换算（x86 上各进程读到
+// 同一个计数器，其他平台为系统级的 steady_clock）。
+class ShmProducer : public std::enable_shared_from_this<ShmProducer> {
+ public:
+  ~ShmProducer();
+
+  ShmProducer(const ShmProducer&) = delete;
+  ShmProducer& operator=(const ShmProducer&) = delete;
+
+  // 检查配置是否有效
+  static absl::Status ValidateOptions(const ShmOptions& options);
+
+  // 在 options.directory 下创建并映射段文件
+  static absl::Status Create(const std::string& name, const ShmOptions& options,
+                             std::shared_ptr<ShmProducer>* producer);
+
+  // 写入一条待格式化的记录；编码后超过单条上限或环满时丢弃并计数
+  template<typename... Args>
+  void write(LogLevel level, const Callsite* callsite, LoggerId logger_id,
+             RecordTime time, absl::string_view format, const Args&... args) {
+    static_assert(sizeof...(Args) <= 255, "too many log arguments");
+    internal::ShmRingHeader* ring = local_ring();
+    if (ring == nullptr) {
+      header_->unclaimed.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    uint32_t format_id = InternFormatCached(format);
+    if (!export_format(format_id, format)) {
+      // 字典已满：在调用线程上格式化，按文本传输
+      fmt::memory_buffer& buffer = internal::ThreadFormatBuffer();
+      buffer.clear();
+      fmt::vformat_to(fmt::appender(buffer),
+                      fmt::string_view(format.data(), format.size()),
+                      fmt::make_format_args(args...));
+      write_text(level, callsite, logger_id, time,
+                 absl::string_view(buffer.data(), buffer.size()));
+      return;
+    }
+    size_t args_size = EncodedArgsSize(args...);
+    size_t advance = 0;
+    char* dst =
+        reserve(ring, sizeof(internal::ShmRecordHeader) + args_size, &advance);
+    if (dst == nullptr) {
+      return;
+    }
+    internal::ShmRecordHeader header;
+    fill_header(&header, level, callsite, logger_id, time, args_size);
+    header.format_id = format_id;
+    header.arg_count = static_cast<uint8_t>(sizeof...(Args));
+    std::memcpy(dst, &header, sizeof(header));
+    EncodeArgs(dst + sizeof(header), args...);
+    commit(ring, advance);
+  }
+
+  // 写入一条已格式化的记录
+  void write_text(LogLevel level, const Callsite* callsite, LoggerId logger_id,
+                  RecordTime time, absl::string_view message);
+
+  // 请求 qxlogd 写出此前提交的全部记录并刷新输出；qxlogd 不在线或超时
+  // 返回 false
+  bool flush(std::chrono::milliseconds timeout);
+
+  // 标记段已关闭，qxlogd 写完剩余记录后删除段文件
+  void close();
+
+  // qxlogd 是否在线（最近一次心跳在 kDaemonTimeout 之内）
+  bool daemon_alive() const;
+
+  // 统计信息，各线程环计数之和
+  ShmStats stats() const;
+
+  const std::string& path() const { return path_; }
+
+  // 单条记录（含 32 字节记录头）的最大字节数
+  size_t max_record_size() const {
+    return ring_capacity_ / 4 - shm_format::kFrameSize;
+  }
+
+ private:
+  friend struct internal::ShmThreadRings;
+
+  ShmProducer() = default;
+
+  // 当前线程在本段中的线程环，首次调用时分配
+  internal::ShmRingHeader* local_ring() {
+    internal::ShmThreadRings& local = internal::LocalShmRings();
+    if (local.last_id == id_) {
+      return local.last_ring;
+    }
+    return claim_ring(local);
+  }
+  internal::ShmRingHeader* claim_ring(internal::ShmThreadRings& local);
+  internal::ShmRingHeader* ring_at(uint32_t index) const;
+
+  // 预留 size 字节的帧，环满或超过单条上限时计入 dropped 并返回 nullptr
+  char* reserve(internal::ShmRingHeader* ring, size_t size, size_t* advance) {
+    size_t total = AlignedFrameSize(size);
+    if (size > max_record_size()) {
+      ring->dropped.store(ring->dropped.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+      return nullptr;
+    }
+    uint64_t write_pos = ring->write_pos.load(std::memory_order_relaxed);
+    size_t offset = write_pos & (ring_capacity_ - 1);
+    size_t padding =
+        offset + total > ring_capacity_ ? ring_capacity_ - offset : 0;
+    size_t required = padding + total;
+    if (ring_capacity_ - (write_pos - ring->read_pos_cache) < required &&
+        !wait_for_space(ring, write_pos, required)) {
+      return nullptr;
+    }
+
+    char* data = reinterpret_cast<char*>(ring) + shm_format::kRingHeaderSize;
+    if (padding != 0) {
+      PutFrame(data + offset,
+               static_cast<uint32_t>(padding - shm_format::kFrameSize),
+               shm_format::kPaddingFrame);
+      offset = 0;
+    }
+    PutFrame(data + offset, static_cast<uint32_t>(size), 0);
+    *advance = required;
+    return data + offset + shm_format::kFrameSize;
+  }
+
+  // 发布 reserve 预留的帧
+  void commit(internal::ShmRingHeader* ring, size_t advance) {
+    // 只有所属线程写这两个字段，不需要原子读改写
+    ring->committed.store(ring->committed.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+    ring->write_pos.store(
+        ring->write_pos.load(std::memory_order_relaxed) + advance,
+        std::memory_order_release);
+  }
+
+  // 刷新消费位置，空间仍不足时按溢出策略等待；放弃时计入 dropped
+  bool wait_for_space(internal::ShmRingHeader* ring, uint64_t write_pos,
+                      size_t required);
+
+  void fill_header(internal::ShmRecordHeader* header, LogLevel level,
+                   const Callsite* callsite, LoggerId logger_id,
+                   RecordTime time, size_t args_size) {
+    header->time = time.value;
+    header->format_id = 0;
+    header->args_size = static_cast<uint32_t>(args_size);
+    header->callsite_id = export_callsite(callsite);
+    header->logger_id = export_logger(logger_id) ? logger_id : kNoLoggerId;
+    header->thread_id = internal::LocalShmRings().thread_id;
+    header->level = static_cast<uint8_t>(LogLevelToInt(level));
+    header->arg_count = 0;
+    header->flags = time.is_event ? shm_format::kEventTime : 0;
+    header->reserved = 0;
+  }
+
+  // 把格式串写入字典，已写入时只做一次位图读取；字典已满时返回 false
+  bool export_format(uint32_t format_id, absl::string_view format) {
+    if (format_id < kMaxExportedIds &&
+        (exported_formats_[format_id / 64].load(std::memory_order_relaxed) &
+         (uint64_t{1} << (format_id % 64)))) {
+      return true;
+    }
+    return export_format_slow(format_id, format);
+  }
+  bool export_format_slow(uint32_t format_id, absl::string_view format);
+
+  // 返回调用点在字典中的 ID，callsite 为空或字典已满时返回 kNoCallsiteId
+  uint32_t export_callsite(const Callsite* callsite);
+
+  // 把日志器名字写入字典，字典已满时返回 false
+  bool export_logger(LoggerId logger_id) {
+    if (logger_id == kNoLoggerId) {
+      return true;
+    }
+    if (logger_id < kMaxExportedIds &&
+        (exported_loggers_[logger_id / 64].load(std::memory_order_relaxed) &
+         (uint64_t{1} << (logger_id % 64)))) {
+      return true;
+    }
+    return export_logger_slow(logger_id);
+  }
+  bool export_logger_slow(LoggerId logger_id);
+
+  // 追加一个字典条目，调用方持有 dictionary_mutex_
+  bool append_entry_locked(uint32_t kind, uint32_t id, uint32_t aux,
+                           absl::string_view first, absl::string_view second);
+
+  static size_t AlignedFrameSize(size_t size) {
+    return (size + shm_format::kFrameSize + 7) & ~static_cast<size_t>(7);
+  }
+
+  static void PutFrame(char* dst, uint32_t size, uint32_t flags) {
+    std::memcpy(dst, &size, sizeof(size));
+    std::memcpy(dst + sizeof(size), &flags, sizeof(flags));
+  }
+
+  static constexpr size_t kMaxExportedIds = 65536;
+
+  uint64_t id_ = 0;
+  std::string path_;
+  char* region_ = nullptr;
+  size_t region_size_ = 0;
+  internal::ShmSegmentHeader* header_ = nullptr;
+  char* dictionary_ = nullptr;
+  char* rings_ = nullptr;
+  size_t ring_capacity_ = 0;
+  OverflowPolicy overflow_policy_ = OverflowPolicy::kDropNewest;
+
+  // 已写入字典的格式串和日志器 ID 位图，只增不减
+  std::unique_ptr<std::atomic<uint64_t>[]> exported_formats_;
+  std::unique_ptr<std::atomic<uint64_t>[]> exported_loggers_;
+  std::mutex dictionary_mutex_;
+  absl::flat_hash_map<const Callsite*, uint32_t> callsite_ids_;
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_SHM_TRANSPORT_H_
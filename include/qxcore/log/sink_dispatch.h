@@ -0,0 +1,75 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_SINK_DISPATCH_H_
+#define QXCORE_LOG_SINK_DISPATCH_H_
+
+#include <chrono>
+#include <vector>
+#include <spdlog/common.h>
+#include <spdlog/details/log_msg.h>
+#include "qxcore/log/callsite.h"
+#include "qxcore/log/log_level.h"
+#include "qxcore/log/tsc_clock.h"
+
+namespace qxcore {
+namespace log {
+
+class GroupCommitSink;
+
+namespace internal {
+
+// LogLevel 与 spdlog::level::level_enum 的取值一一对应
+inline spdlog::level::level_enum ToSpdlogLevel(LogLevel level) {
+  return static_cast<spdlog::level::level_enum>(LogLevelToInt(level));
+}
+
+// 调用点对应的 spdlog 源码位置，callsite 为空时返回空位置
+inline spdlog::source_loc ToSourceLoc(const Callsite* callsite) {
+  if (callsite == nullptr) {
+    return spdlog::source_loc{};
+  }
+  return spdlog::source_loc{callsite->file(), callsite->line(),
+                            callsite->function()};
+}
+
+// 记录时间对应的 spdlog 时间点，TSC 计数按当前校准换算
+inline spdlog::log_clock::time_point ToLogTime(RecordTime time) {
+  return spdlog::log_clock::time_point(
+      std::chrono::duration_cast<spdlog::log_clock::duration>(
+          std::chrono::nanoseconds(TscClock::Global().to_unix_nanos(time))));
+}
+
+// 后台写线程把一条记录写入全部 sinks，单个 sink 出错不影响其他 sink
+void DispatchToSinks(const std::vector<spdlog::sink_ptr>& sinks,
+                     const spdlog::details::log_msg& msg);
+
+// 刷新全部 sinks
+void FlushSinks(const std::vector<spdlog::sink_ptr>& sinks);
+
+// sinks 中支持批量提交的 sink（见 group_commit_sink.h）
+std::vector<GroupCommitSink*> FindGroupCommitSinks(
+    const std::vector<spdlog::sink_ptr>& sinks);
+
+// 写线程开始连续写出，批量提交的 sink 开始累积本线程的记录
+void BeginSinkBatch(const std::vector<GroupCommitSink*>& sinks);
+
+// 写线程已取空待写记录，批量提交的 sink 立即写出累积的记录
+void EndSinkBatch(const std::vector<GroupCommitSink*>& sinks);
+
+}  // namespace internal
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_SINK_DISPATCH_H_
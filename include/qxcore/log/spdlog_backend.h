@@ -15,12 +15,23 @@
 #ifndef QXCORE_LOG_SPDLOG_BACKEND_H_
 #define QXCORE_LOG_SPDLOG_BACKEND_H_
 
+#include <atomic>
 #include <string>
 #include <memory>
 #include <absl/strings/string_view.h>
 #include <absl/status/status.h>
 #include <absl/strings/str_format.h>
+#include "qxcore/log/async_writer.h"
+#include "qxcore/log/callsite.h"
+#include "qxcore/log/dedup_filter.h"
+#include "qxcore/log/deferred_writer.h"
+#include "qxcore/log/format_string.h"
 #include "qxcore/log/log_level.h"
+#include "qxcore/log/log_options.h"
+#include "qxcore/log/logger_registry.h"
+#include "qxcore/log/sink_dispatch.h"
+#include "qxcore/log/tsc_clock.h"
+#include "qxcore/log/workload_capture.h"
 
 // 包含完整的 spdlog 头文件以支持模板函数
 #include <spdlog/spdlog.h>
@@ -28,9 +39,14 @@
 namespace qxcore {
 namespace log {
 
+class NonBlockingConsoleSink;
+
 // Spdlog 后端实现
 class SpdlogBackend {
  public:
+  // sinks 识别结构化负载（见 structured.h），Log 不必预先渲染为文本
+  static constexpr bool kStructuredPayload = true;
+
   SpdlogBackend() = default;
   ~SpdlogBackend();
 
@@ -38,12 +54,13 @@ class SpdlogBackend {
   SpdlogBackend(const SpdlogBackend&) = delete;
   SpdlogBackend& operator=(const SpdlogBackend&) = delete;
   
-  // 移动构造和赋值
-  SpdlogBackend(SpdlogBackend&&) = default;
-  SpdlogBackend& operator=(SpdlogBackend&&) = default;
+  // 以地址注册到 CallsiteRegistry，禁用移动
+  SpdlogBackend(SpdlogBackend&&) = delete;
+  SpdlogBackend& operator=(SpdlogBackend&&) = delete;
 
   // 初始化日志系统
-  absl::Status init(const std::string& name, LogLevel level = LogLevel::kInfo);
+  absl::Status init(const std::string& name, LogLevel level = LogLevel::kInfo,
+                    const LogOptions& options = LogOptions());
 
   // 设置日志级别
   absl::Status set_level(LogLevel level);
@@ -51,24 +68,69 @@ class SpdlogBackend {
   // 获取当前日志级别
   LogLevel get_level() const;
 
-  // 检查日志级别是否启用
-  bool is_enabled(LogLevel level) const;
+  // 检查日志级别是否启用：既不低于日志器级别，也至少有一个输出需要
+  bool is_enabled(LogLevel level) const {
+    return initialized_.load(std::memory_order_acquire) &&
+           IsLogLevelEnabled(enabled_level_.load(std::memory_order_relaxed),
+                             level);
+  }
 
   // 基础日志接口
-  void log(LogLevel level, absl::string_view msg);
+  void log(LogLevel level, absl::string_view msg) {
+    if (is_enabled(level)) {
+      write(level, nullptr, kNoLoggerId, RecordTime::Now(), msg);
+    }
+  }
+
+  // 调用点日志接口：级别已由调用点判断，只检查是否已初始化
+  void log(const Callsite& callsite, absl::string_view msg) {
+    if (initialized_.load(std::memory_order_acquire)) {
+      write(callsite.level(), &callsite, kNoLoggerId, RecordTime::Now(), msg);
+    }
+  }
 
   // 格式化日志接口
-  template<typename... Args>
-  void logf(LogLevel level, absl::string_view fmt_str, Args&&... args) {
-    if (!initialized_ || !is_enabled(level)) {
-      return;
+  //
+  // fmt_str 可以是 QXLOG_FMT 编译期格式串，也可以是运行期字符串；
+  // 不带参数的运行期字符串按原文输出
+  template<typename S, typename... Args>
+  void logf(LogLevel level, const S& fmt_str, Args&&... args) {
+    if (is_enabled(level)) {
+      writef(level, nullptr, kNoLoggerId, RecordTime::Now(), fmt_str, args...);
     }
+  }
 
-    try {
-      // 直接使用 spdlog 的格式化功能
-      logger_->log(ToSpdlogLevel(level), fmt_str, std::forward<Args>(args)...);
-    } catch (...) {
-      // 静默处理日志错误，避免异常传播
+  // 指定事件时间的格式化日志接口：记录使用调用方给定的时间戳，不读取时钟
+  template<typename S, typename... Args>
+  void logf(LogLevel level, EventTime time, const S& fmt_str, Args&&... args) {
+    if (is_enabled(level)) {
+      writef(level, nullptr, kNoLoggerId, RecordTime::Event(time), fmt_str,
+             args...);
+    }
+  }
+
+  template<typename S, typename... Args>
+  void logf(const Callsite& callsite, const S& fmt_str, Args&&... args) {
+    if (initialized_.load(std::memory_order_acquire)) {
+      writef(callsite.level(), &callsite, kNoLoggerId, RecordTime::Now(),
+             fmt_str, args...);
+    }
+  }
+
+  // 命名日志器接口：级别已由 LoggerRegistry 判断，记录以 logger_id 的名字
+  // 写入本后端的 sinks；callsite 可以为空
+  void log_named(LoggerId logger_id, LogLevel level, const Callsite* callsite,
+                 RecordTime time, absl::string_view msg) {
+    if (initialized_.load(std::memory_order_acquire) && sinks_accept(level)) {
+      write(level, callsite, logger_id, time, msg);
+    }
+  }
+
+  template<typename S, typename... Args>
+  void logf_named(LoggerId logger_id, LogLevel level, const Callsite* callsite,
+                  RecordTime time, const S& fmt_str, Args&&... args) {
+    if (initialized_.load(std::memory_order_acquire) && sinks_accept(level)) {
+      writef(level, callsite, logger_id, time, fmt_str, args...);
     }
   }
 
@@ -78,14 +140,121 @@ class SpdlogBackend {
   // 关闭日志系统
   void shutdown();
 
+  // 是否运行在异步模式（kAsync 或 kDeferred）
+  bool is_async() const {
+    return async_writer_ != nullptr || deferred_writer_ != nullptr;
+  }
+
+  // 异步模式统计信息，同步模式下全部为 0
+  AsyncStats async_stats() const;
+
+  // 被重复折叠丢弃的记录数，未启用时为 0
+  uint64_t dedup_suppressed() const {
+    return dedup_ != nullptr ? dedup_->suppressed() : 0;
+  }
+
+  // 非阻塞控制台因缓冲区已满丢弃的记录数，未启用时为 0
+  uint64_t console_dropped() const;
+
  private:
+  // 是否至少有一个输出的级别阈值不高于 level
+  bool sinks_accept(LogLevel level) const {
+    return IsLogLevelEnabled(sink_level_, level);
+  }
+
+  // 日志器级别为 level 时实际放行的级别
+  LogLevel enabled_level_for(LogLevel level) const {
+    return sinks_accept(level) ? level : sink_level_;
+  }
+
+  // 该级别的记录是否交给后台写线程
+  bool use_async(LogLevel level) const {
+    return is_async() &&
+           !(bypass_enabled_ && LogLevelToInt(level) >= LogLevelToInt(bypass_level_));
+  }
+
+  // 写出一条已通过级别检查的记录
+  void write(LogLevel level, const Callsite* callsite, LoggerId logger_id,
+             RecordTime time, absl::string_view msg);
+
+  // 重复记录折叠：返回 true 表示本条已计入上一条的重复段；否则先写出
+  // 刚结束的重复段汇总
+  bool fold_duplicate(const Callsite* callsite, LoggerId logger_id,
+                      uint64_t args_hash);
+
+  // 写出一段重复记录的汇总，级别与源码位置取自其调用点
+  void write_dedup_summary(const DedupRun& run);
+
+  // 在调用线程上同步写出
+  void write_sync(LogLevel level, const Callsite* callsite, LoggerId logger_id,
+                  RecordTime time, absl::string_view msg);
+
+  template<typename S, typename... Args>
+  void writef(LogLevel level, const Callsite* callsite, LoggerId logger_id,
+              RecordTime time, const S& fmt_str, const Args&... args) {
+    if constexpr (sizeof...(Args) == 0 && !kIsCompiledFormat<S>) {
+      if (dedup_ != nullptr && callsite != nullptr &&
+          fold_duplicate(callsite, logger_id,
+                         HashDedupArgs(FormatView(fmt_str)))) {
+        return;
+      }
+      write(level, callsite, logger_id, time, FormatView(fmt_str));
+    } else {
+      try {
+        // 重复判定在格式化之前，重复记录只付出一次参数哈希
+        if (dedup_ != nullptr && callsite != nullptr &&
+            fold_duplicate(callsite, logger_id, HashDedupArgs(args...))) {
+          return;
+        }
+        if (capture_ != nullptr) {
+          capture_->record(level, callsite, logger_id, FormatView(fmt_str),
+                           args...);
+        }
+        if (use_async(level)) {
+          // 延迟格式化：只编码参数，超出线程缓冲区单条上限时退回同步写出
+          if (deferred_writer_ != nullptr &&
+              deferred_writer_->log(callsite, logger_id, level, time,
+                                    FormatView(fmt_str), args...)) {
+            return;
+          }
+        }
+        // 在调用线程上格式化到线程本地缓冲区
+        fmt::memory_buffer& buffer = internal::ThreadFormatBuffer();
+        buffer.clear();
+        FormatTo(buffer, fmt_str, args...);
+        if (use_async(level) && async_writer_ != nullptr) {
+          // 写出交给后台线程
+          async_writer_->enqueue(
+              level, absl::string_view(buffer.data(), buffer.size()), callsite,
+              logger_id, time);
+          return;
+        }
+        write_sync(level, callsite, logger_id, time,
+                   absl::string_view(buffer.data(), buffer.size()));
+      } catch (...) {
+        // 静默处理日志错误，避免异常传播
+      }
+    }
+  }
+
   // 转换日志级别
   static spdlog::level::level_enum ToSpdlogLevel(LogLevel level);
   static LogLevel FromSpdlogLevel(spdlog::level::level_enum level);
 
   std::shared_ptr<spdlog::logger> logger_;
-  LogLevel current_level_ = LogLevel::kInfo;
-  bool initialized_ = false;
+  std::unique_ptr<AsyncWriter> async_writer_;
+  std::unique_ptr<DeferredWriter> deferred_writer_;
+  std::unique_ptr<WorkloadCapture> capture_;
+  std::unique_ptr<DedupFilter> dedup_;
+  NonBlockingConsoleSink* console_sink_ = nullptr;  // 由 logger_ 持有
+  bool bypass_enabled_ = false;
+  LogLevel bypass_level_ = LogLevel::kCritical;
+  // 各输出级别阈值中的最低者
+  LogLevel sink_level_ = LogLevel::kTrace;
+  std::atomic<LogLevel> current_level_{LogLevel::kInfo};
+  // current_level_ 与 sink_level_ 中较高者，决定记录是否格式化
+  std::atomic<LogLevel> enabled_level_{LogLevel::kInfo};
+  std::atomic<bool> initialized_{false};
 };
 
 }  // namespace log
@@ -0,0 +1,160 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_SPSC_RING_H_
+#define QXCORE_LOG_SPSC_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <absl/strings/string_view.h>
+
+namespace qxcore {
+namespace log {
+
+// 单生产者单消费者变长字节环形缓冲区
+//
+// 每条记录以 8 字节帧头 [uint32 长度][uint32 标志] 开始并按 8 字节对齐，
+// 记录在缓冲区内总是连续存放：尾部空间不足时写入填充帧并回绕到起点。
+class SpscByteRing {
+ public:
+  // capacity 会向上取整为 2 的幂，最小 4KB
+  explicit SpscByteRing(size_t capacity)
+      : capacity_(RoundUpPowerOfTwo(capacity)),
+        mask_(capacity_ - 1),
+        buffer_(new char[capacity_]) {}
+
+  SpscByteRing(const SpscByteRing&) = delete;
+  SpscByteRing& operator=(const SpscByteRing&) = delete;
+
+  // 单条记录允许的最大负载
+  size_t max_record_size() const { return capacity_ / 4 - kFrameSize; }
+
+  size_t capacity() const { return capacity_; }
+
+  // 生产者：预留 size 字节，空间不足返回 nullptr
+  char* reserve(size_t size) {
+    if (size > max_record_size()) {
+      return nullptr;
+    }
+    size_t total = AlignedFrameSize(size);
+    size_t offset = write_pos_local_ & mask_;
+    size_t padding = offset + total > capacity_ ? capacity_ - offset : 0;
+    size_t required = padding + total;
+
+    if (capacity_ - (write_pos_local_ - read_pos_cache_) < required) {
+      read_pos_cache_ = read_pos_.load(std::memory_order_acquire);
+      if (capacity_ - (write_pos_local_ - read_pos_cache_) < required) {
+        return nullptr;
+      }
+    }
+
+    if (padding != 0) {
+      WriteFrame(offset, static_cast<uint32_t>(padding - kFrameSize),
+                 kPaddingFlag);
+      offset = 0;
+    }
+    WriteFrame(offset, static_cast<uint32_t>(size), 0);
+    pending_advance_ = required;
+    return buffer_.get() + offset + kFrameSize;
+  }
+
+  // 生产者：发布最近一次 reserve 的记录
+  void commit() {
+    write_pos_local_ += pending_advance_;
+    pending_advance_ = 0;
+    write_pos_.store(write_pos_local_, std::memory_order_release);
+  }
+
+  // 消费者：查看下一条记录，缓冲区为空时返回空视图（data 为 nullptr）
+  absl::string_view peek() {
+    for (;;) {
+      if (read_pos_local_ == write_pos_cache_) {
+        write_pos_cache_ = write_pos_.load(std::memory_order_acquire);
+        if (read_pos_local_ == write_pos_cache_) {
+          return absl::string_view();
+        }
+      }
+      size_t offset = read_pos_local_ & mask_;
+      uint32_t size;
+      uint32_t flags;
+      std::memcpy(&size, buffer_.get() + offset, sizeof(size));
+      std::memcpy(&flags, buffer_.get() + offset + sizeof(size), sizeof(flags));
+      if (flags & kPaddingFlag) {
+        read_pos_local_ += size + kFrameSize;
+        continue;
+      }
+      current_size_ = size;
+      return absl::string_view(buffer_.get() + offset + kFrameSize, size);
+    }
+  }
+
+  // 消费者：释放 peek 返回的记录
+  void release() {
+    read_pos_local_ += AlignedFrameSize(current_size_);
+    read_pos_.store(read_pos_local_, std::memory_order_release);
+  }
+
+  // 是否为空（可在任意线程调用，结果为近似值）
+  bool empty() const {
+    return read_pos_.load(std::memory_order_acquire) ==
+           write_pos_.load(std::memory_order_acquire);
+  }
+
+ private:
+  static constexpr size_t kFrameSize = 8;
+  static constexpr uint32_t kPaddingFlag = 1;
+  static constexpr size_t kCacheLineSize = 64;
+
+  static size_t RoundUpPowerOfTwo(size_t value) {
+    size_t result = 4096;
+    while (result < value) {
+      result <<= 1;
+    }
+    return result;
+  }
+
+  static size_t AlignedFrameSize(size_t size) {
+    return (size + kFrameSize + 7) & ~static_cast<size_t>(7);
+  }
+
+  void WriteFrame(size_t offset, uint32_t size, uint32_t flags) {
+    std::memcpy(buffer_.get() + offset, &size, sizeof(size));
+    std::memcpy(buffer_.get() + offset + sizeof(size), &flags, sizeof(flags));
+  }
+
+  const size_t capacity_;
+  const size_t mask_;
+  std::unique_ptr<char[]> buffer_;
+
+  // 生产者私有状态
+  alignas(kCacheLineSize) size_t write_pos_local_ = 0;
+  size_t read_pos_cache_ = 0;
+  size_t pending_advance_ = 0;
+
+  // 消费者私有状态
+  alignas(kCacheLineSize) size_t read_pos_local_ = 0;
+  size_t write_pos_cache_ = 0;
+  size_t current_size_ = 0;
+
+  alignas(kCacheLineSize) std::atomic<size_t> write_pos_{0};
+  alignas(kCacheLineSize) std::atomic<size_t> read_pos_{0};
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_SPSC_RING_H_
@@ -0,0 +1,180 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef QXCORE_LOG_STRUCTURED_H_
+#define QXCORE_LOG_STRUCTURED_H_
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <absl/strings/string_view.h>
+#include "qxcore/log/arg_codec.h"
+#include "qxcore/log/fmt.h"
+
+namespace qxcore {
+namespace log {
+
+// 结构化字段，由 kv() 创建，只在所属的日志调用内有效
+template<typename T>
+struct KeyValue {
+  absl::string_view key;
+  const T& value;
+};
+
+// 结构化日志字段：logger.info("order_ack", kv("id", id), kv("px", px))
+//
+// 值在写出前保持原始类型：数值、布尔、字符与字符串按类型编码，其他类型
+// 在调用线程上格式化为文本
+template<typename T>
+KeyValue<T> kv(absl::string_view key, const T& value) {
+  return KeyValue<T>{key, value};
+}
+
+namespace internal {
+
+template<typename T>
+struct IsKeyValue : std::false_type {};
+
+template<typename T>
+struct IsKeyValue<KeyValue<T>> : std::true_type {};
+
+}  // namespace internal
+
+// 参数是否全部为结构化字段（至少一个）
+template<typename... Args>
+constexpr bool kIsStructured =
+    sizeof...(Args) > 0 &&
+    (internal::IsKeyValue<std::decay_t<Args>>::value && ...);
+
+// 结构化负载
+//
+// 结构化记录以普通消息的形式经过后端与写线程，负载以 2 字节标记开头：
+//   [标记][uint32 事件名长度][事件名][uint32 字段数]
+//   每个字段：[uint32 键长度][键][值，编码同 arg_codec.h]
+// 文本格式化器把它渲染为 "事件名 键=值 ..."，JsonLinesSink 渲染为一行 JSON。
+constexpr char kStructuredMagic[] = "\x1fS";
+constexpr size_t kStructuredMagicSize = 2;
+
+// 负载是否为结构化编码
+inline bool IsStructuredPayload(absl::string_view payload) {
+  return payload.size() >= kStructuredMagicSize &&
+         std::memcmp(payload.data(), kStructuredMagic,
+                     kStructuredMagicSize) == 0;
+}
+
+namespace internal {
+
+inline char* PutStructuredString(char* dst, absl::string_view value) {
+  uint32_t size = static_cast<uint32_t>(value.size());
+  std::memcpy(dst, &size, sizeof(size));
+  dst += sizeof(size);
+  std::memcpy(dst, value.data(), value.size());
+  return dst + value.size();
+}
+
+}  // namespace internal
+
+// 结构化负载编码后的字节数
+template<typename... Fields>
+size_t EncodedStructuredSize(absl::string_view event, const Fields&... fields) {
+  return kStructuredMagicSize + 4 + event.size() + 4 +
+         (size_t{0} + ... + (4 + fields.key.size() + EncodedArgSize(fields.value)));
+}
+
+// 编码结构化负载，返回写入后的位置；dst 至少有 EncodedStructuredSize 字节
+template<typename... Fields>
+char* EncodeStructured(char* dst, absl::string_view event,
+                       const Fields&... fields) {
+  std::memcpy(dst, kStructuredMagic, kStructuredMagicSize);
+  dst = internal::PutStructuredString(dst + kStructuredMagicSize, event);
+  uint32_t count = static_cast<uint32_t>(sizeof...(Fields));
+  std::memcpy(dst, &count, sizeof(count));
+  dst += sizeof(count);
+  ((dst = EncodeArg(internal::PutStructuredString(dst, fields.key), fields.value)),
+   ...);
+  return dst;
+}
+
+// 解码后的字段，视图引用负载中的字节
+struct StructuredField {
+  absl::string_view key;
+  ArgType type = ArgType::kString;
+  int64_t int_value = 0;     // kBool kChar kInt32 kInt64
+  uint64_t uint_value = 0;   // kUInt32 kUInt64 kPointer
+  double double_value = 0;   // kFloat kDouble
+  absl::string_view text;    // kString
+};
+
+struct StructuredRecord {
+  absl::string_view event;
+  std::vector<StructuredField> fields;
+};
+
+// 解析结构化负载，负载不是结构化编码或已损坏时返回 false；
+// record 的字段向量被复用，解析不分配内存（字段数不超过已有容量时）
+bool ParseStructured(absl::string_view payload, StructuredRecord* record);
+
+// 按文本格式渲染："事件名 键=值 ..."，含空白、引号或等号的字符串值加引号
+void AppendStructuredText(const StructuredRecord& record, fmt::appender out);
+
+// 按文本格式渲染单个字段："键=值"
+void AppendStructuredField(const StructuredField& field, fmt::appender out);
+
+// 结构化负载的文本形式；payload 不是结构化编码时原样返回。结果引用
+// 线程本地缓冲区，在本线程下一次调用前有效
+absl::string_view StructuredPayloadText(absl::string_view payload);
+
+namespace internal {
+
+// 编码结构化负载到线程本地缓冲区并返回其视图；as_text 为 true 时返回
+// 渲染后的文本，供不识别结构化负载的后端使用
+template<typename... Fields>
+absl::string_view EncodeStructuredMessage(bool as_text,
+                                          absl::string_view event,
+                                          const Fields&... fields) {
+  thread_local std::string buffer;
+  buffer.resize(EncodedStructuredSize(event, fields...));
+  EncodeStructured(buffer.data(), event, fields...);
+  return as_text ? StructuredPayloadText(buffer) : absl::string_view(buffer);
+}
+
+// 后端是否声明 kStructuredPayload，即其 sinks 能识别结构化负载
+template<typename Backend, typename = void>
+constexpr bool kAcceptsStructured = false;
+
+template<typename Backend>
+constexpr bool kAcceptsStructured<
+    Backend, std::void_t<decltype(Backend::kStructuredPayload)>> =
+    Backend::kStructuredPayload;
+
+}  // namespace internal
+
+}  // namespace log
+}  // namespace qxcore
+
+// 字段也可以混在普通格式参数中，此时按 "键=值" 格式化
+template<typename T>
+struct fmt::formatter<qxcore::log::KeyValue<T>> : fmt::formatter<fmt::string_view> {
+  template<typename FormatContext>
+  auto format(const qxcore::log::KeyValue<T>& field, FormatContext& ctx) const {
+    return fmt::format_to(ctx.out(), "{}={}",
+                          fmt::string_view(field.key.data(), field.key.size()),
+                          field.value);
+  }
+};
+
+#endif  // QXCORE_LOG_STRUCTURED_H_
@@ -0,0 +1,138 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifndef QXCORE_LOG_TSC_CLOCK_H_
+#define QXCORE_LOG_TSC_CLOCK_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define QXCORE_LOG_HAVE_RDTSC 1
+#endif
+
+namespace qxcore {
+namespace log {
+
+// 调用方给定的事件时间（Unix 纪元纳秒），如交易所或网卡硬件时间戳
+struct EventTime {
+  constexpr explicit EventTime(int64_t nanos) : unix_nanos(nanos) {}
+
+  int64_t unix_nanos;
+};
+
+// 记录时间：生产者线程读取的原始计数，或调用方给定的事件时间
+struct RecordTime {
+  uint64_t value = 0;
+  bool is_event = false;
+
+  // 读取当前计数，不做换算
+  static RecordTime Now();
+
+  static RecordTime Event(EventTime time) {
+    return RecordTime{static_cast<uint64_t>(time.unix_nanos), true};
+  }
+};
+
+// 基于 TSC 的记录时钟
+//
+// 生产者只读取原始计数（x86 上为 rdtsc，其他平台为 steady_clock 纳秒），
+// 写出记录时再换算为墙上时间。换算参数通过 seqlock 发布；距离上次校准
+// 超过 kCalibrationInterval 时，下一次换算顺带重新校准，因此校准发生在
+// 写出记录的线程上（异步模式下为后台写线程）。
+class TscClock {
+ public:
+  // 重新校准的间隔
+  static constexpr std::chrono::nanoseconds kCalibrationInterval =
+      std::chrono::seconds(1);
+
+  // 是否使用 rdtsc；为 false 时计数即 steady_clock 纳秒
+#ifdef QXCORE_LOG_HAVE_RDTSC
+  static constexpr bool kUsesTsc = true;
+#else
+  static constexpr bool kUsesTsc = false;
+#endif
+
+  // 进程级全局实例，首次调用时完成初始校准
+  static TscClock& Global();
+
+  TscClock(const TscClock&) = delete;
+  TscClock& operator=(const TscClock&) = delete;
+
+  // 读取原始计数
+  static uint64_t ReadTicks() {
+#ifdef QXCORE_LOG_HAVE_RDTSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#endif
+  }
+
+  // 把原始计数换算为 Unix 纳秒，必要时先重新校准
+  int64_t to_unix_nanos(uint64_t ticks);
+
+  // 记录时间对应的 Unix 纳秒，事件时间原样返回
+  int64_t to_unix_nanos(RecordTime time) {
+    return time.is_event ? static_cast<int64_t>(time.value)
+                         : to_unix_nanos(time.value);
+  }
+
+  // 立即重新校准
+  void calibrate();
+
+  // 当前估计的每个计数对应的纳秒数
+  double nanos_per_tick() const {
+    return nanos_per_tick_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  TscClock();
+
+  // 同时读取计数与墙上时间，计数取墙上时间读取前后的中点
+  static void ReadPair(uint64_t* ticks, int64_t* unix_nanos);
+
+  // 按当前参数换算，不检查是否需要校准
+  int64_t convert(uint64_t ticks) const;
+
+  // 发布新的换算参数，调用方持有 mutex_
+  void publish_locked(uint64_t base_ticks, int64_t base_nanos,
+                      double nanos_per_tick);
+
+  std::mutex mutex_;
+  // 首次校准的锚点，用于累积长基线估计频率
+  uint64_t anchor_ticks_ = 0;
+  int64_t anchor_nanos_ = 0;
+
+  std::atomic<uint32_t> sequence_{0};
+  std::atomic<uint64_t> base_ticks_{0};
+  std::atomic<int64_t> base_nanos_{0};
+  std::atomic<double> nanos_per_tick_{1.0};
+  std::atomic<uint64_t> next_calibration_ticks_{0};
+};
+
+inline RecordTime RecordTime::Now() {
+  return RecordTime{TscClock::ReadTicks(), false};
+}
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_TSC_CLOCK_H_
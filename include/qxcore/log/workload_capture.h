@@ -0,0 +1,204 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef QXCORE_LOG_WORKLOAD_CAPTURE_H_
+#define QXCORE_LOG_WORKLOAD_CAPTURE_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <absl/container/flat_hash_map.h>
+#include <absl/status/status.h>
+#include <absl/strings/string_view.h>
+#include <absl/types/span.h>
+#include "qxcore/log/arg_codec.h"
+#include "qxcore/log/callsite.h"
+#include "qxcore/log/log_level.h"
+#include "qxcore/log/logger_registry.h"
+
+namespace qxcore {
+namespace log {
+
+// 负载采集文件格式
+//
+// 文件以 8 字节文件头 [uint32 magic][uint32 版本] 开始，其后是连续记录，
+// 每条记录以 1 字节类型开头：
+//   kSiteDef    varint ID, 标志, varint 行号, varint 长度, 文件名,
+//               varint 长度, 格式串
+//   kLoggerDef  varint ID, varint 长度, 日志器名称
+//   kEvent      varint 到达间隔(ns), 级别, varint 调用点 ID, varint 日志器 ID,
+//               varint 线程序号, varint 参数个数, 每个参数为 ArgType 标签
+//               加 varint 字节数
+// 只记录参数的类型与长度，不记录参数值。日志器 ID 0 表示后端自身，命名
+// 日志器从 1 开始；线程按首次出现的顺序从 0 编号。定义记录总是出现在
+// 首次引用它的事件之前，文件头按小端序写入。
+namespace capture_format {
+
+constexpr uint32_t kFileMagic = 0x54435851;  // "QXCT"
+constexpr uint32_t kVersion = 1;
+constexpr size_t kFileHeaderSize = 8;
+
+enum class RecordType : uint8_t {
+  kSiteDef = 1,
+  kLoggerDef = 2,
+  kEvent = 3,
+};
+
+// 调用点标志：不带格式化参数的 log(level, msg) 调用，参数为消息本身
+constexpr uint8_t kPlainSite = 1;
+
+}  // namespace capture_format
+
+// 一个参数的形状
+struct CapturedArg {
+  ArgType type = ArgType::kString;
+  uint32_t size = 0;  // 字符串为字节数，其余类型为值的字节数
+};
+
+namespace internal {
+
+template<typename T>
+CapturedArg CaptureArgOf(const T& value) {
+  constexpr ArgType type = NativeArgType<T>();
+  // EncodedArgSize 含 1 字节标签，字符串另含 4 字节长度
+  size_t encoded = EncodedArgSize(value);
+  size_t size = type == ArgType::kString ? encoded - 5 : encoded - 1;
+  return CapturedArg{type, static_cast<uint32_t>(size)};
+}
+
+}  // namespace internal
+
+// 日志负载采集器
+//
+// 记录每次日志调用的形状：调用点、级别、参数类型与长度、线程和到达间隔，
+// 供 qxlog_replay 按原有节奏回放。调用线程加锁后追加到缓冲区，只在
+// 首次出现的调用点、日志器和线程上分配内存。采集用于诊断，会串行化
+// 所有日志调用，不应在延迟敏感的配置中常开。
+class WorkloadCapture {
+ public:
+  // buffer_size 为写出前累积的字节数
+  explicit WorkloadCapture(size_t buffer_size = 64 * 1024);
+  ~WorkloadCapture();
+
+  WorkloadCapture(const WorkloadCapture&) = delete;
+  WorkloadCapture& operator=(const WorkloadCapture&) = delete;
+
+  // 创建（截断）采集文件并写入文件头
+  absl::Status open(const std::string& path);
+
+  // 记录一次格式化日志调用
+  template<typename... Args>
+  void record(LogLevel level, const Callsite* callsite, LoggerId logger_id,
+              absl::string_view format, const Args&... args) {
+    CapturedArg shapes[sizeof...(Args) + 1] = {internal::CaptureArgOf(args)...,
+                                               CapturedArg{}};
+    append(level, callsite, logger_id, format, false,
+           absl::MakeConstSpan(shapes, sizeof...(Args)));
+  }
+
+  // 记录一次不带参数的消息调用
+  void record_plain(LogLevel level, const Callsite* callsite,
+                    LoggerId logger_id, size_t message_size);
+
+  // 把缓冲区写入文件并刷新到操作系统
+  absl::Status flush();
+
+  // 写出剩余数据并关闭文件，返回采集过程中的首个写入错误
+  absl::Status close();
+
+  // 已记录的调用数
+  uint64_t events() const;
+
+ private:
+  void append(LogLevel level, const Callsite* callsite, LoggerId logger_id,
+              absl::string_view format, bool plain,
+              absl::Span<const CapturedArg> args);
+
+  // 以下函数要求持有 mutex_
+  uint32_t site_id(const Callsite* callsite, absl::string_view format,
+                   bool plain);
+  uint32_t logger_index(LoggerId logger_id);
+  uint32_t thread_index();
+  void write_buffer();
+
+  const size_t buffer_size_;
+  mutable std::mutex mutex_;
+  std::FILE* file_ = nullptr;
+  std::string buffer_;
+  absl::Status status_;
+  int64_t last_time_ns_ = 0;
+  uint64_t events_ = 0;
+
+  absl::flat_hash_map<const Callsite*, uint32_t> callsite_sites_;
+  absl::flat_hash_map<std::string, uint32_t> format_sites_;
+  uint32_t plain_site_ = 0;  // 无调用点的消息调用，0 表示尚未定义
+  uint32_t next_site_ = 0;
+  absl::flat_hash_map<LoggerId, uint32_t> loggers_;
+  absl::flat_hash_map<std::thread::id, uint32_t, std::hash<std::thread::id>>
+      threads_;
+};
+
+// 采集文件中的一个调用点
+struct CapturedSite {
+  std::string file;
+  int line = 0;
+  std::string format;
+  bool plain = false;
+};
+
+// 采集文件中的一次调用
+struct CapturedEvent {
+  int64_t time_ns = 0;  // 相对首次调用的时间
+  LogLevel level = LogLevel::kInfo;
+  uint32_t site = 0;
+  uint32_t logger = 0;  // 0 为后端自身，其余为 loggers() 的下标
+  uint32_t thread = 0;
+  uint32_t first_arg = 0;  // 在 args() 中的起始下标
+  uint32_t arg_count = 0;
+};
+
+// 完整载入内存的采集文件
+class WorkloadTrace {
+ public:
+  // 读取采集文件；尾部不完整的记录（如进程退出前未刷新）被忽略，
+  // 文件头无效或记录损坏时返回 DataLoss
+  absl::Status load(const std::string& path);
+
+  const std::vector<CapturedSite>& sites() const { return sites_; }
+  // 下标 0 为空串，对应后端自身
+  const std::vector<std::string>& loggers() const { return loggers_; }
+  const std::vector<CapturedEvent>& events() const { return events_; }
+  uint32_t thread_count() const { return thread_count_; }
+
+  absl::Span<const CapturedArg> args(const CapturedEvent& event) const {
+    return absl::MakeConstSpan(args_.data() + event.first_arg,
+                               event.arg_count);
+  }
+
+ private:
+  std::vector<CapturedSite> sites_;
+  std::vector<std::string> loggers_;
+  std::vector<CapturedEvent> events_;
+  std::vector<CapturedArg> args_;
+  uint32_t thread_count_ = 0;
+};
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_LOG_WORKLOAD_CAPTURE_H_
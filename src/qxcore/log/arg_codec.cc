@@ -0,0 +1,142 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/arg_codec.h"
+
+#include <absl/strings/str_format.h>
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+template<typename V>
+bool ReadValue(const char*& cursor, const char* end, V& value) {
+  if (static_cast<size_t>(end - cursor) < sizeof(V)) {
+    return false;
+  }
+  std::memcpy(&value, cursor, sizeof(V));
+  cursor += sizeof(V);
+  return true;
+}
+
+}  // anonymous namespace
+
+absl::Status DecodeArgs(const char* data, size_t size, size_t count,
+                        FormatArgStore& store) {
+  const char* cursor = data;
+  const char* end = data + size;
+  for (size_t i = 0; i < count; ++i) {
+    if (cursor >= end) {
+      return absl::DataLossError("Truncated argument list");
+    }
+    ArgType type = static_cast<ArgType>(*cursor++);
+    bool ok = true;
+    switch (type) {
+      case ArgType::kBool: {
+        uint8_t value = 0;
+        ok = ReadValue(cursor, end, value);
+        store.push_back(value != 0);
+        break;
+      }
+      case ArgType::kChar: {
+        char value = 0;
+        ok = ReadValue(cursor, end, value);
+        store.push_back(value);
+        break;
+      }
+      case ArgType::kInt32: {
+        int32_t value = 0;
+        ok = ReadValue(cursor, end, value);
+        store.push_back(value);
+        break;
+      }
+      case ArgType::kUInt32: {
+        uint32_t value = 0;
+        ok = ReadValue(cursor, end, value);
+        store.push_back(value);
+        break;
+      }
+      case ArgType::kInt64: {
+        int64_t value = 0;
+        ok = ReadValue(cursor, end, value);
+        store.push_back(value);
+        break;
+      }
+      case ArgType::kUInt64: {
+        uint64_t value = 0;
+        ok = ReadValue(cursor, end, value);
+        store.push_back(value);
+        break;
+      }
+      case ArgType::kFloat: {
+        float value = 0;
+        ok = ReadValue(cursor, end, value);
+        store.push_back(value);
+        break;
+      }
+      case ArgType::kDouble: {
+        double value = 0;
+        ok = ReadValue(cursor, end, value);
+        store.push_back(value);
+        break;
+      }
+      case ArgType::kPointer: {
+        uint64_t value = 0;
+        ok = ReadValue(cursor, end, value);
+        store.push_back(
+            reinterpret_cast<const void*>(static_cast<uintptr_t>(value)));
+        break;
+      }
+      case ArgType::kString: {
+        uint32_t length = 0;
+        ok = ReadValue(cursor, end, length) &&
+             static_cast<size_t>(end - cursor) >= length;
+        if (ok) {
+          store.push_back(fmt::string_view(cursor, length));
+          cursor += length;
+        }
+        break;
+      }
+      default:
+        return absl::DataLossError(
+            absl::StrFormat("Unknown argument type %d", static_cast<int>(type)));
+    }
+    if (!ok) {
+      return absl::DataLossError("Truncated argument value");
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status FormatEncoded(absl::string_view fmt_str, const char* data,
+                           size_t size, size_t count, FormatArgStore& store,
+                           fmt::memory_buffer& out) {
+  store.clear();
+  absl::Status status = DecodeArgs(data, size, count, store);
+  if (!status.ok()) {
+    return status;
+  }
+  try {
+    fmt::vformat_to(fmt::appender(out),
+                    fmt::string_view(fmt_str.data(), fmt_str.size()), store);
+  } catch (const std::exception& e) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Failed to format '%s': %s", fmt_str, e.what()));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace log
+}  // namespace qxcore
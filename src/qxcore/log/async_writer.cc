@@ -0,0 +1,297 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/async_writer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <limits>
+#include <spdlog/details/log_msg.h>
+#include <spdlog/details/os.h>
+#include "qxcore/log/log_context.h"
+#include "qxcore/log/sink_dispatch.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+// 写线程空转多少轮后进入休眠
+constexpr int kIdleSpins = 64;
+
+// 写线程单次休眠的最长时间，用于兜底可能丢失的唤醒
+constexpr std::chrono::milliseconds kMaxIdleWait(5);
+
+// 阻塞策略下生产者自旋多少次后开始休眠
+constexpr int kBlockSpins = 64;
+constexpr std::chrono::microseconds kBlockSleep(50);
+
+}  // anonymous namespace
+
+AsyncWriter::AsyncWriter(std::string logger_name,
+                         std::vector<spdlog::sink_ptr> sinks,
+                         const AsyncOptions& options)
+    : logger_name_(std::move(logger_name)),
+      sinks_(std::move(sinks)),
+      batch_sinks_(internal::FindGroupCommitSinks(sinks_)),
+      options_(options),
+      queue_(options.queue_capacity),
+      arena_(new char[queue_.capacity() * options.inline_message_size]) {
+  for (size_t i = 0; i < queue_.capacity(); ++i) {
+    AsyncRecord& record = queue_.slot(i);
+    record.inline_capacity = static_cast<uint32_t>(options_.inline_message_size);
+    record.inline_data = arena_.get() + i * options_.inline_message_size;
+  }
+}
+
+AsyncWriter::~AsyncWriter() {
+  stop();
+}
+
+absl::Status AsyncWriter::ValidateOptions(const AsyncOptions& options) {
+  if (options.queue_capacity == 0) {
+    return absl::InvalidArgumentError("Async queue capacity must be positive");
+  }
+  if (options.inline_message_size == 0 ||
+      options.inline_message_size > std::numeric_limits<uint32_t>::max()) {
+    return absl::InvalidArgumentError("Invalid async inline message size");
+  }
+  return absl::OkStatus();
+}
+
+absl::Status AsyncWriter::start() {
+  if (running_.load(std::memory_order_acquire)) {
+    return absl::AlreadyExistsError("Async writer already started");
+  }
+  stopping_.store(false, std::memory_order_relaxed);
+  running_.store(true, std::memory_order_release);
+  thread_ = std::thread(&AsyncWriter::run, this);
+  return absl::OkStatus();
+}
+
+void AsyncWriter::stop() {
+  if (!running_.load(std::memory_order_acquire)) {
+    return;
+  }
+  stopping_.store(true, std::memory_order_release);
+  wake_writer();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  running_.store(false, std::memory_order_release);
+
+  // 唤醒可能仍在等待的 flush 调用方
+  std::lock_guard<std::mutex> lock(mutex_);
+  flush_cv_.notify_all();
+}
+
+bool AsyncWriter::enqueue(LogLevel level, absl::string_view payload,
+                          const Callsite* callsite, LoggerId logger_id,
+                          RecordTime time) {
+  // 消息与上下文合计不超过 uint32 上限，超出部分截断
+  constexpr size_t kMaxSize = std::numeric_limits<uint32_t>::max();
+  payload = payload.substr(0, kMaxSize);
+  absl::string_view context =
+      CurrentLogContext().substr(0, kMaxSize - payload.size());
+  auto fill = [&](AsyncRecord& record) {
+    record.time = time;
+    record.thread_id = spdlog::details::os::thread_id();
+    record.level = level;
+    record.callsite = callsite;
+    record.logger_id = logger_id;
+    record.size = static_cast<uint32_t>(payload.size());
+    record.context_size = static_cast<uint32_t>(context.size());
+    char* dst;
+    if (record.is_inline()) {
+      dst = record.inline_data;
+    } else {
+      record.spill.resize(payload.size() + context.size());
+      dst = record.spill.data();
+    }
+    std::memcpy(dst, payload.data(), payload.size());
+    std::memcpy(dst + payload.size(), context.data(), context.size());
+  };
+
+  bool pushed = queue_.try_push(fill);
+  if (!pushed) {
+    switch (options_.overflow_policy) {
+      case OverflowPolicy::kDropNewest:
+        dropped_newest_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+
+      case OverflowPolicy::kDropOldest:
+        while (!pushed) {
+          if (queue_.try_pop([](AsyncRecord&) {})) {
+            dropped_oldest_.fetch_add(1, std::memory_order_relaxed);
+          }
+          pushed = queue_.try_push(fill);
+        }
+        break;
+
+      case OverflowPolicy::kBlock:
+        for (int attempt = 0; !pushed; ++attempt) {
+          if (!running_.load(std::memory_order_acquire) ||
+              stopping_.load(std::memory_order_acquire)) {
+            dropped_newest_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+          }
+          wake_writer();
+          if (attempt < kBlockSpins) {
+            std::this_thread::yield();
+          } else {
+            std::this_thread::sleep_for(kBlockSleep);
+          }
+          pushed = queue_.try_push(fill);
+        }
+        break;
+    }
+  }
+
+  if (sleeping_.load(std::memory_order_relaxed)) {
+    wake_writer();
+  }
+  return true;
+}
+
+void AsyncWriter::flush() {
+  if (!running_.load(std::memory_order_acquire)) {
+    internal::FlushSinks(sinks_);
+    return;
+  }
+
+  size_t target = queue_.enqueue_position();
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (target > flush_target_) {
+    flush_target_ = target;
+  }
+  wake_cv_.notify_one();
+  flush_cv_.wait(lock, [&] {
+    return flushed_position_ >= target ||
+           !running_.load(std::memory_order_acquire);
+  });
+}
+
+AsyncStats AsyncWriter::stats() const {
+  AsyncStats stats;
+  // 先读写出数再读入队位置，保证 written 不超过 enqueued
+  stats.written = written_.load(std::memory_order_acquire);
+  stats.dropped_newest = dropped_newest_.load(std::memory_order_relaxed);
+  stats.dropped_oldest = dropped_oldest_.load(std::memory_order_relaxed);
+  stats.enqueued = queue_.enqueue_position();
+  return stats;
+}
+
+void AsyncWriter::run() {
+  int idle_spins = 0;
+  bool in_batch = false;
+  for (;;) {
+    // 队列非空时开始一批，取空后立即提交：空闲时逐条写出，负载高时合并
+    if (!in_batch && !batch_sinks_.empty() && queue_.size_approx() != 0) {
+      internal::BeginSinkBatch(batch_sinks_);
+      in_batch = true;
+    }
+    if (write_one()) {
+      idle_spins = 0;
+      continue;
+    }
+    if (in_batch) {
+      internal::EndSinkBatch(batch_sinks_);
+      in_batch = false;
+    }
+
+    handle_flush_requests();
+
+    if (stopping_.load(std::memory_order_acquire)) {
+      // 生产者已停止，写出剩余记录后退出
+      while (write_one()) {
+      }
+      internal::FlushSinks(sinks_);
+      std::lock_guard<std::mutex> lock(mutex_);
+      flushed_position_ = queue_.dequeue_position();
+      flush_cv_.notify_all();
+      return;
+    }
+
+    if (++idle_spins < kIdleSpins) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    sleeping_.store(true, std::memory_order_relaxed);
+    if (queue_.size_approx() == 0 &&
+        !stopping_.load(std::memory_order_acquire) &&
+        flush_target_ <= flushed_position_) {
+      wake_cv_.wait_for(lock, kMaxIdleWait);
+    }
+    sleeping_.store(false, std::memory_order_relaxed);
+    idle_spins = 0;
+  }
+}
+
+bool AsyncWriter::write_one() {
+  return queue_.try_pop([this](AsyncRecord& record) {
+    write_record(record);
+    if (!record.is_inline()) {
+      // 超长消息释放临时内存，避免槽位长期持有大块堆内存
+      std::string().swap(record.spill);
+    }
+  });
+}
+
+void AsyncWriter::write_record(const AsyncRecord& record) {
+  absl::string_view name = LoggerNameOr(record.logger_id, logger_name_);
+  spdlog::details::log_msg msg(internal::ToLogTime(record.time),
+                               internal::ToSourceLoc(record.callsite),
+                               spdlog::string_view_t(name.data(), name.size()),
+                               internal::ToSpdlogLevel(record.level),
+                               record.payload());
+  msg.thread_id = record.thread_id;
+  internal::RecordContextScope context(record.context());
+  internal::DispatchToSinks(sinks_, msg);
+  // 只有写线程写该计数，不需要原子读改写
+  written_.store(written_.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_release);
+}
+
+void AsyncWriter::handle_flush_requests() {
+  size_t target;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    target = flush_target_;
+    if (target <= flushed_position_) {
+      return;
+    }
+  }
+  if (queue_.dequeue_position() < target) {
+    return;
+  }
+
+  internal::FlushSinks(sinks_);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  flushed_position_ = target;
+  flush_cv_.notify_all();
+}
+
+void AsyncWriter::wake_writer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+  }
+  wake_cv_.notify_one();
+}
+
+}  // namespace log
+}  // namespace qxcore
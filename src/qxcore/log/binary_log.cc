@@ -0,0 +1,540 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/binary_log.h"
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <absl/crc/crc32c.h>
+#include <absl/strings/str_format.h>
+#include "qxcore/log/format_registry.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+using binary_format::RecordType;
+
+void EncodeFixed32(char* dst, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    dst[i] = static_cast<char>(value >> (8 * i));
+  }
+}
+
+uint32_t DecodeFixed32(const char* src) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value |= static_cast<uint32_t>(static_cast<uint8_t>(src[i])) << (8 * i);
+  }
+  return value;
+}
+
+template<typename V>
+bool ReadRaw(const char*& cursor, const char* end, V& value) {
+  if (static_cast<size_t>(end - cursor) < sizeof(V)) {
+    return false;
+  }
+  std::memcpy(&value, cursor, sizeof(V));
+  cursor += sizeof(V);
+  return true;
+}
+
+void PutDefinition(std::string& out, RecordType type, uint32_t id,
+                   absl::string_view text) {
+  out.push_back(static_cast<char>(type));
+  internal::PutVarint(out, id);
+  internal::PutVarint(out, text.size());
+  out.append(text.data(), text.size());
+}
+
+}  // anonymous namespace
+
+// ---------------------------------------------------------------------------
+// BinaryLogWriter
+// ---------------------------------------------------------------------------
+
+BinaryLogWriter::BinaryLogWriter(size_t block_size)
+    : block_size_(block_size),
+      text_format_id_(FormatRegistry::Global().intern("{}")) {
+  block_.reserve(block_size_ + 1024);
+}
+
+BinaryLogWriter::~BinaryLogWriter() {
+  close().IgnoreError();
+}
+
+absl::Status BinaryLogWriter::open(const std::string& path, bool truncate) {
+  if (file_ != nullptr) {
+    return absl::AlreadyExistsError("Binary log already opened");
+  }
+  file_ = std::fopen(path.c_str(), truncate ? "wb" : "ab");
+  if (file_ == nullptr) {
+    return absl::InternalError(absl::StrFormat(
+        "Failed to open binary log %s: %s", path, std::strerror(errno)));
+  }
+  // 新文件（或追加段）不依赖之前写出的字典
+  block_.clear();
+  block_records_ = 0;
+  last_time_ns_ = 0;
+  defined_formats_.clear();
+  logger_ids_.clear();
+  return absl::OkStatus();
+}
+
+absl::Status BinaryLogWriter::append(const RawLogRecord& record) {
+  if (file_ == nullptr) {
+    return absl::FailedPreconditionError("Binary log not opened");
+  }
+
+  if (record.format_id >= defined_formats_.size()) {
+    defined_formats_.resize(record.format_id + 1, false);
+  }
+  if (!defined_formats_[record.format_id]) {
+    PutDefinition(block_, RecordType::kFormatDef, record.format_id,
+                  record.format);
+    defined_formats_[record.format_id] = true;
+    ++block_records_;
+  }
+  uint32_t logger = logger_id(record.logger_name);
+
+  size_t rollback = block_.size();
+  block_.push_back(static_cast<char>(RecordType::kEvent));
+  internal::PutVarint(block_,
+                      internal::ZigZagEncode(record.time_ns - last_time_ns_));
+  block_.push_back(static_cast<char>(LogLevelToInt(record.level)));
+  internal::PutVarint(block_, logger);
+  internal::PutVarint(block_, record.format_id);
+  internal::PutVarint(block_, record.thread_id);
+  internal::PutVarint(block_, record.arg_count);
+  if (!transcode_args(record.args, record.args_size, record.arg_count)) {
+    block_.resize(rollback);
+    return absl::InvalidArgumentError("Malformed encoded arguments");
+  }
+  last_time_ns_ = record.time_ns;
+  ++block_records_;
+
+  if (block_.size() >= block_size_) {
+    return seal_block();
+  }
+  return absl::OkStatus();
+}
+
+absl::Status BinaryLogWriter::append_text(int64_t time_ns, LogLevel level,
+                                          size_t thread_id,
+                                          absl::string_view logger_name,
+                                          absl::string_view message) {
+  std::string encoded(EncodedArgSize(message), '\0');
+  EncodeArg(&encoded[0], message);
+
+  RawLogRecord record;
+  record.time_ns = time_ns;
+  record.level = level;
+  record.thread_id = thread_id;
+  record.logger_name = logger_name;
+  record.format_id = text_format_id_;
+  record.format = "{}";
+  record.args = encoded.data();
+  record.args_size = encoded.size();
+  record.arg_count = 1;
+  return append(record);
+}
+
+absl::Status BinaryLogWriter::flush() {
+  if (file_ == nullptr) {
+    return absl::OkStatus();
+  }
+  absl::Status status = seal_block();
+  if (std::fflush(file_) != 0 && status.ok()) {
+    status = absl::InternalError(
+        absl::StrFormat("Failed to flush binary log: %s", std::strerror(errno)));
+  }
+  return status;
+}
+
+absl::Status BinaryLogWriter::close() {
+  if (file_ == nullptr) {
+    return absl::OkStatus();
+  }
+  absl::Status status = flush();
+  std::fclose(file_);
+  file_ = nullptr;
+  return status;
+}
+
+absl::Status BinaryLogWriter::seal_block() {
+  if (block_records_ == 0) {
+    return absl::OkStatus();
+  }
+
+  char header[binary_format::kBlockHeaderSize];
+  EncodeFixed32(header, binary_format::kBlockMagic);
+  EncodeFixed32(header + 4, static_cast<uint32_t>(block_.size()));
+  EncodeFixed32(header + 8, block_records_);
+  EncodeFixed32(header + 12,
+                static_cast<uint32_t>(absl::ComputeCrc32c(block_)));
+
+  bool ok = std::fwrite(header, sizeof(header), 1, file_) == 1 &&
+            std::fwrite(block_.data(), block_.size(), 1, file_) == 1;
+  bytes_written_ += sizeof(header) + block_.size();
+  block_.clear();
+  block_records_ = 0;
+  last_time_ns_ = 0;
+  if (!ok) {
+    return absl::InternalError(
+        absl::StrFormat("Failed to write binary log: %s", std::strerror(errno)));
+  }
+  return absl::OkStatus();
+}
+
+uint32_t BinaryLogWriter::logger_id(absl::string_view name) {
+  auto it = logger_ids_.find(name);
+  if (it != logger_ids_.end()) {
+    return it->second;
+  }
+  uint32_t id = static_cast<uint32_t>(logger_ids_.size());
+  logger_ids_.emplace(std::string(name), id);
+  PutDefinition(block_, RecordType::kLoggerDef, id, name);
+  ++block_records_;
+  return id;
+}
+
+bool BinaryLogWriter::transcode_args(const char* data, size_t size,
+                                     size_t count) {
+  const char* cursor = data;
+  const char* end = data + size;
+  for (size_t i = 0; i < count; ++i) {
+    if (cursor >= end) {
+      return false;
+    }
+    ArgType type = static_cast<ArgType>(*cursor++);
+    block_.push_back(static_cast<char>(type));
+    switch (type) {
+      case ArgType::kBool:
+      case ArgType::kChar: {
+        char value;
+        if (!ReadRaw(cursor, end, value)) {
+          return false;
+        }
+        block_.push_back(value);
+        break;
+      }
+      case ArgType::kInt32: {
+        int32_t value;
+        if (!ReadRaw(cursor, end, value)) {
+          return false;
+        }
+        internal::PutVarint(block_, internal::ZigZagEncode(value));
+        break;
+      }
+      case ArgType::kInt64: {
+        int64_t value;
+        if (!ReadRaw(cursor, end, value)) {
+          return false;
+        }
+        internal::PutVarint(block_, internal::ZigZagEncode(value));
+        break;
+      }
+      case ArgType::kUInt32: {
+        uint32_t value;
+        if (!ReadRaw(cursor, end, value)) {
+          return false;
+        }
+        internal::PutVarint(block_, value);
+        break;
+      }
+      case ArgType::kUInt64:
+      case ArgType::kPointer: {
+        uint64_t value;
+        if (!ReadRaw(cursor, end, value)) {
+          return false;
+        }
+        internal::PutVarint(block_, value);
+        break;
+      }
+      case ArgType::kFloat:
+      case ArgType::kDouble: {
+        size_t width = type == ArgType::kFloat ? 4 : 8;
+        if (static_cast<size_t>(end - cursor) < width) {
+          return false;
+        }
+        block_.append(cursor, width);
+        cursor += width;
+        break;
+      }
+      case ArgType::kString: {
+        uint32_t length;
+        if (!ReadRaw(cursor, end, length) ||
+            static_cast<size_t>(end - cursor) < length) {
+          return false;
+        }
+        internal::PutVarint(block_, length);
+        block_.append(cursor, length);
+        cursor += length;
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// BinaryLogReader
+// ---------------------------------------------------------------------------
+
+BinaryLogReader::~BinaryLogReader() {
+  close();
+}
+
+absl::Status BinaryLogReader::open(const std::string& path) {
+  if (file_ != nullptr) {
+    return absl::AlreadyExistsError("Binary log already opened");
+  }
+  file_ = std::fopen(path.c_str(), "rb");
+  if (file_ == nullptr) {
+    return absl::NotFoundError(absl::StrFormat(
+        "Failed to open binary log %s: %s", path, std::strerror(errno)));
+  }
+  file_offset_ = 0;
+  blocks_read_ = 0;
+  block_.clear();
+  cursor_ = end_ = nullptr;
+  formats_.clear();
+  loggers_.clear();
+  return absl::OkStatus();
+}
+
+void BinaryLogReader::close() {
+  if (file_ != nullptr) {
+    std::fclose(file_);
+    file_ = nullptr;
+  }
+}
+
+absl::Status BinaryLogReader::next(BinaryLogEntry* entry) {
+  if (file_ == nullptr) {
+    return absl::FailedPreconditionError("Binary log not opened");
+  }
+  for (;;) {
+    if (cursor_ == end_) {
+      absl::Status status = read_block();
+      if (!status.ok()) {
+        return status;
+      }
+      continue;
+    }
+    bool is_event = false;
+    absl::Status status = parse_record(entry, &is_event);
+    if (!status.ok()) {
+      // 损坏的块不再继续解析
+      cursor_ = end_;
+      return status;
+    }
+    if (is_event) {
+      return absl::OkStatus();
+    }
+  }
+}
+
+absl::Status BinaryLogReader::read_block() {
+  char header[binary_format::kBlockHeaderSize];
+  size_t read = std::fread(header, 1, sizeof(header), file_);
+  if (read == 0) {
+    return absl::OutOfRangeError("End of binary log");
+  }
+  if (read < sizeof(header)) {
+    return absl::DataLossError(absl::StrFormat(
+        "Truncated block header at offset %d", file_offset_));
+  }
+  if (DecodeFixed32(header) != binary_format::kBlockMagic) {
+    return absl::DataLossError(
+        absl::StrFormat("Bad block magic at offset %d", file_offset_));
+  }
+  uint32_t size = DecodeFixed32(header + 4);
+  uint32_t crc = DecodeFixed32(header + 12);
+
+  block_.resize(size);
+  if (size != 0 && std::fread(&block_[0], 1, size, file_) != size) {
+    return absl::DataLossError(absl::StrFormat(
+        "Truncated block payload at offset %d", file_offset_));
+  }
+  if (static_cast<uint32_t>(absl::ComputeCrc32c(block_)) != crc) {
+    return absl::DataLossError(
+        absl::StrFormat("Block checksum mismatch at offset %d", file_offset_));
+  }
+
+  file_offset_ += sizeof(header) + size;
+  ++blocks_read_;
+  cursor_ = block_.data();
+  end_ = block_.data() + block_.size();
+  last_time_ns_ = 0;
+  return absl::OkStatus();
+}
+
+absl::Status BinaryLogReader::parse_record(BinaryLogEntry* entry,
+                                           bool* is_event) {
+  RecordType type = static_cast<RecordType>(*cursor_++);
+  switch (type) {
+    case RecordType::kFormatDef:
+    case RecordType::kLoggerDef: {
+      uint64_t id;
+      uint64_t length;
+      if (!internal::GetVarint(cursor_, end_, id) ||
+          !internal::GetVarint(cursor_, end_, length) ||
+          static_cast<uint64_t>(end_ - cursor_) < length ||
+          id > std::numeric_limits<uint32_t>::max()) {
+        return absl::DataLossError("Malformed dictionary record");
+      }
+      auto& table = type == RecordType::kFormatDef ? formats_ : loggers_;
+      if (id >= table.size()) {
+        table.resize(id + 1);
+      }
+      table[id].assign(cursor_, length);
+      cursor_ += length;
+      *is_event = false;
+      return absl::OkStatus();
+    }
+
+    case RecordType::kEvent: {
+      uint64_t delta;
+      uint64_t logger;
+      uint64_t format;
+      uint64_t thread_id;
+      uint64_t count;
+      if (!internal::GetVarint(cursor_, end_, delta) || cursor_ >= end_) {
+        return absl::DataLossError("Malformed event record");
+      }
+      uint8_t level = static_cast<uint8_t>(*cursor_++);
+      if (!internal::GetVarint(cursor_, end_, logger) ||
+          !internal::GetVarint(cursor_, end_, format) ||
+          !internal::GetVarint(cursor_, end_, thread_id) ||
+          !internal::GetVarint(cursor_, end_, count)) {
+        return absl::DataLossError("Malformed event record");
+      }
+      if (logger >= loggers_.size() || format >= formats_.size() ||
+          level > LogLevelToInt(LogLevel::kCritical)) {
+        return absl::DataLossError("Event references undefined dictionary entry");
+      }
+
+      last_time_ns_ += internal::ZigZagDecode(delta);
+      entry->time_ns = last_time_ns_;
+      entry->level = static_cast<LogLevel>(level);
+      entry->thread_id = static_cast<size_t>(thread_id);
+      entry->logger_name = loggers_[logger];
+      entry->format = formats_[format];
+
+      store_.clear();
+      absl::Status status = decode_args(count);
+      if (!status.ok()) {
+        return status;
+      }
+      buffer_.clear();
+      try {
+        fmt::vformat_to(fmt::appender(buffer_),
+                        fmt::string_view(entry->format.data(),
+                                         entry->format.size()),
+                        store_);
+      } catch (const std::exception& e) {
+        buffer_.clear();
+        fmt::format_to(fmt::appender(buffer_), "[qxlog format error] {}",
+                       e.what());
+      }
+      entry->message.assign(buffer_.data(), buffer_.size());
+      *is_event = true;
+      return absl::OkStatus();
+    }
+
+    default:
+      return absl::DataLossError(absl::StrFormat(
+          "Unknown record type %d", static_cast<int>(type)));
+  }
+}
+
+absl::Status BinaryLogReader::decode_args(size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    if (cursor_ >= end_) {
+      return absl::DataLossError("Truncated argument list");
+    }
+    ArgType type = static_cast<ArgType>(*cursor_++);
+    uint64_t value = 0;
+    bool ok = true;
+    switch (type) {
+      case ArgType::kBool:
+      case ArgType::kChar: {
+        char byte = 0;
+        ok = ReadRaw(cursor_, end_, byte);
+        if (type == ArgType::kBool) {
+          store_.push_back(byte != 0);
+        } else {
+          store_.push_back(byte);
+        }
+        break;
+      }
+      case ArgType::kInt32:
+        ok = internal::GetVarint(cursor_, end_, value);
+        store_.push_back(static_cast<int32_t>(internal::ZigZagDecode(value)));
+        break;
+      case ArgType::kInt64:
+        ok = internal::GetVarint(cursor_, end_, value);
+        store_.push_back(internal::ZigZagDecode(value));
+        break;
+      case ArgType::kUInt32:
+        ok = internal::GetVarint(cursor_, end_, value);
+        store_.push_back(static_cast<uint32_t>(value));
+        break;
+      case ArgType::kUInt64:
+        ok = internal::GetVarint(cursor_, end_, value);
+        store_.push_back(value);
+        break;
+      case ArgType::kPointer:
+        ok = internal::GetVarint(cursor_, end_, value);
+        store_.push_back(
+            reinterpret_cast<const void*>(static_cast<uintptr_t>(value)));
+        break;
+      case ArgType::kFloat: {
+        float number = 0;
+        ok = ReadRaw(cursor_, end_, number);
+        store_.push_back(number);
+        break;
+      }
+      case ArgType::kDouble: {
+        double number = 0;
+        ok = ReadRaw(cursor_, end_, number);
+        store_.push_back(number);
+        break;
+      }
+      case ArgType::kString:
+        ok = internal::GetVarint(cursor_, end_, value) &&
+             static_cast<uint64_t>(end_ - cursor_) >= value;
+        if (ok) {
+          store_.push_back(fmt::string_view(cursor_, value));
+          cursor_ += value;
+        }
+        break;
+      default:
+        return absl::DataLossError(absl::StrFormat(
+            "Unknown argument type %d", static_cast<int>(type)));
+    }
+    if (!ok) {
+      return absl::DataLossError("Truncated argument value");
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,61 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/binary_sink.h"
+
+#include <chrono>
+#include "qxcore/log/structured.h"
+
+namespace qxcore {
+namespace log {
+
+BinaryFileSink::BinaryFileSink(size_t block_size) : writer_(block_size) {}
+
+absl::Status BinaryFileSink::open(const std::string& path, bool truncate) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return writer_.open(path, truncate);
+}
+
+void BinaryFileSink::log_raw(const RawLogRecord& record) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  // 写入失败时丢弃该记录，避免异常传播到写线程
+  writer_.append(record).IgnoreError();
+}
+
+uint64_t BinaryFileSink::bytes_written() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return writer_.bytes_written();
+}
+
+void BinaryFileSink::sink_it_(const spdlog::details::log_msg& msg) {
+  int64_t time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        msg.time.time_since_epoch())
+                        .count();
+  // LogLevel 与 spdlog::level::level_enum 的取值一一对应；结构化记录按
+  // 文本形式保存
+  writer_
+      .append_text(time_ns, static_cast<LogLevel>(msg.level), msg.thread_id,
+                   absl::string_view(msg.logger_name.data(),
+                                     msg.logger_name.size()),
+                   StructuredPayloadText(absl::string_view(
+                       msg.payload.data(), msg.payload.size())))
+      .IgnoreError();
+}
+
+void BinaryFileSink::flush_() {
+  writer_.flush().IgnoreError();
+}
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,181 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/callsite.h"
+
+#include <algorithm>
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+// path 是否以 suffix 结尾且在路径分隔符处对齐
+bool MatchesFileSuffix(absl::string_view path, absl::string_view suffix) {
+  if (suffix.empty() || path.size() < suffix.size() ||
+      path.substr(path.size() - suffix.size()) != suffix) {
+    return false;
+  }
+  if (path.size() == suffix.size() || suffix.front() == '/') {
+    return true;
+  }
+  char separator = path[path.size() - suffix.size() - 1];
+  return separator == '/' || separator == '\\';
+}
+
+}  // anonymous namespace
+
+CallsiteRegistry& CallsiteRegistry::Global() {
+  // 故意泄漏，保证静态析构阶段的日志调用仍可安全访问
+  static CallsiteRegistry* registry = new CallsiteRegistry();
+  return *registry;
+}
+
+void CallsiteRegistry::set_logger_level(const void* owner, LogLevel level) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  loggers_[owner] = level;
+  refresh_locked();
+}
+
+void CallsiteRegistry::remove_logger(const void* owner) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (loggers_.erase(owner) != 0) {
+    refresh_locked();
+  }
+}
+
+size_t CallsiteRegistry::set_override(absl::string_view file, int line,
+                                      CallsiteOverride value) {
+  if (value == CallsiteOverride::kNone) {
+    return update_rule(file, line, nullptr);
+  }
+  OverrideRule rule{std::string(file), line, false, LogLevel::kTrace, value};
+  return update_rule(file, line, &rule);
+}
+
+size_t CallsiteRegistry::set_level_override(absl::string_view file, int line,
+                                            LogLevel level) {
+  OverrideRule rule{std::string(file), line, true, level,
+                    CallsiteOverride::kNone};
+  return update_rule(file, line, &rule);
+}
+
+void CallsiteRegistry::clear_overrides() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  rules_.clear();
+  for (Callsite* callsite : callsites_) {
+    callsite->override_ = CallsiteOverride::kNone;
+    callsite->state_.store(compute_state(*callsite), std::memory_order_relaxed);
+  }
+}
+
+void CallsiteRegistry::for_each(
+    const std::function<void(const Callsite&)>& fn) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const Callsite* callsite : callsites_) {
+    fn(*callsite);
+  }
+}
+
+size_t CallsiteRegistry::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return callsites_.size();
+}
+
+uint8_t CallsiteRegistry::register_callsite(Callsite* callsite) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint8_t state = callsite->state_.load(std::memory_order_relaxed);
+  if (state != Callsite::kUnregistered) {
+    // 其他线程已完成注册
+    return state;
+  }
+  callsites_.push_back(callsite);
+  callsite->override_ = resolve_override(*callsite);
+  state = compute_state(*callsite);
+  callsite->state_.store(state, std::memory_order_relaxed);
+  return state;
+}
+
+size_t CallsiteRegistry::update_rule(absl::string_view file, int line,
+                                     const OverrideRule* rule) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  rules_.erase(std::remove_if(rules_.begin(), rules_.end(),
+                              [&](const OverrideRule& existing) {
+                                return existing.line == line &&
+                                       existing.file == file;
+                              }),
+               rules_.end());
+  if (rule != nullptr) {
+    rules_.push_back(*rule);
+  }
+
+  size_t matched = 0;
+  for (Callsite* callsite : callsites_) {
+    if ((line == 0 || callsite->line_ == line) &&
+        MatchesFileSuffix(callsite->file_, file)) {
+      callsite->override_ = resolve_override(*callsite);
+      callsite->state_.store(compute_state(*callsite),
+                             std::memory_order_relaxed);
+      ++matched;
+    }
+  }
+  return matched;
+}
+
+CallsiteOverride CallsiteRegistry::resolve_override(
+    const Callsite& callsite) const {
+  for (auto it = rules_.rbegin(); it != rules_.rend(); ++it) {
+    if ((it->line == 0 || callsite.line_ == it->line) &&
+        MatchesFileSuffix(callsite.file_, it->file)) {
+      if (!it->has_level) {
+        return it->value;
+      }
+      return IsLogLevelEnabled(it->level, callsite.level_)
+                 ? CallsiteOverride::kForceOn
+                 : CallsiteOverride::kForceOff;
+    }
+  }
+  return CallsiteOverride::kNone;
+}
+
+uint8_t CallsiteRegistry::compute_state(const Callsite& callsite) const {
+  switch (callsite.override_) {
+    case CallsiteOverride::kForceOn:
+      return Callsite::kForced;
+    case CallsiteOverride::kForceOff:
+      return Callsite::kForcedOff;
+    case CallsiteOverride::kNone:
+      break;
+  }
+  return LogLevelToInt(callsite.level_) >= min_level_ ? Callsite::kLevelEnabled
+                                                      : Callsite::kDisabled;
+}
+
+void CallsiteRegistry::refresh_locked() {
+  int min_level = kNoLoggers;
+  for (const auto& entry : loggers_) {
+    min_level = std::min(min_level, LogLevelToInt(entry.second));
+  }
+  if (min_level == min_level_) {
+    return;
+  }
+  min_level_ = min_level;
+  for (Callsite* callsite : callsites_) {
+    callsite->state_.store(compute_state(*callsite), std::memory_order_relaxed);
+  }
+}
+
+}  // namespace log
+}  // namespace qxcore
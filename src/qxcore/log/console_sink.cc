@@ -0,0 +1,273 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/console_sink.h"
+#include <limits.h>
+#include <poll.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <absl/strings/string_view.h>
+#include <spdlog/details/console_globals.h>
+#include <spdlog/details/os.h>
+#include <spdlog/pattern_formatter.h>
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+// 按 spdlog::level::level_enum 取值索引的 ANSI 颜色码
+constexpr absl::string_view kLevelColors[] = {
+    "\033[37m",           // trace: white
+    "\033[36m",           // debug: cyan
+    "\033[32m",           // info: green
+    "\033[33m\033[1m",    // warn: yellow bold
+    "\033[31m\033[1m",    // err: red bold
+    "\033[1m\033[41m",    // critical: bold on red
+    "\033[m",             // off: reset
+};
+constexpr absl::string_view kResetColor = "\033[m";
+
+// 写线程等待 target 可写的单次 poll 超时，到期后检查是否已开始析构
+constexpr int kPollTimeoutMs = 100;
+
+}  // anonymous namespace
+
+namespace internal {
+
+bool ShouldColorConsole(FILE* target, spdlog::color_mode mode) {
+  switch (mode) {
+    case spdlog::color_mode::always:
+      return true;
+    case spdlog::color_mode::automatic:
+      return spdlog::details::os::in_terminal(target) &&
+             spdlog::details::os::is_color_terminal();
+    default:
+      return false;
+  }
+}
+
+absl::string_view ConsoleLevelColor(spdlog::level::level_enum level) {
+  return kLevelColors[static_cast<size_t>(level)];
+}
+
+absl::string_view ConsoleResetColor() {
+  return kResetColor;
+}
+
+}  // namespace internal
+
+ConsoleSink::ConsoleSink(FILE* target, size_t buffer_size,
+                         spdlog::color_mode mode)
+    : target_(target),
+      mutex_(spdlog::details::console_mutex::mutex()),
+      should_color_(internal::ShouldColorConsole(target, mode)),
+      formatter_(std::make_unique<spdlog::pattern_formatter>()) {
+  buffer_.reserve(buffer_size);
+}
+
+void ConsoleSink::log(const spdlog::details::log_msg& msg) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  msg.color_range_start = 0;
+  msg.color_range_end = 0;
+  buffer_.clear();
+  formatter_->format(msg, buffer_);
+  if (should_color_ && msg.color_range_end > msg.color_range_start) {
+    write_range(0, msg.color_range_start);
+    absl::string_view color = internal::ConsoleLevelColor(msg.level);
+    spdlog::details::os::fwrite_bytes(color.data(), color.size(), target_);
+    write_range(msg.color_range_start, msg.color_range_end);
+    spdlog::details::os::fwrite_bytes(kResetColor.data(), kResetColor.size(),
+                                      target_);
+    write_range(msg.color_range_end, buffer_.size());
+  } else {
+    write_range(0, buffer_.size());
+  }
+  fflush(target_);
+}
+
+void ConsoleSink::flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  fflush(target_);
+}
+
+void ConsoleSink::set_pattern(const std::string& pattern) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  formatter_ = std::make_unique<spdlog::pattern_formatter>(pattern);
+}
+
+void ConsoleSink::set_formatter(std::unique_ptr<spdlog::formatter> formatter) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  formatter_ = std::move(formatter);
+}
+
+void ConsoleSink::write_range(size_t begin, size_t end) {
+  spdlog::details::os::fwrite_bytes(buffer_.data() + begin, end - begin,
+                                    target_);
+}
+
+NonBlockingConsoleSink::NonBlockingConsoleSink(FILE* target,
+                                               size_t buffer_size,
+                                               size_t format_buffer_size,
+                                               spdlog::color_mode mode)
+    : target_(target),
+      fd_(fileno(target)),
+      capacity_(buffer_size),
+      should_color_(internal::ShouldColorConsole(target, mode)),
+      formatter_(std::make_unique<spdlog::pattern_formatter>()) {
+  // 之后绕过 stdio 直接写文件描述符，先写出 stdio 中已缓冲的文本
+  fflush(target_);
+  buffer_.reserve(format_buffer_size);
+  pending_.reserve(capacity_);
+  output_.reserve(capacity_);
+  thread_ = std::thread(&NonBlockingConsoleSink::run, this);
+}
+
+NonBlockingConsoleSink::~NonBlockingConsoleSink() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    drain_deadline_ = std::chrono::steady_clock::now() + kFlushTimeout;
+    stopping_.store(true, std::memory_order_release);
+  }
+  wake_cv_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void NonBlockingConsoleSink::log(const spdlog::details::log_msg& msg) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  msg.color_range_start = 0;
+  msg.color_range_end = 0;
+  buffer_.clear();
+  formatter_->format(msg, buffer_);
+
+  bool color = should_color_ && msg.color_range_end > msg.color_range_start;
+  absl::string_view level_color = internal::ConsoleLevelColor(msg.level);
+  size_t size = buffer_.size();
+  if (color) {
+    size += level_color.size() + kResetColor.size();
+  }
+  if (pending_.size() + size > capacity_) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  // 缓冲区由空变为非空时写线程可能在等待，其余情况它会自行取走
+  bool was_empty = pending_.empty();
+  if (color) {
+    append_range(0, msg.color_range_start);
+    pending_.append(level_color.data(), level_color.size());
+    append_range(msg.color_range_start, msg.color_range_end);
+    pending_.append(kResetColor.data(), kResetColor.size());
+    append_range(msg.color_range_end, buffer_.size());
+  } else {
+    append_range(0, buffer_.size());
+  }
+  if (was_empty) {
+    wake_cv_.notify_one();
+  }
+}
+
+void NonBlockingConsoleSink::flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  drained_cv_.wait_for(lock, kFlushTimeout,
+                       [this] { return pending_.empty() && !writing_; });
+}
+
+void NonBlockingConsoleSink::set_pattern(const std::string& pattern) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  formatter_ = std::make_unique<spdlog::pattern_formatter>(pattern);
+}
+
+void NonBlockingConsoleSink::set_formatter(
+    std::unique_ptr<spdlog::formatter> formatter) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  formatter_ = std::move(formatter);
+}
+
+void NonBlockingConsoleSink::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    wake_cv_.wait(lock, [this] {
+      return !pending_.empty() || stopping_.load(std::memory_order_relaxed);
+    });
+    if (pending_.empty()) {
+      return;
+    }
+    // 交换后两块缓冲区都保留预留的容量
+    output_.swap(pending_);
+    writing_ = true;
+    lock.unlock();
+    write_output();
+    output_.clear();
+    lock.lock();
+    writing_ = false;
+    drained_cv_.notify_all();
+  }
+}
+
+void NonBlockingConsoleSink::write_output() {
+  size_t offset = 0;
+  while (offset < output_.size()) {
+    if (stopping_.load(std::memory_order_acquire) &&
+        std::chrono::steady_clock::now() >= drain_deadline_) {
+      break;
+    }
+    pollfd pfd{fd_, POLLOUT, 0};
+    int ready = ::poll(&pfd, 1, kPollTimeoutMs);
+    if (ready < 0 && errno != EINTR) {
+      break;
+    }
+    if (ready <= 0) {
+      continue;
+    }
+    if ((pfd.revents & POLLOUT) == 0) {
+      // POLLERR/POLLHUP/POLLNVAL：读端已关闭或描述符无效
+      break;
+    }
+
+    // 不超过 PIPE_BUF 的写入在管道上是原子的，POLLOUT 后也不会阻塞
+    size_t size = std::min(output_.size() - offset, size_t{PIPE_BUF});
+    if (offset + size < output_.size()) {
+      size_t newline =
+          absl::string_view(output_.data() + offset, size).rfind('\n');
+      if (newline != absl::string_view::npos) {
+        size = newline + 1;
+      }
+    }
+    ssize_t written = ::write(fd_, output_.data() + offset, size);
+    if (written < 0) {
+      if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK) {
+        continue;
+      }
+      break;
+    }
+    offset += static_cast<size_t>(written);
+  }
+  if (offset < output_.size()) {
+    dropped_.fetch_add(static_cast<uint64_t>(std::count(
+                           output_.begin() + offset, output_.end(), '\n')),
+                       std::memory_order_relaxed);
+  }
+}
+
+void NonBlockingConsoleSink::append_range(size_t begin, size_t end) {
+  pending_.append(buffer_.data() + begin, end - begin);
+}
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,188 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/dedup_filter.h"
+#include <algorithm>
+#include <chrono>
+#include <absl/strings/str_format.h>
+#include "qxcore/log/rate_limit.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+std::atomic<uint64_t> g_next_filter_id{1};
+
+// 每个线程缓存的过滤器槽位数
+constexpr size_t kThreadSlotCache = 4;
+
+// 定时线程的最长扫描间隔
+constexpr std::chrono::milliseconds kMaxSweepInterval{100};
+
+}  // anonymous namespace
+
+absl::Status DedupFilter::ValidateOptions(const DedupOptions& options) {
+  if (options.window_ms < 1 || options.window_ms > 3600000) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Dedup window must be in [1, 3600000] ms, got %d",
+                        options.window_ms));
+  }
+  return absl::OkStatus();
+}
+
+DedupFilter::DedupFilter(const DedupOptions& options)
+    : window_nanos_(static_cast<int64_t>(options.window_ms) * 1000000),
+      id_(g_next_filter_id.fetch_add(1, std::memory_order_relaxed)),
+      slots_(new Slot[kSlots]) {}
+
+DedupFilter::~DedupFilter() {
+  stop();
+}
+
+absl::Status DedupFilter::start(SummaryCallback emit) {
+  if (thread_.joinable()) {
+    return absl::AlreadyExistsError("Dedup timer already started");
+  }
+  emit_ = std::move(emit);
+  stopping_ = false;
+  thread_ = std::thread(&DedupFilter::run, this);
+  return absl::OkStatus();
+}
+
+void DedupFilter::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+bool DedupFilter::admit(const Callsite* callsite, LoggerId logger_id,
+                        uint64_t args_hash, DedupRun* finished) {
+  int64_t now = internal::RateLimitNowNanos();
+  Slot& slot = thread_slot();
+  std::lock_guard<std::mutex> lock(slot.mutex);
+  if (callsite == slot.callsite && logger_id == slot.logger_id &&
+      args_hash == slot.args_hash && now - slot.start_nanos < window_nanos_) {
+    ++slot.repeats;
+    slot.last_nanos = now;
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  if (!take_locked(slot, finished)) {
+    finished->repeats = 0;
+  }
+  slot.callsite = callsite;
+  slot.logger_id = logger_id;
+  slot.args_hash = args_hash;
+  slot.start_nanos = now;
+  slot.last_nanos = now;
+  return false;
+}
+
+bool DedupFilter::take(DedupRun* finished) {
+  return take_first(false, finished);
+}
+
+bool DedupFilter::take_expired(DedupRun* finished) {
+  return take_first(true, finished);
+}
+
+DedupFilter::Slot& DedupFilter::thread_slot() {
+  struct Entry {
+    uint64_t filter_id = 0;
+    Slot* slot = nullptr;
+  };
+  thread_local Entry cache[kThreadSlotCache];
+  thread_local size_t victim = 0;
+
+  for (const Entry& entry : cache) {
+    if (entry.filter_id == id_) {
+      return *entry.slot;
+    }
+  }
+  // 槽位不回收，线程数超过 kSlots 后按顺序共用
+  Entry& entry = cache[victim++ % kThreadSlotCache];
+  entry.filter_id = id_;
+  entry.slot =
+      &slots_[next_slot_.fetch_add(1, std::memory_order_relaxed) % kSlots];
+  return *entry.slot;
+}
+
+bool DedupFilter::take_first(bool expired_only, DedupRun* finished) {
+  int64_t now = internal::RateLimitNowNanos();
+  for (size_t i = 0; i < kSlots; ++i) {
+    Slot& slot = slots_[i];
+    std::lock_guard<std::mutex> lock(slot.mutex);
+    if (expired_only && (slot.repeats == 0 ||
+                         now - slot.start_nanos < window_nanos_)) {
+      continue;
+    }
+    bool taken = take_locked(slot, finished);
+    // 之后的相同记录重新按首条写出
+    slot.callsite = nullptr;
+    if (taken) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool DedupFilter::take_locked(Slot& slot, DedupRun* finished) {
+  if (slot.repeats == 0) {
+    return false;
+  }
+  finished->callsite = slot.callsite;
+  finished->logger_id = slot.logger_id;
+  finished->repeats = slot.repeats;
+  finished->span_nanos = slot.last_nanos - slot.start_nanos;
+  slot.repeats = 0;
+  return true;
+}
+
+void DedupFilter::run() {
+  // 窗口较短时按窗口扫描，汇总最多比窗口晚一个扫描周期写出
+  auto interval = std::min<std::chrono::nanoseconds>(
+      std::chrono::nanoseconds(window_nanos_), kMaxSweepInterval);
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!cv_.wait_for(lock, interval, [this] { return stopping_; })) {
+    lock.unlock();
+    DedupRun run;
+    while (take_expired(&run)) {
+      try {
+        emit_(run);
+      } catch (...) {
+        // 静默处理日志错误，避免异常传播
+      }
+    }
+    lock.lock();
+  }
+}
+
+std::string FormatDedupSummary(const DedupRun& run) {
+  const char* format =
+      run.callsite != nullptr && run.callsite->format() != nullptr
+          ? run.callsite->format()
+          : "";
+  return absl::StrFormat("\"%s\" repeated %d times over %d ms", format,
+                         run.repeats, run.span_nanos / 1000000);
+}
+
+}  // namespace log
+}  // namespace qxcore
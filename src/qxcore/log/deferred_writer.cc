@@ -0,0 +1,424 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/deferred_writer.h"
+
+#include <algorithm>
+#include <limits>
+#include <spdlog/details/log_msg.h>
+#include <spdlog/details/os.h>
+#include "qxcore/log/sink_dispatch.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+// 写线程空转多少轮后进入休眠
+constexpr int kIdleSpins = 64;
+
+// 写线程单次休眠的最长时间，用于兜底可能丢失的唤醒
+constexpr std::chrono::milliseconds kMaxIdleWait(5);
+
+// 阻塞策略下生产者自旋多少次后开始休眠
+constexpr int kBlockSpins = 64;
+constexpr std::chrono::microseconds kBlockSleep(50);
+
+// 线程缓冲区最小容量
+constexpr size_t kMinThreadBufferSize = 4096;
+
+std::atomic<uint64_t> g_next_writer_id{1};
+
+}  // anonymous namespace
+
+DeferredWriter::DeferredWriter(std::string logger_name,
+                               std::vector<spdlog::sink_ptr> sinks,
+                               const AsyncOptions& options)
+    : logger_name_(std::move(logger_name)),
+      sinks_(std::move(sinks)),
+      options_(options),
+      id_(g_next_writer_id.fetch_add(1, std::memory_order_relaxed)),
+      clock_(TscClock::Global()) {
+  for (const auto& sink : sinks_) {
+    auto* raw_sink = dynamic_cast<RawRecordSink*>(sink.get());
+    if (raw_sink != nullptr) {
+      raw_sinks_.emplace_back(sink, raw_sink);
+    } else {
+      text_sinks_.push_back(sink);
+    }
+  }
+  batch_sinks_ = internal::FindGroupCommitSinks(sinks_);
+}
+
+DeferredWriter::~DeferredWriter() {
+  stop();
+}
+
+absl::Status DeferredWriter::ValidateOptions(const AsyncOptions& options) {
+  if (options.thread_buffer_size < kMinThreadBufferSize ||
+      options.thread_buffer_size > std::numeric_limits<uint32_t>::max()) {
+    return absl::InvalidArgumentError("Invalid deferred thread buffer size");
+  }
+  return absl::OkStatus();
+}
+
+absl::Status DeferredWriter::start() {
+  if (running_.load(std::memory_order_acquire)) {
+    return absl::AlreadyExistsError("Deferred writer already started");
+  }
+  stopping_.store(false, std::memory_order_relaxed);
+  running_.store(true, std::memory_order_release);
+  thread_ = std::thread(&DeferredWriter::run, this);
+  return absl::OkStatus();
+}
+
+void DeferredWriter::stop() {
+  if (!running_.load(std::memory_order_acquire)) {
+    return;
+  }
+  stopping_.store(true, std::memory_order_release);
+  wake_writer();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  running_.store(false, std::memory_order_release);
+
+  {
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    for (auto& buffer : buffers_) {
+      buffer->closed.store(true, std::memory_order_release);
+    }
+  }
+
+  // 唤醒可能仍在等待的 flush 调用方
+  std::lock_guard<std::mutex> lock(mutex_);
+  flush_cv_.notify_all();
+}
+
+internal::DeferredThreadBuffer* DeferredWriter::register_thread(
+    internal::DeferredThreadBuffers& local) {
+  // 清理已停止写线程留下的缓冲区
+  local.entries.erase(
+      std::remove_if(local.entries.begin(), local.entries.end(),
+                     [](const internal::DeferredThreadBuffers::Entry& entry) {
+                       return entry.buffer->closed.load(
+                           std::memory_order_acquire);
+                     }),
+      local.entries.end());
+
+  internal::DeferredThreadBuffer* buffer = nullptr;
+  for (auto& entry : local.entries) {
+    if (entry.writer_id == id_) {
+      buffer = entry.buffer.get();
+      break;
+    }
+  }
+
+  if (buffer == nullptr) {
+    auto created = std::make_shared<internal::DeferredThreadBuffer>(
+        options_.thread_buffer_size);
+    created->thread_id = spdlog::details::os::thread_id();
+    {
+      std::lock_guard<std::mutex> lock(buffers_mutex_);
+      buffers_.push_back(created);
+    }
+    buffers_version_.fetch_add(1, std::memory_order_release);
+    buffer = created.get();
+    local.entries.push_back({id_, std::move(created)});
+  }
+
+  local.last_writer_id = id_;
+  local.last_buffer = buffer;
+  return buffer;
+}
+
+char* DeferredWriter::reserve(internal::DeferredThreadBuffer* buffer,
+                              size_t size) {
+  char* dst = buffer->ring.reserve(size);
+  if (dst != nullptr) {
+    return dst;
+  }
+
+  // 线程缓冲区由单个生产者独占，无法从生产者侧丢弃最旧的记录，
+  // kDropOldest 按 kDropNewest 处理
+  if (options_.overflow_policy != OverflowPolicy::kBlock) {
+    buffer->dropped.store(buffer->dropped.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  for (int attempt = 0; dst == nullptr; ++attempt) {
+    if (!running_.load(std::memory_order_acquire) ||
+        stopping_.load(std::memory_order_acquire)) {
+      buffer->dropped.store(
+          buffer->dropped.load(std::memory_order_relaxed) + 1,
+          std::memory_order_relaxed);
+      return nullptr;
+    }
+    wake_writer();
+    if (attempt < kBlockSpins) {
+      std::this_thread::yield();
+    } else {
+      std::this_thread::sleep_for(kBlockSleep);
+    }
+    dst = buffer->ring.reserve(size);
+  }
+  return dst;
+}
+
+void DeferredWriter::flush() {
+  if (!running_.load(std::memory_order_acquire)) {
+    internal::FlushSinks(sinks_);
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  uint64_t ticket = flush_requested_.fetch_add(1, std::memory_order_acq_rel) + 1;
+  wake_cv_.notify_one();
+  flush_cv_.wait(lock, [&] {
+    return flush_completed_ >= ticket ||
+           !running_.load(std::memory_order_acquire);
+  });
+}
+
+AsyncStats DeferredWriter::stats() const {
+  AsyncStats stats;
+  // 先读写出数再汇总提交数，保证 written 不超过 enqueued
+  stats.written = written_.load(std::memory_order_acquire);
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+  stats.enqueued = retired_committed_;
+  stats.dropped_newest = retired_dropped_;
+  for (const auto& buffer : buffers_) {
+    stats.enqueued += buffer->committed.load(std::memory_order_relaxed);
+    stats.dropped_newest += buffer->dropped.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+void DeferredWriter::run() {
+  std::vector<BufferPtr> buffers;
+  uint64_t seen_version = 0;
+  int idle_spins = 0;
+  bool in_batch = false;
+  for (;;) {
+    uint64_t version = buffers_version_.load(std::memory_order_acquire);
+    if (version != seen_version) {
+      seen_version = version;
+      refresh_buffers(buffers);
+    }
+
+    // 写出第一条后开始一批，全部缓冲区取空后立即提交
+    if (write_one(buffers)) {
+      if (!in_batch && !batch_sinks_.empty()) {
+        internal::BeginSinkBatch(batch_sinks_);
+        in_batch = true;
+      }
+      idle_spins = 0;
+      continue;
+    }
+    if (in_batch) {
+      internal::EndSinkBatch(batch_sinks_);
+      in_batch = false;
+    }
+
+    // flush 请求在确认全部缓冲区为空之前读取，确保请求前提交的记录都已写出
+    uint64_t requested = flush_requested_.load(std::memory_order_acquire);
+    bool stopping = stopping_.load(std::memory_order_acquire);
+    if (buffers_version_.load(std::memory_order_acquire) != seen_version ||
+        write_one(buffers)) {
+      idle_spins = 0;
+      continue;
+    }
+
+    // 回收已退出线程的缓冲区
+    bool has_abandoned = false;
+    for (const auto& buffer : buffers) {
+      if (buffer->abandoned.load(std::memory_order_acquire)) {
+        has_abandoned = true;
+        break;
+      }
+    }
+    if (has_abandoned) {
+      refresh_buffers(buffers);
+      seen_version = buffers_version_.load(std::memory_order_acquire);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (requested > flush_completed_) {
+        internal::FlushSinks(sinks_);
+        flush_completed_ = requested;
+        flush_cv_.notify_all();
+      }
+    }
+
+    if (stopping) {
+      internal::FlushSinks(sinks_);
+      return;
+    }
+
+    if (++idle_spins < kIdleSpins) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    sleeping_.store(true, std::memory_order_relaxed);
+    if (!stopping_.load(std::memory_order_acquire) &&
+        flush_requested_.load(std::memory_order_acquire) <= flush_completed_) {
+      wake_cv_.wait_for(lock, kMaxIdleWait);
+    }
+    sleeping_.store(false, std::memory_order_relaxed);
+    idle_spins = 0;
+  }
+}
+
+bool DeferredWriter::write_one(std::vector<BufferPtr>& buffers) {
+  internal::DeferredThreadBuffer* oldest = nullptr;
+  absl::string_view oldest_record;
+  int64_t oldest_time = std::numeric_limits<int64_t>::max();
+  for (const auto& buffer : buffers) {
+    absl::string_view record = buffer->ring.peek();
+    if (record.data() == nullptr) {
+      continue;
+    }
+    // 计数与事件时间统一换算为 Unix 纳秒后比较
+    DeferredRecordHeader header;
+    std::memcpy(&header, record.data(), sizeof(header));
+    int64_t time_ns = clock_.to_unix_nanos(header.record_time());
+    if (oldest == nullptr || time_ns < oldest_time) {
+      oldest = buffer.get();
+      oldest_record = record;
+      oldest_time = time_ns;
+    }
+  }
+  if (oldest == nullptr) {
+    return false;
+  }
+  write_record(*oldest, oldest_record);
+  oldest->ring.release();
+  // 只有写线程写该计数，不需要原子读改写
+  written_.store(written_.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_release);
+  return true;
+}
+
+void DeferredWriter::write_record(const internal::DeferredThreadBuffer& buffer,
+                                  absl::string_view record) {
+  DeferredRecordHeader header;
+  std::memcpy(&header, record.data(), sizeof(header));
+  int64_t time_ns = clock_.to_unix_nanos(header.record_time());
+
+  if (header.format_id >= format_cache_.size()) {
+    format_cache_.resize(header.format_id + 1, nullptr);
+  }
+  const std::string*& fmt_str = format_cache_[header.format_id];
+  if (fmt_str == nullptr) {
+    fmt_str = FormatRegistry::Global().find(header.format_id);
+  }
+
+  LogLevel level = static_cast<LogLevel>(header.level);
+  absl::string_view logger_name = LoggerNameOr(header.logger_id, logger_name_);
+  const char* args = record.data() + sizeof(header);
+  size_t args_size =
+      std::min<size_t>(header.args_size, record.size() - sizeof(header));
+  absl::string_view context = record.substr(sizeof(header) + args_size);
+
+  spdlog::level::level_enum spdlog_level = internal::ToSpdlogLevel(level);
+  if (!raw_sinks_.empty() && fmt_str != nullptr) {
+    RawLogRecord raw;
+    raw.time_ns = time_ns;
+    raw.level = level;
+    raw.thread_id = buffer.thread_id;
+    raw.logger_name = logger_name;
+    raw.format_id = header.format_id;
+    raw.format = *fmt_str;
+    raw.args = args;
+    raw.args_size = args_size;
+    raw.arg_count = header.arg_count;
+    for (const auto& [sink, raw_sink] : raw_sinks_) {
+      if (!sink->should_log(spdlog_level)) {
+        continue;
+      }
+      try {
+        raw_sink->log_raw(raw);
+      } catch (...) {
+        // 静默处理日志错误，避免异常传播
+      }
+    }
+  }
+  // 没有文本 sink 需要该级别时不格式化
+  if (fmt_str != nullptr &&
+      std::none_of(text_sinks_.begin(), text_sinks_.end(),
+                   [spdlog_level](const spdlog::sink_ptr& sink) {
+                     return sink->should_log(spdlog_level);
+                   })) {
+    return;
+  }
+
+  format_buffer_.clear();
+  absl::Status status;
+  if (fmt_str == nullptr) {
+    status = absl::DataLossError("Unknown format id");
+  } else {
+    status = FormatEncoded(*fmt_str, args, args_size, header.arg_count,
+                           arg_store_, format_buffer_);
+  }
+  if (!status.ok()) {
+    // 格式化失败时输出错误描述，不向写线程外传播
+    format_buffer_.clear();
+    fmt::format_to(fmt::appender(format_buffer_), "[qxlog format error] {}",
+                   status.message());
+  }
+
+  auto time = spdlog::log_clock::time_point(
+      std::chrono::duration_cast<spdlog::log_clock::duration>(
+          std::chrono::nanoseconds(time_ns)));
+  spdlog::details::log_msg msg(
+      time, internal::ToSourceLoc(header.callsite),
+      spdlog::string_view_t(logger_name.data(), logger_name.size()),
+      internal::ToSpdlogLevel(level),
+      spdlog::string_view_t(format_buffer_.data(), format_buffer_.size()));
+  msg.thread_id = buffer.thread_id;
+  internal::RecordContextScope context_scope(context);
+  // 格式串 ID 无效时原始记录无法保存，错误描述写入全部 sinks
+  internal::DispatchToSinks(fmt_str == nullptr ? sinks_ : text_sinks_, msg);
+}
+
+void DeferredWriter::refresh_buffers(std::vector<BufferPtr>& buffers) {
+  std::lock_guard<std::mutex> lock(buffers_mutex_);
+  auto retired = std::remove_if(
+      buffers_.begin(), buffers_.end(), [this](const BufferPtr& buffer) {
+        // 先确认线程已退出再检查是否为空，退出后不会再有新记录
+        if (!buffer->abandoned.load(std::memory_order_acquire) ||
+            !buffer->ring.empty()) {
+          return false;
+        }
+        retired_committed_ += buffer->committed.load(std::memory_order_relaxed);
+        retired_dropped_ += buffer->dropped.load(std::memory_order_relaxed);
+        return true;
+      });
+  buffers_.erase(retired, buffers_.end());
+  buffers = buffers_;
+}
+
+void DeferredWriter::wake_writer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+  }
+  wake_cv_.notify_one();
+}
+
+}  // namespace log
+}  // namespace qxcore
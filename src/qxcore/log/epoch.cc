@@ -0,0 +1,129 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/epoch.h"
+
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+namespace qxcore {
+namespace log {
+namespace internal {
+
+EpochDomain::EpochDomain() : slots_(new Slot[kMaxSlots]) {}
+
+EpochDomain& EpochDomain::Global() {
+  // 故意泄漏，线程退出时的 ThreadState 析构仍可安全访问
+  static EpochDomain* domain = new EpochDomain();
+  return *domain;
+}
+
+EpochDomain::ThreadState::~ThreadState() {
+  if (slot != nullptr) {
+    slot->epoch.store(kQuiescent, std::memory_order_release);
+    slot->in_use.store(false, std::memory_order_release);
+  }
+}
+
+void EpochDomain::acquire_slot(ThreadState& state) {
+  if (state.overflow) {
+    return;
+  }
+  for (size_t i = 0; i < kMaxSlots; ++i) {
+    bool expected = false;
+    if (!slots_[i].in_use.load(std::memory_order_relaxed) &&
+        slots_[i].in_use.compare_exchange_strong(expected, true,
+                                                 std::memory_order_acq_rel)) {
+      state.slot = &slots_[i];
+      return;
+    }
+  }
+  state.overflow = true;
+}
+
+uint64_t EpochDomain::min_active_epoch() const {
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (overflow_readers_.load(std::memory_order_acquire) != 0) {
+    // 共享计数无法区分进入时间，保守地视为最早的读者
+    return kQuiescent;
+  }
+  uint64_t min_epoch = std::numeric_limits<uint64_t>::max();
+  for (size_t i = 0; i < kMaxSlots; ++i) {
+    uint64_t epoch = slots_[i].epoch.load(std::memory_order_acquire);
+    if (epoch != kQuiescent) {
+      min_epoch = std::min(min_epoch, epoch);
+    }
+  }
+  return min_epoch;
+}
+
+void EpochDomain::retire(std::function<void()> deleter) {
+  // 递增全局 epoch：此后进入的读者一定能看到替换后的指针
+  uint64_t epoch = global_epoch_.fetch_add(1, std::memory_order_seq_cst);
+  std::lock_guard<std::mutex> lock(retired_mutex_);
+  retired_.push_back({epoch, std::move(deleter)});
+}
+
+std::vector<std::function<void()>> EpochDomain::collect_locked() {
+  std::vector<std::function<void()>> ready;
+  if (retired_.empty()) {
+    return ready;
+  }
+  // 进入时记录的 epoch 不超过 retire epoch 的读者可能仍持有旧指针
+  uint64_t min_epoch = min_active_epoch();
+  auto it = std::stable_partition(
+      retired_.begin(), retired_.end(),
+      [min_epoch](const Retired& retired) { return retired.epoch >= min_epoch; });
+  for (auto ready_it = it; ready_it != retired_.end(); ++ready_it) {
+    ready.push_back(std::move(ready_it->deleter));
+  }
+  retired_.erase(it, retired_.end());
+  return ready;
+}
+
+size_t EpochDomain::reclaim() {
+  std::vector<std::function<void()>> ready;
+  {
+    std::lock_guard<std::mutex> lock(retired_mutex_);
+    ready = collect_locked();
+  }
+  // deleter 可能耗时（如关闭日志器），在锁外执行
+  for (auto& deleter : ready) {
+    deleter();
+  }
+  return ready.size();
+}
+
+void EpochDomain::synchronize() {
+  if (in_critical_section()) {
+    reclaim();
+    return;
+  }
+  // 此前登记对象的 epoch 都小于 target，所有读者越过 target 后即可释放
+  uint64_t target = global_epoch_.load(std::memory_order_acquire);
+  while (min_active_epoch() < target) {
+    std::this_thread::yield();
+  }
+  reclaim();
+}
+
+size_t EpochDomain::retired_count() const {
+  std::lock_guard<std::mutex> lock(retired_mutex_);
+  return retired_.size();
+}
+
+}  // namespace internal
+}  // namespace log
+}  // namespace qxcore
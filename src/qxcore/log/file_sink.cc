@@ -0,0 +1,53 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/file_sink.h"
+#include <absl/strings/str_format.h>
+
+namespace qxcore {
+namespace log {
+
+FileSink::FileSink(size_t buffer_size) {
+  buffer_.reserve(buffer_size);
+}
+
+absl::Status FileSink::open(const std::string& path, bool truncate) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  try {
+    file_.open(path, truncate);
+    return absl::OkStatus();
+  } catch (const std::exception& e) {
+    return absl::InternalError(
+        absl::StrFormat("Failed to open log file %s: %s", path, e.what()));
+  }
+}
+
+std::string FileSink::filename() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return file_.filename();
+}
+
+void FileSink::sink_it_(const spdlog::details::log_msg& msg) {
+  buffer_.clear();
+  formatter_->format(msg, buffer_);
+  file_.write(buffer_);
+}
+
+void FileSink::flush_() {
+  file_.flush();
+}
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,837 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/flight_recorder.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_format.h>
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+using internal::FlightHeader;
+using internal::FlightRingHeader;
+using internal::FlightSlotHeader;
+
+constexpr size_t kMinRecordSize = 64;
+constexpr size_t kMaxRecordSize = 4096;
+constexpr size_t kMaxThreads = 512;
+constexpr size_t kExportedFormats = 64 * 1024;
+constexpr size_t kThreadRingCache = 4;
+
+std::atomic<uint64_t> g_next_recorder_id{1};
+
+// 安装了崩溃处理函数的记录器
+constexpr size_t kMaxCrashRecorders = 8;
+std::atomic<const FlightRecorder*> g_crash_recorders[kMaxCrashRecorders];
+std::atomic<int> g_crash_fds[kMaxCrashRecorders];
+constexpr int kCrashSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+constexpr size_t kCrashSignalCount = sizeof(kCrashSignals) / sizeof(int);
+struct sigaction g_previous_actions[kCrashSignalCount];
+std::once_flag g_install_once;
+std::atomic<bool> g_crashing{false};
+
+size_t AlignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+uint32_t CurrentThreadId() {
+#if defined(__linux__)
+  return static_cast<uint32_t>(::syscall(SYS_gettid));
+#else
+  return static_cast<uint32_t>(
+      std::hash<std::thread::id>()(std::this_thread::get_id()));
+#endif
+}
+
+// 不分配内存、只调用 write 的输出缓冲，可在信号处理函数中使用
+class SignalSafeWriter {
+ public:
+  explicit SignalSafeWriter(int fd) : fd_(fd) {}
+  ~SignalSafeWriter() { flush(); }
+
+  SignalSafeWriter(const SignalSafeWriter&) = delete;
+  SignalSafeWriter& operator=(const SignalSafeWriter&) = delete;
+
+  void put(char c) {
+    if (size_ == sizeof(buffer_)) {
+      flush();
+    }
+    buffer_[size_++] = c;
+  }
+
+  void put(absl::string_view text) {
+    for (char c : text) {
+      put(c);
+    }
+  }
+
+  void put_uint(uint64_t value, int min_digits = 1) {
+    char digits[20];
+    int count = 0;
+    do {
+      digits[count++] = static_cast<char>('0' + value % 10);
+      value /= 10;
+    } while (value != 0 || count < min_digits);
+    while (count > 0) {
+      put(digits[--count]);
+    }
+  }
+
+  void put_int(int64_t value) {
+    if (value < 0) {
+      put('-');
+      put_uint(0 - static_cast<uint64_t>(value));
+    } else {
+      put_uint(static_cast<uint64_t>(value));
+    }
+  }
+
+  void put_hex(uint64_t value) {
+    put("0x");
+    bool started = false;
+    for (int shift = 60; shift >= 0; shift -= 4) {
+      unsigned digit = (value >> shift) & 0xf;
+      if (digit != 0 || started || shift == 0) {
+        put("0123456789abcdef"[digit]);
+        started = true;
+      }
+    }
+  }
+
+  // 定点六位小数，超出 uint64 范围时只输出量级
+  void put_double(double value) {
+    if (std::isnan(value)) {
+      put("nan");
+      return;
+    }
+    if (value < 0) {
+      put('-');
+      value = -value;
+    }
+    if (std::isinf(value)) {
+      put("inf");
+      return;
+    }
+    if (value >= 1e19) {
+      put(">1e19");
+      return;
+    }
+    uint64_t scaled = static_cast<uint64_t>(value * 1e6 + 0.5);
+    if (value >= 1e12) {
+      put_uint(static_cast<uint64_t>(value));
+      return;
+    }
+    put_uint(scaled / 1000000);
+    put('.');
+    put_uint(scaled % 1000000, 6);
+  }
+
+  void flush() {
+    size_t offset = 0;
+    while (offset < size_) {
+      ssize_t n = ::write(fd_, buffer_ + offset, size_ - offset);
+      if (n < 0 && errno == EINTR) {
+        continue;
+      }
+      if (n <= 0) {
+        break;
+      }
+      offset += static_cast<size_t>(n);
+    }
+    size_ = 0;
+  }
+
+ private:
+  int fd_;
+  char buffer_[1024];
+  size_t size_ = 0;
+};
+
+// 只读解析一块记录区
+class RegionView {
+ public:
+  RegionView(const char* region, size_t size) : region_(region), size_(size) {}
+
+  // 检查文件头与区域长度是否一致
+  bool valid() const {
+    if (size_ < flight_format::kHeaderSize) {
+      return false;
+    }
+    const FlightHeader& h = header();
+    if (h.magic != flight_format::kMagic ||
+        h.version != flight_format::kVersion ||
+        h.record_size < kMinRecordSize || h.record_size > kMaxRecordSize ||
+        h.records_per_thread == 0 || h.max_threads == 0 ||
+        h.max_threads > kMaxThreads) {
+      return false;
+    }
+    return size_ >= flight_format::kHeaderSize + h.table_capacity +
+                        h.max_threads * ring_size();
+  }
+
+  const FlightHeader& header() const {
+    return *reinterpret_cast<const FlightHeader*>(region_);
+  }
+
+  size_t ring_size() const {
+    return flight_format::kRingHeaderSize +
+           static_cast<size_t>(header().records_per_thread) *
+               header().record_size;
+  }
+
+  uint32_t threads() const {
+    return std::min(header().threads.load(std::memory_order_acquire),
+                    header().max_threads);
+  }
+
+  const FlightRingHeader& ring(uint32_t index) const {
+    return *reinterpret_cast<const FlightRingHeader*>(
+        region_ + flight_format::kHeaderSize + header().table_capacity +
+        index * ring_size());
+  }
+
+  const FlightSlotHeader& slot(uint32_t ring_index, uint64_t sequence) const {
+    const char* ring_base = reinterpret_cast<const char*>(&ring(ring_index));
+    return *reinterpret_cast<const FlightSlotHeader*>(
+        ring_base + flight_format::kRingHeaderSize +
+        (sequence % header().records_per_thread) * header().record_size);
+  }
+
+  // 序号为 sequence 的记录仍在环中时拷贝到 out（至少 record_size 字节）
+  bool copy_slot(uint32_t ring_index, uint64_t sequence, char* out) const {
+    const FlightSlotHeader& s = slot(ring_index, sequence);
+    if (s.sequence.load(std::memory_order_acquire) != sequence + 1) {
+      return false;
+    }
+    std::memcpy(out, reinterpret_cast<const char*>(&s), header().record_size);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return s.sequence.load(std::memory_order_relaxed) == sequence + 1;
+  }
+
+  // 在格式串表中查找，找不到时返回空视图
+  absl::string_view format(uint32_t id) const {
+    const char* table = region_ + flight_format::kHeaderSize;
+    uint32_t used = std::min(header().table_used.load(std::memory_order_acquire),
+                             header().table_capacity);
+    size_t offset = 0;
+    while (offset + 8 <= used) {
+      uint32_t entry_id;
+      uint32_t size;
+      std::memcpy(&entry_id, table + offset, 4);
+      std::memcpy(&size, table + offset + 4, 4);
+      if (offset + 8 + size > used) {
+        break;
+      }
+      if (entry_id == id) {
+        return absl::string_view(table + offset + 8, size);
+      }
+      offset += AlignUp(8 + size, 4);
+    }
+    return absl::string_view();
+  }
+
+  int64_t unix_nanos(const FlightSlotHeader& s) const {
+    if (s.flags & flight_format::kEventTime) {
+      return static_cast<int64_t>(s.time);
+    }
+    const FlightHeader& h = header();
+    int64_t delta = static_cast<int64_t>(
+        s.time - h.clock_ticks.load(std::memory_order_relaxed));
+    return h.clock_nanos.load(std::memory_order_relaxed) +
+           static_cast<int64_t>(static_cast<double>(delta) *
+                                h.nanos_per_tick.load(std::memory_order_relaxed));
+  }
+
+ private:
+  const char* region_;
+  size_t size_;
+};
+
+// 逐个输出编码参数；格式说明符被忽略，参数按默认形式输出
+class SafeArgReader {
+ public:
+  SafeArgReader(const char* data, size_t size) : data_(data), end_(data + size) {}
+
+  bool put_next(SignalSafeWriter& out) {
+    if (data_ >= end_) {
+      return false;
+    }
+    auto type = static_cast<ArgType>(*data_++);
+    switch (type) {
+      case ArgType::kBool: {
+        uint8_t value;
+        if (!read(&value)) return false;
+        out.put(value ? "true" : "false");
+        return true;
+      }
+      case ArgType::kChar: {
+        char value;
+        if (!read(&value)) return false;
+        out.put(value);
+        return true;
+      }
+      case ArgType::kInt32: {
+        int32_t value;
+        if (!read(&value)) return false;
+        out.put_int(value);
+        return true;
+      }
+      case ArgType::kUInt32: {
+        uint32_t value;
+        if (!read(&value)) return false;
+        out.put_uint(value);
+        return true;
+      }
+      case ArgType::kInt64: {
+        int64_t value;
+        if (!read(&value)) return false;
+        out.put_int(value);
+        return true;
+      }
+      case ArgType::kUInt64: {
+        uint64_t value;
+        if (!read(&value)) return false;
+        out.put_uint(value);
+        return true;
+      }
+      case ArgType::kFloat: {
+        float value;
+        if (!read(&value)) return false;
+        out.put_double(value);
+        return true;
+      }
+      case ArgType::kDouble: {
+        double value;
+        if (!read(&value)) return false;
+        out.put_double(value);
+        return true;
+      }
+      case ArgType::kPointer: {
+        uint64_t value;
+        if (!read(&value)) return false;
+        out.put_hex(value);
+        return true;
+      }
+      case ArgType::kString: {
+        uint32_t size;
+        if (!read(&size) || size > static_cast<size_t>(end_ - data_)) {
+          return false;
+        }
+        out.put(absl::string_view(data_, size));
+        data_ += size;
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  template<typename T>
+  bool read(T* value) {
+    if (static_cast<size_t>(end_ - data_) < sizeof(T)) {
+      return false;
+    }
+    std::memcpy(value, data_, sizeof(T));
+    data_ += sizeof(T);
+    return true;
+  }
+
+  const char* data_;
+  const char* end_;
+};
+
+// 把 {} 占位符依次替换为参数
+void PutSafeMessage(SignalSafeWriter& out, absl::string_view format,
+                    uint8_t flags, const char* payload, size_t payload_size) {
+  if (flags & flight_format::kVerbatim) {
+    out.put(absl::string_view(payload, payload_size));
+    return;
+  }
+  if (flags & flight_format::kTruncated) {
+    out.put(format);
+    out.put(" [args truncated]");
+    return;
+  }
+  SafeArgReader args(payload, payload_size);
+  for (size_t i = 0; i < format.size(); ++i) {
+    char c = format[i];
+    if ((c == '{' || c == '}') && i + 1 < format.size() &&
+        format[i + 1] == c) {
+      out.put(c);
+      ++i;
+    } else if (c == '{') {
+      size_t close = format.find('}', i);
+      if (close == absl::string_view::npos || !args.put_next(out)) {
+        out.put(format.substr(i));
+        return;
+      }
+      i = close;
+    } else {
+      out.put(c);
+    }
+  }
+}
+
+// 按时间顺序把记录区中的全部记录写到 fd
+void DumpRegion(const RegionView& view, int fd) {
+  SignalSafeWriter out(fd);
+  const FlightHeader& h = view.header();
+  out.put("*** qxlog flight recorder: ");
+  out.put(absl::string_view(h.name, strnlen(h.name, sizeof(h.name))));
+  out.put(" ***\n");
+
+  uint32_t threads = view.threads();
+  uint64_t cursor[kMaxThreads];
+  uint64_t end[kMaxThreads];
+  for (uint32_t r = 0; r < threads; ++r) {
+    end[r] = view.ring(r).next.load(std::memory_order_acquire);
+    cursor[r] = end[r] > h.records_per_thread ? end[r] - h.records_per_thread
+                                              : 0;
+  }
+
+  alignas(8) char current[kMaxRecordSize];
+  alignas(8) char candidate[kMaxRecordSize];
+  for (;;) {
+    // 各线程环内按序号有序，每次取各环首条中时间最早的一条
+    int best = -1;
+    int64_t best_nanos = 0;
+    for (uint32_t r = 0; r < threads; ++r) {
+      while (cursor[r] < end[r] && !view.copy_slot(r, cursor[r], candidate)) {
+        ++cursor[r];
+      }
+      if (cursor[r] == end[r]) {
+        continue;
+      }
+      int64_t nanos = view.unix_nanos(
+          *reinterpret_cast<const FlightSlotHeader*>(candidate));
+      if (best < 0 || nanos < best_nanos) {
+        best = static_cast<int>(r);
+        best_nanos = nanos;
+        std::memcpy(current, candidate, h.record_size);
+      }
+    }
+    if (best < 0) {
+      break;
+    }
+    ++cursor[best];
+
+    const auto& s = *reinterpret_cast<const FlightSlotHeader*>(current);
+    out.put_int(best_nanos / 1000000000);
+    out.put('.');
+    out.put_uint(static_cast<uint64_t>(best_nanos % 1000000000), 9);
+    out.put(' ');
+    out.put(LogLevelToString(static_cast<LogLevel>(s.level)));
+    out.put(" [tid ");
+    out.put_uint(view.ring(static_cast<uint32_t>(best))
+                     .thread_id.load(std::memory_order_relaxed));
+    out.put("] ");
+    absl::string_view format = view.format(s.format_id);
+    if (format.data() == nullptr) {
+      out.put("<format #");
+      out.put_uint(s.format_id);
+      out.put("> ");
+    }
+    size_t payload_size = std::min<size_t>(
+        s.args_size, h.record_size - sizeof(FlightSlotHeader));
+    PutSafeMessage(out, format, s.flags, current + sizeof(FlightSlotHeader),
+                   payload_size);
+    out.put('\n');
+  }
+}
+
+void CrashHandler(int signal, siginfo_t* /*info*/, void* /*context*/) {
+  if (!g_crashing.exchange(true)) {
+    for (size_t i = 0; i < kMaxCrashRecorders; ++i) {
+      const FlightRecorder* recorder =
+          g_crash_recorders[i].load(std::memory_order_acquire);
+      if (recorder != nullptr) {
+        recorder->dump_to_fd(g_crash_fds[i].load(std::memory_order_relaxed));
+      }
+    }
+  }
+  // 恢复原处理函数后重新触发，处理函数返回时按原方式处理该信号
+  for (size_t i = 0; i < kCrashSignalCount; ++i) {
+    if (kCrashSignals[i] == signal) {
+      ::sigaction(signal, &g_previous_actions[i], nullptr);
+    }
+  }
+  ::raise(signal);
+}
+
+}  // anonymous namespace
+
+FlightRecorder::~FlightRecorder() {
+  for (auto& slot : g_crash_recorders) {
+    const FlightRecorder* expected = this;
+    slot.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+  }
+  if (region_ != nullptr) {
+    ::munmap(region_, region_size_);
+  }
+}
+
+absl::Status FlightRecorder::ValidateOptions(
+    const FlightRecorderOptions& options) {
+  if (options.record_size < kMinRecordSize ||
+      options.record_size > kMaxRecordSize || options.record_size % 8 != 0) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Flight record size must be a multiple of 8 in [%d, %d]",
+        kMinRecordSize, kMaxRecordSize));
+  }
+  if (options.max_threads == 0 || options.max_threads > kMaxThreads) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Flight recorder max_threads must be in [1, %d]", kMaxThreads));
+  }
+  if (options.records_per_thread > std::numeric_limits<uint32_t>::max()) {
+    return absl::InvalidArgumentError("Too many flight records per thread");
+  }
+  if (options.crash_fd < 0) {
+    return absl::InvalidArgumentError("Invalid flight recorder crash fd");
+  }
+  return absl::OkStatus();
+}
+
+absl::Status FlightRecorder::init(const std::string& name,
+                                  const FlightRecorderOptions& options) {
+  if (region_ != nullptr) {
+    return absl::AlreadyExistsError("Flight recorder already initialized");
+  }
+  absl::Status status = ValidateOptions(options);
+  if (!status.ok()) {
+    return status;
+  }
+
+  ring_size_ = flight_format::kRingHeaderSize +
+               options.records_per_thread * options.record_size;
+  size_t size = flight_format::kHeaderSize + flight_format::kTableCapacity +
+                options.max_threads * ring_size_;
+  void* region = MAP_FAILED;
+  if (options.shm_path.empty()) {
+    // 匿名映射按需分配物理页，未使用的线程环不占内存
+    region = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  } else {
+    int fd = ::open(options.shm_path.c_str(),
+                    O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      return absl::InternalError(absl::StrFormat(
+          "Failed to open flight recorder file %s", options.shm_path));
+    }
+    if (::ftruncate(fd, static_cast<off_t>(size)) == 0) {
+      region = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+  }
+  if (region == MAP_FAILED) {
+    return absl::InternalError(
+        absl::StrFormat("Failed to map %d bytes for flight recorder", size));
+  }
+
+  region_ = static_cast<char*>(region);
+  region_size_ = size;
+  header_ = new (region_) FlightHeader();
+  header_->magic = flight_format::kMagic;
+  header_->version = flight_format::kVersion;
+  header_->record_size = static_cast<uint32_t>(options.record_size);
+  header_->records_per_thread =
+      static_cast<uint32_t>(options.records_per_thread);
+  header_->max_threads = static_cast<uint32_t>(options.max_threads);
+  header_->table_capacity = static_cast<uint32_t>(flight_format::kTableCapacity);
+  header_->threads.store(0, std::memory_order_relaxed);
+  header_->table_used.store(0, std::memory_order_relaxed);
+  std::memset(header_->name, 0, sizeof(header_->name));
+  std::memcpy(header_->name, name.data(),
+              std::min(name.size(), sizeof(header_->name) - 1));
+  publish_clock();
+
+  payload_capacity_ = options.record_size - sizeof(FlightSlotHeader);
+  dump_on_error_ = options.dump_on_error;
+  dump_level_ = options.dump_level;
+  exported_bits_ = kExportedFormats;
+  exported_.reset(new std::atomic<uint64_t>[kExportedFormats / 64]);
+  for (size_t i = 0; i < kExportedFormats / 64; ++i) {
+    exported_[i].store(0, std::memory_order_relaxed);
+  }
+  id_ = g_next_recorder_id.fetch_add(1, std::memory_order_relaxed);
+  return absl::OkStatus();
+}
+
+void FlightRecorder::record_verbatim(LogLevel level, RecordTime time,
+                                     bool written, absl::string_view message) {
+  internal::FlightRingHeader* ring = thread_ring();
+  if (ring == nullptr) {
+    return;
+  }
+  uint8_t flags = flight_format::kVerbatim |
+                  (time.is_event ? flight_format::kEventTime : 0) |
+                  (written ? flight_format::kWritten : 0);
+  // 原文按槽位容量截断，格式串表中只记录一个空占位
+  size_t size = std::min(message.size(), payload_capacity_);
+  char* payload = begin_record(ring, level, time.value, absl::string_view(),
+                               flags, 0, size);
+  std::memcpy(payload, message.data(), size);
+  end_record(ring, payload);
+}
+
+size_t FlightRecorder::dump(const DumpFn& emit) {
+  if (region_ == nullptr) {
+    return 0;
+  }
+  struct Pending {
+    int64_t unix_nanos;
+    LogLevel level;
+    std::string message;
+  };
+
+  std::lock_guard<std::mutex> lock(dump_mutex_);
+  publish_clock();
+  RegionView view(region_, region_size_);
+  std::vector<Pending> pending;
+  std::vector<char> slot(header_->record_size);
+  FormatArgStore store;
+  fmt::memory_buffer text;
+  TscClock& clock = TscClock::Global();
+
+  for (uint32_t r = 0; r < view.threads(); ++r) {
+    FlightRingHeader* ring = ring_at(r);
+    uint64_t end = ring->next.load(std::memory_order_acquire);
+    uint64_t begin = std::max(ring->dumped.load(std::memory_order_relaxed),
+                              end > header_->records_per_thread
+                                  ? end - header_->records_per_thread
+                                  : 0);
+    for (uint64_t seq = begin; seq < end; ++seq) {
+      if (!view.copy_slot(r, seq, slot.data())) {
+        continue;
+      }
+      const auto& s = *reinterpret_cast<const FlightSlotHeader*>(slot.data());
+      if (s.flags & flight_format::kWritten) {
+        continue;
+      }
+      const char* payload = slot.data() + sizeof(FlightSlotHeader);
+      size_t payload_size = std::min<size_t>(s.args_size, payload_capacity_);
+      text.clear();
+      fmt::format_to(fmt::appender(text), "[flight tid {}] ",
+                     ring->thread_id.load(std::memory_order_relaxed));
+      const std::string* format = FormatRegistry::Global().find(s.format_id);
+      if (s.flags & flight_format::kVerbatim) {
+        text.append(payload, payload + payload_size);
+      } else if (format == nullptr) {
+        fmt::format_to(fmt::appender(text), "<format #{}>", s.format_id);
+      } else if (s.flags & flight_format::kTruncated) {
+        text.append(*format);
+        fmt::format_to(fmt::appender(text), " [args truncated]");
+      } else if (!FormatEncoded(*format, payload, payload_size, s.arg_count,
+                                store, text)
+                      .ok()) {
+        fmt::format_to(fmt::appender(text), "[qxlog format error] {}",
+                       *format);
+      }
+      pending.push_back(
+          Pending{clock.to_unix_nanos(RecordTime{
+                      s.time, (s.flags & flight_format::kEventTime) != 0}),
+                  static_cast<LogLevel>(s.level),
+                  std::string(text.data(), text.size())});
+    }
+    ring->dumped.store(end, std::memory_order_relaxed);
+  }
+
+  std::stable_sort(pending.begin(), pending.end(),
+                   [](const Pending& a, const Pending& b) {
+                     return a.unix_nanos < b.unix_nanos;
+                   });
+  for (const Pending& record : pending) {
+    emit(record.level, record.unix_nanos, record.message);
+  }
+  return pending.size();
+}
+
+void FlightRecorder::dump_to_fd(int fd) const {
+  if (region_ != nullptr) {
+    DumpRegion(RegionView(region_, region_size_), fd);
+  }
+}
+
+absl::Status FlightRecorder::DumpFile(const std::string& path, int fd) {
+  int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (file < 0) {
+    return absl::NotFoundError(
+        absl::StrFormat("Failed to open flight recorder file %s", path));
+  }
+  struct stat st;
+  void* region = MAP_FAILED;
+  if (::fstat(file, &st) == 0 && st.st_size > 0) {
+    region = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ,
+                    MAP_PRIVATE, file, 0);
+  }
+  ::close(file);
+  if (region == MAP_FAILED) {
+    return absl::DataLossError(
+        absl::StrFormat("Failed to map flight recorder file %s", path));
+  }
+  RegionView view(static_cast<const char*>(region),
+                  static_cast<size_t>(st.st_size));
+  absl::Status status = absl::OkStatus();
+  if (view.valid()) {
+    DumpRegion(view, fd);
+  } else {
+    status = absl::DataLossError(
+        absl::StrFormat("%s is not a flight recorder file", path));
+  }
+  ::munmap(region, static_cast<size_t>(st.st_size));
+  return status;
+}
+
+void FlightRecorder::install_crash_handler(int fd) {
+  for (size_t i = 0; i < kMaxCrashRecorders; ++i) {
+    const FlightRecorder* expected = nullptr;
+    g_crash_fds[i].store(fd, std::memory_order_relaxed);
+    if (g_crash_recorders[i].compare_exchange_strong(
+            expected, this, std::memory_order_acq_rel)) {
+      break;
+    }
+  }
+  std::call_once(g_install_once, [] {
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_sigaction = CrashHandler;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    for (size_t i = 0; i < kCrashSignalCount; ++i) {
+      ::sigaction(kCrashSignals[i], &action, &g_previous_actions[i]);
+    }
+  });
+}
+
+FlightRingHeader* FlightRecorder::thread_ring() {
+  struct Entry {
+    uint64_t recorder_id = 0;
+    FlightRingHeader* ring = nullptr;
+  };
+  thread_local Entry cache[kThreadRingCache];
+  thread_local size_t victim = 0;
+
+  if (region_ == nullptr) {
+    return nullptr;
+  }
+  for (const Entry& entry : cache) {
+    if (entry.recorder_id == id_) {
+      return entry.ring;
+    }
+  }
+  // 线程环不回收：超过 max_threads 的线程缓存空指针，不再尝试
+  Entry& entry = cache[victim++ % kThreadRingCache];
+  entry.recorder_id = id_;
+  entry.ring = nullptr;
+  uint32_t index = header_->threads.fetch_add(1, std::memory_order_acq_rel);
+  if (index < header_->max_threads) {
+    entry.ring = ring_at(index);
+    entry.ring->thread_id.store(CurrentThreadId(), std::memory_order_relaxed);
+  }
+  return entry.ring;
+}
+
+FlightRingHeader* FlightRecorder::ring_at(uint32_t index) const {
+  return reinterpret_cast<FlightRingHeader*>(
+      region_ + flight_format::kHeaderSize + flight_format::kTableCapacity +
+      index * ring_size_);
+}
+
+char* FlightRecorder::begin_record(FlightRingHeader* ring, LogLevel level,
+                                   uint64_t time, absl::string_view format,
+                                   uint8_t flags, uint8_t arg_count,
+                                   size_t args_size) {
+  uint64_t sequence = ring->next.load(std::memory_order_relaxed);
+  auto* slot = reinterpret_cast<FlightSlotHeader*>(
+      reinterpret_cast<char*>(ring) + flight_format::kRingHeaderSize +
+      (sequence % header_->records_per_thread) * header_->record_size);
+  // 先作废槽位再改写内容，读取方据此丢弃写到一半的记录
+  slot->sequence.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  uint32_t format_id = 0;
+  if (!(flags & flight_format::kVerbatim)) {
+    format_id = InternFormatCached(format);
+    export_format(format_id, format);
+  }
+  slot->time = time;
+  slot->format_id = format_id;
+  slot->args_size = static_cast<uint16_t>(args_size);
+  slot->level = static_cast<uint8_t>(LogLevelToInt(level));
+  slot->arg_count = arg_count;
+  slot->flags = flags;
+  return reinterpret_cast<char*>(slot) + sizeof(FlightSlotHeader);
+}
+
+void FlightRecorder::export_format(uint32_t format_id,
+                                   absl::string_view format) {
+  if (format_id >= exported_bits_) {
+    return;
+  }
+  uint64_t bit = uint64_t{1} << (format_id % 64);
+  std::atomic<uint64_t>& word = exported_[format_id / 64];
+  if (word.load(std::memory_order_relaxed) & bit) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(table_mutex_);
+  if (word.load(std::memory_order_relaxed) & bit) {
+    return;
+  }
+  uint32_t used = header_->table_used.load(std::memory_order_relaxed);
+  size_t entry_size = AlignUp(8 + format.size(), 4);
+  if (used + entry_size > header_->table_capacity) {
+    // 表已满，转储时该格式串显示为 <format #id>
+    word.fetch_or(bit, std::memory_order_relaxed);
+    return;
+  }
+  char* entry = region_ + flight_format::kHeaderSize + used;
+  uint32_t size = static_cast<uint32_t>(format.size());
+  std::memcpy(entry, &format_id, 4);
+  std::memcpy(entry + 4, &size, 4);
+  std::memcpy(entry + 8, format.data(), format.size());
+  header_->table_used.store(static_cast<uint32_t>(used + entry_size),
+                            std::memory_order_release);
+  word.fetch_or(bit, std::memory_order_relaxed);
+}
+
+void FlightRecorder::publish_clock() {
+  TscClock& clock = TscClock::Global();
+  uint64_t ticks = TscClock::ReadTicks();
+  header_->clock_nanos.store(clock.to_unix_nanos(ticks),
+                             std::memory_order_relaxed);
+  header_->clock_ticks.store(ticks, std::memory_order_relaxed);
+  header_->nanos_per_tick.store(clock.nanos_per_tick(),
+                                std::memory_order_relaxed);
+}
+
+}  // namespace log
+}  // namespace qxcore
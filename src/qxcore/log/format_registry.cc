@@ -0,0 +1,53 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/format_registry.h"
+
+namespace qxcore {
+namespace log {
+
+FormatRegistry& FormatRegistry::Global() {
+  // 故意泄漏，保证进程退出阶段的日志调用仍可安全访问
+  static FormatRegistry* registry = new FormatRegistry();
+  return *registry;
+}
+
+uint32_t FormatRegistry::intern(absl::string_view fmt_str) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = ids_.find(fmt_str);
+  if (it != ids_.end()) {
+    return it->second;
+  }
+  uint32_t id = static_cast<uint32_t>(formats_.size());
+  formats_.emplace_back(fmt_str);
+  // deque 尾部追加不会移动已有元素，键可以直接引用存储的字符串
+  ids_.emplace(absl::string_view(formats_.back()), id);
+  return id;
+}
+
+const std::string* FormatRegistry::find(uint32_t id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (id >= formats_.size()) {
+    return nullptr;
+  }
+  return &formats_[id];
+}
+
+size_t FormatRegistry::size() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return formats_.size();
+}
+
+}  // namespace log
+}  // namespace qxcore
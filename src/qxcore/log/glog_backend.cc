@@ -14,31 +14,83 @@
 
 #include "qxcore/log/glog_backend.h"
 #include <glog/logging.h>
+#include <ostream>
 #include <absl/strings/str_cat.h>
 #include <absl/strings/str_format.h>
 
 namespace qxcore {
 namespace log {
 
-absl::Status GlogBackend::init(const std::string& name, LogLevel level) {
-  if (initialized_) {
+namespace {
+
+// TRACE/DEBUG 对应的 glog 详细级别（--v），与 VLOG 一样只在 VLOG_IS_ON 时以 INFO
+// 严重级别写出
+constexpr int kDebugVerbosity = 1;
+constexpr int kTraceVerbosity = 2;
+
+int ToGlogVerbosity(LogLevel level) {
+  switch (level) {
+    case LogLevel::kTrace:
+      return kTraceVerbosity;
+    case LogLevel::kDebug:
+      return kDebugVerbosity;
+    default:
+      return 0;
+  }
+}
+
+}  // anonymous namespace
+
+GlogBackend::~GlogBackend() {
+  if (initialized_.load(std::memory_order_acquire)) {
+    shutdown();
+  }
+}
+
+absl::Status GlogBackend::init(const std::string& name, LogLevel level,
+                               const LogOptions& options) {
+  if (initialized_.load(std::memory_order_acquire)) {
     return absl::AlreadyExistsError("Logger already initialized");
   }
 
+  if (name.empty()) {
+    return absl::InvalidArgumentError("Logger name cannot be empty");
+  }
+
+  if (options.mode != LogMode::kSync) {
+    return absl::UnimplementedError("Glog backend only supports sync mode");
+  }
+
   try {
     // 初始化 glog（如果尚未初始化）
     if (!google::IsGoogleLoggingInitialized()) {
       google::InitGoogleLogging(name.c_str());
     }
+    if (options.output == LogOutput::kNull) {
+      // 空文件名关闭对应严重级别的文件输出；glog 的输出目标是进程级的，
+      // 同一进程内的其他 GlogBackend 也会受影响
+      for (int severity = 0; severity < google::NUM_SEVERITIES; ++severity) {
+        google::SetLogDestination(static_cast<google::LogSeverity>(severity),
+                                  "");
+      }
+      FLAGS_stderrthreshold = google::NUM_SEVERITIES;
+      FLAGS_logtostderr = false;
+      FLAGS_alsologtostderr = false;
+    } else {
+      // 日志文件前缀只在初始化时设置一次，INFO 文件包含全部严重级别
+      google::SetLogDestination(google::GLOG_INFO,
+                                absl::StrCat(name, ".log").c_str());
+    }
 
     logger_name_ = name;
-    current_level_ = level;
-    initialized_ = true;
+    current_level_.store(level, std::memory_order_relaxed);
+    initialized_.store(true, std::memory_order_release);
 
     // 设置 glog 日志级别
     absl::Status status = set_level(level);
     if (!status.ok()) {
-      initialized_ = false;
+      initialized_.store(false, std::memory_order_release);
+      CallsiteRegistry::Global().remove_logger(this);
       return status;
     }
 
@@ -49,18 +101,14 @@ absl::Status GlogBackend::init(const std::string& name, LogLevel level) {
 }
 
 absl::Status GlogBackend::set_level(LogLevel level) {
-  if (!initialized_) {
+  if (!initialized_.load(std::memory_order_acquire)) {
     return absl::FailedPreconditionError("Logger not initialized");
   }
 
   try {
-    // glog 使用 FLAGS_minloglevel 控制最小日志级别
-    // 0=INFO, 1=WARNING, 2=ERROR, 3=FATAL
-    google::LogSeverity glog_level = static_cast<google::LogSeverity>(ToGlogLevel(level));
-    google::SetLogDestination(glog_level, 
-        absl::StrCat(logger_name_, ".log").c_str());
-    
-    current_level_ = level;
+    // --v 属于整个进程，由用户通过命令行或 vmodule 控制，这里不改写
+    current_level_.store(level, std::memory_order_relaxed);
+    CallsiteRegistry::Global().set_logger_level(this, level);
     return absl::OkStatus();
   } catch (const std::exception& e) {
     return absl::InternalError(absl::StrFormat("Failed to set log level: %s", e.what()));
@@ -68,47 +116,42 @@ absl::Status GlogBackend::set_level(LogLevel level) {
 }
 
 LogLevel GlogBackend::get_level() const {
-  return current_level_;
+  return current_level_.load(std::memory_order_relaxed);
 }
 
-bool GlogBackend::is_enabled(LogLevel level) const {
-  if (!initialized_) {
-    return false;
-  }
-  return IsLogLevelEnabled(current_level_, level);
+bool GlogBackend::VerbosityEnabled(LogLevel level) {
+  int verbosity = ToGlogVerbosity(level);
+  return verbosity == 0 || VLOG_IS_ON(verbosity);
 }
 
-void GlogBackend::log(LogLevel level, absl::string_view msg) {
-  if (!initialized_ || !is_enabled(level)) {
+void GlogBackend::write(LogLevel level, const Callsite* callsite,
+                        LoggerId logger_id, absl::string_view msg) {
+  if (!VerbosityEnabled(level)) {
     return;
   }
-
   try {
-    std::string msg_str(msg);
-    switch (level) {
-      case LogLevel::kTrace:
-      case LogLevel::kDebug:
-      case LogLevel::kInfo:
-        LOG(INFO) << msg_str;
-        break;
-      case LogLevel::kWarn:
-        LOG(WARNING) << msg_str;
-        break;
-      case LogLevel::kError:
-        LOG(ERROR) << msg_str;
-        break;
-      case LogLevel::kCritical:
-        LOG(FATAL) << msg_str;
-        break;
+    // 调用点记录使用宏所在的源码位置，否则与 LOG() 一样记录本文件位置
+    const char* file = callsite != nullptr ? callsite->file() : __FILE__;
+    int line = callsite != nullptr ? callsite->line() : __LINE__;
+    google::LogMessage message(
+        file, line, static_cast<google::LogSeverity>(ToGlogLevel(level)));
+    // glog 0.8 的 LogMessage 复用线程本地缓冲区，直接写入字节不产生分配
+    std::ostream& stream = message.stream();
+    if (logger_id != kNoLoggerId) {
+      // glog 没有日志器名字字段，命名日志器以前缀区分
+      absl::string_view name = LoggerRegistry::Global().name(logger_id);
+      stream.put('[');
+      stream.write(name.data(), static_cast<std::streamsize>(name.size()));
+      stream.write("] ", 2);
     }
+    stream.write(msg.data(), static_cast<std::streamsize>(msg.size()));
   } catch (...) {
     // 静默处理日志错误，避免异常传播
   }
 }
 
-
 void GlogBackend::flush() {
-  if (!initialized_) {
+  if (!initialized_.load(std::memory_order_acquire)) {
     return;
   }
 
@@ -120,13 +163,14 @@ void GlogBackend::flush() {
 }
 
 void GlogBackend::shutdown() {
-  if (!initialized_) {
+  if (!initialized_.load(std::memory_order_acquire)) {
     return;
   }
 
   try {
+    initialized_.store(false, std::memory_order_release);
+    CallsiteRegistry::Global().remove_logger(this);
     google::FlushLogFiles(google::GLOG_INFO);
-    initialized_ = false;
   } catch (...) {
     // 静默处理日志错误，避免异常传播
   }
@@ -141,9 +185,9 @@ int GlogBackend::ToGlogLevel(LogLevel level) {
     case LogLevel::kWarn:
       return google::GLOG_WARNING;
     case LogLevel::kError:
-      return google::GLOG_ERROR;
     case LogLevel::kCritical:
-      return google::GLOG_FATAL;
+      // GLOG_FATAL 会终止进程，CRITICAL 只作为最高级别的普通记录写出
+      return google::GLOG_ERROR;
     default:
       return google::GLOG_INFO;
   }
@@ -0,0 +1,580 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/group_commit_sink.h"
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <absl/strings/str_format.h>
+#include <spdlog/details/console_globals.h>
+#include <spdlog/pattern_formatter.h>
+#include "qxcore/log/console_sink.h"
+
+namespace qxcore {
+namespace log {
+
+namespace internal {
+
+// 最小化的 io_uring 封装：同一时刻最多一个未完成的 writev
+//
+// 不依赖 liburing，直接使用 io_uring_setup/io_uring_enter 系统调用。写入
+// 位置取文件当前位置（IORING_FEAT_RW_CUR_POS），配合 O_APPEND 追加写。
+class UringWriter {
+ public:
+  // 内核不支持（或被禁用）时返回 nullptr
+  static std::unique_ptr<UringWriter> Create() {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    int ring_fd =
+        static_cast<int>(syscall(__NR_io_uring_setup, kEntries, &params));
+    if (ring_fd < 0) {
+      return nullptr;
+    }
+    std::unique_ptr<UringWriter> writer(new UringWriter(ring_fd));
+    if ((params.features & IORING_FEAT_RW_CUR_POS) == 0 ||
+        !writer->map(params)) {
+      return nullptr;
+    }
+    return writer;
+  }
+
+  ~UringWriter() {
+    if (sqes_mapping_ != MAP_FAILED) {
+      munmap(sqes_mapping_, sqes_size_);
+    }
+    if (cq_ring_ != MAP_FAILED && cq_ring_ != sq_ring_) {
+      munmap(cq_ring_, cq_ring_size_);
+    }
+    if (sq_ring_ != MAP_FAILED) {
+      munmap(sq_ring_, sq_ring_size_);
+    }
+    ::close(ring_fd_);
+  }
+
+  UringWriter(const UringWriter&) = delete;
+  UringWriter& operator=(const UringWriter&) = delete;
+
+  // 提交一次 writev，不等待完成；iov 内容被拷贝，数据须保持到 wait 返回
+  bool submit(int fd, const struct iovec* iov, size_t count) {
+    iov_.assign(iov, iov + count);
+    unsigned tail = *sq_tail_;
+    unsigned index = tail & *sq_mask_;
+    io_uring_sqe* sqe = &sqes_[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_WRITEV;
+    sqe->fd = fd;
+    sqe->off = ~uint64_t{0};
+    sqe->addr = reinterpret_cast<uint64_t>(iov_.data());
+    sqe->len = static_cast<uint32_t>(iov_.size());
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+    for (;;) {
+      int ret = static_cast<int>(
+          syscall(__NR_io_uring_enter, ring_fd_, 1, 0, 0, nullptr, 0));
+      if (ret >= 0) {
+        pending_ = true;
+        return true;
+      }
+      if (errno != EINTR) {
+        // 撤回未被内核取走的提交项
+        __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+        return false;
+      }
+    }
+  }
+
+  // 等待已提交的写入完成，返回写入字节数或负的 errno；entered 返回是否
+  // 为等待进入了内核
+  int64_t wait(bool* entered) {
+    *entered = false;
+    for (;;) {
+      unsigned head = *cq_head_;
+      if (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) {
+        int64_t result = cqes_[head & *cq_mask_].res;
+        __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+        pending_ = false;
+        return result;
+      }
+      *entered = true;
+      int ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, 0, 1,
+                                         IORING_ENTER_GETEVENTS, nullptr, 0));
+      if (ret < 0 && errno != EINTR) {
+        pending_ = false;
+        return -errno;
+      }
+    }
+  }
+
+  bool pending() const { return pending_; }
+
+ private:
+  static constexpr unsigned kEntries = 2;
+
+  explicit UringWriter(int ring_fd) : ring_fd_(ring_fd) {}
+
+  bool map(const io_uring_params& params) {
+    sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size_ =
+        params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+      sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+    }
+    sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQ_RING);
+    if (sq_ring_ == MAP_FAILED) {
+      return false;
+    }
+    cq_ring_ = single_mmap
+                   ? sq_ring_
+                   : mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd_,
+                          IORING_OFF_CQ_RING);
+    if (cq_ring_ == MAP_FAILED) {
+      return false;
+    }
+    sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_mapping_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, ring_fd_, IORING_OFF_SQES);
+    if (sqes_mapping_ == MAP_FAILED) {
+      return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes_mapping_);
+
+    char* sq = static_cast<char*>(sq_ring_);
+    sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    char* cq = static_cast<char*>(cq_ring_);
+    cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return true;
+  }
+
+  const int ring_fd_;
+  void* sq_ring_ = MAP_FAILED;
+  void* cq_ring_ = MAP_FAILED;
+  void* sqes_mapping_ = MAP_FAILED;
+  size_t sq_ring_size_ = 0;
+  size_t cq_ring_size_ = 0;
+  size_t sqes_size_ = 0;
+  io_uring_sqe* sqes_ = nullptr;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_mask_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  unsigned* cq_mask_ = nullptr;
+  io_uring_cqe* cqes_ = nullptr;
+  std::vector<struct iovec> iov_;
+  bool pending_ = false;
+};
+
+}  // namespace internal
+
+namespace {
+
+// 单次 writev 的 iovec 上限
+constexpr size_t kMaxIov = IOV_MAX;
+
+// 等待不可写的非阻塞描述符变为可写的最长毫秒数
+constexpr int kPollTimeoutMs = 100;
+
+int64_t SteadyNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // anonymous namespace
+
+char* GroupCommitSink::Batch::append(size_t size) {
+  if (used_chunks == 0 ||
+      chunks[used_chunks - 1].size() + size >
+          std::max(kChunkSize, chunks[used_chunks - 1].capacity())) {
+    if (used_chunks == chunks.size()) {
+      chunks.emplace_back();
+      chunks.back().reserve(std::max(kChunkSize, size));
+    } else if (chunks[used_chunks].capacity() < size) {
+      chunks[used_chunks].reserve(size);
+    }
+    ++used_chunks;
+  }
+  std::string& chunk = chunks[used_chunks - 1];
+  size_t offset = chunk.size();
+  // 容量已预留，resize 不会重新分配
+  chunk.resize(offset + size);
+  bytes += size;
+  return chunk.data() + offset;
+}
+
+void GroupCommitSink::Batch::clear() {
+  for (size_t i = 0; i < used_chunks; ++i) {
+    chunks[i].clear();
+  }
+  used_chunks = 0;
+  bytes = 0;
+  records = 0;
+  first_nanos = 0;
+}
+
+GroupCommitSink::GroupCommitSink(const GroupCommitOptions& options,
+                                 size_t buffer_size)
+    : max_batch_bytes_(options.max_batch_bytes),
+      max_batch_delay_nanos_(int64_t{options.max_batch_delay_us} * 1000),
+      use_io_uring_(options.use_io_uring),
+      formatter_(std::make_unique<spdlog::pattern_formatter>()) {
+  buffer_.reserve(buffer_size);
+}
+
+GroupCommitSink::~GroupCommitSink() {
+  try {
+    flush();
+  } catch (...) {
+    // 静默处理日志错误，避免异常传播
+  }
+  uring_.reset();
+  close_fd();
+}
+
+absl::Status GroupCommitSink::ValidateOptions(
+    const GroupCommitOptions& options) {
+  if (options.max_batch_bytes < 4096 ||
+      options.max_batch_bytes > (size_t{64} << 20)) {
+    return absl::InvalidArgumentError(
+        "Group commit batch size must be between 4KB and 64MB");
+  }
+  if (options.max_batch_delay_us < 0) {
+    return absl::InvalidArgumentError(
+        "Group commit batch delay cannot be negative");
+  }
+  return absl::OkStatus();
+}
+
+absl::Status GroupCommitSink::open(const std::string& path, bool truncate) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int flags = O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC;
+  if (truncate) {
+    flags |= O_TRUNC;
+  }
+  int fd = ::open(path.c_str(), flags, 0644);
+  if (fd < 0) {
+    return absl::InternalError(absl::StrFormat(
+        "Failed to open log file %s: %s", path, std::strerror(errno)));
+  }
+  close_fd();
+  fd_ = fd;
+  console_ = nullptr;
+  should_color_ = false;
+  filename_ = path;
+  uring_.reset();
+  if (use_io_uring_) {
+    uring_ = internal::UringWriter::Create();
+  }
+  return absl::OkStatus();
+}
+
+absl::Status GroupCommitSink::open_console(FILE* target,
+                                           spdlog::color_mode mode) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int fd = fileno(target);
+  if (fd < 0) {
+    return absl::InvalidArgumentError("Console stream has no file descriptor");
+  }
+  close_fd();
+  fd_ = fd;
+  console_ = target;
+  should_color_ = internal::ShouldColorConsole(target, mode);
+  filename_.clear();
+  // 终端和管道的写入在内核中同样会阻塞，不经 io_uring
+  uring_.reset();
+  return absl::OkStatus();
+}
+
+void GroupCommitSink::log(const spdlog::details::log_msg& msg) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  // leader 写出期间暂存批次达到上限时等待，限制内存占用；等待会释放锁，
+  // 须在格式化到共用缓冲区之前完成
+  while (committing_ && staging_.bytes >= max_batch_bytes_) {
+    committed_cv_.wait(lock);
+  }
+
+  msg.color_range_start = 0;
+  msg.color_range_end = 0;
+  buffer_.clear();
+  formatter_->format(msg, buffer_);
+
+  int64_t now = SteadyNanos();
+  if (staging_.empty()) {
+    staging_.first_nanos = now;
+  }
+  if (should_color_ && msg.color_range_end > msg.color_range_start) {
+    absl::string_view color = internal::ConsoleLevelColor(msg.level);
+    absl::string_view reset = internal::ConsoleResetColor();
+    char* dst = staging_.append(buffer_.size() + color.size() + reset.size());
+    auto put = [&dst](const char* data, size_t size) {
+      std::memcpy(dst, data, size);
+      dst += size;
+    };
+    put(buffer_.data(), msg.color_range_start);
+    put(color.data(), color.size());
+    put(buffer_.data() + msg.color_range_start,
+        msg.color_range_end - msg.color_range_start);
+    put(reset.data(), reset.size());
+    put(buffer_.data() + msg.color_range_end,
+        buffer_.size() - msg.color_range_end);
+  } else {
+    std::memcpy(staging_.append(buffer_.size()), buffer_.data(),
+                buffer_.size());
+  }
+  ++staging_.records;
+
+  if (should_commit(now)) {
+    pending_commit_ = true;
+  }
+  // 已有 leader 时由它在本次写出后接着提交
+  if (pending_commit_ && !committing_) {
+    commit_locked(lock, false);
+  }
+}
+
+void GroupCommitSink::flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  committed_cv_.wait(lock, [this] { return !committing_; });
+  if (!staging_.empty()) {
+    pending_commit_ = true;
+  }
+  commit_locked(lock, true);
+}
+
+void GroupCommitSink::set_pattern(const std::string& pattern) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  formatter_ = std::make_unique<spdlog::pattern_formatter>(pattern);
+}
+
+void GroupCommitSink::set_formatter(
+    std::unique_ptr<spdlog::formatter> formatter) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  formatter_ = std::move(formatter);
+}
+
+void GroupCommitSink::begin_batch() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  batch_active_ = true;
+  batch_thread_ = std::this_thread::get_id();
+}
+
+void GroupCommitSink::end_batch() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  batch_active_ = false;
+  if (!staging_.empty()) {
+    pending_commit_ = true;
+  }
+  if (pending_commit_ && !committing_) {
+    commit_locked(lock, false);
+  }
+}
+
+std::string GroupCommitSink::filename() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return filename_;
+}
+
+GroupCommitStats GroupCommitSink::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  GroupCommitStats stats;
+  stats.records = records_;
+  stats.batches = batches_;
+  stats.bytes = bytes_;
+  stats.write_calls = write_calls_.load(std::memory_order_relaxed);
+  stats.errors = errors_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+bool GroupCommitSink::deferring() const {
+  return batch_active_ && batch_thread_ == std::this_thread::get_id();
+}
+
+bool GroupCommitSink::should_commit(int64_t now_nanos) const {
+  if (staging_.empty()) {
+    return false;
+  }
+  return !deferring() || staging_.bytes >= max_batch_bytes_ ||
+         now_nanos - staging_.first_nanos >= max_batch_delay_nanos_;
+}
+
+void GroupCommitSink::commit_locked(std::unique_lock<std::mutex>& lock,
+                                    bool drain) {
+  committing_ = true;
+  while (pending_commit_) {
+    pending_commit_ = false;
+    std::swap(staging_, outgoing_);
+    lock.unlock();
+    bool submitted = false;
+    bool ok = write_batch(outgoing_, &submitted);
+    lock.lock();
+
+    if (ok) {
+      records_ += outgoing_.records;
+      bytes_ += outgoing_.bytes;
+      ++batches_;
+    } else {
+      errors_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (submitted) {
+      // outgoing_ 已交给内核，换回已确认完成的上一批
+      std::swap(outgoing_, inflight_);
+    }
+    outgoing_.clear();
+    committed_cv_.notify_all();
+
+    if (should_commit(SteadyNanos())) {
+      pending_commit_ = true;
+    }
+  }
+
+  if (drain && uring_ != nullptr && uring_->pending()) {
+    lock.unlock();
+    reap_inflight();
+    lock.lock();
+    inflight_.clear();
+  }
+  committing_ = false;
+  committed_cv_.notify_all();
+}
+
+bool GroupCommitSink::write_batch(const Batch& batch, bool* submitted) {
+  *submitted = false;
+  if (fd_ < 0) {
+    return false;
+  }
+  if (uring_ == nullptr) {
+    if (console_ == nullptr) {
+      return writev_all(batch, 0);
+    }
+    // 与其他控制台 sink 共用全局锁，并先写出 stdio 中已缓冲的内容
+    std::lock_guard<std::mutex> console_lock(
+        spdlog::details::console_mutex::mutex());
+    fflush(console_);
+    return writev_all(batch, 0);
+  }
+
+  // 回收上一批后再提交，同一文件上最多一个未完成的写入，保证顺序
+  reap_inflight();
+  iov_.clear();
+  for (size_t i = 0; i < batch.used_chunks && i < kMaxIov; ++i) {
+    iov_.push_back({const_cast<char*>(batch.chunks[i].data()),
+                    batch.chunks[i].size()});
+  }
+  if (batch.used_chunks <= kMaxIov &&
+      uring_->submit(fd_, iov_.data(), iov_.size())) {
+    write_calls_.fetch_add(1, std::memory_order_relaxed);
+    *submitted = true;
+    return true;
+  }
+  // 提交失败或块数超出单次上限：同步写出本批
+  return writev_all(batch, 0);
+}
+
+bool GroupCommitSink::writev_all(const Batch& batch, size_t skip) {
+  iov_.clear();
+  for (size_t i = 0; i < batch.used_chunks; ++i) {
+    const std::string& chunk = batch.chunks[i];
+    if (skip >= chunk.size()) {
+      skip -= chunk.size();
+      continue;
+    }
+    iov_.push_back({const_cast<char*>(chunk.data()) + skip,
+                    chunk.size() - skip});
+    skip = 0;
+  }
+
+  size_t index = 0;
+  while (index < iov_.size()) {
+    int count = static_cast<int>(std::min(kMaxIov, iov_.size() - index));
+    ssize_t written = ::writev(fd_, iov_.data() + index, count);
+    write_calls_.fetch_add(1, std::memory_order_relaxed);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        pollfd pfd{fd_, POLLOUT, 0};
+        ::poll(&pfd, 1, kPollTimeoutMs);
+        continue;
+      }
+      return false;
+    }
+    // 跳过已完整写出的 iovec，截掉部分写出的那一个
+    size_t remaining = static_cast<size_t>(written);
+    while (index < iov_.size() && remaining >= iov_[index].iov_len) {
+      remaining -= iov_[index].iov_len;
+      ++index;
+    }
+    if (remaining != 0) {
+      iov_[index].iov_base =
+          static_cast<char*>(iov_[index].iov_base) + remaining;
+      iov_[index].iov_len -= remaining;
+    }
+  }
+  return true;
+}
+
+bool GroupCommitSink::reap_inflight() {
+  if (uring_ == nullptr || !uring_->pending()) {
+    return true;
+  }
+  bool entered = false;
+  int64_t result = uring_->wait(&entered);
+  if (entered) {
+    write_calls_.fetch_add(1, std::memory_order_relaxed);
+  }
+  if (result == static_cast<int64_t>(inflight_.bytes)) {
+    return true;
+  }
+  // 短写补写剩余部分，EAGAIN 等错误整批改为同步重写
+  size_t skip = result > 0 ? static_cast<size_t>(result) : 0;
+  if (result < 0 && result != -EAGAIN) {
+    errors_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  if (!writev_all(inflight_, skip)) {
+    errors_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+void GroupCommitSink::close_fd() {
+  if (fd_ >= 0 && console_ == nullptr) {
+    ::close(fd_);
+  }
+  fd_ = -1;
+}
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,434 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/json_escape.h"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define QXCORE_LOG_HAVE_X86_SIMD 1
+#endif
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+// ASCII 字节的转义字符：0 不转义，'u' 写成 \u00XX
+struct EscapeTable {
+  char value[128];
+
+  constexpr EscapeTable() : value() {
+    for (int c = 0; c < 0x20; ++c) {
+      value[c] = 'u';
+    }
+    value['\b'] = 'b';
+    value['\f'] = 'f';
+    value['\n'] = 'n';
+    value['\r'] = 'r';
+    value['\t'] = 't';
+    value['"'] = '"';
+    value['\\'] = '\\';
+  }
+};
+
+constexpr EscapeTable kEscapes;
+constexpr char kHexDigits[] = "0123456789abcdef";
+constexpr char kReplacement[] = "\\ufffd";
+
+inline bool NeedsEscape(unsigned char c) {
+  return c < 0x80 && kEscapes.value[c] != 0;
+}
+
+inline char* WriteEscape(unsigned char c, char* dst) {
+  char escape = kEscapes.value[c];
+  *dst++ = '\\';
+  *dst++ = escape;
+  if (escape == 'u') {
+    *dst++ = '0';
+    *dst++ = '0';
+    *dst++ = kHexDigits[c >> 4];
+    *dst++ = kHexDigits[c & 0x0F];
+  }
+  return dst;
+}
+
+// 从 p 开始的 UTF-8 序列长度，非法时返回 0；p[0] 不是 ASCII
+size_t Utf8SequenceLength(const unsigned char* p, size_t remaining) {
+  auto continuation = [&](size_t i) {
+    return i < remaining && (p[i] & 0xC0) == 0x80;
+  };
+  unsigned char c = p[0];
+  if (c < 0xC2) {
+    return 0;
+  }
+  if (c < 0xE0) {
+    return continuation(1) ? 2 : 0;
+  }
+  if (c < 0xF0) {
+    if (!continuation(1) || (c == 0xE0 && p[1] < 0xA0) ||
+        (c == 0xED && p[1] > 0x9F)) {
+      return 0;
+    }
+    return continuation(2) ? 3 : 0;
+  }
+  if (c < 0xF5) {
+    if (!continuation(1) || (c == 0xF0 && p[1] < 0x90) ||
+        (c == 0xF4 && p[1] > 0x8F)) {
+      return 0;
+    }
+    return continuation(2) && continuation(3) ? 4 : 0;
+  }
+  return 0;
+}
+
+bool IsValidUtf8Scalar(const unsigned char* p, size_t size) {
+  size_t i = 0;
+  while (i < size) {
+    if (p[i] < 0x80) {
+      ++i;
+      continue;
+    }
+    size_t length = Utf8SequenceLength(p + i, size - i);
+    if (length == 0) {
+      return false;
+    }
+    i += length;
+  }
+  return true;
+}
+
+// 含非法 UTF-8 的输入：逐字符转义，非法字节写成 \ufffd
+char* WriteReplacingInvalid(const unsigned char* p, size_t size, char* dst) {
+  size_t i = 0;
+  while (i < size) {
+    unsigned char c = p[i];
+    if (c < 0x80) {
+      if (NeedsEscape(c)) {
+        dst = WriteEscape(c, dst);
+      } else {
+        *dst++ = static_cast<char>(c);
+      }
+      ++i;
+      continue;
+    }
+    size_t length = Utf8SequenceLength(p + i, size - i);
+    if (length == 0) {
+      std::memcpy(dst, kReplacement, sizeof(kReplacement) - 1);
+      dst += sizeof(kReplacement) - 1;
+      ++i;
+    } else {
+      std::memcpy(dst, p + i, length);
+      dst += length;
+      i += length;
+    }
+  }
+  return dst;
+}
+
+size_t FindEscapeScalar(const unsigned char* p, size_t i, size_t size) {
+  while (i < size && !NeedsEscape(p[i])) {
+    ++i;
+  }
+  return i;
+}
+
+#ifdef QXCORE_LOG_HAVE_X86_SIMD
+
+// 需要转义的字节掩码：" \ 与 < 0x20
+inline int EscapeMaskSse2(__m128i input) {
+  __m128i quote = _mm_cmpeq_epi8(input, _mm_set1_epi8('"'));
+  __m128i backslash = _mm_cmpeq_epi8(input, _mm_set1_epi8('\\'));
+  __m128i control = _mm_cmpeq_epi8(_mm_max_epu8(input, _mm_set1_epi8(0x1F)),
+                                   _mm_set1_epi8(0x1F));
+  return _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(quote, backslash), control));
+}
+
+size_t FindEscapeSse2(const unsigned char* p, size_t i, size_t size) {
+  for (; i + 16 <= size; i += 16) {
+    int mask = EscapeMaskSse2(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)));
+    if (mask != 0) {
+      return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+    }
+  }
+  return FindEscapeScalar(p, i, size);
+}
+
+__attribute__((target("avx2"))) size_t FindEscapeAvx2(const unsigned char* p,
+                                                      size_t i, size_t size) {
+  const __m256i quote = _mm256_set1_epi8('"');
+  const __m256i backslash = _mm256_set1_epi8('\\');
+  const __m256i control = _mm256_set1_epi8(0x1F);
+  for (; i + 32 <= size; i += 32) {
+    __m256i input = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+    __m256i hits = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(input, quote),
+                        _mm256_cmpeq_epi8(input, backslash)),
+        _mm256_cmpeq_epi8(_mm256_max_epu8(input, control), control));
+    uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hits));
+    if (mask != 0) {
+      return i + static_cast<size_t>(__builtin_ctz(mask));
+    }
+  }
+  return FindEscapeSse2(p, i, size);
+}
+
+// SSE2：整块跳过 ASCII，遇到非 ASCII 字节时逐字符校验
+bool IsValidUtf8Sse2(const unsigned char* p, size_t size) {
+  size_t i = 0;
+  while (i < size) {
+    if (i + 16 <= size &&
+        _mm_movemask_epi8(_mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(p + i))) == 0) {
+      i += 16;
+      continue;
+    }
+    if (p[i] < 0x80) {
+      ++i;
+      continue;
+    }
+    size_t length = Utf8SequenceLength(p + i, size - i);
+    if (length == 0) {
+      return false;
+    }
+    i += length;
+  }
+  return true;
+}
+
+// AVX2 查表法 UTF-8 校验（Keiser & Lemire, "Validating UTF-8 In Less Than
+// One Instruction Per Byte"）。每个字节与其前 1~3 个字节组合查三张 16 项表，
+// 结果按位与后非零即为错误；表项的每一位对应一类错误。
+constexpr uint8_t kTooShort = 1 << 0;
+constexpr uint8_t kTooLong = 1 << 1;
+constexpr uint8_t kOverlong3 = 1 << 2;
+constexpr uint8_t kTooLarge = 1 << 3;
+constexpr uint8_t kSurrogate = 1 << 4;
+constexpr uint8_t kOverlong2 = 1 << 5;
+constexpr uint8_t kTooLarge1000 = 1 << 6;
+constexpr uint8_t kOverlong4 = 1 << 6;
+constexpr uint8_t kTwoConts = 1 << 7;
+constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+// 前一字节的高 4 位
+alignas(16) constexpr uint8_t kByte1High[16] = {
+    kTooLong, kTooLong, kTooLong, kTooLong,
+    kTooLong, kTooLong, kTooLong, kTooLong,
+    kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+    kTooShort | kOverlong2,
+    kTooShort,
+    kTooShort | kOverlong3 | kSurrogate,
+    kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+};
+
+// 前一字节的低 4 位
+alignas(16) constexpr uint8_t kByte1Low[16] = {
+    kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+    kCarry | kOverlong2,
+    kCarry,
+    kCarry,
+    kCarry | kTooLarge,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+};
+
+// 当前字节的高 4 位
+alignas(16) constexpr uint8_t kByte2High[16] = {
+    kTooShort, kTooShort, kTooShort, kTooShort,
+    kTooShort, kTooShort, kTooShort, kTooShort,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooShort, kTooShort, kTooShort, kTooShort,
+};
+
+struct Utf8Avx2State {
+  __m256i error;
+  __m256i prev_input;
+  __m256i prev_incomplete;
+};
+
+__attribute__((target("avx2"))) inline __m256i LoadTable(
+    const uint8_t (&table)[16]) {
+  return _mm256_broadcastsi128_si256(
+      _mm_load_si128(reinterpret_cast<const __m128i*>(table)));
+}
+
+__attribute__((target("avx2"))) inline __m256i HighNibble(__m256i value) {
+  return _mm256_and_si256(_mm256_srli_epi16(value, 4), _mm256_set1_epi8(0x0F));
+}
+
+// input 之前第 N 个字节组成的向量，跨块时取 prev 的末尾
+template<int N>
+__attribute__((target("avx2"))) inline __m256i Previous(__m256i input,
+                                                        __m256i prev) {
+  return _mm256_alignr_epi8(
+      input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N);
+}
+
+__attribute__((target("avx2"))) inline void CheckUtf8BlockAvx2(
+    __m256i input, Utf8Avx2State& state) {
+  if (_mm256_movemask_epi8(input) == 0) {
+    // 纯 ASCII 块：只需确认上一块末尾没有未完成的序列
+    state.error = _mm256_or_si256(state.error, state.prev_incomplete);
+    state.prev_incomplete = _mm256_setzero_si256();
+    state.prev_input = input;
+    return;
+  }
+  __m256i prev1 = Previous<1>(input, state.prev_input);
+  __m256i special = _mm256_and_si256(
+      _mm256_and_si256(
+          _mm256_shuffle_epi8(LoadTable(kByte1High), HighNibble(prev1)),
+          _mm256_shuffle_epi8(LoadTable(kByte1Low),
+                              _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)))),
+      _mm256_shuffle_epi8(LoadTable(kByte2High), HighNibble(input)));
+
+  // 三、四字节序列的第 3、4 个字节必须是延续字节
+  __m256i prev2 = Previous<2>(input, state.prev_input);
+  __m256i prev3 = Previous<3>(input, state.prev_input);
+  __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8(0xE0 - 0x80));
+  __m256i fourth = _mm256_subs_epu8(
+      prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+  __m256i must_continue = _mm256_and_si256(
+      _mm256_or_si256(third, fourth),
+      _mm256_set1_epi8(static_cast<char>(0x80)));
+  state.error = _mm256_or_si256(state.error,
+                                _mm256_xor_si256(must_continue, special));
+
+  // 末尾 3 个字节中的前导字节需要下一块的延续字节
+  const __m256i max_value = _mm256_setr_epi8(
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1),
+      static_cast<char>(0xC0 - 1));
+  state.prev_incomplete = _mm256_subs_epu8(input, max_value);
+  state.prev_input = input;
+}
+
+__attribute__((target("avx2"))) bool IsValidUtf8Avx2(const unsigned char* p,
+                                                     size_t size) {
+  Utf8Avx2State state{_mm256_setzero_si256(), _mm256_setzero_si256(),
+                      _mm256_setzero_si256()};
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    CheckUtf8BlockAvx2(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)), state);
+  }
+  if (i < size) {
+    // 尾部补零：零字节是 ASCII，未完成的序列会在补零处报错
+    alignas(32) unsigned char tail[32] = {};
+    std::memcpy(tail, p + i, size - i);
+    CheckUtf8BlockAvx2(_mm256_load_si256(reinterpret_cast<const __m256i*>(tail)),
+                       state);
+  }
+  __m256i error = _mm256_or_si256(state.error, state.prev_incomplete);
+  return _mm256_testz_si256(error, error) != 0;
+}
+
+#endif  // QXCORE_LOG_HAVE_X86_SIMD
+
+size_t FindEscape(const unsigned char* p, size_t i, size_t size,
+                  internal::SimdLevel level) {
+#ifdef QXCORE_LOG_HAVE_X86_SIMD
+  if (level == internal::SimdLevel::kAvx2) {
+    return FindEscapeAvx2(p, i, size);
+  }
+  if (level == internal::SimdLevel::kSse2) {
+    return FindEscapeSse2(p, i, size);
+  }
+#else
+  (void)level;
+#endif
+  return FindEscapeScalar(p, i, size);
+}
+
+}  // anonymous namespace
+
+namespace internal {
+
+SimdLevel DetectSimdLevel() {
+#ifdef QXCORE_LOG_HAVE_X86_SIMD
+  static const SimdLevel level = __builtin_cpu_supports("avx2")
+                                     ? SimdLevel::kAvx2
+                                     : SimdLevel::kSse2;
+  return level;
+#else
+  return SimdLevel::kScalar;
+#endif
+}
+
+bool IsValidUtf8(absl::string_view text, SimdLevel level) {
+  const auto* p = reinterpret_cast<const unsigned char*>(text.data());
+#ifdef QXCORE_LOG_HAVE_X86_SIMD
+  if (level == SimdLevel::kAvx2) {
+    return IsValidUtf8Avx2(p, text.size());
+  }
+  if (level == SimdLevel::kSse2) {
+    return IsValidUtf8Sse2(p, text.size());
+  }
+#else
+  (void)level;
+#endif
+  return IsValidUtf8Scalar(p, text.size());
+}
+
+char* WriteJsonString(absl::string_view text, char* dst, SimdLevel level) {
+  const auto* p = reinterpret_cast<const unsigned char*>(text.data());
+  size_t size = text.size();
+  *dst++ = '"';
+  if (!IsValidUtf8(text, level)) {
+    dst = WriteReplacingInvalid(p, size, dst);
+  } else {
+    // 合法 UTF-8 中只有 ASCII 字节需要转义，其余内容整段拷贝
+    size_t i = 0;
+    while (i < size) {
+      size_t next = FindEscape(p, i, size, level);
+      std::memcpy(dst, p + i, next - i);
+      dst += next - i;
+      if (next == size) {
+        break;
+      }
+      dst = WriteEscape(p[next], dst);
+      i = next + 1;
+    }
+  }
+  *dst++ = '"';
+  return dst;
+}
+
+}  // namespace internal
+
+char* WriteJsonString(absl::string_view text, char* dst) {
+  return internal::WriteJsonString(text, dst, internal::DetectSimdLevel());
+}
+
+bool IsValidUtf8(absl::string_view text) {
+  return internal::IsValidUtf8(text, internal::DetectSimdLevel());
+}
+
+}  // namespace log
+}  // namespace qxcore
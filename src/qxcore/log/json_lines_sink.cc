@@ -0,0 +1,147 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/json_lines_sink.h"
+
+#include <chrono>
+#include <cmath>
+#include <type_traits>
+#include <absl/strings/str_format.h>
+#include "qxcore/log/json_escape.h"
+#include "qxcore/log/log_context.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+void AppendLiteral(absl::string_view text, spdlog::memory_buf_t& out) {
+  out.append(text.data(), text.data() + text.size());
+}
+
+// 非有限浮点数不是合法的 JSON 数值，写成字符串
+template<typename T>
+void AppendNumber(T value, spdlog::memory_buf_t& out) {
+  if constexpr (std::is_floating_point_v<T>) {
+    if (!std::isfinite(value)) {
+      fmt::format_to(fmt::appender(out), FMT_COMPILE("\"{}\""), value);
+      return;
+    }
+  }
+  fmt::format_to(fmt::appender(out), FMT_COMPILE("{}"), value);
+}
+
+}  // anonymous namespace
+
+JsonLinesSink::JsonLinesSink(size_t buffer_size) {
+  buffer_.reserve(buffer_size);
+}
+
+absl::Status JsonLinesSink::open(const std::string& path, bool truncate) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  try {
+    file_.open(path, truncate);
+    return absl::OkStatus();
+  } catch (const std::exception& e) {
+    return absl::InternalError(
+        absl::StrFormat("Failed to open JSON log file %s: %s", path, e.what()));
+  }
+}
+
+void JsonLinesSink::sink_it_(const spdlog::details::log_msg& msg) {
+  buffer_.clear();
+  AppendLiteral("{\"ts\":", buffer_);
+  AppendNumber(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   msg.time.time_since_epoch())
+                   .count(),
+               buffer_);
+  AppendLiteral(",\"level\":\"", buffer_);
+  spdlog::string_view_t level = spdlog::level::to_string_view(msg.level);
+  buffer_.append(level.data(), level.data() + level.size());
+  AppendLiteral("\",\"logger\":", buffer_);
+  AppendJsonString(absl::string_view(msg.logger_name.data(),
+                                     msg.logger_name.size()),
+                   buffer_);
+  AppendLiteral(",\"thread\":", buffer_);
+  AppendNumber(msg.thread_id, buffer_);
+  if (!msg.source.empty()) {
+    AppendLiteral(",\"file\":", buffer_);
+    AppendJsonString(msg.source.filename, buffer_);
+    AppendLiteral(",\"line\":", buffer_);
+    AppendNumber(msg.source.line, buffer_);
+  }
+  absl::string_view context = internal::RecordLogContext();
+  if (!context.empty()) {
+    AppendLiteral(",\"context\":", buffer_);
+    AppendJsonString(context, buffer_);
+  }
+
+  absl::string_view payload(msg.payload.data(), msg.payload.size());
+  AppendLiteral(",\"msg\":", buffer_);
+  if (ParseStructured(payload, &record_)) {
+    AppendJsonString(record_.event, buffer_);
+    for (const StructuredField& field : record_.fields) {
+      append_field(field);
+    }
+  } else {
+    AppendJsonString(payload, buffer_);
+  }
+  AppendLiteral("}\n", buffer_);
+  file_.write(buffer_);
+}
+
+void JsonLinesSink::append_field(const StructuredField& field) {
+  buffer_.push_back(',');
+  AppendJsonString(field.key, buffer_);
+  buffer_.push_back(':');
+  switch (field.type) {
+    case ArgType::kBool:
+      AppendLiteral(field.int_value != 0 ? "true" : "false", buffer_);
+      break;
+    case ArgType::kChar: {
+      char c = static_cast<char>(field.int_value);
+      AppendJsonString(absl::string_view(&c, 1), buffer_);
+      break;
+    }
+    case ArgType::kInt32:
+    case ArgType::kInt64:
+      AppendNumber(field.int_value, buffer_);
+      break;
+    case ArgType::kUInt32:
+    case ArgType::kUInt64:
+      AppendNumber(field.uint_value, buffer_);
+      break;
+    case ArgType::kPointer:
+      fmt::format_to(fmt::appender(buffer_), FMT_COMPILE("\"{:#x}\""),
+                     field.uint_value);
+      break;
+    case ArgType::kFloat:
+      AppendNumber(static_cast<float>(field.double_value), buffer_);
+      break;
+    case ArgType::kDouble:
+      AppendNumber(field.double_value, buffer_);
+      break;
+    case ArgType::kString:
+      AppendJsonString(field.text, buffer_);
+      break;
+  }
+}
+
+void JsonLinesSink::flush_() {
+  file_.flush();
+}
+
+}  // namespace log
+}  // namespace qxcore
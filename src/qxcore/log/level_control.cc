@@ -0,0 +1,489 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/level_control.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/inotify.h>
+#endif
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <absl/strings/ascii.h>
+#include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_format.h>
+#include <absl/strings/str_split.h>
+#include "qxcore/log/logger_registry.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+constexpr absl::string_view kLoggerPrefix = "logger.";
+constexpr absl::string_view kCallsitePrefix = "callsite.";
+
+// 控制线程唤醒管道中的字节
+constexpr char kStopByte = 'q';
+constexpr char kRaiseByte = '+';
+constexpr char kRestoreByte = '-';
+
+// 处理 SIGUSR1/SIGUSR2 的控制器及其唤醒管道写端
+std::atomic<LevelController*> g_signal_owner{nullptr};
+std::atomic<int> g_signal_fd{-1};
+struct sigaction g_previous_usr1;
+struct sigaction g_previous_usr2;
+
+// 只调用 write，异步信号安全
+void LevelSignalHandler(int signal) {
+  int saved_errno = errno;
+  int fd = g_signal_fd.load(std::memory_order_relaxed);
+  if (fd >= 0) {
+    char byte = signal == SIGUSR1 ? kRaiseByte : kRestoreByte;
+    ssize_t written = ::write(fd, &byte, 1);
+    (void)written;
+  }
+  errno = saved_errno;
+}
+
+absl::Status ParseCallsiteRule(absl::string_view key, absl::string_view value,
+                               CallsiteLevelRule* rule) {
+  absl::string_view file = key;
+  size_t colon = key.rfind(':');
+  if (colon != absl::string_view::npos) {
+    if (!absl::SimpleAtoi(key.substr(colon + 1), &rule->line) ||
+        rule->line <= 0) {
+      return absl::InvalidArgumentError("invalid callsite line");
+    }
+    file = key.substr(0, colon);
+  }
+  if (file.empty()) {
+    return absl::InvalidArgumentError("empty callsite file");
+  }
+  rule->file = std::string(file);
+
+  if (absl::EqualsIgnoreCase(value, "on")) {
+    rule->value = CallsiteOverride::kForceOn;
+  } else if (absl::EqualsIgnoreCase(value, "off")) {
+    rule->value = CallsiteOverride::kForceOff;
+  } else if (absl::EqualsIgnoreCase(value, "default")) {
+    rule->value = CallsiteOverride::kNone;
+  } else if (StringToLogLevel(value, rule->level)) {
+    rule->has_level = true;
+  } else {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("invalid callsite value '%s'", value));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ReadConfigFile(const std::string& path, std::string* content) {
+  std::FILE* file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    if (errno == ENOENT) {
+      return absl::NotFoundError(
+          absl::StrFormat("Level control file %s not found", path));
+    }
+    return absl::InternalError(absl::StrFormat(
+        "Failed to open level control file %s: %s", path,
+        std::strerror(errno)));
+  }
+  char buffer[4096];
+  size_t size;
+  while ((size = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    content->append(buffer, size);
+  }
+  bool failed = std::ferror(file) != 0;
+  std::fclose(file);
+  if (failed) {
+    return absl::InternalError(
+        absl::StrFormat("Failed to read level control file %s", path));
+  }
+  return absl::OkStatus();
+}
+
+LogLevel MoreVerbose(LogLevel level) {
+  return level == LogLevel::kTrace
+             ? level
+             : static_cast<LogLevel>(LogLevelToInt(level) - 1);
+}
+
+void KeepFirstError(absl::Status* first, const absl::Status& status) {
+  if (first->ok() && !status.ok()) {
+    *first = status;
+  }
+}
+
+}  // anonymous namespace
+
+absl::Status ParseLevelConfig(absl::string_view text, LevelConfig* config) {
+  *config = LevelConfig();
+  int line_number = 0;
+  for (absl::string_view line : absl::StrSplit(text, '\n')) {
+    ++line_number;
+    size_t comment = line.find('#');
+    if (comment != absl::string_view::npos) {
+      line = line.substr(0, comment);
+    }
+    line = absl::StripAsciiWhitespace(line);
+    if (line.empty()) {
+      continue;
+    }
+
+    size_t equals = line.find('=');
+    if (equals == absl::string_view::npos) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Line %d: expected key = value", line_number));
+    }
+    absl::string_view key = absl::StripAsciiWhitespace(line.substr(0, equals));
+    absl::string_view value =
+        absl::StripAsciiWhitespace(line.substr(equals + 1));
+
+    if (key == "level") {
+      if (!StringToLogLevel(value, config->global)) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Line %d: invalid log level '%s'", line_number, value));
+      }
+      config->has_global = true;
+    } else if (absl::StartsWith(key, kLoggerPrefix)) {
+      absl::string_view name = key.substr(kLoggerPrefix.size());
+      LogLevel level;
+      if (name.empty()) {
+        return absl::InvalidArgumentError(
+            absl::StrFormat("Line %d: empty logger name", line_number));
+      }
+      if (!StringToLogLevel(value, level)) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Line %d: invalid log level '%s'", line_number, value));
+      }
+      config->loggers.emplace_back(std::string(name), level);
+    } else if (absl::StartsWith(key, kCallsitePrefix)) {
+      CallsiteLevelRule rule;
+      absl::Status status =
+          ParseCallsiteRule(key.substr(kCallsitePrefix.size()), value, &rule);
+      if (!status.ok()) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "Line %d: %s", line_number, status.message()));
+      }
+      config->callsites.push_back(std::move(rule));
+    } else {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Line %d: unknown key '%s'", line_number, key));
+    }
+  }
+  return absl::OkStatus();
+}
+
+LevelController::~LevelController() {
+  stop();
+}
+
+void LevelController::add_target(
+    std::function<absl::Status(LogLevel)> set_level,
+    std::function<LogLevel()> get_level) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  targets_.push_back(Target{std::move(set_level), std::move(get_level), false,
+                            LogLevel::kInfo});
+}
+
+absl::Status LevelController::start(const LevelControlOptions& options) {
+  if (thread_.joinable()) {
+    return absl::FailedPreconditionError("Level controller already started");
+  }
+#if defined(__linux__)
+  options_ = options;
+  if (!options_.config_path.empty()) {
+    // 文件可以稍后再创建
+    absl::Status status = reload();
+    if (!status.ok() && !absl::IsNotFound(status)) {
+      return status;
+    }
+  }
+
+  if (::pipe2(wake_fds_, O_NONBLOCK | O_CLOEXEC) != 0) {
+    return absl::InternalError(absl::StrFormat(
+        "Failed to create level control pipe: %s", std::strerror(errno)));
+  }
+
+  if (!options_.config_path.empty()) {
+    // 监视所在目录，这样编辑器以“写临时文件再改名”方式保存时也能收到
+    size_t slash = options_.config_path.rfind('/');
+    std::string directory =
+        slash == std::string::npos
+            ? std::string(".")
+            : options_.config_path.substr(0, slash == 0 ? 1 : slash);
+    inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0 ||
+        ::inotify_add_watch(inotify_fd_, directory.c_str(),
+                            IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+      absl::Status status = absl::InternalError(absl::StrFormat(
+          "Failed to watch %s: %s", directory, std::strerror(errno)));
+      stop();
+      return status;
+    }
+  }
+
+  if (options_.handle_signals) {
+    LevelController* expected = nullptr;
+    if (!g_signal_owner.compare_exchange_strong(expected, this,
+                                                std::memory_order_acq_rel)) {
+      stop();
+      return absl::FailedPreconditionError(
+          "Another level controller already handles signals");
+    }
+    g_signal_fd.store(wake_fds_[1], std::memory_order_relaxed);
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = LevelSignalHandler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    ::sigaction(SIGUSR1, &action, &g_previous_usr1);
+    ::sigaction(SIGUSR2, &action, &g_previous_usr2);
+    owns_signals_ = true;
+  }
+
+  thread_ = std::thread([this] { run(); });
+  return absl::OkStatus();
+#else
+  (void)options;
+  return absl::UnimplementedError("Level control thread requires Linux");
+#endif
+}
+
+void LevelController::stop() {
+#if defined(__linux__)
+  if (owns_signals_) {
+    ::sigaction(SIGUSR1, &g_previous_usr1, nullptr);
+    ::sigaction(SIGUSR2, &g_previous_usr2, nullptr);
+    g_signal_fd.store(-1, std::memory_order_relaxed);
+    g_signal_owner.store(nullptr, std::memory_order_release);
+    owns_signals_ = false;
+  }
+  if (thread_.joinable()) {
+    char byte = kStopByte;
+    ssize_t written = ::write(wake_fds_[1], &byte, 1);
+    (void)written;
+    thread_.join();
+  }
+  for (int* fd : {&inotify_fd_, &wake_fds_[0], &wake_fds_[1]}) {
+    if (*fd >= 0) {
+      ::close(*fd);
+      *fd = -1;
+    }
+  }
+#endif
+}
+
+absl::Status LevelController::reload() {
+  std::string text;
+  LevelConfig config;
+  absl::Status status = ReadConfigFile(options_.config_path, &text);
+  if (status.ok()) {
+    status = ParseLevelConfig(text, &config);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (status.ok()) {
+    status = apply_locked(config);
+  }
+  last_status_ = status;
+  return status;
+}
+
+absl::Status LevelController::apply(const LevelConfig& config) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return apply_locked(config);
+}
+
+void LevelController::raise_verbosity() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (Target& target : targets_) {
+    save_target_locked(target);
+    target.set_level(MoreVerbose(target.get_level())).IgnoreError();
+  }
+  save_root_locked();
+  LoggerRegistry& registry = LoggerRegistry::Global();
+  registry.set_level("", MoreVerbose(registry.get_level(kRootLoggerId)))
+      .IgnoreError();
+}
+
+void LevelController::restore_verbosity() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  set_global_locked(applied_).IgnoreError();
+}
+
+absl::Status LevelController::last_status() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return last_status_;
+}
+
+absl::Status LevelController::apply_locked(const LevelConfig& config) {
+  absl::Status first_error = set_global_locked(config);
+
+  LoggerRegistry& registry = LoggerRegistry::Global();
+  for (const auto& previous : applied_.loggers) {
+    bool kept = false;
+    for (const auto& entry : config.loggers) {
+      kept = kept || entry.first == previous.first;
+    }
+    if (kept) {
+      continue;
+    }
+    // 恢复控制器接管之前的显式级别，而不是一律恢复继承
+    auto saved = saved_loggers_.find(previous.first);
+    if (saved != saved_loggers_.end()) {
+      if (saved->second.has_level) {
+        registry.set_level(previous.first, saved->second.level).IgnoreError();
+      } else {
+        registry.reset_level(previous.first).IgnoreError();
+      }
+      saved_loggers_.erase(saved);
+    }
+  }
+  for (const auto& entry : config.loggers) {
+    if (!saved_loggers_.contains(entry.first)) {
+      SavedLoggerLevel saved{false, LogLevel::kInfo};
+      saved.has_level = registry.explicit_level(entry.first, &saved.level);
+      saved_loggers_.emplace(entry.first, saved);
+    }
+    KeepFirstError(&first_error, registry.set_level(entry.first, entry.second));
+  }
+
+  CallsiteRegistry& callsites = CallsiteRegistry::Global();
+  for (const CallsiteLevelRule& rule : applied_.callsites) {
+    callsites.set_override(rule.file, rule.line, CallsiteOverride::kNone);
+  }
+  for (const CallsiteLevelRule& rule : config.callsites) {
+    if (rule.has_level) {
+      callsites.set_level_override(rule.file, rule.line, rule.level);
+    } else {
+      callsites.set_override(rule.file, rule.line, rule.value);
+    }
+  }
+
+  applied_ = config;
+  return first_error;
+}
+
+absl::Status LevelController::set_global_locked(const LevelConfig& config) {
+  absl::Status first_error;
+  if (config.has_global) {
+    for (Target& target : targets_) {
+      save_target_locked(target);
+      KeepFirstError(&first_error, target.set_level(config.global));
+    }
+    save_root_locked();
+    KeepFirstError(&first_error,
+                   LoggerRegistry::Global().set_level("", config.global));
+    return first_error;
+  }
+
+  // 配置不含全局级别：只恢复控制器（上次配置或信号）改过的级别，保留之后
+  // 由程序自己设置的级别
+  for (Target& target : targets_) {
+    if (target.saved) {
+      KeepFirstError(&first_error, target.set_level(target.saved_level));
+      target.saved = false;
+    }
+  }
+  if (root_saved_) {
+    KeepFirstError(&first_error,
+                   LoggerRegistry::Global().set_level("", root_initial_));
+    root_saved_ = false;
+  }
+  return first_error;
+}
+
+void LevelController::save_target_locked(Target& target) {
+  if (!target.saved) {
+    target.saved_level = target.get_level();
+    target.saved = true;
+  }
+}
+
+void LevelController::save_root_locked() {
+  if (!root_saved_) {
+    root_initial_ = LoggerRegistry::Global().get_level(kRootLoggerId);
+    root_saved_ = true;
+  }
+}
+
+void LevelController::run() {
+#if defined(__linux__)
+  absl::string_view name = options_.config_path;
+  size_t slash = name.rfind('/');
+  if (slash != absl::string_view::npos) {
+    name.remove_prefix(slash + 1);
+  }
+
+  for (;;) {
+    struct pollfd fds[2];
+    fds[0] = {wake_fds_[0], POLLIN, 0};
+    fds[1] = {inotify_fd_, POLLIN, 0};
+    nfds_t count = inotify_fd_ >= 0 ? 2 : 1;
+    if (::poll(fds, count, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+
+    if (fds[0].revents & POLLIN) {
+      char bytes[64];
+      ssize_t size = ::read(wake_fds_[0], bytes, sizeof(bytes));
+      for (ssize_t i = 0; i < size; ++i) {
+        switch (bytes[i]) {
+          case kStopByte:
+            return;
+          case kRaiseByte:
+            raise_verbosity();
+            break;
+          case kRestoreByte:
+            restore_verbosity();
+            break;
+        }
+        handled_events_.fetch_add(1, std::memory_order_release);
+      }
+    }
+
+    if (count == 2 && (fds[1].revents & POLLIN)) {
+      alignas(struct inotify_event) char buffer[4096];
+      bool changed = false;
+      ssize_t size = ::read(inotify_fd_, buffer, sizeof(buffer));
+      for (ssize_t offset = 0; offset < size;) {
+        const auto* event =
+            reinterpret_cast<const struct inotify_event*>(buffer + offset);
+        // 队列溢出时事件可能丢失，保守地重新读取
+        if ((event->mask & IN_Q_OVERFLOW) ||
+            (event->len != 0 && name == event->name)) {
+          changed = true;
+        }
+        offset += sizeof(struct inotify_event) + event->len;
+      }
+      if (changed) {
+        reload().IgnoreError();
+        handled_events_.fetch_add(1, std::memory_order_release);
+      }
+    }
+  }
+#endif
+}
+
+}  // namespace log
+}  // namespace qxcore
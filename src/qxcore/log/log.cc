@@ -13,7 +13,9 @@
 // limitations under the License.
 
 #include "qxcore/log/log.h"
+#include <atomic>
 #include <mutex>
+#include <string>
 
 // 确保包含完整的后端定义
 #ifdef QXCORE_ENABLE_LOG_SPDLOG
@@ -27,57 +29,86 @@ namespace log {
 
 namespace {
 
-// 全局日志器实例和互斥锁
-std::mutex g_logger_mutex;
-DefaultLog* g_logger = nullptr;
+// 全局日志器指针：读路径只做一次 acquire 读取，替换时由 init 互斥锁串行化
+std::atomic<DefaultLog*> g_logger{nullptr};
+std::mutex g_logger_init_mutex;
+std::string g_logger_name;
+
+// 关闭并释放旧日志器，由 EpochDomain 在没有读者后调用
+void RetireLogger(DefaultLog* logger) {
+  internal::EpochDomain::Global().retire([logger] {
+    logger->shutdown();
+    delete logger;
+  });
+}
 
 // 确保全局日志器在程序结束时正确清理
 class LoggerGuard {
  public:
   ~LoggerGuard() {
-    std::lock_guard<std::mutex> lock(g_logger_mutex);
-    if (g_logger != nullptr) {
-      g_logger->shutdown();
-      delete g_logger;
-      g_logger = nullptr;
+    std::lock_guard<std::mutex> lock(g_logger_init_mutex);
+    DefaultLog* logger = g_logger.exchange(nullptr, std::memory_order_acq_rel);
+    if (logger != nullptr) {
+      RetireLogger(logger);
     }
+    internal::EpochDomain::Global().synchronize();
   }
 };
 
 static LoggerGuard g_logger_guard;
 
+// 首次访问时创建默认日志器
+DefaultLog* CreateDefaultLogger() {
+  std::lock_guard<std::mutex> lock(g_logger_init_mutex);
+  DefaultLog* logger = g_logger.load(std::memory_order_acquire);
+  if (logger != nullptr) {
+    return logger;
+  }
+
+  logger = new DefaultLog();
+  // 使用默认配置初始化
+  absl::Status status = logger->init("qxcore_default", LogLevel::kInfo);
+  if (!status.ok()) {
+    // 如果初始化失败，我们无法使用日志系统记录错误
+    // 但至少确保对象存在
+  }
+  g_logger_name = "qxcore_default";
+  g_logger.store(logger, std::memory_order_release);
+  return logger;
+}
+
 }  // anonymous namespace
 
 DefaultLog& GetDefaultLogger() {
-  std::lock_guard<std::mutex> lock(g_logger_mutex);
-  
-  if (g_logger == nullptr) {
-    // 创建默认日志器
-    g_logger = new DefaultLog();
-    
-    // 使用默认配置初始化
-    absl::Status status = g_logger->init("qxcore_default", LogLevel::kInfo);
-    if (!status.ok()) {
-      // 如果初始化失败，我们无法使用日志系统记录错误
-      // 但至少确保对象存在
-    }
+  DefaultLog* logger = g_logger.load(std::memory_order_acquire);
+  if (logger == nullptr) {
+    logger = CreateDefaultLogger();
   }
-  
-  return *g_logger;
+  return *logger;
 }
 
-absl::Status InitDefaultLogger(const std::string& name, LogLevel level) {
-  std::lock_guard<std::mutex> lock(g_logger_mutex);
-  
-  if (g_logger != nullptr) {
-    // 如果已经存在，先关闭旧的
-    g_logger->shutdown();
-    delete g_logger;
+absl::Status InitDefaultLogger(const std::string& name, LogLevel level,
+                               const LogOptions& options) {
+  std::lock_guard<std::mutex> lock(g_logger_init_mutex);
+  DefaultLog* old_logger = g_logger.load(std::memory_order_acquire);
+
+  // 同名日志器在后端注册表中冲突，需要先关闭旧的；关闭后的日志器
+  // 仍可被在途调用安全访问（丢弃日志），内存在宽限期后才释放
+  if (old_logger != nullptr && g_logger_name == name) {
+    old_logger->shutdown();
+  }
+
+  // 创建新的日志器，初始化完成后再发布
+  auto* logger = new DefaultLog();
+  absl::Status status = logger->init(name, level, options);
+  g_logger_name = name;
+  g_logger.store(logger, std::memory_order_release);
+
+  if (old_logger != nullptr) {
+    RetireLogger(old_logger);
+    internal::EpochDomain::Global().synchronize();
   }
-  
-  // 创建新的日志器
-  g_logger = new DefaultLog();
-  return g_logger->init(name, level);
+  return status;
 }
 
 }  // namespace log
@@ -0,0 +1,50 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/log_context.h"
+
+namespace qxcore {
+namespace log {
+namespace internal {
+
+void PushLogContext(absl::string_view payload) {
+  thread_local StructuredRecord record;
+  LogContextState& state = ThreadLogContext();
+  state.marks.push_back(static_cast<uint32_t>(state.text.size()));
+  if (!ParseStructured(payload, &record)) {
+    return;
+  }
+  fmt::memory_buffer text;
+  for (const StructuredField& field : record.fields) {
+    if (!state.text.empty() || text.size() != 0) {
+      text.push_back(' ');
+    }
+    AppendStructuredField(field, fmt::appender(text));
+  }
+  state.text.append(text.data(), text.size());
+}
+
+void PopLogContext() {
+  LogContextState& state = ThreadLogContext();
+  if (state.marks.empty()) {
+    return;
+  }
+  state.text.resize(state.marks.back());
+  state.marks.pop_back();
+}
+
+}  // namespace internal
+}  // namespace log
+}  // namespace qxcore
@@ -14,7 +14,7 @@
 
 #include "qxcore/log/log_level.h"
 
-#include <absl/strings/ascii.h>
+#include <absl/strings/match.h>
 
 namespace qxcore {
 namespace log {
@@ -39,28 +39,23 @@ absl::string_view LogLevelToString(LogLevel level) {
 }
 
 bool StringToLogLevel(absl::string_view str, LogLevel& level) {
-  std::string lower_str = absl::AsciiStrToLower(str);
-  
-  if (lower_str == "trace") {
-    level = LogLevel::kTrace;
-    return true;
-  } else if (lower_str == "debug") {
-    level = LogLevel::kDebug;
-    return true;
-  } else if (lower_str == "info") {
-    level = LogLevel::kInfo;
-    return true;
-  } else if (lower_str == "warn" || lower_str == "warning") {
-    level = LogLevel::kWarn;
-    return true;
-  } else if (lower_str == "error") {
-    level = LogLevel::kError;
-    return true;
-  } else if (lower_str == "critical" || lower_str == "fatal") {
-    level = LogLevel::kCritical;
-    return true;
+  // 逐个忽略大小写比较，不构造小写副本
+  struct Name {
+    absl::string_view text;
+    LogLevel level;
+  };
+  static constexpr Name kNames[] = {
+      {"trace", LogLevel::kTrace},       {"debug", LogLevel::kDebug},
+      {"info", LogLevel::kInfo},         {"warn", LogLevel::kWarn},
+      {"warning", LogLevel::kWarn},      {"error", LogLevel::kError},
+      {"critical", LogLevel::kCritical}, {"fatal", LogLevel::kCritical},
+  };
+  for (const Name& name : kNames) {
+    if (absl::EqualsIgnoreCase(str, name.text)) {
+      level = name.level;
+      return true;
+    }
   }
-  
   return false;
 }
 
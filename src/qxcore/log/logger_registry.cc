@@ -0,0 +1,179 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/logger_registry.h"
+
+#include <absl/strings/str_cat.h>
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+// 名字非空且不含空段
+bool IsValidLoggerName(absl::string_view name) {
+  if (name.empty() || name.front() == '.' || name.back() == '.') {
+    return false;
+  }
+  return name.find("..") == absl::string_view::npos;
+}
+
+}  // anonymous namespace
+
+LoggerRegistry& LoggerRegistry::Global() {
+  // 故意泄漏，保证静态析构阶段的日志调用仍可安全访问
+  static LoggerRegistry* registry = new LoggerRegistry();
+  return *registry;
+}
+
+LoggerRegistry::LoggerRegistry() {
+  for (auto& chunk : chunks_) {
+    chunk.store(nullptr, std::memory_order_relaxed);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  LoggerId root = append_locked("", kNoLoggerId);
+  node_locked(root).explicit_level = static_cast<int8_t>(LogLevel::kInfo);
+  propagate_locked();
+}
+
+LoggerRegistry::~LoggerRegistry() {
+  for (auto& chunk : chunks_) {
+    delete[] chunk.load(std::memory_order_relaxed);
+  }
+}
+
+absl::Status LoggerRegistry::get(absl::string_view name, LoggerId* id) {
+  if (!IsValidLoggerName(name)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("Invalid logger name '", name, "'"));
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  return get_locked(name, id);
+}
+
+absl::Status LoggerRegistry::set_level(absl::string_view name,
+                                       LogLevel level) {
+  LoggerId id = kRootLoggerId;
+  if (!name.empty()) {
+    absl::Status status = get(name, &id);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  node_locked(id).explicit_level = static_cast<int8_t>(level);
+  propagate_locked();
+  return absl::OkStatus();
+}
+
+absl::Status LoggerRegistry::reset_level(absl::string_view name) {
+  LoggerId id = kRootLoggerId;
+  if (!name.empty()) {
+    absl::Status status = get(name, &id);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  node_locked(id).explicit_level =
+      id == kRootLoggerId ? static_cast<int8_t>(LogLevel::kInfo)
+                          : kInheritLevel;
+  propagate_locked();
+  return absl::OkStatus();
+}
+
+bool LoggerRegistry::explicit_level(absl::string_view name,
+                                    LogLevel* level) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = ids_.find(name);
+  if (it == ids_.end()) {
+    return false;
+  }
+  int8_t value = find(it->second)->explicit_level;
+  if (value == kInheritLevel) {
+    return false;
+  }
+  *level = static_cast<LogLevel>(value);
+  return true;
+}
+
+LogLevel LoggerRegistry::get_level(LoggerId id) const {
+  const Node* node = find(id);
+  if (node == nullptr) {
+    return LogLevel::kCritical;
+  }
+  return static_cast<LogLevel>(node->level.load(std::memory_order_relaxed));
+}
+
+absl::Status LoggerRegistry::get_locked(absl::string_view name,
+                                        LoggerId* id) {
+  auto it = ids_.find(name);
+  if (it != ids_.end()) {
+    *id = it->second;
+    return absl::OkStatus();
+  }
+
+  // 先确保父节点存在，保证父节点 ID 总是小于子节点
+  LoggerId parent = kRootLoggerId;
+  size_t dot = name.rfind('.');
+  if (dot != absl::string_view::npos) {
+    absl::Status status = get_locked(name.substr(0, dot), &parent);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  if (size_.load(std::memory_order_relaxed) >= kMaxLoggers) {
+    return absl::ResourceExhaustedError("Too many named loggers");
+  }
+  *id = append_locked(name, parent);
+  Node& node = node_locked(*id);
+  node.level.store(node_locked(parent).level.load(std::memory_order_relaxed),
+                   std::memory_order_relaxed);
+  return absl::OkStatus();
+}
+
+LoggerId LoggerRegistry::append_locked(absl::string_view name,
+                                       LoggerId parent) {
+  LoggerId id = static_cast<LoggerId>(size_.load(std::memory_order_relaxed));
+  std::atomic<Node*>& chunk = chunks_[id / kChunkSize];
+  if (chunk.load(std::memory_order_relaxed) == nullptr) {
+    chunk.store(new Node[kChunkSize], std::memory_order_release);
+  }
+  names_.emplace_back(name);
+  // deque 尾部追加不会移动已有元素，键可以直接引用存储的字符串
+  ids_.emplace(absl::string_view(names_.back()), id);
+
+  Node& node = node_locked(id);
+  node.parent = parent;
+  node.name = &names_.back();
+  // 节点内容写完后再发布，读者以 acquire 读取 size_
+  size_.store(id + 1, std::memory_order_release);
+  return id;
+}
+
+void LoggerRegistry::propagate_locked() {
+  size_t size = size_.load(std::memory_order_relaxed);
+  for (LoggerId id = 0; id < size; ++id) {
+    Node& node = node_locked(id);
+    int8_t level = node.explicit_level;
+    if (level == kInheritLevel) {
+      level = node_locked(node.parent).level.load(std::memory_order_relaxed);
+    }
+    node.level.store(level, std::memory_order_relaxed);
+  }
+}
+
+}  // namespace log
+}  // namespace qxcore
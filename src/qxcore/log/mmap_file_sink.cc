@@ -0,0 +1,437 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/mmap_file_sink.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#include <vector>
+#include <absl/strings/ascii.h>
+#include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_format.h>
+#include <spdlog/pattern_formatter.h>
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr size_t kMinSegmentSize = 64 * 1024;
+constexpr char kLogSuffix[] = ".log";
+constexpr int kSpinsBeforeWake = 64;
+
+std::atomic<uint64_t> g_next_sink_id{1};
+
+// 每个线程为每个 sink 持有的格式化器副本与缓冲区：spdlog 格式化器带有
+// 时间缓存，不能被多个生产者并发使用
+struct ThreadFormatter {
+  uint64_t sink_id = 0;
+  uint64_t generation = 0;
+  std::unique_ptr<spdlog::formatter> formatter;
+  spdlog::memory_buf_t buffer;
+};
+
+constexpr size_t kThreadFormatters = 4;
+
+// 截掉上次运行崩溃时遗留在分段末尾的零字节，返回截断后的长度；无法打开
+// 时返回 -1
+off_t TrimTrailingZeros(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+  if (fd < 0) {
+    return -1;
+  }
+  off_t result = -1;
+  struct stat st;
+  if (::fstat(fd, &st) == 0) {
+    off_t end = st.st_size;
+    char chunk[64 * 1024];
+    bool found = false;
+    while (end > 0 && !found) {
+      off_t begin = end > static_cast<off_t>(sizeof(chunk))
+                        ? end - static_cast<off_t>(sizeof(chunk))
+                        : 0;
+      ssize_t n = ::pread(fd, chunk, static_cast<size_t>(end - begin), begin);
+      if (n <= 0) {
+        break;
+      }
+      for (ssize_t i = n; i > 0; --i) {
+        if (chunk[i - 1] != '\0') {
+          end = begin + i;
+          found = true;
+          break;
+        }
+      }
+      if (!found) {
+        end = begin;
+      }
+    }
+    if (end != st.st_size) {
+      (void)::ftruncate(fd, end);
+    }
+    result = end;
+  }
+  ::close(fd);
+  return result;
+}
+
+}  // anonymous namespace
+
+MmapFileSink::MmapFileSink(size_t segment_size,
+                           std::chrono::milliseconds sync_interval)
+    : segment_size_(segment_size),
+      sync_interval_(sync_interval),
+      id_(g_next_sink_id.fetch_add(1, std::memory_order_relaxed)),
+      formatter_(std::make_unique<spdlog::pattern_formatter>()) {}
+
+MmapFileSink::~MmapFileSink() {
+  if (thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    cv_.notify_all();
+    thread_.join();
+  }
+}
+
+absl::Status MmapFileSink::ValidateSegmentSize(size_t segment_size) {
+  if (segment_size < kMinSegmentSize) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Mmap segment size must be at least %d bytes", kMinSegmentSize));
+  }
+  return absl::OkStatus();
+}
+
+absl::Status MmapFileSink::open(const std::string& path) {
+  absl::Status status = ValidateSegmentSize(segment_size_);
+  if (!status.ok()) {
+    return status;
+  }
+  if (thread_.joinable()) {
+    return absl::AlreadyExistsError("Mmap file sink already open");
+  }
+  stem_ = absl::EndsWith(path, kLogSuffix)
+              ? path.substr(0, path.size() - (sizeof(kLogSuffix) - 1))
+              : path;
+
+  // 序号接着已有分段递增，重启不会覆盖上次的输出
+  fs::path stem(stem_);
+  fs::path dir = stem.has_parent_path() ? stem.parent_path() : fs::path(".");
+  std::string prefix = stem.filename().string() + ".";
+  std::vector<uint64_t> sequences;
+  std::error_code ec;
+  for (fs::directory_iterator it(dir, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    std::string name = it->path().filename().string();
+    if (!absl::StartsWith(name, prefix) || !absl::EndsWith(name, kLogSuffix)) {
+      continue;
+    }
+    absl::string_view digits(name);
+    digits.remove_prefix(prefix.size());
+    digits.remove_suffix(sizeof(kLogSuffix) - 1);
+    uint64_t sequence = 0;
+    if (!digits.empty() && absl::ascii_isdigit(digits.front()) &&
+        absl::SimpleAtoi(digits, &sequence)) {
+      sequences.push_back(sequence);
+    }
+  }
+
+  // 崩溃时后台线程已提前映射了 kLookahead 个全零的预备分段，尚未回收的已写满
+  // 分段和当前分段也都保留全长。逐个截掉零字节尾部，删除截断后为空的分段
+  uint64_t last = 0;
+  for (uint64_t sequence : sequences) {
+    std::string segment = SegmentName(stem_, sequence);
+    if (TrimTrailingZeros(segment) == 0) {
+      ::unlink(segment.c_str());
+    } else {
+      last = std::max(last, sequence);
+    }
+  }
+  first_sequence_ = last + 1;
+
+  if (!map_segment(0)) {
+    return absl::InternalError(
+        absl::StrFormat("Failed to map log segment %s: %s",
+                        SegmentName(stem_, first_sequence_),
+                        std::strerror(errno)));
+  }
+  thread_ = std::thread(&MmapFileSink::run, this);
+  return absl::OkStatus();
+}
+
+void MmapFileSink::log(const spdlog::details::log_msg& msg) {
+  if (!thread_.joinable()) {
+    return;
+  }
+  spdlog::memory_buf_t* buffer = nullptr;
+  spdlog::formatter& formatter = thread_formatter(&buffer);
+  buffer->clear();
+  formatter.format(msg, *buffer);
+
+  uint64_t size = buffer->size();
+  if (size == 0) {
+    return;
+  }
+  if (size > segment_size_ ||
+      head_.load(std::memory_order_relaxed) / segment_size_ >=
+          failed_segment_.load(std::memory_order_acquire)) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  // 预留 [pos, pos + size)；放不下时由抢到的生产者关闭当前分段，
+  // 记录从下一个分段的起点开始
+  uint64_t pos = head_.load(std::memory_order_relaxed);
+  for (;;) {
+    uint64_t segment = pos / segment_size_;
+    uint64_t end = (segment + 1) * segment_size_;
+    if (pos + size <= end) {
+      if (head_.compare_exchange_weak(pos, pos + size,
+                                      std::memory_order_acq_rel)) {
+        if (pos + size == end) {
+          close_segment(segment, segment_size_);
+        }
+        break;
+      }
+    } else if (head_.compare_exchange_weak(pos, end + size,
+                                           std::memory_order_acq_rel)) {
+      close_segment(segment, pos - segment * segment_size_);
+      pos = end;
+      break;
+    }
+  }
+
+  uint64_t segment = pos / segment_size_;
+  char* base = wait_for_segment(segment);
+  if (base == nullptr) {
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  std::memcpy(base + (pos - segment * segment_size_), buffer->data(), size);
+  slots_[segment % kSlots].committed.fetch_add(size,
+                                               std::memory_order_release);
+}
+
+void MmapFileSink::flush() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wake_ = true;
+  }
+  cv_.notify_one();
+}
+
+void MmapFileSink::set_pattern(const std::string& pattern) {
+  set_formatter(std::make_unique<spdlog::pattern_formatter>(pattern));
+}
+
+void MmapFileSink::set_formatter(std::unique_ptr<spdlog::formatter> formatter) {
+  std::lock_guard<std::mutex> lock(formatter_mutex_);
+  formatter_ = std::move(formatter);
+  formatter_generation_.fetch_add(1, std::memory_order_release);
+}
+
+std::string MmapFileSink::filename() const {
+  return SegmentName(stem_, first_sequence_ +
+                                head_.load(std::memory_order_acquire) /
+                                    segment_size_);
+}
+
+std::string MmapFileSink::SegmentName(const std::string& stem,
+                                      uint64_t sequence) {
+  return absl::StrFormat("%s.%06d%s", stem, sequence, kLogSuffix);
+}
+
+char* MmapFileSink::wait_for_segment(uint64_t segment) {
+  Slot& slot = slots_[segment % kSlots];
+  // 后台线程提前映射后续分段，稳态下这里不会等待
+  for (int spins = 0; slot.ready.load(std::memory_order_acquire) != segment + 1;
+       ++spins) {
+    if (segment >= failed_segment_.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    if (spins == kSpinsBeforeWake) {
+      flush();
+    }
+    std::this_thread::yield();
+  }
+  return slot.base;
+}
+
+void MmapFileSink::close_segment(uint64_t segment, uint64_t used) {
+  // 槽位可能还被更早的分段占用，等到本分段映射后再写入有效长度
+  if (wait_for_segment(segment) == nullptr) {
+    return;
+  }
+  slots_[segment % kSlots].used.store(used, std::memory_order_release);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wake_ = true;
+  }
+  cv_.notify_one();
+}
+
+spdlog::formatter& MmapFileSink::thread_formatter(
+    spdlog::memory_buf_t** buffer) {
+  thread_local ThreadFormatter cache[kThreadFormatters];
+  thread_local size_t victim = 0;
+
+  uint64_t generation = formatter_generation_.load(std::memory_order_acquire);
+  ThreadFormatter* entry = nullptr;
+  for (ThreadFormatter& candidate : cache) {
+    if (candidate.sink_id == id_) {
+      entry = &candidate;
+      break;
+    }
+  }
+  if (entry == nullptr) {
+    entry = &cache[victim++ % kThreadFormatters];
+    entry->sink_id = id_;
+    entry->formatter.reset();
+  }
+  if (entry->formatter == nullptr || entry->generation != generation) {
+    std::lock_guard<std::mutex> lock(formatter_mutex_);
+    entry->formatter = formatter_->clone();
+    entry->generation = formatter_generation_.load(std::memory_order_relaxed);
+  }
+  *buffer = &entry->buffer;
+  return *entry->formatter;
+}
+
+void MmapFileSink::run() {
+  uint64_t next_retire = 0;
+  uint64_t next_map = 1;
+  bool stop = false;
+  while (!stop) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait_for(lock, sync_interval_, [this] { return wake_ || stopping_; });
+      wake_ = false;
+      stop = stopping_;
+    }
+    while (next_retire < next_map && retire_segment(next_retire, false)) {
+      ++next_retire;
+    }
+    uint64_t current = head_.load(std::memory_order_acquire) / segment_size_;
+    while (next_map <= current + kLookahead && next_map < next_retire + kSlots &&
+           failed_segment_.load(std::memory_order_relaxed) == kNoFailedSegment) {
+      if (!map_segment(next_map)) {
+        // 分段必须按序映射，之后的分段也无法使用；通知等待中的生产者放弃
+        failed_segment_.store(next_map, std::memory_order_release);
+        break;
+      }
+      ++next_map;
+    }
+    sync_active();
+  }
+
+  // 生产者已全部退出：收尾当前分段，删除未使用的预备分段
+  for (uint64_t segment = next_retire; segment < next_map; ++segment) {
+    retire_segment(segment, true);
+  }
+}
+
+bool MmapFileSink::map_segment(uint64_t segment) {
+  std::string path = SegmentName(stem_, first_sequence_ + segment);
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  // 预先分配磁盘块，避免映射区写入时因空间不足触发 SIGBUS
+  int result = -1;
+#if defined(__linux__)
+  result = ::fallocate(fd, 0, 0, static_cast<off_t>(segment_size_));
+  if (result != 0 && errno == EOPNOTSUPP) {
+    result = ::ftruncate(fd, static_cast<off_t>(segment_size_));
+  }
+#else
+  result = ::posix_fallocate(fd, 0, static_cast<off_t>(segment_size_));
+#endif
+  int flags = MAP_SHARED;
+#if defined(MAP_POPULATE)
+  // 预先建立页表，生产者拷贝时不触发缺页
+  flags |= MAP_POPULATE;
+#endif
+  void* base = result == 0 ? ::mmap(nullptr, segment_size_,
+                                    PROT_READ | PROT_WRITE, flags, fd, 0)
+                           : MAP_FAILED;
+  if (base == MAP_FAILED) {
+    int saved = errno;
+    ::close(fd);
+    ::unlink(path.c_str());
+    errno = saved;
+    return false;
+  }
+
+  Slot& slot = slots_[segment % kSlots];
+  slot.base = static_cast<char*>(base);
+  slot.fd = fd;
+  slot.committed.store(0, std::memory_order_relaxed);
+  slot.used.store(kOpenSegment, std::memory_order_relaxed);
+  slot.ready.store(segment + 1, std::memory_order_release);
+  return true;
+}
+
+bool MmapFileSink::retire_segment(uint64_t segment, bool final) {
+  Slot& slot = slots_[segment % kSlots];
+  if (slot.ready.load(std::memory_order_acquire) != segment + 1) {
+    return false;
+  }
+  uint64_t used = slot.used.load(std::memory_order_acquire);
+  if (final && used == kOpenSegment) {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    used = head > segment * segment_size_
+               ? std::min(head - segment * segment_size_, segment_size_)
+               : 0;
+  }
+  if (used == kOpenSegment ||
+      slot.committed.load(std::memory_order_acquire) < used) {
+    return false;
+  }
+
+  ::munmap(slot.base, segment_size_);
+  (void)::ftruncate(slot.fd, static_cast<off_t>(used));
+  ::close(slot.fd);
+  if (used == 0) {
+    ::unlink(SegmentName(stem_, first_sequence_ + segment).c_str());
+  } else {
+    completed_.fetch_add(1, std::memory_order_release);
+  }
+  slot.base = nullptr;
+  slot.fd = -1;
+  slot.ready.store(0, std::memory_order_release);
+  return true;
+}
+
+void MmapFileSink::sync_active() {
+  uint64_t head = head_.load(std::memory_order_acquire);
+  uint64_t segment = head / segment_size_;
+  Slot& slot = slots_[segment % kSlots];
+  if (slot.ready.load(std::memory_order_acquire) == segment + 1) {
+    // 只发起写回，不等待完成
+    ::msync(slot.base, segment_size_, MS_ASYNC);
+  }
+}
+
+}  // namespace log
+}  // namespace qxcore
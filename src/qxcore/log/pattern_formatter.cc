@@ -0,0 +1,375 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/pattern_formatter.h"
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <utility>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_format.h>
+#include <spdlog/details/log_msg.h>
+#include <spdlog/details/os.h>
+#include <spdlog/pattern_formatter.h>
+#include "qxcore/log/fmt.h"
+#include "qxcore/log/log_context.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+// 0..999 的三位十进制文本
+struct DigitTable {
+  char digits[1000][3];
+};
+
+constexpr DigitTable MakeDigitTable() {
+  DigitTable table{};
+  for (int i = 0; i < 1000; ++i) {
+    table.digits[i][0] = static_cast<char>('0' + i / 100);
+    table.digits[i][1] = static_cast<char>('0' + i / 10 % 10);
+    table.digits[i][2] = static_cast<char>('0' + i % 10);
+  }
+  return table;
+}
+
+constexpr DigitTable kDigits = MakeDigitTable();
+
+inline void AppendDigits3(uint32_t value, spdlog::memory_buf_t& dest) {
+  const char* digits = kDigits.digits[value];
+  dest.append(digits, digits + 3);
+}
+
+inline void AppendView(absl::string_view text, spdlog::memory_buf_t& dest) {
+  dest.append(text.data(), text.data() + text.size());
+}
+
+inline void AppendCString(const char* text, spdlog::memory_buf_t& dest) {
+  dest.append(text, text + std::strlen(text));
+}
+
+inline void AppendInt(uint64_t value, spdlog::memory_buf_t& dest) {
+  fmt::format_int text(value);
+  dest.append(text.data(), text.data() + text.size());
+}
+
+// 写入两位数字
+inline void PutDigits2(int value, char* dst) {
+  const char* digits = kDigits.digits[value % 100];
+  dst[0] = digits[1];
+  dst[1] = digits[2];
+}
+
+const char* ShortFilename(const char* filename) {
+  const char* base = filename;
+  for (const char* p = filename; *p != '\0'; ++p) {
+    if (std::strchr(spdlog::details::os::folder_seps, *p) != nullptr) {
+      base = p + 1;
+    }
+  }
+  return base;
+}
+
+}  // anonymous namespace
+
+PatternFormatter::PatternFormatter(std::string pattern)
+    : pattern_(std::move(pattern)) {
+  for (int i = 0; i < spdlog::level::n_levels; ++i) {
+    spdlog::string_view_t name =
+        spdlog::level::to_string_view(static_cast<spdlog::level::level_enum>(i));
+    level_names_[i] = absl::string_view(name.data(), name.size());
+  }
+}
+
+absl::Status PatternFormatter::Compile(
+    absl::string_view pattern, std::unique_ptr<PatternFormatter>* formatter) {
+  std::unique_ptr<PatternFormatter> result(
+      new PatternFormatter(std::string(pattern)));
+  size_t literal_begin = 0;
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    if (pattern[i] != '%') {
+      continue;
+    }
+    result->append_text(pattern.substr(literal_begin, i - literal_begin));
+    if (i + 1 == pattern.size()) {
+      return absl::InvalidArgumentError("Pattern ends with a dangling '%'");
+    }
+    char flag = pattern[++i];
+    literal_begin = i + 1;
+    switch (flag) {
+      case 'Y': result->append_time(TimeField::kYear); break;
+      case 'y': result->append_time(TimeField::kShortYear); break;
+      case 'm': result->append_time(TimeField::kMonth); break;
+      case 'd': result->append_time(TimeField::kDay); break;
+      case 'H': result->append_time(TimeField::kHour); break;
+      case 'M': result->append_time(TimeField::kMinute); break;
+      case 'S': result->append_time(TimeField::kSecond); break;
+      case 'T':
+        result->append_time(TimeField::kHour);
+        result->append_text(":");
+        result->append_time(TimeField::kMinute);
+        result->append_text(":");
+        result->append_time(TimeField::kSecond);
+        break;
+      case 'D':
+        result->append_time(TimeField::kMonth);
+        result->append_text("/");
+        result->append_time(TimeField::kDay);
+        result->append_text("/");
+        result->append_time(TimeField::kShortYear);
+        break;
+      case 'e': result->append_op(OpType::kMillis); break;
+      case 'f': result->append_op(OpType::kMicros); break;
+      case 'F': result->append_op(OpType::kNanos); break;
+      case 'n': result->append_op(OpType::kName); break;
+      case 'l': result->append_op(OpType::kLevel); break;
+      case 'L': result->append_op(OpType::kShortLevel); break;
+      case 't': result->append_op(OpType::kThreadId); break;
+      case 'v': result->append_op(OpType::kPayload); break;
+      case '^': result->append_op(OpType::kColorStart); break;
+      case '$': result->append_op(OpType::kColorEnd); break;
+      case 'g': result->append_op(OpType::kSourceFile); break;
+      case 's': result->append_op(OpType::kShortFile); break;
+      case '#': result->append_op(OpType::kSourceLine); break;
+      case '!': result->append_op(OpType::kSourceFunc); break;
+      case '@': result->append_op(OpType::kSourceLocation); break;
+      case '&': result->append_op(OpType::kContext); break;
+      case 'P':
+        // 进程号在编译时渲染
+        result->append_text(absl::StrCat(spdlog::details::os::pid()));
+        break;
+      case '%': result->append_text("%"); break;
+      default:
+        return absl::InvalidArgumentError(
+            absl::StrFormat("Unsupported pattern flag '%%%c'", flag));
+    }
+  }
+  result->append_text(pattern.substr(literal_begin));
+  result->append_text(spdlog::details::os::default_eol);
+  *formatter = std::move(result);
+  return absl::OkStatus();
+}
+
+void PatternFormatter::append_text(absl::string_view text) {
+  if (text.empty()) {
+    return;
+  }
+  if (ops_.empty() || ops_.back().type != OpType::kText) {
+    Op op;
+    op.type = OpType::kText;
+    op.offset = static_cast<uint32_t>(text_.size());
+    ops_.push_back(op);
+  }
+  text_.append(text.data(), text.size());
+  ops_.back().size += static_cast<uint32_t>(text.size());
+}
+
+void PatternFormatter::append_time(TimeField field) {
+  time_slots_.push_back(
+      TimeSlot{field, static_cast<uint32_t>(text_.size())});
+  // 占位，首条记录时填写
+  append_text(field == TimeField::kYear ? "0000" : "00");
+}
+
+void PatternFormatter::append_op(OpType type) {
+  Op op;
+  op.type = type;
+  ops_.push_back(op);
+}
+
+void PatternFormatter::update_time(int64_t seconds) {
+  std::tm local = spdlog::details::os::localtime(static_cast<std::time_t>(seconds));
+  for (const TimeSlot& slot : time_slots_) {
+    char* dst = &text_[slot.offset];
+    switch (slot.field) {
+      case TimeField::kYear: {
+        int year = local.tm_year + 1900;
+        PutDigits2(year / 100, dst);
+        PutDigits2(year % 100, dst + 2);
+        break;
+      }
+      case TimeField::kShortYear:
+        PutDigits2(local.tm_year % 100, dst);
+        break;
+      case TimeField::kMonth:
+        PutDigits2(local.tm_mon + 1, dst);
+        break;
+      case TimeField::kDay:
+        PutDigits2(local.tm_mday, dst);
+        break;
+      case TimeField::kHour:
+        PutDigits2(local.tm_hour, dst);
+        break;
+      case TimeField::kMinute:
+        PutDigits2(local.tm_min, dst);
+        break;
+      case TimeField::kSecond:
+        PutDigits2(local.tm_sec, dst);
+        break;
+    }
+  }
+  cached_seconds_ = seconds;
+}
+
+void PatternFormatter::format(const spdlog::details::log_msg& msg,
+                              spdlog::memory_buf_t& dest) {
+  int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      msg.time.time_since_epoch())
+                      .count();
+  int64_t seconds = nanos / 1000000000;
+  int64_t fraction = nanos % 1000000000;
+  if (fraction < 0) {
+    fraction += 1000000000;
+    --seconds;
+  }
+  if (seconds != cached_seconds_ && !time_slots_.empty()) {
+    update_time(seconds);
+  }
+
+  uint32_t fraction_ns = static_cast<uint32_t>(fraction);
+  for (const Op& op : ops_) {
+    switch (op.type) {
+      case OpType::kText:
+        dest.append(text_.data() + op.offset,
+                    text_.data() + op.offset + op.size);
+        break;
+      case OpType::kMillis:
+        AppendDigits3(fraction_ns / 1000000, dest);
+        break;
+      case OpType::kMicros:
+        AppendDigits3(fraction_ns / 1000000, dest);
+        AppendDigits3(fraction_ns / 1000 % 1000, dest);
+        break;
+      case OpType::kNanos:
+        AppendDigits3(fraction_ns / 1000000, dest);
+        AppendDigits3(fraction_ns / 1000 % 1000, dest);
+        AppendDigits3(fraction_ns % 1000, dest);
+        break;
+      case OpType::kName:
+        dest.append(msg.logger_name.data(),
+                    msg.logger_name.data() + msg.logger_name.size());
+        break;
+      case OpType::kLevel:
+        AppendView(level_names_[msg.level], dest);
+        break;
+      case OpType::kShortLevel:
+        AppendCString(spdlog::level::to_short_c_str(msg.level), dest);
+        break;
+      case OpType::kThreadId:
+        AppendInt(msg.thread_id, dest);
+        break;
+      case OpType::kPayload:
+        if (ParseStructured(absl::string_view(msg.payload.data(),
+                                              msg.payload.size()),
+                            &record_)) {
+          AppendStructuredText(record_, fmt::appender(dest));
+        } else {
+          dest.append(msg.payload.data(),
+                      msg.payload.data() + msg.payload.size());
+        }
+        break;
+      case OpType::kColorStart:
+        msg.color_range_start = dest.size();
+        break;
+      case OpType::kColorEnd:
+        msg.color_range_end = dest.size();
+        break;
+      case OpType::kSourceFile:
+        if (!msg.source.empty()) {
+          AppendCString(msg.source.filename, dest);
+        }
+        break;
+      case OpType::kShortFile:
+        if (!msg.source.empty()) {
+          AppendCString(ShortFilename(msg.source.filename), dest);
+        }
+        break;
+      case OpType::kSourceLine:
+        if (!msg.source.empty()) {
+          AppendInt(static_cast<uint64_t>(msg.source.line), dest);
+        }
+        break;
+      case OpType::kSourceFunc:
+        if (!msg.source.empty()) {
+          AppendCString(msg.source.funcname, dest);
+        }
+        break;
+      case OpType::kSourceLocation:
+        if (!msg.source.empty()) {
+          AppendCString(msg.source.filename, dest);
+          dest.push_back(':');
+          AppendInt(static_cast<uint64_t>(msg.source.line), dest);
+        }
+        break;
+      case OpType::kContext:
+        AppendView(internal::RecordLogContext(), dest);
+        break;
+    }
+  }
+}
+
+std::unique_ptr<spdlog::formatter> PatternFormatter::clone() const {
+  return std::unique_ptr<PatternFormatter>(new PatternFormatter(*this));
+}
+
+namespace {
+
+// spdlog 原生格式化器的包装：结构化负载先渲染为文本再交给 %v
+class StructuredTextFormatter final : public spdlog::formatter {
+ public:
+  explicit StructuredTextFormatter(std::unique_ptr<spdlog::formatter> inner)
+      : inner_(std::move(inner)) {}
+
+  void format(const spdlog::details::log_msg& msg,
+              spdlog::memory_buf_t& dest) override {
+    if (!ParseStructured(absl::string_view(msg.payload.data(),
+                                           msg.payload.size()),
+                         &record_)) {
+      inner_->format(msg, dest);
+      return;
+    }
+    text_.clear();
+    AppendStructuredText(record_, fmt::appender(text_));
+    spdlog::details::log_msg text_msg = msg;
+    text_msg.payload = spdlog::string_view_t(text_.data(), text_.size());
+    inner_->format(text_msg, dest);
+    msg.color_range_start = text_msg.color_range_start;
+    msg.color_range_end = text_msg.color_range_end;
+  }
+
+  std::unique_ptr<spdlog::formatter> clone() const override {
+    return std::make_unique<StructuredTextFormatter>(inner_->clone());
+  }
+
+ private:
+  std::unique_ptr<spdlog::formatter> inner_;
+  StructuredRecord record_;
+  fmt::memory_buffer text_;
+};
+
+}  // anonymous namespace
+
+std::unique_ptr<spdlog::formatter> MakeLogFormatter(const std::string& pattern) {
+  std::unique_ptr<PatternFormatter> formatter;
+  if (PatternFormatter::Compile(pattern, &formatter).ok()) {
+    return formatter;
+  }
+  return std::make_unique<StructuredTextFormatter>(
+      std::make_unique<spdlog::pattern_formatter>(pattern));
+}
+
+}  // namespace log
+}  // namespace qxcore
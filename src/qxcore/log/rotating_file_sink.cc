@@ -0,0 +1,392 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/rotating_file_sink.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <system_error>
+#include <utility>
+#include <absl/strings/ascii.h>
+#include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_format.h>
+#include <absl/strings/str_split.h>
+#include <absl/time/civil_time.h>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr int kSecondsPerDay = 86400;
+constexpr char kSpareSuffix[] = ".next";
+constexpr char kLogSuffix[] = ".log";
+
+// 把 "HH:MM" 解析为当天零点起的分钟数
+bool ParseBoundary(absl::string_view text, int* minutes) {
+  std::vector<absl::string_view> parts = absl::StrSplit(text, ':');
+  int hour = 0;
+  int minute = 0;
+  if (parts.size() != 2 || parts[0].empty() || parts[1].size() != 2 ||
+      !absl::SimpleAtoi(parts[0], &hour) ||
+      !absl::SimpleAtoi(parts[1], &minute) || hour < 0 || hour > 23 ||
+      minute < 0 || minute > 59) {
+    return false;
+  }
+  *minutes = hour * 60 + minute;
+  return true;
+}
+
+// 为新文件预分配磁盘块；保持文件长度不变，追加写不会越过空洞
+void Preallocate(std::FILE* file, size_t size) {
+#if defined(__linux__)
+  if (size != 0) {
+    // 文件系统不支持时放弃预分配，不影响写入
+    (void)::fallocate(::fileno(file), FALLOC_FL_KEEP_SIZE, 0,
+                      static_cast<off_t>(size));
+  }
+#else
+  (void)file;
+  (void)size;
+#endif
+}
+
+// 关闭文件并释放未用完的预分配空间
+void CloseFile(std::FILE* file) {
+  std::fflush(file);
+#if defined(__linux__)
+  long size = std::ftell(file);
+  if (size >= 0) {
+    (void)::ftruncate(::fileno(file), static_cast<off_t>(size));
+  }
+#endif
+  std::fclose(file);
+}
+
+// 不与已有文件重名的归档路径，同一秒内多次轮转时追加序号
+std::string UniqueArchivePath(const std::string& stem, absl::Time time,
+                              absl::TimeZone zone) {
+  std::string target = RotatingFileSink::ArchiveName(stem, time, zone);
+  std::string base = target.substr(0, target.size() - (sizeof(kLogSuffix) - 1));
+  std::error_code ec;
+  for (int sequence = 1; fs::exists(target, ec); ++sequence) {
+    target = absl::StrCat(base, "-", sequence, kLogSuffix);
+  }
+  return target;
+}
+
+}  // anonymous namespace
+
+RotatingFileSink::RotatingFileSink(const RotationOptions& options,
+                                   size_t buffer_size)
+    : options_(options), zone_(absl::LocalTimeZone()) {
+  buffer_.reserve(buffer_size);
+  // 时区无效时保持本地时区，ValidateOptions 会先拒绝这类配置
+  absl::LoadTimeZone(options_.time_zone, &zone_);
+}
+
+RotatingFileSink::~RotatingFileSink() {
+  if (thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(jobs_mutex_);
+      stopping_ = true;
+    }
+    jobs_cv_.notify_all();
+    thread_.join();
+  }
+  std::FILE* spare = spare_.exchange(nullptr, std::memory_order_acq_rel);
+  if (spare != nullptr) {
+    std::fclose(spare);
+    std::error_code ec;
+    fs::remove(path_ + kSpareSuffix, ec);
+  }
+  if (file_ != nullptr) {
+    CloseFile(file_);
+  }
+}
+
+absl::Status RotatingFileSink::ValidateOptions(const RotationOptions& options) {
+  absl::TimeZone zone;
+  if (!absl::LoadTimeZone(options.time_zone, &zone)) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Unknown time zone: %s", options.time_zone));
+  }
+  if (options.interval_seconds < 0 ||
+      (options.interval_seconds > 0 &&
+       kSecondsPerDay % options.interval_seconds != 0)) {
+    return absl::InvalidArgumentError(
+        "Rotation interval must evenly divide one day");
+  }
+  for (const std::string& boundary : options.session_boundaries) {
+    int minutes = 0;
+    if (!ParseBoundary(boundary, &minutes)) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("Invalid session boundary: %s", boundary));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::Status RotatingFileSink::open(const std::string& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file_ != nullptr) {
+    return absl::AlreadyExistsError("Rotating file sink already open");
+  }
+  path_ = path;
+  stem_ = absl::EndsWith(path, kLogSuffix)
+              ? path.substr(0, path.size() - (sizeof(kLogSuffix) - 1))
+              : path;
+
+  // 上次运行残留的备用文件没有内容，直接删除
+  std::error_code ec;
+  fs::remove(path_ + kSpareSuffix, ec);
+
+  // 上次运行的文件按最后修改时间归档，而不是截断
+  if (fs::file_size(path_, ec) > 0 && !ec) {
+    auto modified = fs::last_write_time(path_, ec);
+    absl::Time closed = absl::Now();
+    if (!ec) {
+      // file_time_type 与 system_clock 的纪元不同，按两者的当前时刻换算
+      closed -= absl::FromChrono(fs::file_time_type::clock::now() - modified);
+    }
+    fs::rename(path_, UniqueArchivePath(stem_, closed, zone_), ec);
+    if (ec) {
+      return absl::InternalError(absl::StrFormat(
+          "Failed to archive log file %s: %s", path_, ec.message()));
+    }
+  }
+
+  file_ = std::fopen(path_.c_str(), "ab");
+  if (file_ == nullptr) {
+    return absl::InternalError(
+        absl::StrFormat("Failed to open log file %s", path_));
+  }
+  Preallocate(file_, options_.preallocate_size != 0 ? options_.preallocate_size
+                                                     : options_.max_file_size);
+  file_size_ = 0;
+  next_rotation_ = NextRotation(absl::Now(), options_, zone_);
+
+  spare_requested_ = true;
+  thread_ = std::thread(&RotatingFileSink::run, this);
+  return absl::OkStatus();
+}
+
+std::string RotatingFileSink::filename() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return path_;
+}
+
+void RotatingFileSink::wait_idle() {
+  std::unique_lock<std::mutex> lock(jobs_mutex_);
+  idle_cv_.wait(lock, [this] {
+    return stopping_ || (retired_.empty() && !busy_ &&
+                         (!spare_requested_ || spare_failed_));
+  });
+}
+
+std::string RotatingFileSink::ArchiveName(const std::string& stem,
+                                          absl::Time time,
+                                          absl::TimeZone zone) {
+  return absl::StrCat(stem, ".", absl::FormatTime("%Y%m%d-%H%M%S", time, zone),
+                      kLogSuffix);
+}
+
+absl::Time RotatingFileSink::NextRotation(absl::Time now,
+                                          const RotationOptions& options,
+                                          absl::TimeZone zone) {
+  absl::Time next = absl::InfiniteFuture();
+  absl::CivilSecond local = absl::ToCivilSecond(now, zone);
+  absl::CivilDay today(local);
+
+  if (options.interval_seconds > 0) {
+    int64_t elapsed = local - absl::CivilSecond(today);
+    int64_t periods = elapsed / options.interval_seconds + 1;
+    absl::Time candidate = absl::FromCivil(
+        absl::CivilSecond(today) + periods * options.interval_seconds, zone);
+    if (candidate > now) {
+      next = std::min(next, candidate);
+    }
+  }
+
+  for (const std::string& boundary : options.session_boundaries) {
+    int minutes = 0;
+    if (!ParseBoundary(boundary, &minutes)) {
+      continue;
+    }
+    for (absl::CivilDay day : {today, today + 1}) {
+      absl::Time candidate =
+          absl::FromCivil(absl::CivilMinute(day) + minutes, zone);
+      if (candidate > now) {
+        next = std::min(next, candidate);
+        break;
+      }
+    }
+  }
+  return next;
+}
+
+void RotatingFileSink::sink_it_(const spdlog::details::log_msg& msg) {
+  buffer_.clear();
+  formatter_->format(msg, buffer_);
+
+  absl::Time now = absl::FromChrono(msg.time);
+  bool size_due = options_.max_file_size != 0 && file_size_ != 0 &&
+                  file_size_ + buffer_.size() > options_.max_file_size;
+  if (!size_due && now >= next_rotation_ && file_size_ == 0) {
+    // 上个周期没有写入，不产生空的归档文件
+    next_rotation_ = NextRotation(now, options_, zone_);
+  } else if (size_due || now >= next_rotation_) {
+    // 备用文件未就绪时继续写当前文件，下一条记录再尝试轮转
+    std::FILE* next = spare_.exchange(nullptr, std::memory_order_acq_rel);
+    if (next != nullptr) {
+      Retired retired{file_, std::min(now, next_rotation_)};
+      file_ = next;
+      file_size_ = 0;
+      next_rotation_ = NextRotation(now, options_, zone_);
+      {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        retired_.push_back(retired);
+        spare_requested_ = true;
+      }
+      jobs_cv_.notify_one();
+      rotations_.fetch_add(1, std::memory_order_release);
+    }
+  }
+
+  std::fwrite(buffer_.data(), 1, buffer_.size(), file_);
+  file_size_ += buffer_.size();
+}
+
+void RotatingFileSink::flush_() {
+  std::fflush(file_);
+}
+
+void RotatingFileSink::run() {
+  enforce_budget();
+
+  std::unique_lock<std::mutex> lock(jobs_mutex_);
+  for (;;) {
+    if (!retired_.empty()) {
+      Retired retired = retired_.front();
+      retired_.pop_front();
+      busy_ = true;
+      lock.unlock();
+      archive(retired);
+      enforce_budget();
+      lock.lock();
+      busy_ = false;
+      continue;
+    }
+    if (spare_requested_ && !stopping_) {
+      busy_ = true;
+      lock.unlock();
+      std::FILE* spare = open_spare();
+      lock.lock();
+      busy_ = false;
+      if (spare != nullptr) {
+        spare_.store(spare, std::memory_order_release);
+        spare_requested_ = false;
+        spare_failed_ = false;
+      } else {
+        // 创建失败（如磁盘满）时稍后重试，期间继续写当前文件
+        spare_failed_ = true;
+        idle_cv_.notify_all();
+        jobs_cv_.wait_for(lock, std::chrono::seconds(1),
+                          [this] { return stopping_; });
+      }
+      continue;
+    }
+    idle_cv_.notify_all();
+    if (stopping_) {
+      break;
+    }
+    jobs_cv_.wait(lock, [this] {
+      return stopping_ || !retired_.empty() || spare_requested_;
+    });
+  }
+}
+
+std::FILE* RotatingFileSink::open_spare() {
+  std::string spare_path = path_ + kSpareSuffix;
+  std::FILE* spare = std::fopen(spare_path.c_str(), "wb");
+  if (spare != nullptr) {
+    Preallocate(spare, options_.preallocate_size != 0
+                           ? options_.preallocate_size
+                           : options_.max_file_size);
+  }
+  return spare;
+}
+
+void RotatingFileSink::archive(const Retired& retired) {
+  CloseFile(retired.file);
+
+  // 写入线程已切换到备用文件的句柄，改名不影响正在进行的写入
+  std::error_code ec;
+  fs::rename(path_, UniqueArchivePath(stem_, retired.closed, zone_), ec);
+  fs::rename(path_ + kSpareSuffix, path_, ec);
+}
+
+void RotatingFileSink::enforce_budget() {
+  if (options_.max_total_size == 0) {
+    return;
+  }
+  fs::path stem(stem_);
+  fs::path dir = stem.has_parent_path() ? stem.parent_path() : fs::path(".");
+  std::string prefix = stem.filename().string() + ".";
+
+  // 归档名中的时间戳按字典序即按时间排序
+  std::vector<std::pair<std::string, uintmax_t>> archives;
+  std::error_code ec;
+  for (fs::directory_iterator it(dir, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    std::string name = it->path().filename().string();
+    if (name.size() <= prefix.size() || !absl::StartsWith(name, prefix) ||
+        !absl::EndsWith(name, kLogSuffix) ||
+        !absl::ascii_isdigit(name[prefix.size()])) {
+      continue;
+    }
+    std::error_code size_ec;
+    uintmax_t size = it->file_size(size_ec);
+    if (!size_ec) {
+      archives.emplace_back(it->path().string(), size);
+    }
+  }
+  std::sort(archives.begin(), archives.end());
+
+  uintmax_t total = 0;
+  for (const auto& archive : archives) {
+    total += archive.second;
+  }
+  for (const auto& archive : archives) {
+    if (total <= options_.max_total_size) {
+      break;
+    }
+    std::error_code remove_ec;
+    if (fs::remove(archive.first, remove_ec)) {
+      total -= archive.second;
+    }
+  }
+}
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,96 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/shm_backend.h"
+
+#include <chrono>
+#include <absl/strings/str_format.h>
+
+namespace qxcore {
+namespace log {
+
+ShmBackend::~ShmBackend() {
+  if (initialized_.load(std::memory_order_acquire)) {
+    shutdown();
+  }
+}
+
+absl::Status ShmBackend::init(const std::string& name, LogLevel level,
+                              const LogOptions& options) {
+  if (initialized_.load(std::memory_order_acquire)) {
+    return absl::AlreadyExistsError("Logger already initialized");
+  }
+
+  if (name.empty()) {
+    return absl::InvalidArgumentError("Logger name cannot be empty");
+  }
+
+  std::shared_ptr<ShmProducer> producer;
+  absl::Status status = ShmProducer::Create(name, options.shm, &producer);
+  if (!status.ok()) {
+    return status;
+  }
+
+  producer_ = std::move(producer);
+  flush_timeout_ms_ = options.shm.flush_timeout_ms;
+  current_level_.store(level, std::memory_order_relaxed);
+  initialized_.store(true, std::memory_order_release);
+  CallsiteRegistry::Global().set_logger_level(this, level);
+  return absl::OkStatus();
+}
+
+absl::Status ShmBackend::set_level(LogLevel level) {
+  if (!initialized_.load(std::memory_order_acquire)) {
+    return absl::FailedPreconditionError("Logger not initialized");
+  }
+  current_level_.store(level, std::memory_order_relaxed);
+  CallsiteRegistry::Global().set_logger_level(this, level);
+  return absl::OkStatus();
+}
+
+LogLevel ShmBackend::get_level() const {
+  return current_level_.load(std::memory_order_relaxed);
+}
+
+void ShmBackend::flush() {
+  if (!initialized_.load(std::memory_order_acquire)) {
+    return;
+  }
+  producer_->flush(std::chrono::milliseconds(flush_timeout_ms_));
+}
+
+void ShmBackend::shutdown() {
+  if (!initialized_.load(std::memory_order_acquire)) {
+    return;
+  }
+  initialized_.store(false, std::memory_order_release);
+  CallsiteRegistry::Global().remove_logger(this);
+  producer_->flush(std::chrono::milliseconds(flush_timeout_ms_));
+  producer_->close();
+}
+
+bool ShmBackend::daemon_alive() const {
+  return producer_ != nullptr && producer_->daemon_alive();
+}
+
+std::string ShmBackend::segment_path() const {
+  return producer_ != nullptr ? producer_->path() : std::string();
+}
+
+ShmStats ShmBackend::stats() const {
+  return producer_ != nullptr ? producer_->stats() : ShmStats();
+}
+
+}  // namespace log
+}  // namespace qxcore
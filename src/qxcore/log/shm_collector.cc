@@ -0,0 +1,449 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/shm_collector.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <filesystem>
+#include <limits>
+#include <absl/strings/match.h>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_format.h>
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+using internal::ShmRecordHeader;
+using internal::ShmRingHeader;
+using internal::ShmSegmentHeader;
+
+int64_t RealtimeNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+size_t AlignedFrameSize(size_t size) {
+  return (size + shm_format::kFrameSize + 7) & ~static_cast<size_t>(7);
+}
+
+}  // anonymous namespace
+
+struct ShmLogCollector::Client {
+  ~Client() {
+    if (region != nullptr) {
+      ::munmap(region, size);
+    }
+  }
+
+  ShmRingHeader* ring(uint32_t index) const {
+    return reinterpret_cast<ShmRingHeader*>(
+        rings + index * (shm_format::kRingHeaderSize + ring_capacity));
+  }
+
+  // 生产者侧丢弃的记录总数
+  uint64_t dropped() const {
+    uint64_t total = header->unclaimed.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < header->max_threads; ++i) {
+      total += ring(i)->dropped.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+  std::string path;
+  char* region = nullptr;
+  size_t size = 0;
+  ShmSegmentHeader* header = nullptr;
+  const char* dictionary = nullptr;
+  char* rings = nullptr;
+  size_t ring_capacity = 0;
+  std::string name;
+  uint32_t dictionary_read = 0;
+  uint64_t flush_seen = 0;
+
+  // 段字典在本进程中的重建结果
+  absl::flat_hash_map<uint32_t, std::string> formats;
+  absl::flat_hash_map<uint32_t, const Callsite*> callsites;
+  absl::flat_hash_map<uint32_t, LoggerId> loggers;
+  std::deque<std::string> strings;
+  std::deque<Callsite> callsite_storage;
+};
+
+ShmLogCollector::ShmLogCollector(std::string directory,
+                                 ShmRecordHandler* handler)
+    : directory_(std::move(directory)), handler_(handler) {}
+
+ShmLogCollector::~ShmLogCollector() {
+  close();
+}
+
+absl::Status ShmLogCollector::open() {
+  if (lock_fd_ >= 0) {
+    return absl::AlreadyExistsError("Collector already opened");
+  }
+  std::error_code error;
+  std::filesystem::create_directories(directory_, error);
+  if (error) {
+    return absl::InternalError(absl::StrFormat(
+        "Failed to create directory %s: %s", directory_, error.message()));
+  }
+  std::string lock_path =
+      absl::StrCat(directory_, "/", shm_format::kLockFile);
+  int fd = ::open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return absl::InternalError(
+        absl::StrFormat("Failed to open lock file %s", lock_path));
+  }
+  if (::flock(fd, LOCK_EX | LOCK_NB) != 0) {
+    ::close(fd);
+    return absl::AlreadyExistsError(
+        absl::StrFormat("Another collector is running on %s", directory_));
+  }
+  lock_fd_ = fd;
+  next_scan_ = std::chrono::steady_clock::time_point{};
+  return absl::OkStatus();
+}
+
+size_t ShmLogCollector::poll() {
+  if (lock_fd_ < 0) {
+    return 0;
+  }
+  auto now = std::chrono::steady_clock::now();
+  if (now >= next_scan_) {
+    scan();
+    next_scan_ = now + kScanInterval;
+  }
+
+  int64_t heartbeat = RealtimeNanos();
+  int pid = static_cast<int>(::getpid());
+  size_t count = 0;
+  for (auto& client : clients_) {
+    ShmSegmentHeader* header = client->header;
+    header->daemon_heartbeat.store(heartbeat, std::memory_order_relaxed);
+    header->daemon_pid.store(pid, std::memory_order_release);
+
+    // 先读取刷新请求再写出，请求之前提交的记录都在本轮写出
+    uint64_t flush_request =
+        header->flush_requested.load(std::memory_order_acquire);
+    size_t drained = drain(*client, kMaxBatch);
+    count += drained;
+    if (flush_request > client->flush_seen && drained < kMaxBatch) {
+      handler_->flush(client->name);
+      client->flush_seen = flush_request;
+      header->flush_completed.store(flush_request, std::memory_order_release);
+    }
+  }
+  return count;
+}
+
+void ShmLogCollector::close() {
+  for (auto& client : clients_) {
+    client->header->daemon_pid.store(0, std::memory_order_release);
+  }
+  clients_.clear();
+  if (lock_fd_ >= 0) {
+    ::close(lock_fd_);
+    lock_fd_ = -1;
+  }
+}
+
+void ShmLogCollector::scan() {
+  std::error_code error;
+  for (const auto& entry :
+       std::filesystem::directory_iterator(directory_, error)) {
+    std::string path = entry.path().string();
+    if (!absl::EndsWith(path, shm_format::kSegmentSuffix)) {
+      continue;
+    }
+    bool known = std::any_of(
+        clients_.begin(), clients_.end(),
+        [&](const std::unique_ptr<Client>& client) {
+          return client->path == path;
+        });
+    if (!known) {
+      std::unique_ptr<Client> client = attach(path);
+      if (client != nullptr) {
+        clients_.push_back(std::move(client));
+      }
+    }
+  }
+
+  // 生产者关闭或退出后写完剩余记录，再删除段文件
+  for (auto it = clients_.begin(); it != clients_.end();) {
+    Client& client = **it;
+    bool clean = client.header->closed.load(std::memory_order_acquire) != 0;
+    if (!clean &&
+        internal::ProcessAlive(client.header->pid, client.header->start_time)) {
+      ++it;
+      continue;
+    }
+    drain(client, std::numeric_limits<size_t>::max());
+    handler_->flush(client.name);
+    handler_->detach(client.name, client.header->pid, clean, client.dropped());
+    ::unlink(client.path.c_str());
+    it = clients_.erase(it);
+  }
+}
+
+std::unique_ptr<ShmLogCollector::Client> ShmLogCollector::attach(
+    const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  void* region = MAP_FAILED;
+  if (::fstat(fd, &st) == 0 &&
+      static_cast<size_t>(st.st_size) >= shm_format::kHeaderSize) {
+    region = ::mmap(nullptr, static_cast<size_t>(st.st_size),
+                    PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  ::close(fd);
+  if (region == MAP_FAILED) {
+    return nullptr;
+  }
+
+  auto client = std::make_unique<Client>();
+  client->path = path;
+  client->region = static_cast<char*>(region);
+  client->size = static_cast<size_t>(st.st_size);
+  client->header = reinterpret_cast<ShmSegmentHeader*>(client->region);
+
+  // 生产者最后写入 magic；尚未完成初始化的段留到下次扫描
+  const ShmSegmentHeader& header = *client->header;
+  if (header.magic.load(std::memory_order_acquire) != shm_format::kMagic ||
+      header.version != shm_format::kVersion || header.max_threads == 0 ||
+      header.ring_capacity == 0 ||
+      (header.ring_capacity & (header.ring_capacity - 1)) != 0) {
+    return nullptr;
+  }
+  client->ring_capacity = header.ring_capacity;
+  size_t required = shm_format::kHeaderSize + header.dictionary_capacity +
+                    static_cast<size_t>(header.max_threads) *
+                        (shm_format::kRingHeaderSize + client->ring_capacity);
+  if (client->size < required) {
+    return nullptr;
+  }
+  client->dictionary = client->region + shm_format::kHeaderSize;
+  client->rings = client->region + shm_format::kHeaderSize +
+                  header.dictionary_capacity;
+  client->name.assign(header.name, strnlen(header.name, sizeof(header.name)));
+  // 刷新请求在收集器重启前可能已完成，从当前值开始跟踪
+  client->flush_seen = header.flush_completed.load(std::memory_order_acquire);
+  return client;
+}
+
+void ShmLogCollector::read_dictionary(Client& client) {
+  uint32_t used = std::min(
+      client.header->dictionary_used.load(std::memory_order_acquire),
+      client.header->dictionary_capacity);
+  while (client.dictionary_read + 16 <= used) {
+    const char* entry = client.dictionary + client.dictionary_read;
+    uint32_t fields[4];
+    std::memcpy(fields, entry, sizeof(fields));
+    uint32_t kind = fields[0];
+    uint32_t id = fields[1];
+    uint32_t aux = fields[2];
+    uint32_t size = fields[3];
+    if (client.dictionary_read + 16 + size > used) {
+      break;
+    }
+    absl::string_view bytes(entry + 16, size);
+    client.dictionary_read +=
+        static_cast<uint32_t>((16 + size + 7) & ~static_cast<size_t>(7));
+
+    if (kind == shm_format::kFormatEntry) {
+      client.formats[id] = std::string(bytes);
+    } else if (kind == shm_format::kCallsiteEntry && size >= 2) {
+      size_t split = bytes.find('\0', 1);
+      if (split == absl::string_view::npos) {
+        continue;
+      }
+      int level = std::min<int>(static_cast<uint8_t>(bytes[0]),
+                                LogLevelToInt(LogLevel::kCritical));
+      const std::string& file =
+          client.strings.emplace_back(bytes.substr(1, split - 1));
+      const std::string& function =
+          client.strings.emplace_back(bytes.substr(split + 1));
+      const Callsite& callsite = client.callsite_storage.emplace_back(
+          file.c_str(), static_cast<int>(aux), function.c_str(), nullptr,
+          static_cast<LogLevel>(level));
+      client.callsites[id] = &callsite;
+    } else if (kind == shm_format::kLoggerEntry) {
+      LoggerId logger_id = kNoLoggerId;
+      if (LoggerRegistry::Global().get(bytes, &logger_id).ok()) {
+        client.loggers[id] = logger_id;
+      }
+    }
+  }
+}
+
+size_t ShmLogCollector::drain(Client& client, size_t limit) {
+  struct Cursor {
+    ShmRingHeader* ring;
+    const char* data;
+    uint64_t read;
+    uint64_t end;
+    int64_t key;
+    const char* payload;  // 当前记录，为 nullptr 时已取空
+    uint32_t size;
+  };
+  const size_t mask = client.ring_capacity - 1;
+  const size_t max_record = client.ring_capacity / 4;
+  TscClock& clock = TscClock::Global();
+
+  // 定位下一条记录并计算归并键，跳过填充帧；帧长度异常时丢弃该环剩余内容
+  auto advance = [&](Cursor& cursor) {
+    cursor.payload = nullptr;
+    while (cursor.read < cursor.end) {
+      const char* frame = cursor.data + (cursor.read & mask);
+      uint32_t size;
+      uint32_t flags;
+      std::memcpy(&size, frame, sizeof(size));
+      std::memcpy(&flags, frame + sizeof(size), sizeof(flags));
+      size_t frame_size = AlignedFrameSize(size);
+      bool padding = (flags & shm_format::kPaddingFrame) != 0;
+      // 填充帧总是延伸到缓冲区末尾
+      bool valid =
+          frame_size <= cursor.end - cursor.read &&
+          (padding ? (cursor.read & mask) + frame_size == client.ring_capacity
+                   : size >= sizeof(ShmRecordHeader) && size <= max_record);
+      if (!valid) {
+        cursor.read = cursor.end;
+        cursor.ring->read_pos.store(cursor.read, std::memory_order_release);
+        break;
+      }
+      if (padding) {
+        cursor.read += frame_size;
+        continue;
+      }
+      ShmRecordHeader header;
+      std::memcpy(&header, frame + shm_format::kFrameSize, sizeof(header));
+      cursor.payload = frame + shm_format::kFrameSize;
+      cursor.size = size;
+      cursor.key = clock.to_unix_nanos(RecordTime{
+          header.time, (header.flags & shm_format::kEventTime) != 0});
+      break;
+    }
+  };
+
+  std::vector<Cursor> cursors;
+  for (uint32_t i = 0; i < client.header->max_threads; ++i) {
+    ShmRingHeader* ring = client.ring(i);
+    uint64_t end = ring->write_pos.load(std::memory_order_acquire);
+    uint64_t read = ring->read_pos.load(std::memory_order_relaxed);
+    if (read != end) {
+      cursors.push_back(Cursor{ring,
+                               reinterpret_cast<const char*>(ring) +
+                                   shm_format::kRingHeaderSize,
+                               read, end, 0, nullptr, 0});
+    }
+  }
+  if (cursors.empty()) {
+    return 0;
+  }
+  // 写入位置之后读取字典，已提交记录引用的条目都已可见
+  read_dictionary(client);
+  for (Cursor& cursor : cursors) {
+    advance(cursor);
+  }
+
+  size_t count = 0;
+  while (count < limit) {
+    Cursor* next = nullptr;
+    for (Cursor& cursor : cursors) {
+      if (cursor.payload != nullptr &&
+          (next == nullptr || cursor.key < next->key)) {
+        next = &cursor;
+      }
+    }
+    if (next == nullptr) {
+      break;
+    }
+    ShmRecordHeader header;
+    std::memcpy(&header, next->payload, sizeof(header));
+    const char* args = next->payload + sizeof(header);
+    if (header.args_size <= next->size - sizeof(header)) {
+      write_record(client, header, args);
+    }
+    next->read += AlignedFrameSize(next->size);
+    next->ring->read_pos.store(next->read, std::memory_order_release);
+    next->ring->consumed.store(
+        next->ring->consumed.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+    ++count;
+    advance(*next);
+  }
+  written_ += count;
+  return count;
+}
+
+void ShmLogCollector::write_record(Client& client,
+                                   const internal::ShmRecordHeader& header,
+                                   const char* payload) {
+  LoggerId logger_id = kNoLoggerId;
+  if (header.logger_id != kNoLoggerId) {
+    auto it = client.loggers.find(header.logger_id);
+    if (it != client.loggers.end()) {
+      logger_id = it->second;
+    }
+  }
+  const Callsite* callsite = nullptr;
+  if (header.callsite_id != shm_format::kNoCallsiteId) {
+    auto it = client.callsites.find(header.callsite_id);
+    if (it != client.callsites.end()) {
+      callsite = it->second;
+    }
+  }
+  LogLevel level = static_cast<LogLevel>(
+      std::min<int>(header.level, LogLevelToInt(LogLevel::kCritical)));
+  RecordTime time{header.time, (header.flags & shm_format::kEventTime) != 0};
+
+  absl::string_view message;
+  if (header.flags & shm_format::kVerbatim) {
+    message = absl::string_view(payload, header.args_size);
+  } else {
+    format_buffer_.clear();
+    auto it = client.formats.find(header.format_id);
+    absl::Status status =
+        it == client.formats.end()
+            ? absl::NotFoundError(
+                  absl::StrCat("unknown format id ", header.format_id))
+            : FormatEncoded(it->second, payload, header.args_size,
+                            header.arg_count, arg_store_, format_buffer_);
+    if (!status.ok()) {
+      // 格式化失败时输出错误描述，不影响后续记录
+      format_buffer_.clear();
+      fmt::format_to(fmt::appender(format_buffer_), "[qxlog format error] {}",
+                     status.message());
+    }
+    message = absl::string_view(format_buffer_.data(), format_buffer_.size());
+  }
+  try {
+    handler_->write(client.name, level, callsite, logger_id, time, message);
+  } catch (...) {
+    // 静默处理日志错误，避免异常传播
+  }
+}
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,498 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/shm_transport.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_format.h>
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+using internal::ShmRingHeader;
+using internal::ShmSegmentHeader;
+
+constexpr size_t kMinRingSize = 64 * 1024;
+constexpr size_t kMaxRingSize = size_t{1} << 30;
+constexpr size_t kMaxThreads = 1024;
+constexpr size_t kMinDictionarySize = 4096;
+constexpr size_t kMaxDictionarySize = size_t{1} << 30;
+
+// 心跳超过该时间未更新视为 qxlogd 离线
+constexpr int64_t kDaemonTimeoutNanos = 2000000000;
+
+// 阻塞策略下生产者等待空位的休眠间隔
+constexpr std::chrono::microseconds kBlockSleep(50);
+constexpr std::chrono::microseconds kFlushPoll(100);
+
+// 调用点 ID 的线程本地缓存大小
+constexpr size_t kCallsiteCacheSize = 64;
+
+std::atomic<uint64_t> g_next_producer_id{1};
+
+size_t RoundUpPowerOfTwo(size_t value) {
+  size_t result = kMinRingSize;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+size_t AlignUp(size_t value, size_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+int64_t RealtimeNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+uint32_t CurrentThreadId() {
+#if defined(__linux__)
+  return static_cast<uint32_t>(::syscall(SYS_gettid));
+#else
+  return static_cast<uint32_t>(
+      std::hash<std::thread::id>()(std::this_thread::get_id()));
+#endif
+}
+
+// 读取 /proc/<pid>/stat 中的状态字符与启动时间
+bool ReadProcessStat(int pid, char* state, uint64_t* start_time) {
+  std::string path = absl::StrCat("/proc/", pid, "/stat");
+  FILE* file = std::fopen(path.c_str(), "r");
+  if (file == nullptr) {
+    return false;
+  }
+  char buffer[1024];
+  size_t size = std::fread(buffer, 1, sizeof(buffer) - 1, file);
+  std::fclose(file);
+  buffer[size] = '\0';
+
+  // 进程名可能含空格和括号，从最后一个右括号之后开始解析
+  const char* cursor = std::strrchr(buffer, ')');
+  if (cursor == nullptr) {
+    return false;
+  }
+  unsigned long long value = 0;
+  // 第 3 项为状态，第 22 项为启动时间，中间跳过 18 项
+  if (std::sscanf(cursor + 1,
+                  " %c %*s %*s %*s %*s %*s %*s %*s %*s %*s %*s %*s %*s "
+                  "%*s %*s %*s %*s %*s %*s %llu",
+                  state, &value) != 2) {
+    return false;
+  }
+  *start_time = value;
+  return true;
+}
+
+}  // anonymous namespace
+
+namespace internal {
+
+ShmThreadRings::~ShmThreadRings() {
+  for (auto& entry : entries) {
+    if (entry.ring != nullptr) {
+      entry.ring->state.store(shm_format::kRingAbandoned,
+                              std::memory_order_release);
+    }
+  }
+}
+
+uint64_t ProcessStartTime(int pid) {
+  char state = 0;
+  uint64_t start_time = 0;
+  return ReadProcessStat(pid, &state, &start_time) ? start_time : 0;
+}
+
+bool ProcessAlive(int pid, uint64_t start_time) {
+  char state = 0;
+  uint64_t current = 0;
+  if (ReadProcessStat(pid, &state, &current)) {
+    return current == start_time && state != 'Z' && state != 'X';
+  }
+  // 没有 /proc 时只能按 pid 判断
+  return start_time == 0 && (::kill(pid, 0) == 0 || errno == EPERM);
+}
+
+}  // namespace internal
+
+ShmProducer::~ShmProducer() {
+  if (region_ != nullptr) {
+    ::munmap(region_, region_size_);
+  }
+}
+
+absl::Status ShmProducer::ValidateOptions(const ShmOptions& options) {
+  if (options.directory.empty()) {
+    return absl::InvalidArgumentError("Shared memory directory cannot be empty");
+  }
+  if (options.ring_size == 0 || options.ring_size > kMaxRingSize) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Shared memory ring size must be in (0, %d]",
+                        kMaxRingSize));
+  }
+  if (options.max_threads == 0 || options.max_threads > kMaxThreads) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "Shared memory max_threads must be in [1, %d]", kMaxThreads));
+  }
+  if (options.dictionary_size < kMinDictionarySize ||
+      options.dictionary_size > kMaxDictionarySize) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("Shared memory dictionary size must be in [%d, %d]",
+                        kMinDictionarySize, kMaxDictionarySize));
+  }
+  if (options.overflow_policy == OverflowPolicy::kDropOldest) {
+    return absl::InvalidArgumentError(
+        "Shared memory transport does not support kDropOldest");
+  }
+  if (options.flush_timeout_ms < 0) {
+    return absl::InvalidArgumentError("Invalid shared memory flush timeout");
+  }
+  return absl::OkStatus();
+}
+
+absl::Status ShmProducer::Create(const std::string& name,
+                                 const ShmOptions& options,
+                                 std::shared_ptr<ShmProducer>* producer) {
+  absl::Status status = ValidateOptions(options);
+  if (!status.ok()) {
+    return status;
+  }
+  std::error_code error;
+  std::filesystem::create_directories(options.directory, error);
+  if (error) {
+    return absl::InternalError(
+        absl::StrFormat("Failed to create shared memory directory %s: %s",
+                        options.directory, error.message()));
+  }
+
+  std::shared_ptr<ShmProducer> result(new ShmProducer());
+  result->ring_capacity_ = RoundUpPowerOfTwo(options.ring_size);
+  size_t dictionary_size = AlignUp(options.dictionary_size, 64);
+  size_t ring_stride = shm_format::kRingHeaderSize + result->ring_capacity_;
+  size_t size = shm_format::kHeaderSize + dictionary_size +
+                options.max_threads * ring_stride;
+
+  int pid = static_cast<int>(::getpid());
+  result->path_ = absl::StrCat(
+      options.directory, "/", name, ".", pid, ".", RealtimeNanos(),
+      shm_format::kSegmentSuffix);
+  int fd = ::open(result->path_.c_str(),
+                  O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    return absl::InternalError(absl::StrFormat(
+        "Failed to create shared memory segment %s", result->path_));
+  }
+  void* region = MAP_FAILED;
+  if (::ftruncate(fd, static_cast<off_t>(size)) == 0) {
+    region = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  ::close(fd);
+  if (region == MAP_FAILED) {
+    ::unlink(result->path_.c_str());
+    return absl::InternalError(absl::StrFormat(
+        "Failed to map %d bytes for shared memory segment %s", size,
+        result->path_));
+  }
+
+  result->region_ = static_cast<char*>(region);
+  result->region_size_ = size;
+  result->dictionary_ = result->region_ + shm_format::kHeaderSize;
+  result->rings_ = result->dictionary_ + dictionary_size;
+  result->overflow_policy_ = options.overflow_policy;
+  result->exported_formats_.reset(
+      new std::atomic<uint64_t>[kMaxExportedIds / 64]);
+  result->exported_loggers_.reset(
+      new std::atomic<uint64_t>[kMaxExportedIds / 64]);
+  for (size_t i = 0; i < kMaxExportedIds / 64; ++i) {
+    result->exported_formats_[i].store(0, std::memory_order_relaxed);
+    result->exported_loggers_[i].store(0, std::memory_order_relaxed);
+  }
+
+  // 新文件内容全为零，线程环即为空闲状态；magic 最后写入，qxlogd 只接管
+  // 初始化完成的段
+  ShmSegmentHeader* header = new (result->region_) ShmSegmentHeader();
+  header->version = shm_format::kVersion;
+  header->max_threads = static_cast<uint32_t>(options.max_threads);
+  header->ring_capacity = static_cast<uint32_t>(result->ring_capacity_);
+  header->dictionary_capacity = static_cast<uint32_t>(dictionary_size);
+  header->pid = pid;
+  header->start_time = internal::ProcessStartTime(pid);
+  std::memset(header->name, 0, sizeof(header->name));
+  std::memcpy(header->name, name.data(),
+              std::min(name.size(), sizeof(header->name) - 1));
+  header->magic.store(shm_format::kMagic, std::memory_order_release);
+  result->header_ = header;
+
+  result->id_ = g_next_producer_id.fetch_add(1, std::memory_order_relaxed);
+  *producer = std::move(result);
+  return absl::OkStatus();
+}
+
+void ShmProducer::write_text(LogLevel level, const Callsite* callsite,
+                             LoggerId logger_id, RecordTime time,
+                             absl::string_view message) {
+  internal::ShmRingHeader* ring = local_ring();
+  if (ring == nullptr) {
+    header_->unclaimed.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  size_t advance = 0;
+  char* dst = reserve(ring, sizeof(internal::ShmRecordHeader) + message.size(),
+                      &advance);
+  if (dst == nullptr) {
+    return;
+  }
+  internal::ShmRecordHeader header;
+  fill_header(&header, level, callsite, logger_id, time, message.size());
+  header.flags |= shm_format::kVerbatim;
+  std::memcpy(dst, &header, sizeof(header));
+  std::memcpy(dst + sizeof(header), message.data(), message.size());
+  commit(ring, advance);
+}
+
+bool ShmProducer::flush(std::chrono::milliseconds timeout) {
+  if (!daemon_alive()) {
+    return false;
+  }
+  uint64_t request =
+      header_->flush_requested.fetch_add(1, std::memory_order_acq_rel) + 1;
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (header_->flush_completed.load(std::memory_order_acquire) < request) {
+    if (!daemon_alive() || std::chrono::steady_clock::now() >= deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(kFlushPoll);
+  }
+  return true;
+}
+
+void ShmProducer::close() {
+  header_->closed.store(1, std::memory_order_release);
+}
+
+bool ShmProducer::daemon_alive() const {
+  return header_->daemon_pid.load(std::memory_order_acquire) != 0 &&
+         RealtimeNanos() -
+                 header_->daemon_heartbeat.load(std::memory_order_relaxed) <
+             kDaemonTimeoutNanos;
+}
+
+ShmStats ShmProducer::stats() const {
+  ShmStats stats;
+  stats.dropped = header_->unclaimed.load(std::memory_order_relaxed);
+  for (uint32_t i = 0; i < header_->max_threads; ++i) {
+    const ShmRingHeader* ring = ring_at(i);
+    stats.committed += ring->committed.load(std::memory_order_relaxed);
+    stats.dropped += ring->dropped.load(std::memory_order_relaxed);
+    stats.written += ring->consumed.load(std::memory_order_relaxed);
+  }
+  return stats;
+}
+
+internal::ShmRingHeader* ShmProducer::claim_ring(
+    internal::ShmThreadRings& local) {
+  if (local.thread_id == 0) {
+    local.thread_id = CurrentThreadId();
+  }
+  // 清理已关闭段留下的线程环
+  local.entries.erase(
+      std::remove_if(local.entries.begin(), local.entries.end(),
+                     [](const internal::ShmThreadRings::Entry& entry) {
+                       if (!entry.producer->header_->closed.load(
+                               std::memory_order_acquire)) {
+                         return false;
+                       }
+                       if (entry.ring != nullptr) {
+                         entry.ring->state.store(shm_format::kRingAbandoned,
+                                                 std::memory_order_release);
+                       }
+                       return true;
+                     }),
+      local.entries.end());
+
+  for (const auto& entry : local.entries) {
+    if (entry.producer_id == id_) {
+      local.last_id = id_;
+      local.last_ring = entry.ring;
+      return entry.ring;
+    }
+  }
+
+  // 空闲或所属线程已退出的环都可以接管，接管后从原写入位置继续
+  ShmRingHeader* ring = nullptr;
+  for (uint32_t i = 0; i < header_->max_threads && ring == nullptr; ++i) {
+    ShmRingHeader* candidate = ring_at(i);
+    for (uint32_t state : {shm_format::kRingFree, shm_format::kRingAbandoned}) {
+      uint32_t expected = state;
+      if (candidate->state.compare_exchange_strong(
+              expected, shm_format::kRingOwned, std::memory_order_acq_rel)) {
+        ring = candidate;
+        break;
+      }
+    }
+  }
+  if (ring != nullptr) {
+    ring->read_pos_cache = ring->read_pos.load(std::memory_order_acquire);
+  }
+  local.entries.push_back({id_, shared_from_this(), ring});
+  local.last_id = id_;
+  local.last_ring = ring;
+  return ring;
+}
+
+internal::ShmRingHeader* ShmProducer::ring_at(uint32_t index) const {
+  return reinterpret_cast<ShmRingHeader*>(
+      rings_ + index * (shm_format::kRingHeaderSize + ring_capacity_));
+}
+
+bool ShmProducer::wait_for_space(internal::ShmRingHeader* ring,
+                                 uint64_t write_pos, size_t required) {
+  for (;;) {
+    ring->read_pos_cache = ring->read_pos.load(std::memory_order_acquire);
+    if (ring_capacity_ - (write_pos - ring->read_pos_cache) >= required) {
+      return true;
+    }
+    if (overflow_policy_ != OverflowPolicy::kBlock || !daemon_alive()) {
+      ring->dropped.store(ring->dropped.load(std::memory_order_relaxed) + 1,
+                          std::memory_order_relaxed);
+      return false;
+    }
+    std::this_thread::sleep_for(kBlockSleep);
+  }
+}
+
+bool ShmProducer::export_format_slow(uint32_t format_id,
+                                     absl::string_view format) {
+  if (format_id >= kMaxExportedIds) {
+    return false;
+  }
+  uint64_t bit = uint64_t{1} << (format_id % 64);
+  std::lock_guard<std::mutex> lock(dictionary_mutex_);
+  std::atomic<uint64_t>& word = exported_formats_[format_id / 64];
+  if (word.load(std::memory_order_relaxed) & bit) {
+    return true;
+  }
+  if (!append_entry_locked(shm_format::kFormatEntry, format_id, 0, format,
+                           absl::string_view())) {
+    return false;
+  }
+  word.fetch_or(bit, std::memory_order_relaxed);
+  return true;
+}
+
+uint32_t ShmProducer::export_callsite(const Callsite* callsite) {
+  struct Entry {
+    uint64_t producer_id = 0;
+    const Callsite* callsite = nullptr;
+    uint32_t id = 0;
+  };
+  thread_local Entry cache[kCallsiteCacheSize];
+
+  if (callsite == nullptr) {
+    return shm_format::kNoCallsiteId;
+  }
+  Entry& entry = cache[(reinterpret_cast<uintptr_t>(callsite) >> 4) &
+                       (kCallsiteCacheSize - 1)];
+  if (entry.producer_id == id_ && entry.callsite == callsite) {
+    return entry.id;
+  }
+
+  uint32_t id = shm_format::kNoCallsiteId;
+  {
+    std::lock_guard<std::mutex> lock(dictionary_mutex_);
+    auto it = callsite_ids_.find(callsite);
+    if (it != callsite_ids_.end()) {
+      id = it->second;
+    } else {
+      uint32_t next = static_cast<uint32_t>(callsite_ids_.size()) + 1;
+      // 级别占一个字节，文件名与函数名以 \0 分隔
+      std::string location(
+          1, static_cast<char>(LogLevelToInt(callsite->level())));
+      location.append(callsite->file());
+      location.push_back('\0');
+      if (append_entry_locked(shm_format::kCallsiteEntry, next,
+                              static_cast<uint32_t>(callsite->line()),
+                              location, callsite->function())) {
+        callsite_ids_.emplace(callsite, next);
+        id = next;
+      }
+    }
+  }
+  // 字典已满时不缓存，之后的调用仍会尝试（只在字典写满后发生）
+  if (id != shm_format::kNoCallsiteId) {
+    entry.producer_id = id_;
+    entry.callsite = callsite;
+    entry.id = id;
+  }
+  return id;
+}
+
+bool ShmProducer::export_logger_slow(LoggerId logger_id) {
+  if (logger_id >= kMaxExportedIds) {
+    return false;
+  }
+  uint64_t bit = uint64_t{1} << (logger_id % 64);
+  std::lock_guard<std::mutex> lock(dictionary_mutex_);
+  std::atomic<uint64_t>& word = exported_loggers_[logger_id / 64];
+  if (word.load(std::memory_order_relaxed) & bit) {
+    return true;
+  }
+  if (!append_entry_locked(shm_format::kLoggerEntry, logger_id, 0,
+                           LoggerRegistry::Global().name(logger_id),
+                           absl::string_view())) {
+    return false;
+  }
+  word.fetch_or(bit, std::memory_order_relaxed);
+  return true;
+}
+
+bool ShmProducer::append_entry_locked(uint32_t kind, uint32_t id, uint32_t aux,
+                                      absl::string_view first,
+                                      absl::string_view second) {
+  uint32_t used = header_->dictionary_used.load(std::memory_order_relaxed);
+  size_t size = first.size() + second.size();
+  size_t entry_size = AlignUp(16 + size, 8);
+  if (used + entry_size > header_->dictionary_capacity) {
+    return false;
+  }
+  char* entry = dictionary_ + used;
+  uint32_t fields[4] = {kind, id, aux, static_cast<uint32_t>(size)};
+  std::memcpy(entry, fields, sizeof(fields));
+  std::memcpy(entry + 16, first.data(), first.size());
+  std::memcpy(entry + 16 + first.size(), second.data(), second.size());
+  header_->dictionary_used.store(static_cast<uint32_t>(used + entry_size),
+                                 std::memory_order_release);
+  return true;
+}
+
+}  // namespace log
+}  // namespace qxcore
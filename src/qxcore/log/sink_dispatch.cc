@@ -0,0 +1,78 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/sink_dispatch.h"
+
+#include <spdlog/sinks/sink.h>
+#include "qxcore/log/group_commit_sink.h"
+
+namespace qxcore {
+namespace log {
+namespace internal {
+
+void DispatchToSinks(const std::vector<spdlog::sink_ptr>& sinks,
+                     const spdlog::details::log_msg& msg) {
+  for (const auto& sink : sinks) {
+    if (!sink->should_log(msg.level)) {
+      continue;
+    }
+    try {
+      sink->log(msg);
+    } catch (...) {
+      // 静默处理日志错误，避免异常传播
+    }
+  }
+}
+
+void FlushSinks(const std::vector<spdlog::sink_ptr>& sinks) {
+  for (const auto& sink : sinks) {
+    try {
+      sink->flush();
+    } catch (...) {
+      // 静默处理日志错误，避免异常传播
+    }
+  }
+}
+
+std::vector<GroupCommitSink*> FindGroupCommitSinks(
+    const std::vector<spdlog::sink_ptr>& sinks) {
+  std::vector<GroupCommitSink*> result;
+  for (const auto& sink : sinks) {
+    auto* group_sink = dynamic_cast<GroupCommitSink*>(sink.get());
+    if (group_sink != nullptr) {
+      result.push_back(group_sink);
+    }
+  }
+  return result;
+}
+
+void BeginSinkBatch(const std::vector<GroupCommitSink*>& sinks) {
+  for (GroupCommitSink* sink : sinks) {
+    sink->begin_batch();
+  }
+}
+
+void EndSinkBatch(const std::vector<GroupCommitSink*>& sinks) {
+  for (GroupCommitSink* sink : sinks) {
+    try {
+      sink->end_batch();
+    } catch (...) {
+      // 静默处理日志错误，避免异常传播
+    }
+  }
+}
+
+}  // namespace internal
+}  // namespace log
+}  // namespace qxcore
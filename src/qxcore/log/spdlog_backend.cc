@@ -14,8 +14,15 @@
 
 #include "qxcore/log/spdlog_backend.h"
 #include <spdlog/spdlog.h>
-#include <spdlog/sinks/stdout_color_sinks.h>
-#include <spdlog/sinks/basic_file_sink.h>
+#include "qxcore/log/binary_sink.h"
+#include "qxcore/log/console_sink.h"
+#include "qxcore/log/file_sink.h"
+#include "qxcore/log/group_commit_sink.h"
+#include "qxcore/log/json_lines_sink.h"
+#include "qxcore/log/mmap_file_sink.h"
+#include "qxcore/log/null_sink.h"
+#include "qxcore/log/rotating_file_sink.h"
+#include "qxcore/log/pattern_formatter.h"
 #include <absl/strings/str_format.h>
 
 namespace qxcore {
@@ -27,8 +34,9 @@ SpdlogBackend::~SpdlogBackend() {
   }
 }
 
-absl::Status SpdlogBackend::init(const std::string& name, LogLevel level) {
-  if (initialized_) {
+absl::Status SpdlogBackend::init(const std::string& name, LogLevel level,
+                                 const LogOptions& options) {
+  if (initialized_.load(std::memory_order_acquire)) {
     return absl::AlreadyExistsError("Logger already initialized");
   }
 
@@ -36,26 +44,220 @@ absl::Status SpdlogBackend::init(const std::string& name, LogLevel level) {
     return absl::InvalidArgumentError("Logger name cannot be empty");
   }
 
+  if (options.mode == LogMode::kAsync) {
+    absl::Status status = AsyncWriter::ValidateOptions(options.async);
+    if (!status.ok()) {
+      return status;
+    }
+  } else if (options.mode == LogMode::kDeferred) {
+    absl::Status status = DeferredWriter::ValidateOptions(options.async);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  if (options.rotation.enabled()) {
+    absl::Status status = RotatingFileSink::ValidateOptions(options.rotation);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+  if (options.mmap_segment_size != 0) {
+    if (options.rotation.enabled()) {
+      return absl::InvalidArgumentError(
+          "Mmap segments and file rotation cannot be combined");
+    }
+    absl::Status status =
+        MmapFileSink::ValidateSegmentSize(options.mmap_segment_size);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  if (options.group_commit.enabled) {
+    if (options.rotation.enabled() || options.mmap_segment_size != 0) {
+      return absl::InvalidArgumentError(
+          "Group commit cannot be combined with rotation or mmap segments");
+    }
+    absl::Status status =
+        GroupCommitSink::ValidateOptions(options.group_commit);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  if (options.dedup.enabled) {
+    absl::Status status = DedupFilter::ValidateOptions(options.dedup);
+    if (!status.ok()) {
+      return status;
+    }
+  }
+
+  if (options.console.non_blocking && options.console.buffer_size == 0) {
+    return absl::InvalidArgumentError(
+        "Non-blocking console buffer size must be positive");
+  }
+
   try {
-    // 创建控制台和文件输出
-    auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
-    auto file_sink = std::make_shared<spdlog::sinks::basic_file_sink_mt>(
-        name + ".log", true);
+    async_writer_.reset();
+    deferred_writer_.reset();
+    capture_.reset();
+    dedup_.reset();
+    console_sink_ = nullptr;
+    sink_level_ = LogLevel::kTrace;
+
+    std::vector<spdlog::sink_ptr> sinks;
+    if (options.output == LogOutput::kNull) {
+      sinks.push_back(std::make_shared<NullSink>());
+    } else {
+      // 创建控制台和文件输出，格式化缓冲区按 sink_buffer_size 预留
+      spdlog::sink_ptr console_sink;
+      if (options.console.non_blocking) {
+        auto nonblocking_sink = std::make_shared<NonBlockingConsoleSink>(
+            stdout, options.console.buffer_size, options.sink_buffer_size);
+        console_sink_ = nonblocking_sink.get();
+        console_sink = std::move(nonblocking_sink);
+      } else if (options.group_commit.enabled) {
+        auto group_sink = std::make_shared<GroupCommitSink>(
+            options.group_commit, options.sink_buffer_size);
+        absl::Status status = group_sink->open_console(stdout);
+        if (!status.ok()) {
+          return status;
+        }
+        console_sink = std::move(group_sink);
+      } else {
+        console_sink =
+            std::make_shared<ConsoleSink>(stdout, options.sink_buffer_size);
+      }
+      spdlog::sink_ptr file_sink;
+      if (options.binary_log_path.empty() && options.group_commit.enabled) {
+        auto group_sink = std::make_shared<GroupCommitSink>(
+            options.group_commit, options.sink_buffer_size);
+        absl::Status status = group_sink->open(name + ".log");
+        if (!status.ok()) {
+          return status;
+        }
+        file_sink = std::move(group_sink);
+      } else if (options.binary_log_path.empty() &&
+                 options.mmap_segment_size != 0) {
+        auto mmap_sink =
+            std::make_shared<MmapFileSink>(options.mmap_segment_size);
+        absl::Status status = mmap_sink->open(name + ".log");
+        if (!status.ok()) {
+          return status;
+        }
+        file_sink = std::move(mmap_sink);
+      } else if (options.binary_log_path.empty() &&
+                 options.rotation.enabled()) {
+        auto rotating_sink = std::make_shared<RotatingFileSink>(
+            options.rotation, options.sink_buffer_size);
+        absl::Status status = rotating_sink->open(name + ".log");
+        if (!status.ok()) {
+          return status;
+        }
+        file_sink = std::move(rotating_sink);
+      } else if (options.binary_log_path.empty()) {
+        auto text_sink = std::make_shared<FileSink>(options.sink_buffer_size);
+        absl::Status status = text_sink->open(name + ".log");
+        if (!status.ok()) {
+          return status;
+        }
+        file_sink = std::move(text_sink);
+      } else {
+        auto binary_sink = std::make_shared<BinaryFileSink>();
+        absl::Status status = binary_sink->open(options.binary_log_path);
+        if (!status.ok()) {
+          return status;
+        }
+        file_sink = std::move(binary_sink);
+      }
+      // 各输出按自己的阈值过滤，后端按其中最低者决定是否格式化
+      console_sink->set_level(ToSpdlogLevel(options.console.level));
+      file_sink->set_level(ToSpdlogLevel(options.file_level));
+      sink_level_ = LogLevelToInt(options.console.level) <
+                            LogLevelToInt(options.file_level)
+                        ? options.console.level
+                        : options.file_level;
+      sinks = {console_sink, file_sink};
+      if (!options.json_lines_path.empty()) {
+        auto json_sink =
+            std::make_shared<JsonLinesSink>(options.sink_buffer_size);
+        absl::Status status = json_sink->open(options.json_lines_path);
+        if (!status.ok()) {
+          return status;
+        }
+        json_sink->set_level(ToSpdlogLevel(options.json_lines_level));
+        if (LogLevelToInt(options.json_lines_level) <
+            LogLevelToInt(sink_level_)) {
+          sink_level_ = options.json_lines_level;
+        }
+        sinks.push_back(std::move(json_sink));
+      }
+    }
 
     // 创建多 sink 日志器
-    std::vector<spdlog::sink_ptr> sinks{console_sink, file_sink};
     logger_ = std::make_shared<spdlog::logger>(name, sinks.begin(), sinks.end());
     
-    // 设置日志级别
-    logger_->set_level(ToSpdlogLevel(level));
-    logger_->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%n] [%^%l%$] %v");
+    // 级别过滤由本后端和调用点完成，spdlog 日志器始终放行
+    logger_->set_level(spdlog::level::trace);
+    logger_->set_formatter(MakeLogFormatter(options.pattern));
     
+    // 异步模式：与同步 logger 共享 sinks，由后台线程写出
+    if (options.mode == LogMode::kAsync) {
+      auto writer = std::make_unique<AsyncWriter>(name, sinks, options.async);
+      absl::Status status = writer->start();
+      if (!status.ok()) {
+        logger_.reset();
+        return status;
+      }
+      async_writer_ = std::move(writer);
+    } else if (options.mode == LogMode::kDeferred) {
+      auto writer = std::make_unique<DeferredWriter>(name, sinks, options.async);
+      absl::Status status = writer->start();
+      if (!status.ok()) {
+        logger_.reset();
+        return status;
+      }
+      deferred_writer_ = std::move(writer);
+    }
+    if (!options.capture_path.empty()) {
+      auto capture = std::make_unique<WorkloadCapture>();
+      absl::Status status = capture->open(options.capture_path);
+      if (!status.ok()) {
+        async_writer_.reset();
+        deferred_writer_.reset();
+        logger_.reset();
+        return status;
+      }
+      capture_ = std::move(capture);
+    }
+    if (options.dedup.enabled) {
+      dedup_ = std::make_unique<DedupFilter>(options.dedup);
+      // 停止重复后由定时线程写出到期的汇总
+      absl::Status status = dedup_->start(
+          [this](const DedupRun& run) { write_dedup_summary(run); });
+      if (!status.ok()) {
+        dedup_.reset();
+        capture_.reset();
+        async_writer_.reset();
+        deferred_writer_.reset();
+        logger_.reset();
+        return status;
+      }
+    }
+    bypass_enabled_ = options.async.bypass_enabled;
+    bypass_level_ = options.async.bypass_level;
+
     // 注册到 spdlog
     spdlog::register_logger(logger_);
+
+    // 提前完成时钟初始校准，避免落在首条日志上
+    TscClock::Global();
     
-    current_level_ = level;
-    initialized_ = true;
-    
+    current_level_.store(level, std::memory_order_relaxed);
+    enabled_level_.store(enabled_level_for(level), std::memory_order_relaxed);
+    initialized_.store(true, std::memory_order_release);
+    CallsiteRegistry::Global().set_logger_level(this, enabled_level_for(level));
+
     return absl::OkStatus();
   } catch (const std::exception& e) {
     return absl::InternalError(absl::StrFormat("Failed to initialize spdlog: %s", e.what()));
@@ -63,71 +265,148 @@ absl::Status SpdlogBackend::init(const std::string& name, LogLevel level) {
 }
 
 absl::Status SpdlogBackend::set_level(LogLevel level) {
-  if (!initialized_) {
+  if (!initialized_.load(std::memory_order_acquire)) {
     return absl::FailedPreconditionError("Logger not initialized");
   }
 
-  try {
-    logger_->set_level(ToSpdlogLevel(level));
-    current_level_ = level;
-    return absl::OkStatus();
-  } catch (const std::exception& e) {
-    return absl::InternalError(absl::StrFormat("Failed to set log level: %s", e.what()));
-  }
+  current_level_.store(level, std::memory_order_relaxed);
+  enabled_level_.store(enabled_level_for(level), std::memory_order_relaxed);
+  CallsiteRegistry::Global().set_logger_level(this, enabled_level_for(level));
+  return absl::OkStatus();
 }
 
 LogLevel SpdlogBackend::get_level() const {
-  return current_level_;
+  return current_level_.load(std::memory_order_relaxed);
 }
 
-bool SpdlogBackend::is_enabled(LogLevel level) const {
-  if (!initialized_) {
-    return false;
+void SpdlogBackend::write(LogLevel level, const Callsite* callsite,
+                          LoggerId logger_id, RecordTime time,
+                          absl::string_view msg) {
+  try {
+    if (capture_ != nullptr) {
+      capture_->record_plain(level, callsite, logger_id, msg.size());
+    }
+    if (use_async(level)) {
+      if (deferred_writer_ != nullptr) {
+        if (deferred_writer_->log(callsite, logger_id, level, time, "{}",
+                                  msg)) {
+          return;
+        }
+      } else {
+        async_writer_->enqueue(level, msg, callsite, logger_id, time);
+        return;
+      }
+    }
+    write_sync(level, callsite, logger_id, time, msg);
+  } catch (...) {
+    // 静默处理日志错误，避免异常传播
   }
-  return IsLogLevelEnabled(current_level_, level);
 }
 
-void SpdlogBackend::log(LogLevel level, absl::string_view msg) {
-  if (!initialized_ || !is_enabled(level)) {
-    return;
+bool SpdlogBackend::fold_duplicate(const Callsite* callsite,
+                                   LoggerId logger_id, uint64_t args_hash) {
+  DedupRun finished;
+  if (dedup_->admit(callsite, logger_id, args_hash, &finished)) {
+    return true;
   }
-
-  try {
-    logger_->log(ToSpdlogLevel(level), msg);
-  } catch (...) {
-    // 静默处理日志错误，避免异常传播
+  if (finished.repeats != 0) {
+    write_dedup_summary(finished);
   }
+  return false;
 }
 
+void SpdlogBackend::write_dedup_summary(const DedupRun& run) {
+  write(run.callsite->level(), run.callsite, run.logger_id, RecordTime::Now(),
+        FormatDedupSummary(run));
+}
+
+void SpdlogBackend::write_sync(LogLevel level, const Callsite* callsite,
+                               LoggerId logger_id, RecordTime time,
+                               absl::string_view msg) {
+  // 直接写入 sinks：时间戳来自记录而不是 spdlog 读取的系统时钟，
+  // 命名日志器的记录带上自己的名字
+  absl::string_view name = LoggerNameOr(logger_id, logger_->name());
+  spdlog::details::log_msg record(
+      internal::ToLogTime(time), internal::ToSourceLoc(callsite),
+      spdlog::string_view_t(name.data(), name.size()), ToSpdlogLevel(level),
+      spdlog::string_view_t(msg.data(), msg.size()));
+  internal::DispatchToSinks(logger_->sinks(), record);
+}
 
 void SpdlogBackend::flush() {
-  if (!initialized_) {
+  if (!initialized_.load(std::memory_order_acquire)) {
     return;
   }
 
   try {
+    DedupRun run;
+    while (dedup_ != nullptr && dedup_->take(&run)) {
+      write_dedup_summary(run);
+    }
+    if (async_writer_) {
+      async_writer_->flush();
+    }
+    if (deferred_writer_) {
+      deferred_writer_->flush();
+    }
     logger_->flush();
+    if (capture_) {
+      capture_->flush().IgnoreError();
+    }
   } catch (...) {
     // 静默处理日志错误，避免异常传播
   }
 }
 
 void SpdlogBackend::shutdown() {
-  if (!initialized_) {
+  if (!initialized_.load(std::memory_order_acquire)) {
     return;
   }
 
   try {
+    initialized_.store(false, std::memory_order_release);
+    CallsiteRegistry::Global().remove_logger(this);
+    DedupRun run;
+    if (dedup_ != nullptr) {
+      // 先停定时线程，之后不会再有汇总写入即将停止的写线程
+      dedup_->stop();
+      while (dedup_->take(&run)) {
+        write_dedup_summary(run);
+      }
+    }
+    if (async_writer_) {
+      async_writer_->stop();
+    }
+    if (deferred_writer_) {
+      deferred_writer_->stop();
+    }
     if (logger_) {
       logger_->flush();
       spdlog::drop(logger_->name());
     }
-    initialized_ = false;
+    if (capture_) {
+      // 只关闭文件不释放对象，与 shutdown 并发的调用不会访问已释放内存
+      capture_->close().IgnoreError();
+    }
   } catch (...) {
     // 静默处理日志错误，避免异常传播
   }
 }
 
+uint64_t SpdlogBackend::console_dropped() const {
+  return console_sink_ != nullptr ? console_sink_->dropped() : 0;
+}
+
+AsyncStats SpdlogBackend::async_stats() const {
+  if (async_writer_) {
+    return async_writer_->stats();
+  }
+  if (deferred_writer_) {
+    return deferred_writer_->stats();
+  }
+  return AsyncStats();
+}
+
 spdlog::level::level_enum SpdlogBackend::ToSpdlogLevel(LogLevel level) {
   switch (level) {
     case LogLevel::kTrace:
@@ -0,0 +1,215 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/structured.h"
+
+#include <algorithm>
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+template<typename V>
+bool ReadValue(const char*& cursor, const char* end, V& value) {
+  if (static_cast<size_t>(end - cursor) < sizeof(V)) {
+    return false;
+  }
+  std::memcpy(&value, cursor, sizeof(V));
+  cursor += sizeof(V);
+  return true;
+}
+
+bool ReadString(const char*& cursor, const char* end, absl::string_view& value) {
+  uint32_t size = 0;
+  if (!ReadValue(cursor, end, size) ||
+      static_cast<size_t>(end - cursor) < size) {
+    return false;
+  }
+  value = absl::string_view(cursor, size);
+  cursor += size;
+  return true;
+}
+
+bool ReadField(const char*& cursor, const char* end, StructuredField& field) {
+  if (!ReadString(cursor, end, field.key) || cursor >= end) {
+    return false;
+  }
+  field.type = static_cast<ArgType>(*cursor++);
+  switch (field.type) {
+    case ArgType::kBool: {
+      uint8_t value = 0;
+      if (!ReadValue(cursor, end, value)) {
+        return false;
+      }
+      field.int_value = value != 0;
+      return true;
+    }
+    case ArgType::kChar: {
+      char value = 0;
+      if (!ReadValue(cursor, end, value)) {
+        return false;
+      }
+      field.int_value = value;
+      return true;
+    }
+    case ArgType::kInt32: {
+      int32_t value = 0;
+      if (!ReadValue(cursor, end, value)) {
+        return false;
+      }
+      field.int_value = value;
+      return true;
+    }
+    case ArgType::kInt64:
+      return ReadValue(cursor, end, field.int_value);
+    case ArgType::kUInt32: {
+      uint32_t value = 0;
+      if (!ReadValue(cursor, end, value)) {
+        return false;
+      }
+      field.uint_value = value;
+      return true;
+    }
+    case ArgType::kUInt64:
+    case ArgType::kPointer:
+      return ReadValue(cursor, end, field.uint_value);
+    case ArgType::kFloat: {
+      float value = 0;
+      if (!ReadValue(cursor, end, value)) {
+        return false;
+      }
+      field.double_value = value;
+      return true;
+    }
+    case ArgType::kDouble:
+      return ReadValue(cursor, end, field.double_value);
+    case ArgType::kString:
+      return ReadString(cursor, end, field.text);
+  }
+  return false;
+}
+
+// 文本形式中字符串值是否需要加引号
+bool NeedsQuote(absl::string_view text) {
+  if (text.empty()) {
+    return true;
+  }
+  for (char c : text) {
+    if (c == ' ' || c == '"' || c == '=' || static_cast<unsigned char>(c) < 0x20) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template<typename OutputIt>
+OutputIt CopyText(absl::string_view text, OutputIt out) {
+  return std::copy(text.begin(), text.end(), out);
+}
+
+}  // anonymous namespace
+
+bool ParseStructured(absl::string_view payload, StructuredRecord* record) {
+  if (!IsStructuredPayload(payload)) {
+    return false;
+  }
+  const char* cursor = payload.data() + kStructuredMagicSize;
+  const char* end = payload.data() + payload.size();
+  uint32_t count = 0;
+  if (!ReadString(cursor, end, record->event) ||
+      !ReadValue(cursor, end, count)) {
+    return false;
+  }
+  // 每个字段至少 6 字节，防止损坏的计数导致过量分配
+  if (count > static_cast<size_t>(end - cursor) / 6) {
+    return false;
+  }
+  record->fields.resize(count);
+  for (StructuredField& field : record->fields) {
+    if (!ReadField(cursor, end, field)) {
+      return false;
+    }
+  }
+  return cursor == end;
+}
+
+void AppendStructuredField(const StructuredField& field, fmt::appender out) {
+  out = CopyText(field.key, out);
+  *out++ = '=';
+  switch (field.type) {
+    case ArgType::kBool:
+      out = CopyText(field.int_value != 0 ? "true" : "false", out);
+      break;
+    case ArgType::kChar:
+      *out++ = static_cast<char>(field.int_value);
+      break;
+    case ArgType::kInt32:
+    case ArgType::kInt64:
+      out = fmt::format_to(out, FMT_COMPILE("{}"), field.int_value);
+      break;
+    case ArgType::kUInt32:
+    case ArgType::kUInt64:
+      out = fmt::format_to(out, FMT_COMPILE("{}"), field.uint_value);
+      break;
+    case ArgType::kPointer:
+      out = fmt::format_to(out, FMT_COMPILE("{:#x}"), field.uint_value);
+      break;
+    case ArgType::kFloat:
+      // 按 float 输出最短表示，避免 0.1f 显示为 0.10000000149011612
+      out = fmt::format_to(out, FMT_COMPILE("{}"),
+                           static_cast<float>(field.double_value));
+      break;
+    case ArgType::kDouble:
+      out = fmt::format_to(out, FMT_COMPILE("{}"), field.double_value);
+      break;
+    case ArgType::kString:
+      if (!NeedsQuote(field.text)) {
+        out = CopyText(field.text, out);
+        break;
+      }
+      *out++ = '"';
+      for (char c : field.text) {
+        if (c == '"' || c == '\\') {
+          *out++ = '\\';
+        }
+        *out++ = c;
+      }
+      *out++ = '"';
+      break;
+  }
+}
+
+void AppendStructuredText(const StructuredRecord& record, fmt::appender out) {
+  out = CopyText(record.event, out);
+  for (const StructuredField& field : record.fields) {
+    *out++ = ' ';
+    AppendStructuredField(field, out);
+  }
+}
+
+absl::string_view StructuredPayloadText(absl::string_view payload) {
+  thread_local StructuredRecord record;
+  thread_local fmt::memory_buffer text;
+  if (!ParseStructured(payload, &record)) {
+    return payload;
+  }
+  text.clear();
+  AppendStructuredText(record, fmt::appender(text));
+  return absl::string_view(text.data(), text.size());
+}
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,128 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/tsc_clock.h"
+#include <cmath>
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+// 初始校准的采样时长，之后随锚点基线增长逐步精确
+constexpr auto kInitialCalibration = std::chrono::milliseconds(2);
+
+int64_t WallNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // anonymous namespace
+
+TscClock& TscClock::Global() {
+  // 故意泄漏，保证进程退出阶段的日志调用仍可安全访问
+  static TscClock* clock = new TscClock();
+  return *clock;
+}
+
+TscClock::TscClock() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ReadPair(&anchor_ticks_, &anchor_nanos_);
+  double nanos_per_tick = 1.0;
+  if (kUsesTsc) {
+    // 短暂自旋得到初始频率
+    uint64_t ticks;
+    int64_t nanos;
+    do {
+      ReadPair(&ticks, &nanos);
+    } while (nanos - anchor_nanos_ <
+             std::chrono::nanoseconds(kInitialCalibration).count());
+    if (ticks > anchor_ticks_) {
+      nanos_per_tick = static_cast<double>(nanos - anchor_nanos_) /
+                       static_cast<double>(ticks - anchor_ticks_);
+    }
+  }
+  publish_locked(anchor_ticks_, anchor_nanos_, nanos_per_tick);
+}
+
+void TscClock::ReadPair(uint64_t* ticks, int64_t* unix_nanos) {
+  uint64_t before = ReadTicks();
+  *unix_nanos = WallNanos();
+  uint64_t after = ReadTicks();
+  *ticks = before + (after - before) / 2;
+}
+
+int64_t TscClock::to_unix_nanos(uint64_t ticks) {
+  if (ticks >= next_calibration_ticks_.load(std::memory_order_relaxed)) {
+    calibrate();
+  }
+  return convert(ticks);
+}
+
+void TscClock::calibrate() {
+  // 多个写线程同时到期时只需一个完成校准
+  std::unique_lock<std::mutex> lock(mutex_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    return;
+  }
+  uint64_t ticks;
+  int64_t nanos;
+  ReadPair(&ticks, &nanos);
+  double nanos_per_tick = 1.0;
+  if (kUsesTsc && ticks > anchor_ticks_ && nanos > anchor_nanos_) {
+    nanos_per_tick = static_cast<double>(nanos - anchor_nanos_) /
+                     static_cast<double>(ticks - anchor_ticks_);
+  }
+  publish_locked(ticks, nanos, nanos_per_tick);
+}
+
+int64_t TscClock::convert(uint64_t ticks) const {
+  uint64_t base_ticks;
+  int64_t base_nanos;
+  double nanos_per_tick;
+  uint32_t sequence;
+  do {
+    sequence = sequence_.load(std::memory_order_acquire);
+    base_ticks = base_ticks_.load(std::memory_order_relaxed);
+    base_nanos = base_nanos_.load(std::memory_order_relaxed);
+    nanos_per_tick = nanos_per_tick_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((sequence & 1) != 0 ||
+           sequence != sequence_.load(std::memory_order_relaxed));
+
+  // 早于基准点的计数（校准后才写出的旧记录）得到负差值
+  double delta = static_cast<double>(static_cast<int64_t>(ticks - base_ticks));
+  return base_nanos + std::llround(delta * nanos_per_tick);
+}
+
+void TscClock::publish_locked(uint64_t base_ticks, int64_t base_nanos,
+                              double nanos_per_tick) {
+  uint32_t sequence = sequence_.load(std::memory_order_relaxed);
+  sequence_.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  base_ticks_.store(base_ticks, std::memory_order_relaxed);
+  base_nanos_.store(base_nanos, std::memory_order_relaxed);
+  nanos_per_tick_.store(nanos_per_tick, std::memory_order_relaxed);
+  sequence_.store(sequence + 2, std::memory_order_release);
+
+  uint64_t interval = static_cast<uint64_t>(
+      static_cast<double>(kCalibrationInterval.count()) / nanos_per_tick);
+  next_calibration_ticks_.store(base_ticks + interval,
+                                std::memory_order_relaxed);
+}
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,377 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/workload_capture.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <absl/strings/str_format.h>
+#include "qxcore/log/binary_log.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+using capture_format::RecordType;
+
+void PutFixed32(std::string& out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out.push_back(static_cast<char>(value >> (8 * i)));
+  }
+}
+
+uint32_t GetFixed32(const char* src) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value |= static_cast<uint32_t>(static_cast<uint8_t>(src[i])) << (8 * i);
+  }
+  return value;
+}
+
+void PutBytes(std::string& out, absl::string_view bytes) {
+  internal::PutVarint(out, bytes.size());
+  out.append(bytes.data(), bytes.size());
+}
+
+int64_t SteadyNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// 采集文件的顺序读取游标，数据不足时返回 false
+class Cursor {
+ public:
+  Cursor(const char* data, size_t size) : cursor_(data), end_(data + size) {}
+
+  bool done() const { return cursor_ == end_; }
+
+  bool varint(uint64_t& value) {
+    return internal::GetVarint(cursor_, end_, value);
+  }
+
+  bool byte(uint8_t& value) {
+    if (cursor_ == end_) {
+      return false;
+    }
+    value = static_cast<uint8_t>(*cursor_++);
+    return true;
+  }
+
+  bool bytes(std::string& value) {
+    uint64_t size;
+    if (!varint(size) || size > static_cast<uint64_t>(end_ - cursor_)) {
+      return false;
+    }
+    value.assign(cursor_, static_cast<size_t>(size));
+    cursor_ += size;
+    return true;
+  }
+
+ private:
+  const char* cursor_;
+  const char* end_;
+};
+
+}  // anonymous namespace
+
+WorkloadCapture::WorkloadCapture(size_t buffer_size)
+    : buffer_size_(buffer_size) {
+  buffer_.reserve(buffer_size_ + 256);
+}
+
+WorkloadCapture::~WorkloadCapture() {
+  close().IgnoreError();
+}
+
+absl::Status WorkloadCapture::open(const std::string& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file_ != nullptr) {
+    return absl::AlreadyExistsError("Workload capture already opened");
+  }
+  file_ = std::fopen(path.c_str(), "wb");
+  if (file_ == nullptr) {
+    return absl::InternalError(absl::StrFormat(
+        "Failed to open workload capture %s: %s", path, std::strerror(errno)));
+  }
+  PutFixed32(buffer_, capture_format::kFileMagic);
+  PutFixed32(buffer_, capture_format::kVersion);
+  last_time_ns_ = SteadyNanos();
+  return absl::OkStatus();
+}
+
+void WorkloadCapture::record_plain(LogLevel level, const Callsite* callsite,
+                                   LoggerId logger_id, size_t message_size) {
+  CapturedArg message{ArgType::kString, static_cast<uint32_t>(message_size)};
+  append(level, callsite, logger_id, absl::string_view(), true,
+         absl::MakeConstSpan(&message, 1));
+}
+
+void WorkloadCapture::append(LogLevel level, const Callsite* callsite,
+                             LoggerId logger_id, absl::string_view format,
+                             bool plain, absl::Span<const CapturedArg> args) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file_ == nullptr || !status_.ok()) {
+    return;
+  }
+  // 时间在锁内读取，事件按到达顺序单调
+  int64_t now = SteadyNanos();
+  int64_t delta = events_ == 0 ? 0 : std::max<int64_t>(now - last_time_ns_, 0);
+  last_time_ns_ = now;
+
+  uint32_t site = site_id(callsite, format, plain);
+  uint32_t logger = logger_index(logger_id);
+  uint32_t thread = thread_index();
+
+  buffer_.push_back(static_cast<char>(RecordType::kEvent));
+  internal::PutVarint(buffer_, static_cast<uint64_t>(delta));
+  buffer_.push_back(static_cast<char>(LogLevelToInt(level)));
+  internal::PutVarint(buffer_, site);
+  internal::PutVarint(buffer_, logger);
+  internal::PutVarint(buffer_, thread);
+  internal::PutVarint(buffer_, args.size());
+  for (const CapturedArg& arg : args) {
+    buffer_.push_back(static_cast<char>(arg.type));
+    internal::PutVarint(buffer_, arg.size);
+  }
+  ++events_;
+
+  if (buffer_.size() >= buffer_size_) {
+    write_buffer();
+  }
+}
+
+uint32_t WorkloadCapture::site_id(const Callsite* callsite,
+                                  absl::string_view format, bool plain) {
+  uint32_t* slot;
+  if (callsite != nullptr) {
+    slot = &callsite_sites_[callsite];
+  } else if (plain) {
+    slot = &plain_site_;
+  } else {
+    auto it = format_sites_.find(format);
+    slot = it != format_sites_.end()
+               ? &it->second
+               : &format_sites_.emplace(std::string(format), 0).first->second;
+  }
+  // 槽位保存 ID + 1，0 表示尚未定义
+  if (*slot != 0) {
+    return *slot - 1;
+  }
+  uint32_t id = next_site_++;
+  *slot = id + 1;
+
+  buffer_.push_back(static_cast<char>(RecordType::kSiteDef));
+  internal::PutVarint(buffer_, id);
+  buffer_.push_back(static_cast<char>(plain ? capture_format::kPlainSite : 0));
+  internal::PutVarint(buffer_,
+                      callsite != nullptr
+                          ? static_cast<uint64_t>(std::max(callsite->line(), 0))
+                          : 0);
+  PutBytes(buffer_, callsite != nullptr && callsite->file() != nullptr
+                        ? absl::string_view(callsite->file())
+                        : absl::string_view());
+  PutBytes(buffer_, format);
+  return id;
+}
+
+uint32_t WorkloadCapture::logger_index(LoggerId logger_id) {
+  if (logger_id == kNoLoggerId) {
+    return 0;
+  }
+  auto it = loggers_.find(logger_id);
+  if (it != loggers_.end()) {
+    return it->second;
+  }
+  uint32_t index = static_cast<uint32_t>(loggers_.size()) + 1;
+  loggers_.emplace(logger_id, index);
+  buffer_.push_back(static_cast<char>(RecordType::kLoggerDef));
+  internal::PutVarint(buffer_, index);
+  PutBytes(buffer_, LoggerRegistry::Global().name(logger_id));
+  return index;
+}
+
+uint32_t WorkloadCapture::thread_index() {
+  auto result = threads_.emplace(std::this_thread::get_id(),
+                                 static_cast<uint32_t>(threads_.size()));
+  return result.first->second;
+}
+
+void WorkloadCapture::write_buffer() {
+  if (buffer_.empty()) {
+    return;
+  }
+  if (std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size()) {
+    status_ = absl::InternalError(absl::StrFormat(
+        "Failed to write workload capture: %s", std::strerror(errno)));
+  }
+  buffer_.clear();
+}
+
+absl::Status WorkloadCapture::flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file_ == nullptr) {
+    return absl::FailedPreconditionError("Workload capture not opened");
+  }
+  write_buffer();
+  if (status_.ok() && std::fflush(file_) != 0) {
+    status_ = absl::InternalError(absl::StrFormat(
+        "Failed to flush workload capture: %s", std::strerror(errno)));
+  }
+  return status_;
+}
+
+absl::Status WorkloadCapture::close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (file_ == nullptr) {
+    return absl::OkStatus();
+  }
+  if (status_.ok()) {
+    write_buffer();
+  }
+  if (std::fclose(file_) != 0 && status_.ok()) {
+    status_ = absl::InternalError(absl::StrFormat(
+        "Failed to close workload capture: %s", std::strerror(errno)));
+  }
+  file_ = nullptr;
+  absl::Status status = status_;
+  status_ = absl::OkStatus();
+  return status;
+}
+
+uint64_t WorkloadCapture::events() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return events_;
+}
+
+absl::Status WorkloadTrace::load(const std::string& path) {
+  std::FILE* file = std::fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    return absl::NotFoundError(absl::StrFormat(
+        "Failed to open workload capture %s: %s", path, std::strerror(errno)));
+  }
+  std::string data;
+  char chunk[64 * 1024];
+  size_t read;
+  while ((read = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    data.append(chunk, read);
+  }
+  std::fclose(file);
+
+  if (data.size() < capture_format::kFileHeaderSize ||
+      GetFixed32(data.data()) != capture_format::kFileMagic) {
+    return absl::DataLossError(
+        absl::StrFormat("%s is not a workload capture file", path));
+  }
+  if (GetFixed32(data.data() + 4) != capture_format::kVersion) {
+    return absl::DataLossError(absl::StrFormat(
+        "Unsupported workload capture version %d", GetFixed32(data.data() + 4)));
+  }
+
+  sites_.clear();
+  loggers_.assign(1, std::string());
+  events_.clear();
+  args_.clear();
+  thread_count_ = 0;
+
+  Cursor cursor(data.data() + capture_format::kFileHeaderSize,
+                data.size() - capture_format::kFileHeaderSize);
+  int64_t time_ns = 0;
+  while (!cursor.done()) {
+    uint8_t type;
+    cursor.byte(type);
+    // 任一字段读不完整即为尾部截断，丢弃该记录后正常结束
+    switch (static_cast<RecordType>(type)) {
+      case RecordType::kSiteDef: {
+        uint64_t id;
+        uint8_t flags;
+        uint64_t line;
+        CapturedSite site;
+        if (!cursor.varint(id) || !cursor.byte(flags) || !cursor.varint(line) ||
+            !cursor.bytes(site.file) || !cursor.bytes(site.format)) {
+          return absl::OkStatus();
+        }
+        if (id != sites_.size()) {
+          return absl::DataLossError("Workload capture site ids out of order");
+        }
+        site.line = static_cast<int>(line);
+        site.plain = (flags & capture_format::kPlainSite) != 0;
+        sites_.push_back(std::move(site));
+        break;
+      }
+      case RecordType::kLoggerDef: {
+        uint64_t id;
+        std::string name;
+        if (!cursor.varint(id) || !cursor.bytes(name)) {
+          return absl::OkStatus();
+        }
+        if (id != loggers_.size()) {
+          return absl::DataLossError("Workload capture logger ids out of order");
+        }
+        loggers_.push_back(std::move(name));
+        break;
+      }
+      case RecordType::kEvent: {
+        uint64_t delta;
+        uint8_t level;
+        uint64_t site;
+        uint64_t logger;
+        uint64_t thread;
+        uint64_t count;
+        if (!cursor.varint(delta) || !cursor.byte(level) ||
+            !cursor.varint(site) || !cursor.varint(logger) ||
+            !cursor.varint(thread) || !cursor.varint(count)) {
+          return absl::OkStatus();
+        }
+        if (site >= sites_.size() || logger >= loggers_.size() ||
+            level > LogLevelToInt(LogLevel::kCritical) || count > 255) {
+          return absl::DataLossError("Corrupted workload capture event");
+        }
+        size_t first_arg = args_.size();
+        for (uint64_t i = 0; i < count; ++i) {
+          uint8_t arg_type;
+          uint64_t size;
+          if (!cursor.byte(arg_type) || !cursor.varint(size)) {
+            args_.resize(first_arg);
+            return absl::OkStatus();
+          }
+          args_.push_back(CapturedArg{static_cast<ArgType>(arg_type),
+                                      static_cast<uint32_t>(size)});
+        }
+        time_ns += static_cast<int64_t>(delta);
+        CapturedEvent event;
+        event.time_ns = time_ns;
+        event.level = static_cast<LogLevel>(level);
+        event.site = static_cast<uint32_t>(site);
+        event.logger = static_cast<uint32_t>(logger);
+        event.thread = static_cast<uint32_t>(thread);
+        event.first_arg = static_cast<uint32_t>(first_arg);
+        event.arg_count = static_cast<uint32_t>(count);
+        events_.push_back(event);
+        thread_count_ = std::max(thread_count_, event.thread + 1);
+        break;
+      }
+      default:
+        return absl::DataLossError(absl::StrFormat(
+            "Unknown workload capture record type %d", type));
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,207 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+// 稳态日志路径的堆分配检查
+//
+// 本文件替换了全局 operator new 并插桩 malloc/calloc/realloc，只统计
+// 当前线程在计数窗口内的分配次数。插桩依赖 glibc 的 __libc_* 入口。
+
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <gtest/gtest.h>
+#include "qxcore/log/log.h"
+#include "qxcore/log/named_logger.h"
+#ifdef QXCORE_ENABLE_LOG_GLOG
+#include "qxcore/log/glog_backend.h"
+#endif
+
+#ifdef __GLIBC__
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+}
+
+namespace {
+
+thread_local bool t_counting = false;
+thread_local size_t t_allocations = 0;
+
+inline void CountAllocation() {
+  if (t_counting) {
+    ++t_allocations;
+  }
+}
+
+void* AllocateOrThrow(size_t size) {
+  CountAllocation();
+  void* ptr = __libc_malloc(size == 0 ? 1 : size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+}  // anonymous namespace
+
+extern "C" void* malloc(size_t size) noexcept {
+  CountAllocation();
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size) noexcept {
+  CountAllocation();
+  return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size) noexcept {
+  CountAllocation();
+  return __libc_realloc(ptr, size);
+}
+
+void* operator new(size_t size) { return AllocateOrThrow(size); }
+void* operator new[](size_t size) { return AllocateOrThrow(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+// 统计 fn 在当前线程上产生的分配次数
+template<typename Fn>
+size_t CountAllocations(Fn&& fn) {
+  t_allocations = 0;
+  t_counting = true;
+  fn();
+  t_counting = false;
+  return t_allocations;
+}
+
+// 与 log_benchmark.cc 相同的消息长度
+const std::string& SmallMessage() {
+  static const std::string* msg = new std::string(50, 'x');
+  return *msg;
+}
+
+const std::string& MediumMessage() {
+  static const std::string* msg = new std::string(500, 'x');
+  return *msg;
+}
+
+const std::string& LargeMessage() {
+  static const std::string* msg = new std::string(5000, 'x');
+  return *msg;
+}
+
+template<typename Logger>
+void LogBenchmarkMessages(Logger& logger) {
+  logger.info("Benchmark test message");
+  logger.info("Benchmark test message with number: {}", 42);
+  logger.info(QXLOG_FMT("Benchmark test message with number: {}"), 42);
+  logger.info("{}", SmallMessage());
+  logger.info("{}", MediumMessage());
+  logger.info("{}", LargeMessage());
+  logger.debug("This message should be filtered out");
+}
+
+}  // anonymous namespace
+
+TEST(AllocationTest, CounterSeesAllocations) {
+  size_t count = CountAllocations([] {
+    std::string* value = new std::string(100, 'x');
+    delete value;
+    void* raw = std::malloc(16);
+    std::free(raw);
+  });
+  EXPECT_GE(count, 3u);
+}
+
+TEST(AllocationTest, StringToLogLevelDoesNotAllocate) {
+  LogLevel level = LogLevel::kInfo;
+  size_t count = CountAllocations([&] {
+    EXPECT_TRUE(StringToLogLevel("WARNING", level));
+    EXPECT_TRUE(StringToLogLevel("Critical", level));
+    EXPECT_FALSE(StringToLogLevel("verbose", level));
+  });
+  EXPECT_EQ(count, 0u);
+  EXPECT_EQ(level, LogLevel::kCritical);
+}
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+TEST(AllocationTest, SpdlogSteadyStateDoesNotAllocate) {
+  Log<SpdlogBackend> logger;
+  ASSERT_TRUE(logger.init("allocation_spdlog_test", LogLevel::kInfo).ok());
+
+  auto log_all = [&] {
+    LogBenchmarkMessages(logger);
+    QXLOG_INFO(logger, "macro {} {}", 1, 2.5);
+    QXLOG_DEBUG(logger, "disabled macro {}", 3);
+  };
+  log_all();  // 预热：线程缓冲区、调用点注册、控制台缓冲
+  EXPECT_EQ(CountAllocations(log_all), 0u);
+}
+
+TEST(AllocationTest, NamedLoggerSteadyStateDoesNotAllocate) {
+  ASSERT_TRUE(InitDefaultLogger("allocation_named_test", LogLevel::kInfo).ok());
+  EpochGuard guard;
+  NamedLogger logger = GetLogger("test.allocation");
+
+  auto log_all = [&] {
+    LogBenchmarkMessages(logger);
+    QXLOG_INFO(logger, "macro {}", 1);
+  };
+  log_all();
+  EXPECT_EQ(CountAllocations(log_all), 0u);
+}
+
+TEST(AllocationTest, DeferredProducerDoesNotAllocate) {
+  LogOptions options;
+  options.mode = LogMode::kDeferred;
+  Log<SpdlogBackend> logger;
+  ASSERT_TRUE(
+      logger.init("allocation_deferred_test", LogLevel::kInfo, options).ok());
+
+  auto log_all = [&] { LogBenchmarkMessages(logger); };
+  log_all();
+  logger.flush();
+  EXPECT_EQ(CountAllocations(log_all), 0u);
+  logger.flush();
+}
+#endif  // QXCORE_ENABLE_LOG_SPDLOG
+
+#ifdef QXCORE_ENABLE_LOG_GLOG
+TEST(AllocationTest, GlogSteadyStateDoesNotAllocate) {
+  Log<GlogBackend> logger;
+  ASSERT_TRUE(logger.init("allocation_glog_test", LogLevel::kInfo).ok());
+
+  auto log_all = [&] {
+    LogBenchmarkMessages(logger);
+    QXLOG_INFO(logger, "macro {}", 1);
+  };
+  log_all();
+  EXPECT_EQ(CountAllocations(log_all), 0u);
+}
+#endif  // QXCORE_ENABLE_LOG_GLOG
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // __GLIBC__
@@ -0,0 +1,249 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+
+#include "qxcore/log/async_writer.h"
+#include <gtest/gtest.h>
+#include <absl/strings/str_cat.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/sinks/base_sink.h>
+#include "qxcore/log/bounded_queue.h"
+#include "qxcore/log/spdlog_backend.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+// 可以阻塞写线程的测试 sink，用于制造队列积压
+class GatedSink : public spdlog::sinks::base_sink<std::mutex> {
+ public:
+  void close_gate() {
+    std::lock_guard<std::mutex> lock(gate_mutex_);
+    gate_open_ = false;
+  }
+
+  void open_gate() {
+    {
+      std::lock_guard<std::mutex> lock(gate_mutex_);
+      gate_open_ = true;
+    }
+    gate_cv_.notify_all();
+  }
+
+  std::vector<std::string> messages() {
+    std::lock_guard<std::mutex> lock(gate_mutex_);
+    return messages_;
+  }
+
+ protected:
+  void sink_it_(const spdlog::details::log_msg& msg) override {
+    std::unique_lock<std::mutex> lock(gate_mutex_);
+    gate_cv_.wait(lock, [this] { return gate_open_; });
+    messages_.emplace_back(msg.payload.data(), msg.payload.size());
+  }
+
+  void flush_() override {}
+
+ private:
+  std::mutex gate_mutex_;
+  std::condition_variable gate_cv_;
+  bool gate_open_ = true;
+  std::vector<std::string> messages_;
+};
+
+AsyncOptions MakeOptions(size_t capacity, OverflowPolicy policy) {
+  AsyncOptions options;
+  options.queue_capacity = capacity;
+  options.inline_message_size = 16;
+  options.overflow_policy = policy;
+  return options;
+}
+
+}  // anonymous namespace
+
+TEST(BoundedQueueTest, FifoOrderAndCapacity) {
+  BoundedQueue<int> queue(3);
+  EXPECT_EQ(queue.capacity(), 4u);
+
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(queue.try_push([i](int& slot) { slot = i; }));
+  }
+  EXPECT_FALSE(queue.try_push([](int& slot) { slot = 100; }));
+  EXPECT_EQ(queue.size_approx(), 4u);
+
+  for (int i = 0; i < 4; ++i) {
+    int value = -1;
+    EXPECT_TRUE(queue.try_pop([&value](int& slot) { value = slot; }));
+    EXPECT_EQ(value, i);
+  }
+  EXPECT_FALSE(queue.try_pop([](int&) {}));
+}
+
+TEST(AsyncWriterTest, InvalidOptions) {
+  AsyncOptions options;
+  options.queue_capacity = 0;
+  EXPECT_EQ(AsyncWriter::ValidateOptions(options).code(),
+            absl::StatusCode::kInvalidArgument);
+
+  options = AsyncOptions();
+  options.inline_message_size = 0;
+  EXPECT_EQ(AsyncWriter::ValidateOptions(options).code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
+TEST(AsyncWriterTest, DeliversInOrderIncludingSpilledMessages) {
+  auto sink = std::make_shared<GatedSink>();
+  AsyncWriter writer("async_test", {sink},
+                     MakeOptions(8, OverflowPolicy::kBlock));
+  ASSERT_TRUE(writer.start().ok());
+
+  std::string long_message(100, 'x');
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_TRUE(writer.enqueue(LogLevel::kInfo, absl::StrCat("msg ", i)));
+  }
+  EXPECT_TRUE(writer.enqueue(LogLevel::kWarn, long_message));
+  writer.flush();
+
+  std::vector<std::string> messages = sink->messages();
+  ASSERT_EQ(messages.size(), 51u);
+  for (int i = 0; i < 50; ++i) {
+    EXPECT_EQ(messages[i], absl::StrCat("msg ", i));
+  }
+  EXPECT_EQ(messages[50], long_message);
+  EXPECT_EQ(writer.stats().dropped(), 0u);
+  EXPECT_EQ(writer.stats().enqueued, 51u);
+}
+
+TEST(AsyncWriterTest, DropNewestCountsDroppedMessages) {
+  auto sink = std::make_shared<GatedSink>();
+  AsyncWriter writer("async_test", {sink},
+                     MakeOptions(4, OverflowPolicy::kDropNewest));
+  ASSERT_TRUE(writer.start().ok());
+
+  sink->close_gate();
+  constexpr int kMessages = 32;
+  int accepted = 0;
+  for (int i = 0; i < kMessages; ++i) {
+    if (writer.enqueue(LogLevel::kInfo, absl::StrCat("msg ", i))) {
+      ++accepted;
+    }
+  }
+  sink->open_gate();
+  writer.flush();
+
+  AsyncStats stats = writer.stats();
+  EXPECT_GT(stats.dropped_newest, 0u);
+  EXPECT_EQ(stats.dropped_oldest, 0u);
+  EXPECT_EQ(stats.dropped_newest + accepted, static_cast<uint64_t>(kMessages));
+  EXPECT_EQ(sink->messages().size(), static_cast<size_t>(accepted));
+  // 丢弃最新记录时，最早的记录一定被保留
+  EXPECT_EQ(sink->messages().front(), "msg 0");
+}
+
+TEST(AsyncWriterTest, DropOldestKeepsNewestMessages) {
+  auto sink = std::make_shared<GatedSink>();
+  AsyncWriter writer("async_test", {sink},
+                     MakeOptions(4, OverflowPolicy::kDropOldest));
+  ASSERT_TRUE(writer.start().ok());
+
+  sink->close_gate();
+  constexpr int kMessages = 32;
+  for (int i = 0; i < kMessages; ++i) {
+    EXPECT_TRUE(writer.enqueue(LogLevel::kInfo, absl::StrCat("msg ", i)));
+  }
+  sink->open_gate();
+  writer.flush();
+
+  AsyncStats stats = writer.stats();
+  std::vector<std::string> messages = sink->messages();
+  EXPECT_GT(stats.dropped_oldest, 0u);
+  EXPECT_EQ(stats.dropped_newest, 0u);
+  EXPECT_EQ(stats.dropped_oldest + messages.size(),
+            static_cast<uint64_t>(kMessages));
+  ASSERT_FALSE(messages.empty());
+  EXPECT_EQ(messages.back(), absl::StrCat("msg ", kMessages - 1));
+}
+
+TEST(AsyncWriterTest, BlockPolicyWaitsForSpace) {
+  auto sink = std::make_shared<GatedSink>();
+  AsyncWriter writer("async_test", {sink},
+                     MakeOptions(4, OverflowPolicy::kBlock));
+  ASSERT_TRUE(writer.start().ok());
+
+  sink->close_gate();
+  constexpr int kMessages = 32;
+  std::atomic<int> produced{0};
+  std::thread producer([&] {
+    for (int i = 0; i < kMessages; ++i) {
+      writer.enqueue(LogLevel::kInfo, absl::StrCat("msg ", i));
+      produced.fetch_add(1);
+    }
+  });
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_LT(produced.load(), kMessages);
+
+  sink->open_gate();
+  producer.join();
+  writer.flush();
+
+  EXPECT_EQ(sink->messages().size(), static_cast<size_t>(kMessages));
+  EXPECT_EQ(writer.stats().dropped(), 0u);
+}
+
+TEST(AsyncWriterTest, StopDrainsPendingRecords) {
+  auto sink = std::make_shared<GatedSink>();
+  {
+    AsyncWriter writer("async_test", {sink},
+                       MakeOptions(64, OverflowPolicy::kBlock));
+    ASSERT_TRUE(writer.start().ok());
+    for (int i = 0; i < 20; ++i) {
+      writer.enqueue(LogLevel::kInfo, absl::StrCat("msg ", i));
+    }
+    writer.stop();
+  }
+  EXPECT_EQ(sink->messages().size(), 20u);
+}
+
+TEST(AsyncWriterTest, SpdlogBackendAsyncModeWithBypass) {
+  SpdlogBackend backend;
+  LogOptions options;
+  options.mode = LogMode::kAsync;
+  options.async.bypass_level = LogLevel::kError;
+  ASSERT_TRUE(backend.init("test_async_spdlog", LogLevel::kInfo, options).ok());
+  EXPECT_TRUE(backend.is_async());
+
+  backend.logf(LogLevel::kInfo, "async message {}", 1);
+  backend.log(LogLevel::kWarn, "async warning");
+  backend.logf(LogLevel::kError, "bypassed error {}", 2);
+  backend.flush();
+
+  AsyncStats stats = backend.async_stats();
+  EXPECT_EQ(stats.enqueued, 2u);
+  EXPECT_EQ(stats.dropped(), 0u);
+  backend.shutdown();
+}
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_ENABLE_LOG_SPDLOG
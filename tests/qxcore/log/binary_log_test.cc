@@ -0,0 +1,228 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/binary_log.h"
+#include <gtest/gtest.h>
+#include <absl/strings/str_cat.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "qxcore/log/format_registry.h"
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+#include <spdlog/sinks/base_sink.h>
+#include "qxcore/log/binary_sink.h"
+#include "qxcore/log/deferred_writer.h"
+#endif
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+std::string TestPath(const std::string& name) {
+  return testing::TempDir() + name;
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string& path, const std::string& content) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(content.data(), content.size());
+}
+
+template<typename... Args>
+absl::Status AppendEvent(BinaryLogWriter& writer, int64_t time_ns,
+                         absl::string_view format, const Args&... args) {
+  std::string encoded(EncodedArgsSize(args...), '\0');
+  EncodeArgs(&encoded[0], args...);
+
+  RawLogRecord record;
+  record.time_ns = time_ns;
+  record.level = LogLevel::kWarn;
+  record.thread_id = 7;
+  record.logger_name = "binary";
+  record.format_id = FormatRegistry::Global().intern(format);
+  record.format = format;
+  record.args = encoded.data();
+  record.args_size = encoded.size();
+  record.arg_count = sizeof...(Args);
+  return writer.append(record);
+}
+
+// 写入 count 条事件，block_size 较小时会生成多个块
+void WriteEvents(const std::string& path, int count, size_t block_size) {
+  BinaryLogWriter writer(block_size);
+  ASSERT_TRUE(writer.open(path).ok());
+  for (int i = 0; i < count; ++i) {
+    ASSERT_TRUE(AppendEvent(writer, 1700000000000000000 + i * 1000,
+                            "event {} value={:.2f} tag={} neg={}", i, i * 0.5,
+                            "abc", -i)
+                    .ok());
+  }
+  ASSERT_TRUE(writer.close().ok());
+}
+
+}  // anonymous namespace
+
+TEST(BinaryLogTest, VarintRoundTrip) {
+  std::vector<uint64_t> values = {0, 1, 127, 128, 300, uint64_t{1} << 35,
+                                  ~uint64_t{0}};
+  std::string out;
+  for (uint64_t value : values) {
+    internal::PutVarint(out, value);
+  }
+  const char* cursor = out.data();
+  for (uint64_t value : values) {
+    uint64_t decoded = 0;
+    ASSERT_TRUE(internal::GetVarint(cursor, out.data() + out.size(), decoded));
+    EXPECT_EQ(decoded, value);
+  }
+  EXPECT_EQ(cursor, out.data() + out.size());
+
+  for (int64_t value : {int64_t{0}, int64_t{-1}, int64_t{1}, int64_t{-300},
+                        std::numeric_limits<int64_t>::min()}) {
+    EXPECT_EQ(internal::ZigZagDecode(internal::ZigZagEncode(value)), value);
+  }
+}
+
+TEST(BinaryLogTest, WriteAndReadBack) {
+  std::string path = TestPath("binary_roundtrip.qxlog");
+  WriteEvents(path, 500, 1024);
+
+  BinaryLogReader reader;
+  ASSERT_TRUE(reader.open(path).ok());
+  BinaryLogEntry entry;
+  for (int i = 0; i < 500; ++i) {
+    ASSERT_TRUE(reader.next(&entry).ok()) << i;
+    EXPECT_EQ(entry.time_ns, 1700000000000000000 + i * 1000);
+    EXPECT_EQ(entry.level, LogLevel::kWarn);
+    EXPECT_EQ(entry.thread_id, 7u);
+    EXPECT_EQ(entry.logger_name, "binary");
+    EXPECT_EQ(entry.message,
+              absl::StrCat("event ", i, " value=", fmt::format("{:.2f}", i * 0.5),
+                           " tag=abc neg=", -i));
+  }
+  EXPECT_TRUE(absl::IsOutOfRange(reader.next(&entry)));
+  EXPECT_GT(reader.blocks_read(), 1u);
+  std::remove(path.c_str());
+}
+
+TEST(BinaryLogTest, AppendTextUsesPlainFormat) {
+  std::string path = TestPath("binary_text.qxlog");
+  {
+    BinaryLogWriter writer;
+    ASSERT_TRUE(writer.open(path).ok());
+    ASSERT_TRUE(writer.append_text(42, LogLevel::kError, 3, "text", "a {} b").ok());
+  }
+  BinaryLogReader reader;
+  ASSERT_TRUE(reader.open(path).ok());
+  BinaryLogEntry entry;
+  ASSERT_TRUE(reader.next(&entry).ok());
+  EXPECT_EQ(entry.message, "a {} b");
+  EXPECT_EQ(entry.level, LogLevel::kError);
+  EXPECT_EQ(entry.time_ns, 42);
+  std::remove(path.c_str());
+}
+
+TEST(BinaryLogTest, DetectsTornTail) {
+  std::string path = TestPath("binary_torn.qxlog");
+  WriteEvents(path, 200, 512);
+  std::string content = ReadFile(path);
+  WriteFile(path, content.substr(0, content.size() - 5));
+
+  BinaryLogReader reader;
+  ASSERT_TRUE(reader.open(path).ok());
+  BinaryLogEntry entry;
+  absl::Status status;
+  int read = 0;
+  while ((status = reader.next(&entry)).ok()) {
+    ++read;
+  }
+  EXPECT_TRUE(absl::IsDataLoss(status)) << status;
+  EXPECT_GT(read, 0);
+  EXPECT_LT(read, 200);
+  std::remove(path.c_str());
+}
+
+TEST(BinaryLogTest, DetectsCorruptedBlock) {
+  std::string path = TestPath("binary_corrupt.qxlog");
+  WriteEvents(path, 10, 64 * 1024);
+  std::string content = ReadFile(path);
+  content[content.size() / 2] ^= 0x5a;
+  WriteFile(path, content);
+
+  BinaryLogReader reader;
+  ASSERT_TRUE(reader.open(path).ok());
+  BinaryLogEntry entry;
+  EXPECT_TRUE(absl::IsDataLoss(reader.next(&entry)));
+  std::remove(path.c_str());
+}
+
+TEST(BinaryLogTest, SmallerThanText) {
+  std::string path = TestPath("binary_size.qxlog");
+  WriteEvents(path, 1000, 64 * 1024);
+
+  size_t text_size = 0;
+  for (int i = 0; i < 1000; ++i) {
+    // 与默认文本模式等长的前缀
+    text_size += absl::StrCat("[2024-01-01 00:00:00.000] [binary] [warning] ",
+                              "event ", i, " value=", fmt::format("{:.2f}", i * 0.5),
+                              " tag=abc neg=", -i, "\n")
+                     .size();
+  }
+  EXPECT_LT(ReadFile(path).size() * 3, text_size);
+  std::remove(path.c_str());
+}
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+
+TEST(BinaryLogTest, DeferredWriterPassesRawRecords) {
+  std::string path = TestPath("binary_deferred.qxlog");
+  auto sink = std::make_shared<BinaryFileSink>(1024);
+  ASSERT_TRUE(sink->open(path).ok());
+
+  AsyncOptions options;
+  options.thread_buffer_size = 4096;
+  DeferredWriter writer("deferred_binary", {sink}, options);
+  ASSERT_TRUE(writer.start().ok());
+  for (int i = 0; i < 100; ++i) {
+    writer.log(LogLevel::kInfo, "deferred {} {}", i, std::string("raw"));
+  }
+  writer.stop();
+  sink->flush();
+
+  BinaryLogReader reader;
+  ASSERT_TRUE(reader.open(path).ok());
+  BinaryLogEntry entry;
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_TRUE(reader.next(&entry).ok());
+    EXPECT_EQ(entry.format, "deferred {} {}");
+    EXPECT_EQ(entry.message, absl::StrCat("deferred ", i, " raw"));
+    EXPECT_EQ(entry.logger_name, "deferred_binary");
+  }
+  EXPECT_TRUE(absl::IsOutOfRange(reader.next(&entry)));
+  std::remove(path.c_str());
+}
+
+#endif  // QXCORE_ENABLE_LOG_SPDLOG
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,222 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/callsite.h"
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "qxcore/log/log.h"
+#include "qxcore/log/named_logger.h"
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+#include <spdlog/spdlog.h>
+#endif
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path);
+  std::stringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+// 固定调用点，行号由 kDebugLine 记录
+constexpr int kDebugLine = __LINE__ + 2;
+void LogDebug(DefaultLog& logger, int* evaluations) {
+  QXLOG_DEBUG(logger, "callsite debug {}", ++*evaluations);
+}
+
+constexpr int kTraceLine = __LINE__ + 2;
+void LogTrace(DefaultLog& logger, int* evaluations) {
+  QXLOG_TRACE(logger, "callsite trace {}", ++*evaluations);
+}
+
+constexpr int kNamedTraceLine = __LINE__ + 2;
+void LogNamedTrace(NamedLogger& logger, int* evaluations) {
+  QXLOG_TRACE(logger, "callsite named trace {}", ++*evaluations);
+}
+
+const Callsite* FindCallsite(int line) {
+  const Callsite* found = nullptr;
+  CallsiteRegistry::Global().for_each([&](const Callsite& callsite) {
+    if (callsite.line() == line &&
+        absl::string_view(callsite.file()).find("callsite_test.cc") !=
+            absl::string_view::npos) {
+      found = &callsite;
+    }
+  });
+  return found;
+}
+
+}  // anonymous namespace
+
+class CallsiteTest : public ::testing::Test {
+ protected:
+  void TearDown() override {
+    CallsiteRegistry::Global().clear_overrides();
+  }
+};
+
+TEST_F(CallsiteTest, RegistersDescriptorOnFirstUse) {
+  DefaultLog logger;
+  ASSERT_TRUE(logger.init("callsite_register_test", LogLevel::kInfo).ok());
+  int evaluations = 0;
+  LogDebug(logger, &evaluations);
+  EXPECT_EQ(evaluations, 0);
+
+  const Callsite* callsite = FindCallsite(kDebugLine);
+  ASSERT_NE(callsite, nullptr);
+  EXPECT_EQ(callsite->level(), LogLevel::kDebug);
+  EXPECT_STREQ(callsite->format(), "callsite debug {}");
+  EXPECT_STREQ(callsite->function(), "LogDebug");
+  EXPECT_NE(callsite->state(), Callsite::kUnregistered);
+  logger.shutdown();
+}
+
+TEST_F(CallsiteTest, SetLevelUpdatesFlags) {
+  DefaultLog logger;
+  ASSERT_TRUE(logger.init("callsite_level_test", LogLevel::kInfo).ok());
+  int evaluations = 0;
+  LogDebug(logger, &evaluations);
+  const Callsite* callsite = FindCallsite(kDebugLine);
+  ASSERT_NE(callsite, nullptr);
+  EXPECT_EQ(evaluations, 0);
+
+  ASSERT_TRUE(logger.set_level(LogLevel::kDebug).ok());
+  EXPECT_EQ(callsite->state(), Callsite::kLevelEnabled);
+  LogDebug(logger, &evaluations);
+  EXPECT_EQ(evaluations, 1);
+
+  // 其他测试遗留的日志器可能仍使调用点处于 kLevelEnabled，
+  // 此时由日志器自身的级别拒绝
+  ASSERT_TRUE(logger.set_level(LogLevel::kWarn).ok());
+  LogDebug(logger, &evaluations);
+  EXPECT_EQ(evaluations, 1);
+  logger.shutdown();
+}
+
+TEST_F(CallsiteTest, LoggerLevelStillAppliesWithSharedCallsite) {
+  DefaultLog verbose;
+  DefaultLog quiet;
+  ASSERT_TRUE(verbose.init("callsite_verbose_test", LogLevel::kDebug).ok());
+  ASSERT_TRUE(quiet.init("callsite_quiet_test", LogLevel::kInfo).ok());
+
+  int evaluations = 0;
+  LogDebug(quiet, &evaluations);
+  EXPECT_EQ(evaluations, 0);
+  LogDebug(verbose, &evaluations);
+  EXPECT_EQ(evaluations, 1);
+
+  verbose.shutdown();
+  quiet.shutdown();
+}
+
+TEST_F(CallsiteTest, OverrideEnablesAndDisablesSingleCallsite) {
+  DefaultLog logger;
+  ASSERT_TRUE(logger.init("callsite_override_test", LogLevel::kInfo).ok());
+  int evaluations = 0;
+  LogDebug(logger, &evaluations);
+
+  EXPECT_EQ(CallsiteRegistry::Global().set_override(
+                "callsite_test.cc", kDebugLine, CallsiteOverride::kForceOn),
+            1u);
+  LogDebug(logger, &evaluations);
+  EXPECT_EQ(evaluations, 1);
+
+  ASSERT_TRUE(logger.set_level(LogLevel::kTrace).ok());
+  EXPECT_EQ(CallsiteRegistry::Global().set_override(
+                "callsite_test.cc", kDebugLine, CallsiteOverride::kForceOff),
+            1u);
+  LogDebug(logger, &evaluations);
+  EXPECT_EQ(evaluations, 1);
+
+  // 路径后缀必须在分隔符处对齐
+  EXPECT_EQ(CallsiteRegistry::Global().set_override(
+                "site_test.cc", kDebugLine, CallsiteOverride::kNone),
+            0u);
+
+  CallsiteRegistry::Global().clear_overrides();
+  LogDebug(logger, &evaluations);
+  EXPECT_EQ(evaluations, 2);
+  logger.shutdown();
+}
+
+TEST_F(CallsiteTest, NamedLoggersDoNotEnableLogCallsites) {
+  DefaultLog logger;
+  ASSERT_TRUE(logger.init("callsite_named_test", LogLevel::kError).ok());
+  int evaluations = 0;
+  LogTrace(logger, &evaluations);
+  const Callsite* callsite = FindCallsite(kTraceLine);
+  ASSERT_NE(callsite, nullptr);
+  EXPECT_EQ(callsite->state(), Callsite::kDisabled);
+
+  // 命名日志器及其级别不影响 Log 对象的调用点
+  NamedLogger named = GetLogger("test.callsite.named");
+  ASSERT_TRUE(named.set_level(LogLevel::kTrace).ok());
+  EXPECT_EQ(callsite->state(), Callsite::kDisabled);
+  LogTrace(logger, &evaluations);
+  EXPECT_EQ(evaluations, 0);
+
+  // 命名日志器的调用点按 ID 检查级别
+  int named_evaluations = 0;
+  LogNamedTrace(named, &named_evaluations);
+  EXPECT_EQ(named_evaluations, 1);
+  const Callsite* named_callsite = FindCallsite(kNamedTraceLine);
+  ASSERT_NE(named_callsite, nullptr);
+  ASSERT_TRUE(named.set_level(LogLevel::kInfo).ok());
+  LogNamedTrace(named, &named_evaluations);
+  EXPECT_EQ(named_evaluations, 1);
+
+  // 单独开关对命名日志器同样生效
+  ASSERT_TRUE(named.set_level(LogLevel::kTrace).ok());
+  CallsiteRegistry::Global().set_override("callsite_test.cc", kNamedTraceLine,
+                                          CallsiteOverride::kForceOff);
+  EXPECT_EQ(named_callsite->state(), Callsite::kForcedOff);
+  LogNamedTrace(named, &named_evaluations);
+  EXPECT_EQ(named_evaluations, 1);
+
+  ASSERT_TRUE(
+      LoggerRegistry::Global().reset_level("test.callsite.named").ok());
+  logger.shutdown();
+}
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+TEST_F(CallsiteTest, SourceLocationReachesSpdlog) {
+  const std::string name = "callsite_source_test";
+  {
+    DefaultLog logger;
+    ASSERT_TRUE(logger.init(name, LogLevel::kInfo).ok());
+    spdlog::get(name)->set_pattern("%s:%# %! %v");
+    int line = __LINE__ + 1;
+    QXLOG_INFO(logger, "with location {}", 1);
+    logger.flush();
+    logger.shutdown();
+
+    std::string content = ReadFile(name + ".log");
+    EXPECT_NE(content.find("callsite_test.cc:" + std::to_string(line)),
+              std::string::npos)
+        << content;
+    EXPECT_NE(content.find("with location 1"), std::string::npos);
+  }
+}
+#endif  // QXCORE_ENABLE_LOG_SPDLOG
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,152 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+
+#include "qxcore/log/console_sink.h"
+#include <gtest/gtest.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_split.h>
+#include <spdlog/details/console_globals.h>
+#include <spdlog/details/log_msg.h>
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+spdlog::details::log_msg Message(absl::string_view text,
+                                 spdlog::level::level_enum level =
+                                     spdlog::level::info) {
+  return spdlog::details::log_msg(
+      spdlog::source_loc{}, "console", level,
+      spdlog::string_view_t(text.data(), text.size()));
+}
+
+std::string ReadAll(int fd) {
+  std::string content;
+  char buffer[4096];
+  ssize_t n;
+  while ((n = read(fd, buffer, sizeof(buffer))) > 0) {
+    content.append(buffer, static_cast<size_t>(n));
+  }
+  return content;
+}
+
+}  // anonymous namespace
+
+TEST(NonBlockingConsoleSinkTest, WritesFormattedRecords) {
+  FILE* target = std::tmpfile();
+  ASSERT_NE(target, nullptr);
+  {
+    NonBlockingConsoleSink sink(target, 4096, 256,
+                                spdlog::color_mode::always);
+    sink.set_pattern("[%^%l%$] %v");
+    EXPECT_TRUE(sink.should_color());
+    sink.log(Message("first"));
+    sink.log(Message("second", spdlog::level::warn));
+    sink.flush();
+    EXPECT_EQ(sink.dropped(), 0u);
+  }
+  std::rewind(target);
+  std::string content = ReadAll(fileno(target));
+  std::fclose(target);
+  EXPECT_EQ(content,
+            "[\033[32minfo\033[m] first\n"
+            "[\033[33m\033[1mwarning\033[m] second\n");
+}
+
+TEST(NonBlockingConsoleSinkTest, DropsInsteadOfBlocking) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  FILE* target = fdopen(fds[1], "w");
+  ASSERT_NE(target, nullptr);
+
+  // 没有读端消费时管道很快写满，写线程阻塞，日志调用只填满缓冲区后丢弃
+  constexpr int kRecords = 20000;
+  auto sink = std::make_unique<NonBlockingConsoleSink>(
+      target, 8192, 256, spdlog::color_mode::never);
+  sink->set_pattern("%v");
+  std::string text(90, 'x');
+  for (int i = 0; i < kRecords; ++i) {
+    std::string line = absl::StrCat(i, " ", text);
+    sink->log(Message(line));
+  }
+  uint64_t dropped = sink->dropped();
+  EXPECT_GT(dropped, 0u);
+
+  // 开始读取后剩余文本全部写出
+  std::string content;
+  std::thread reader([&] { content = ReadAll(fds[0]); });
+  sink->flush();
+  sink.reset();
+  std::fclose(target);
+  reader.join();
+  close(fds[0]);
+
+  std::vector<std::string> lines =
+      absl::StrSplit(content, '\n', absl::SkipEmpty());
+  EXPECT_EQ(lines.size() + dropped, static_cast<size_t>(kRecords));
+  for (const std::string& line : lines) {
+    ASSERT_EQ(line.size() - line.find(' '), text.size() + 1) << line;
+  }
+}
+
+TEST(NonBlockingConsoleSinkTest, StalledTargetDoesNotBlockOthers) {
+  int fds[2];
+  ASSERT_EQ(pipe(fds), 0);
+  FILE* target = fdopen(fds[1], "w");
+  ASSERT_NE(target, nullptr);
+
+  // 管道始终无人读取，写线程写满管道后停在 poll 上
+  auto sink = std::make_unique<NonBlockingConsoleSink>(
+      target, 8192, 256, spdlog::color_mode::never);
+  sink->set_pattern("%v");
+  std::string text(90, 'x');
+  for (int i = 0; i < 2000; ++i) {
+    sink->log(Message(text));
+    if (i % 100 == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  EXPECT_GT(sink->dropped(), 0u);
+
+  // 写线程阻塞期间不占用全局控制台锁
+  {
+    std::unique_lock<std::mutex> console_lock(
+        spdlog::details::console_mutex::mutex(), std::try_to_lock);
+    EXPECT_TRUE(console_lock.owns_lock());
+  }
+
+  // 析构只在期限内尝试写出，剩余文本丢弃
+  auto start = std::chrono::steady_clock::now();
+  sink.reset();
+  EXPECT_LT(std::chrono::steady_clock::now() - start,
+            NonBlockingConsoleSink::kFlushTimeout + std::chrono::seconds(1));
+  std::fclose(target);
+  close(fds[0]);
+}
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_ENABLE_LOG_SPDLOG
@@ -0,0 +1,307 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/dedup_filter.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <absl/strings/match.h>
+#include <absl/strings/str_split.h>
+#include "qxcore/log/log.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  std::stringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+DedupOptions WindowOptions(int window_ms) {
+  DedupOptions options;
+  options.enabled = true;
+  options.window_ms = window_ms;
+  return options;
+}
+
+constexpr Callsite kSiteA("a.cc", 1, "f", "venue {} down", LogLevel::kError);
+constexpr Callsite kSiteB("b.cc", 2, "g", "venue {} down", LogLevel::kError);
+
+}  // anonymous namespace
+
+TEST(DedupFilterTest, ValidatesOptions) {
+  EXPECT_TRUE(DedupFilter::ValidateOptions(WindowOptions(1)).ok());
+  EXPECT_TRUE(DedupFilter::ValidateOptions(WindowOptions(3600000)).ok());
+  EXPECT_FALSE(DedupFilter::ValidateOptions(WindowOptions(0)).ok());
+  EXPECT_FALSE(DedupFilter::ValidateOptions(WindowOptions(3600001)).ok());
+}
+
+TEST(DedupFilterTest, HashesArgumentValues) {
+  EXPECT_EQ(HashDedupArgs(7, "down"), HashDedupArgs(7, std::string("down")));
+  EXPECT_NE(HashDedupArgs(7, "down"), HashDedupArgs(8, "down"));
+  EXPECT_NE(HashDedupArgs(1.5, "x"), HashDedupArgs(2.5, "x"));
+  EXPECT_EQ(HashDedupArgs(), HashDedupArgs());
+}
+
+TEST(DedupFilterTest, FoldsConsecutiveDuplicates) {
+  DedupFilter filter(WindowOptions(60000));
+  DedupRun run;
+  EXPECT_FALSE(filter.admit(&kSiteA, kNoLoggerId, 1, &run));
+  EXPECT_EQ(run.repeats, 0u);
+  EXPECT_TRUE(filter.admit(&kSiteA, kNoLoggerId, 1, &run));
+  EXPECT_TRUE(filter.admit(&kSiteA, kNoLoggerId, 1, &run));
+
+  // 参数、调用点或日志器不同都会结束重复段
+  EXPECT_FALSE(filter.admit(&kSiteA, kNoLoggerId, 2, &run));
+  EXPECT_EQ(run.callsite, &kSiteA);
+  EXPECT_EQ(run.repeats, 2u);
+  EXPECT_FALSE(filter.admit(&kSiteB, kNoLoggerId, 2, &run));
+  EXPECT_EQ(run.repeats, 0u);
+  EXPECT_FALSE(filter.admit(&kSiteB, 3, 2, &run));
+  EXPECT_EQ(run.repeats, 0u);
+  EXPECT_EQ(filter.suppressed(), 2u);
+}
+
+TEST(DedupFilterTest, TakeEndsRun) {
+  DedupFilter filter(WindowOptions(60000));
+  DedupRun run;
+  EXPECT_FALSE(filter.take(&run));
+  filter.admit(&kSiteA, kNoLoggerId, 1, &run);
+  filter.admit(&kSiteA, kNoLoggerId, 1, &run);
+  ASSERT_TRUE(filter.take(&run));
+  EXPECT_EQ(run.repeats, 1u);
+  EXPECT_FALSE(filter.take(&run));
+
+  // take 之后相同的记录按首条写出
+  EXPECT_FALSE(filter.admit(&kSiteA, kNoLoggerId, 1, &run));
+  EXPECT_EQ(run.repeats, 0u);
+}
+
+TEST(DedupFilterTest, WindowExpiryStartsNewRun) {
+  DedupFilter filter(WindowOptions(20));
+  DedupRun run;
+  filter.admit(&kSiteA, kNoLoggerId, 1, &run);
+  EXPECT_TRUE(filter.admit(&kSiteA, kNoLoggerId, 1, &run));
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  EXPECT_FALSE(filter.admit(&kSiteA, kNoLoggerId, 1, &run));
+  EXPECT_EQ(run.repeats, 1u);
+  EXPECT_TRUE(filter.admit(&kSiteA, kNoLoggerId, 1, &run));
+}
+
+TEST(DedupFilterTest, ThreadsKeepTheirOwnRuns) {
+  DedupFilter filter(WindowOptions(60000));
+  DedupRun run;
+  EXPECT_FALSE(filter.admit(&kSiteA, kNoLoggerId, 1, &run));
+  EXPECT_TRUE(filter.admit(&kSiteA, kNoLoggerId, 1, &run));
+
+  // 其他线程的记录不结束本线程的重复段
+  std::thread other([&] {
+    DedupRun other_run;
+    EXPECT_FALSE(filter.admit(&kSiteB, kNoLoggerId, 1, &other_run));
+    EXPECT_TRUE(filter.admit(&kSiteB, kNoLoggerId, 1, &other_run));
+  });
+  other.join();
+  EXPECT_TRUE(filter.admit(&kSiteA, kNoLoggerId, 1, &run));
+
+  // take 逐段取出全部线程的重复段
+  uint64_t repeats = 0;
+  int runs = 0;
+  while (filter.take(&run)) {
+    repeats += run.repeats;
+    ++runs;
+  }
+  EXPECT_EQ(runs, 2);
+  EXPECT_EQ(repeats, 3u);
+}
+
+TEST(DedupFilterTest, TakeExpiredOnlyEndsExpiredRuns) {
+  DedupFilter filter(WindowOptions(20));
+  DedupRun run;
+  filter.admit(&kSiteA, kNoLoggerId, 1, &run);
+  filter.admit(&kSiteA, kNoLoggerId, 1, &run);
+  EXPECT_FALSE(filter.take_expired(&run));
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  ASSERT_TRUE(filter.take_expired(&run));
+  EXPECT_EQ(run.callsite, &kSiteA);
+  EXPECT_EQ(run.repeats, 1u);
+  EXPECT_FALSE(filter.take_expired(&run));
+  EXPECT_FALSE(filter.take(&run));
+}
+
+TEST(DedupFilterTest, TimerEmitsIdleRuns) {
+  DedupFilter filter(WindowOptions(10));
+  std::mutex mutex;
+  std::vector<DedupRun> emitted;
+  ASSERT_TRUE(filter
+                  .start([&](const DedupRun& run) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    emitted.push_back(run);
+                  })
+                  .ok());
+  EXPECT_TRUE(absl::IsAlreadyExists(filter.start([](const DedupRun&) {})));
+  DedupRun run;
+  filter.admit(&kSiteA, kNoLoggerId, 1, &run);
+  filter.admit(&kSiteA, kNoLoggerId, 1, &run);
+  filter.admit(&kSiteA, kNoLoggerId, 1, &run);
+
+  // 之后不再有记录，汇总由定时线程写出
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  for (;;) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!emitted.empty() ||
+          std::chrono::steady_clock::now() > deadline) {
+        break;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  filter.stop();
+  ASSERT_EQ(emitted.size(), 1u);
+  EXPECT_EQ(emitted[0].callsite, &kSiteA);
+  EXPECT_EQ(emitted[0].repeats, 2u);
+  EXPECT_FALSE(filter.take(&run));
+}
+
+TEST(DedupFilterTest, FormatsSummary) {
+  DedupRun run;
+  run.callsite = &kSiteA;
+  run.repeats = 41;
+  run.span_nanos = 350500000;
+  EXPECT_EQ(FormatDedupSummary(run),
+            "\"venue {} down\" repeated 41 times over 350 ms");
+}
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+
+class DedupLogTest : public ::testing::TestWithParam<LogMode> {
+ protected:
+  void SetUp() override {
+    std::remove((kName + std::string(".log")).c_str());
+    LogOptions options;
+    options.mode = GetParam();
+    options.pattern = "%l %v";
+    options.dedup = WindowOptions(60000);
+    ASSERT_TRUE(logger_.init(kName, LogLevel::kInfo, options).ok());
+  }
+
+  void TearDown() override { logger_.shutdown(); }
+
+  std::vector<std::string> Lines() {
+    logger_.flush();
+    return absl::StrSplit(ReadFile(kName + std::string(".log")), '\n',
+                          absl::SkipEmpty());
+  }
+
+  static constexpr const char* kName = "dedup_test";
+  Log<SpdlogBackend> logger_;
+};
+
+TEST_P(DedupLogTest, CollapsesRepeatedRecords) {
+  int evaluations = 0;
+  for (int venue : {7, 7, 7, 8, 8}) {
+    QXLOG_ERROR(logger_, "venue {} down", (++evaluations, venue));
+  }
+  QXLOG_INFO(logger_, "recovered");
+  // 不经调用点的记录不参与折叠
+  logger_.info("plain");
+  logger_.info("plain");
+  EXPECT_EQ(evaluations, 5);
+  EXPECT_EQ(logger_.backend().dedup_suppressed(), 3u);
+
+  std::vector<std::string> lines = Lines();
+  ASSERT_EQ(lines.size(), 7u);
+  EXPECT_EQ(lines[0], "error venue 7 down");
+  EXPECT_TRUE(absl::StartsWith(
+      lines[1], "error \"venue {} down\" repeated 2 times over "));
+  EXPECT_EQ(lines[2], "error venue 8 down");
+  EXPECT_TRUE(absl::StartsWith(
+      lines[3], "error \"venue {} down\" repeated 1 times over "));
+  EXPECT_EQ(lines[4], "info recovered");
+  EXPECT_EQ(lines[5], "info plain");
+  EXPECT_EQ(lines[6], "info plain");
+}
+
+TEST_P(DedupLogTest, FlushWritesPendingSummary) {
+  for (int i = 0; i < 4; ++i) {
+    QXLOG_WARN(logger_, "gap");
+  }
+  std::vector<std::string> lines = Lines();
+  ASSERT_EQ(lines.size(), 2u);
+  EXPECT_EQ(lines[0], "warning gap");
+  EXPECT_TRUE(absl::StartsWith(lines[1], "warning \"gap\" repeated 3 times"));
+
+  // 汇总写出后重新开始计数
+  QXLOG_WARN(logger_, "gap");
+  EXPECT_EQ(Lines().size(), 3u);
+}
+
+TEST_P(DedupLogTest, TimerWritesSummaryWhenRepeatsStop) {
+  Log<SpdlogBackend> logger;
+  const std::string name = "dedup_timer_test";
+  std::remove((name + ".log").c_str());
+  LogOptions options;
+  options.mode = GetParam();
+  options.pattern = "%l %v";
+  options.dedup = WindowOptions(10);
+  ASSERT_TRUE(logger.init(name, LogLevel::kInfo, options).ok());
+
+  std::thread burst([&] {
+    for (int i = 0; i < 4; ++i) {
+      QXLOG_WARN(logger, "gap");
+    }
+  });
+  burst.join();
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+
+  // 汇总在窗口到期后写出，不等其他记录或 flush
+  QXLOG_INFO(logger, "later");
+  logger.flush();
+  std::vector<std::string> lines =
+      absl::StrSplit(ReadFile(name + ".log"), '\n', absl::SkipEmpty());
+  logger.shutdown();
+  ASSERT_EQ(lines.size(), 3u);
+  EXPECT_EQ(lines[0], "warning gap");
+  EXPECT_TRUE(absl::StartsWith(lines[1], "warning \"gap\" repeated 3 times"));
+  EXPECT_EQ(lines[2], "info later");
+  std::remove((name + ".log").c_str());
+}
+
+INSTANTIATE_TEST_SUITE_P(Modes, DedupLogTest,
+                         ::testing::Values(LogMode::kSync, LogMode::kAsync,
+                                           LogMode::kDeferred));
+
+TEST(DedupLogOptionsTest, RejectsInvalidWindow) {
+  LogOptions options;
+  options.output = LogOutput::kNull;
+  options.dedup = WindowOptions(0);
+  Log<SpdlogBackend> logger;
+  EXPECT_FALSE(logger.init("dedup_invalid", LogLevel::kInfo, options).ok());
+}
+
+#endif  // QXCORE_ENABLE_LOG_SPDLOG
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,300 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+
+#include "qxcore/log/deferred_writer.h"
+#include <gtest/gtest.h>
+#include <absl/strings/str_cat.h>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <spdlog/sinks/base_sink.h>
+#include "qxcore/log/arg_codec.h"
+#include "qxcore/log/format_registry.h"
+#include "qxcore/log/spdlog_backend.h"
+#include "qxcore/log/spsc_ring.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+// 记录写出内容和时间戳的测试 sink
+class CaptureSink : public spdlog::sinks::base_sink<std::mutex> {
+ public:
+  std::vector<std::string> messages() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return messages_;
+  }
+
+  std::vector<spdlog::log_clock::time_point> times() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return times_;
+  }
+
+ protected:
+  void sink_it_(const spdlog::details::log_msg& msg) override {
+    messages_.emplace_back(msg.payload.data(), msg.payload.size());
+    times_.push_back(msg.time);
+  }
+
+  void flush_() override {}
+
+ private:
+  std::vector<std::string> messages_;
+  std::vector<spdlog::log_clock::time_point> times_;
+};
+
+struct Point {
+  int x;
+  int y;
+};
+
+template<typename... Args>
+std::string EncodeAndFormat(absl::string_view fmt_str, const Args&... args) {
+  std::string encoded(EncodedArgsSize(args...), '\0');
+  char* end = EncodeArgs(&encoded[0], args...);
+  EXPECT_EQ(static_cast<size_t>(end - encoded.data()), encoded.size());
+
+  FormatArgStore store;
+  fmt::memory_buffer out;
+  absl::Status status = FormatEncoded(fmt_str, encoded.data(), encoded.size(),
+                                      sizeof...(Args), store, out);
+  EXPECT_TRUE(status.ok()) << status;
+  return std::string(out.data(), out.size());
+}
+
+}  // anonymous namespace
+
+}  // namespace log
+}  // namespace qxcore
+
+template<>
+struct fmt::formatter<qxcore::log::Point> : fmt::formatter<std::string_view> {
+  auto format(const qxcore::log::Point& p, fmt::format_context& ctx) const {
+    return fmt::format_to(ctx.out(), "({}, {})", p.x, p.y);
+  }
+};
+
+namespace qxcore {
+namespace log {
+
+TEST(ArgCodecTest, RoundTripsNativeTypes) {
+  const char* c_str = "text";
+  std::string str = "string";
+  int value = 7;
+  EXPECT_EQ(EncodeAndFormat("{} {} {} {} {} {:.2f} {:.1f} {} {}", true, 'c',
+                            -42, 42u, -(int64_t{1} << 40), 3.14159, 2.5f,
+                            c_str, str),
+            "true c -42 42 -1099511627776 3.14 2.5 text string");
+  EXPECT_EQ(EncodeAndFormat("{}", static_cast<const char*>(nullptr)), "(null)");
+  EXPECT_EQ(EncodeAndFormat("{}", static_cast<const void*>(&value)),
+            fmt::format("{}", static_cast<const void*>(&value)));
+}
+
+TEST(ArgCodecTest, PreformatsCustomTypes) {
+  EXPECT_EQ(EncodeAndFormat("point={}", Point{1, 2}), "point=(1, 2)");
+}
+
+TEST(ArgCodecTest, RejectsTruncatedInput) {
+  std::string encoded(EncodedArgsSize(std::string("abcdef")), '\0');
+  EncodeArgs(&encoded[0], std::string("abcdef"));
+
+  FormatArgStore store;
+  EXPECT_EQ(DecodeArgs(encoded.data(), encoded.size() - 1, 1, store).code(),
+            absl::StatusCode::kDataLoss);
+  store.clear();
+  EXPECT_EQ(DecodeArgs(encoded.data(), encoded.size(), 2, store).code(),
+            absl::StatusCode::kDataLoss);
+}
+
+TEST(FormatRegistryTest, InternsByContent) {
+  FormatRegistry& registry = FormatRegistry::Global();
+  uint32_t id = registry.intern("registry test {}");
+  EXPECT_EQ(registry.intern(std::string("registry test {}")), id);
+  ASSERT_NE(registry.find(id), nullptr);
+  EXPECT_EQ(*registry.find(id), "registry test {}");
+  EXPECT_EQ(registry.find(registry.size()), nullptr);
+
+  // 同一块缓冲区内容变化后缓存不能返回旧 ID
+  char buffer[] = "cached {} a";
+  uint32_t first = InternFormatCached(buffer);
+  buffer[10] = 'b';
+  uint32_t second = InternFormatCached(buffer);
+  EXPECT_NE(first, second);
+  EXPECT_EQ(*registry.find(second), "cached {} b");
+}
+
+TEST(SpscByteRingTest, WrapsAroundWithPadding) {
+  SpscByteRing ring(4096);
+  EXPECT_EQ(ring.capacity(), 4096u);
+  EXPECT_EQ(ring.reserve(ring.max_record_size() + 1), nullptr);
+
+  // 记录大小与容量不整除，多轮读写后必然发生回绕
+  for (int i = 0; i < 1000; ++i) {
+    std::string payload = absl::StrCat("record-", i, std::string(i % 300, '.'));
+    char* dst = ring.reserve(payload.size());
+    ASSERT_NE(dst, nullptr);
+    std::memcpy(dst, payload.data(), payload.size());
+    ring.commit();
+
+    absl::string_view record = ring.peek();
+    ASSERT_NE(record.data(), nullptr);
+    EXPECT_EQ(record, payload);
+    ring.release();
+    EXPECT_TRUE(ring.empty());
+  }
+  EXPECT_EQ(ring.peek().data(), nullptr);
+}
+
+TEST(SpscByteRingTest, ReportsFull) {
+  SpscByteRing ring(4096);
+  size_t reserved = 0;
+  while (ring.reserve(100) != nullptr) {
+    ring.commit();
+    ++reserved;
+  }
+  EXPECT_EQ(reserved, 4096u / 112);
+  ASSERT_NE(ring.peek().data(), nullptr);
+  ring.release();
+  EXPECT_NE(ring.reserve(100), nullptr);
+}
+
+TEST(DeferredWriterTest, InvalidOptions) {
+  AsyncOptions options;
+  options.thread_buffer_size = 16;
+  EXPECT_EQ(DeferredWriter::ValidateOptions(options).code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_TRUE(DeferredWriter::ValidateOptions(AsyncOptions()).ok());
+}
+
+TEST(DeferredWriterTest, FormatsOnWriterThread) {
+  auto sink = std::make_shared<CaptureSink>();
+  AsyncOptions options;
+  options.thread_buffer_size = 4096;
+  DeferredWriter writer("deferred_test", {sink}, options);
+  ASSERT_TRUE(writer.start().ok());
+
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(writer.log(LogLevel::kInfo, "value={} name={} pi={:.1f}", i,
+                           std::string("n") + std::to_string(i), 3.14));
+  }
+  // 超过单条上限的记录交由调用方处理
+  EXPECT_FALSE(writer.log(LogLevel::kInfo, "{}", std::string(2048, 'x')));
+  writer.flush();
+
+  auto messages = sink->messages();
+  ASSERT_EQ(messages.size(), 100u);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(messages[i], absl::StrCat("value=", i, " name=n", i, " pi=3.1"));
+  }
+  EXPECT_EQ(writer.stats().enqueued, 100u);
+}
+
+TEST(DeferredWriterTest, FormatErrorIsReportedInline) {
+  auto sink = std::make_shared<CaptureSink>();
+  DeferredWriter writer("deferred_test", {sink}, AsyncOptions());
+  ASSERT_TRUE(writer.start().ok());
+
+  EXPECT_TRUE(writer.log(LogLevel::kWarn, "{} {}", 1));
+  writer.flush();
+
+  auto messages = sink->messages();
+  ASSERT_EQ(messages.size(), 1u);
+  EXPECT_NE(messages[0].find("format error"), std::string::npos);
+}
+
+TEST(DeferredWriterTest, MergesThreadsByTimestamp) {
+  auto sink = std::make_shared<CaptureSink>();
+  AsyncOptions options;
+  options.thread_buffer_size = 64 * 1024;
+  DeferredWriter writer("deferred_test", {sink}, options);
+  ASSERT_TRUE(writer.start().ok());
+
+  constexpr int kThreads = 4;
+  constexpr int kPerThread = 2000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&writer, t] {
+      for (int i = 0; i < kPerThread; ++i) {
+        writer.log(LogLevel::kInfo, "thread {} seq {}", t, i);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  writer.flush();
+
+  auto messages = sink->messages();
+  ASSERT_EQ(messages.size(), static_cast<size_t>(kThreads * kPerThread));
+  std::vector<int> next(kThreads, 0);
+  for (const auto& message : messages) {
+    int t = 0;
+    int seq = 0;
+    ASSERT_EQ(std::sscanf(message.c_str(), "thread %d seq %d", &t, &seq), 2);
+    EXPECT_EQ(seq, next[t]++);
+  }
+
+  // 线程退出后缓冲区被回收，统计仍然保留
+  EXPECT_EQ(writer.stats().enqueued,
+            static_cast<uint64_t>(kThreads * kPerThread));
+}
+
+TEST(DeferredWriterTest, DropNewestWhenBufferFull) {
+  auto sink = std::make_shared<CaptureSink>();
+  AsyncOptions options;
+  options.thread_buffer_size = 4096;
+  options.overflow_policy = OverflowPolicy::kDropNewest;
+  DeferredWriter writer("deferred_test", {sink}, options);
+  // 写线程未启动，缓冲区写满后丢弃
+  for (int i = 0; i < 1000; ++i) {
+    EXPECT_TRUE(writer.log(LogLevel::kInfo, "drop {}", i));
+  }
+  AsyncStats stats = writer.stats();
+  EXPECT_GT(stats.dropped_newest, 0u);
+  EXPECT_EQ(stats.enqueued + stats.dropped_newest, 1000u);
+
+  ASSERT_TRUE(writer.start().ok());
+  writer.flush();
+  EXPECT_EQ(sink->messages().size(), stats.enqueued);
+}
+
+TEST(DeferredWriterTest, SpdlogBackendDeferredMode) {
+  LogOptions options;
+  options.mode = LogMode::kDeferred;
+  options.async.thread_buffer_size = 4096;
+
+  SpdlogBackend backend;
+  ASSERT_TRUE(backend.init("deferred_backend_test", LogLevel::kInfo, options).ok());
+  EXPECT_TRUE(backend.is_async());
+
+  backend.logf(LogLevel::kInfo, "deferred {} {}", 1, "two");
+  backend.log(LogLevel::kInfo, "plain message");
+  // 超长记录退回同步写出
+  backend.logf(LogLevel::kInfo, "{}", std::string(2048, 'y'));
+  // bypass 级别在调用线程写出
+  backend.logf(LogLevel::kError, "bypass {}", 3);
+  backend.flush();
+
+  EXPECT_EQ(backend.async_stats().enqueued, 2u);
+  backend.shutdown();
+}
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_ENABLE_LOG_SPDLOG
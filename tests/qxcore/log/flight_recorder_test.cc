@@ -0,0 +1,267 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/flight_recorder.h"
+#include <gtest/gtest.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <absl/strings/match.h>
+#include <absl/strings/str_split.h>
+#include "qxcore/log/log.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  std::stringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+FlightRecorderOptions SmallOptions() {
+  FlightRecorderOptions options;
+  options.records_per_thread = 8;
+  options.record_size = 128;
+  options.max_threads = 4;
+  return options;
+}
+
+// 转储结果，去掉 "[flight tid N] " 前缀
+std::vector<std::pair<LogLevel, std::string>> Dump(FlightRecorder& recorder) {
+  std::vector<std::pair<LogLevel, std::string>> records;
+  recorder.dump([&](LogLevel level, int64_t, absl::string_view message) {
+    size_t prefix = message.find("] ");
+    records.emplace_back(level, std::string(message.substr(prefix + 2)));
+  });
+  return records;
+}
+
+// 把 dump_to_fd 的输出写到临时文件后按行返回
+std::vector<std::string> DumpLines(const FlightRecorder& recorder,
+                                   const std::string& name) {
+  std::string path = testing::TempDir() + name;
+  int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  EXPECT_GE(fd, 0);
+  recorder.dump_to_fd(fd);
+  ::close(fd);
+  return absl::StrSplit(ReadFile(path), '\n', absl::SkipEmpty());
+}
+
+}  // anonymous namespace
+
+TEST(FlightRecorderTest, ValidatesOptions) {
+  FlightRecorderOptions options = SmallOptions();
+  EXPECT_TRUE(FlightRecorder::ValidateOptions(options).ok());
+
+  options.record_size = 100;
+  EXPECT_FALSE(FlightRecorder::ValidateOptions(options).ok());
+  options.record_size = 32;
+  EXPECT_FALSE(FlightRecorder::ValidateOptions(options).ok());
+  options.record_size = 8192;
+  EXPECT_FALSE(FlightRecorder::ValidateOptions(options).ok());
+
+  options = SmallOptions();
+  options.max_threads = 0;
+  EXPECT_FALSE(FlightRecorder::ValidateOptions(options).ok());
+  options.max_threads = 1000;
+  EXPECT_FALSE(FlightRecorder::ValidateOptions(options).ok());
+}
+
+TEST(FlightRecorderTest, DumpsUnwrittenRecordsOnce) {
+  FlightRecorder recorder;
+  ASSERT_TRUE(recorder.init("flight_once", SmallOptions()).ok());
+
+  recorder.record(LogLevel::kDebug, RecordTime::Now(), false, "order {} px {}",
+                  42, 1.5);
+  recorder.record(LogLevel::kInfo, RecordTime::Now(), true, "written {}", 1);
+  recorder.record(LogLevel::kTrace, RecordTime::Now(), false, "name {:>4}",
+                  "ab");
+
+  auto records = Dump(recorder);
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_EQ(records[0].first, LogLevel::kDebug);
+  EXPECT_EQ(records[0].second, "order 42 px 1.5");
+  EXPECT_EQ(records[1].first, LogLevel::kTrace);
+  EXPECT_EQ(records[1].second, "name   ab");
+
+  // 已转储的记录不再重复输出
+  EXPECT_TRUE(Dump(recorder).empty());
+  recorder.record(LogLevel::kDebug, RecordTime::Now(), false, "later");
+  records = Dump(recorder);
+  ASSERT_EQ(records.size(), 1u);
+  EXPECT_EQ(records[0].second, "later");
+}
+
+TEST(FlightRecorderTest, KeepsOnlyLatestRecordsPerThread) {
+  FlightRecorder recorder;
+  ASSERT_TRUE(recorder.init("flight_latest", SmallOptions()).ok());
+  for (int i = 0; i < 20; ++i) {
+    recorder.record(LogLevel::kDebug, RecordTime::Now(), false, "seq {}", i);
+  }
+  auto records = Dump(recorder);
+  ASSERT_EQ(records.size(), 8u);
+  EXPECT_EQ(records.front().second, "seq 12");
+  EXPECT_EQ(records.back().second, "seq 19");
+}
+
+TEST(FlightRecorderTest, VerbatimAndTruncatedRecords) {
+  FlightRecorder recorder;
+  ASSERT_TRUE(recorder.init("flight_verbatim", SmallOptions()).ok());
+
+  recorder.record_verbatim(LogLevel::kDebug, RecordTime::Now(), false,
+                           "raw {not a format}");
+  std::string large(200, 'x');
+  recorder.record(LogLevel::kDebug, RecordTime::Now(), false, "big {}", large);
+
+  auto records = Dump(recorder);
+  ASSERT_EQ(records.size(), 2u);
+  EXPECT_EQ(records[0].second, "raw {not a format}");
+  EXPECT_EQ(records[1].second, "big {} [args truncated]");
+}
+
+TEST(FlightRecorderTest, MergesThreadsByTime) {
+  FlightRecorder recorder;
+  ASSERT_TRUE(recorder.init("flight_threads", SmallOptions()).ok());
+  recorder.record(LogLevel::kDebug, RecordTime::Event(EventTime(1000)), false,
+                  "main {}", 1);
+  std::thread([&] {
+    EXPECT_TRUE(recorder.thread_recorded());
+    recorder.record(LogLevel::kDebug, RecordTime::Event(EventTime(500)), false,
+                    "worker {}", 1);
+    recorder.record(LogLevel::kDebug, RecordTime::Event(EventTime(1500)),
+                    false, "worker {}", 2);
+  }).join();
+
+  auto records = Dump(recorder);
+  ASSERT_EQ(records.size(), 3u);
+  EXPECT_EQ(records[0].second, "worker 1");
+  EXPECT_EQ(records[1].second, "main 1");
+  EXPECT_EQ(records[2].second, "worker 2");
+}
+
+TEST(FlightRecorderTest, SignalSafeDumpRendersAllRecords) {
+  FlightRecorder recorder;
+  ASSERT_TRUE(recorder.init("flight_fd", SmallOptions()).ok());
+  recorder.record(LogLevel::kWarn, RecordTime::Event(EventTime(1500000000)),
+                  true, "px {} qty {} side {} {{ok}}", 2.25, -7, 'B');
+  recorder.record(LogLevel::kDebug, RecordTime::Event(EventTime(2000000001)),
+                  false, "ptr {} flag {} name {}",
+                  reinterpret_cast<const void*>(0xff), true, "abc");
+
+  auto lines = DumpLines(recorder, "flight_fd.txt");
+  ASSERT_EQ(lines.size(), 3u);
+  EXPECT_EQ(lines[0], "*** qxlog flight recorder: flight_fd ***");
+  EXPECT_TRUE(absl::StartsWith(lines[1], "1.500000000 WARN [tid "))
+      << lines[1];
+  EXPECT_TRUE(absl::EndsWith(lines[1], "] px 2.250000 qty -7 side B {ok}"))
+      << lines[1];
+  EXPECT_TRUE(absl::StartsWith(lines[2], "2.000000001 DEBUG [tid "))
+      << lines[2];
+  EXPECT_TRUE(absl::EndsWith(lines[2], "] ptr 0xff flag true name abc"))
+      << lines[2];
+}
+
+TEST(FlightRecorderTest, SharedMemoryFileOutlivesRecorder) {
+  std::string path = testing::TempDir() + "flight_shm.bin";
+  FlightRecorderOptions options = SmallOptions();
+  options.shm_path = path;
+  {
+    FlightRecorder recorder;
+    ASSERT_TRUE(recorder.init("flight_shm", options).ok());
+    recorder.record(LogLevel::kInfo, RecordTime::Event(EventTime(3000000000)),
+                    false, "last words {}", 99);
+  }
+
+  std::string out = testing::TempDir() + "flight_shm.txt";
+  int fd = ::open(out.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  ASSERT_GE(fd, 0);
+  EXPECT_TRUE(FlightRecorder::DumpFile(path, fd).ok());
+  ::close(fd);
+  std::string text = ReadFile(out);
+  EXPECT_TRUE(absl::StrContains(text, "*** qxlog flight recorder: flight_shm"));
+  EXPECT_TRUE(absl::StrContains(text, "3.000000000 INFO [tid "));
+  EXPECT_TRUE(absl::StrContains(text, "] last words 99\n"));
+
+  EXPECT_TRUE(absl::IsNotFound(
+      FlightRecorder::DumpFile(path + ".missing", fd)));
+  EXPECT_TRUE(absl::IsDataLoss(FlightRecorder::DumpFile(out, fd)));
+  std::remove(path.c_str());
+}
+
+TEST(FlightRecorderDeathTest, CrashHandlerDumpsRecords) {
+  EXPECT_DEATH(
+      {
+        FlightRecorder recorder;
+        if (recorder.init("flight_crash", SmallOptions()).ok()) {
+          recorder.install_crash_handler(STDERR_FILENO);
+          recorder.record(LogLevel::kDebug, RecordTime::Now(), false,
+                          "before crash {}", 7);
+          std::abort();
+        }
+      },
+      "flight recorder: flight_crash.*\n.*DEBUG.*before crash 7");
+}
+
+TEST(FlightRecorderTest, LogRecordsFilteredCallsAndDumpsOnError) {
+  std::string name = "flight_log_test";
+  std::remove((name + ".log").c_str());
+  LogOptions options;
+  options.flight_recorder = SmallOptions();
+  options.pattern = "%l %v";
+  DefaultLog logger;
+  ASSERT_TRUE(logger.init(name, LogLevel::kInfo, options).ok());
+  ASSERT_NE(logger.flight_recorder(), nullptr);
+  EXPECT_TRUE(logger.is_enabled(LogLevel::kDebug));
+
+  int evaluations = 0;
+  QXLOG_DEBUG(logger, "macro debug {}", ++evaluations);
+  logger.logf(LogLevel::kTrace, "runtime trace {}", 2);
+  logger.info("normal info");
+  EXPECT_EQ(evaluations, 1);
+  logger.error("failure {}", 3);
+
+  // 错误之前未写出的记录已补写，不会再次转储
+  EXPECT_EQ(logger.dump_flight_recorder(), 0u);
+  logger.debug("after error");
+  EXPECT_EQ(logger.dump_flight_recorder(), 1u);
+  logger.flush();
+  logger.shutdown();
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+  std::vector<std::string> lines =
+      absl::StrSplit(ReadFile(name + ".log"), '\n', absl::SkipEmpty());
+  ASSERT_EQ(lines.size(), 5u);
+  EXPECT_EQ(lines[0], "info normal info");
+  EXPECT_TRUE(absl::StartsWith(lines[1], "debug [flight tid "));
+  EXPECT_TRUE(absl::EndsWith(lines[1], "] macro debug 1"));
+  EXPECT_TRUE(absl::EndsWith(lines[2], "] runtime trace 2"));
+  EXPECT_EQ(lines[3], "error failure 3");
+  EXPECT_TRUE(absl::EndsWith(lines[4], "] after error"));
+#endif
+  std::remove((name + ".log").c_str());
+}
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,111 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/format_string.h"
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "qxcore/log/log.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+template<typename S, typename... Args>
+std::string Format(const S& fmt_str, const Args&... args) {
+  fmt::memory_buffer buffer;
+  FormatTo(buffer, fmt_str, args...);
+  return std::string(buffer.data(), buffer.size());
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path);
+  std::stringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+}  // anonymous namespace
+
+TEST(FormatStringTest, CompiledAndRuntimeFormatsAgree) {
+  std::string name = "value";
+  EXPECT_EQ(Format(QXLOG_FMT("{} = {:>4} ({:.2f})"), name, 42, 3.14159),
+            Format("{} = {:>4} ({:.2f})", name, 42, 3.14159));
+  EXPECT_EQ(Format(QXLOG_FMT("{} {}"), "literal", 'c'), "literal c");
+  EXPECT_EQ(Format(QXLOG_FMT("no args {{}}")), "no args {}");
+}
+
+TEST(FormatStringTest, FormatViewReturnsOriginalText) {
+  EXPECT_FALSE(kIsCompiledFormat<absl::string_view>);
+  auto compiled = QXLOG_FMT("x {}");
+  EXPECT_TRUE(kIsCompiledFormat<decltype(compiled)>);
+  EXPECT_EQ(FormatView(QXLOG_FMT("count = {}")), "count = {}");
+  EXPECT_EQ(FormatView(std::string("runtime {}")), "runtime {}");
+}
+
+TEST(FormatStringTest, RuntimeFormatErrorThrows) {
+  fmt::memory_buffer buffer;
+  EXPECT_THROW(FormatTo(buffer, absl::string_view("{} {}"), 1),
+               fmt::format_error);
+}
+
+TEST(FormatStringTest, BackendUsesBraceSyntax) {
+  const std::string name = "format_string_test";
+  {
+    DefaultLog logger;
+    ASSERT_TRUE(logger.init(name, LogLevel::kInfo).ok());
+    QXLOG_INFO(logger, "macro {} {}", 1, "two");
+    QXLOG_INFO(logger, "macro without args");
+    logger.info("runtime {:03d}", 7);
+    // 不带参数的运行期字符串按原文输出
+    logger.info("verbatim {braces}");
+    // 运行期格式错误的记录被丢弃
+    logger.info("broken {} {}", 1);
+    logger.flush();
+    logger.shutdown();
+  }
+
+  std::string content = ReadFile(name + ".log");
+  EXPECT_NE(content.find("macro 1 two"), std::string::npos);
+  EXPECT_NE(content.find("macro without args"), std::string::npos);
+  EXPECT_NE(content.find("runtime 007"), std::string::npos);
+  EXPECT_NE(content.find("verbatim {braces}"), std::string::npos);
+  EXPECT_EQ(content.find("broken"), std::string::npos);
+}
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+TEST(FormatStringTest, CompiledFormatInDeferredMode) {
+  const std::string name = "format_string_deferred_test";
+  LogOptions options;
+  options.mode = LogMode::kDeferred;
+  {
+    DefaultLog logger;
+    ASSERT_TRUE(logger.init(name, LogLevel::kInfo, options).ok());
+    QXLOG_INFO(logger, "deferred {} {:.1f}", 5, 2.5);
+    QXLOG_WARN(logger, "deferred without args");
+    logger.flush();
+    logger.shutdown();
+  }
+
+  std::string content = ReadFile(name + ".log");
+  EXPECT_NE(content.find("deferred 5 2.5"), std::string::npos);
+  EXPECT_NE(content.find("deferred without args"), std::string::npos);
+}
+#endif  // QXCORE_ENABLE_LOG_SPDLOG
+
+}  // namespace log
+}  // namespace qxcore
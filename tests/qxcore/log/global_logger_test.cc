@@ -0,0 +1,112 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/epoch.h"
+#include <gtest/gtest.h>
+#include <absl/status/status.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "qxcore/log/log.h"
+
+namespace qxcore {
+namespace log {
+
+TEST(EpochDomainTest, RetiredObjectWaitsForReaders) {
+  internal::EpochDomain& domain = internal::EpochDomain::Global();
+  domain.synchronize();
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool entered = false;
+  bool release = false;
+  std::thread reader([&] {
+    EpochGuard guard;
+    std::unique_lock<std::mutex> lock(mutex);
+    entered = true;
+    cv.notify_all();
+    cv.wait(lock, [&] { return release; });
+  });
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return entered; });
+  }
+
+  std::atomic<bool> deleted{false};
+  domain.retire([&deleted] { deleted.store(true); });
+  EXPECT_EQ(domain.reclaim(), 0u);
+  EXPECT_FALSE(deleted.load());
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    release = true;
+  }
+  cv.notify_all();
+  reader.join();
+
+  EXPECT_EQ(domain.reclaim(), 1u);
+  EXPECT_TRUE(deleted.load());
+}
+
+TEST(EpochDomainTest, ReadersEnteringAfterRetireDoNotBlock) {
+  internal::EpochDomain& domain = internal::EpochDomain::Global();
+  domain.synchronize();
+
+  bool deleted = false;
+  domain.retire([&deleted] { deleted = true; });
+  {
+    // 嵌套临界区：retire 之后进入的读者不会阻止回收
+    EpochGuard outer;
+    EpochGuard inner;
+    EXPECT_TRUE(domain.in_critical_section());
+    EXPECT_EQ(domain.reclaim(), 1u);
+  }
+  EXPECT_FALSE(domain.in_critical_section());
+  EXPECT_TRUE(deleted);
+}
+
+TEST(GlobalLoggerTest, HotSwapWhileLogging) {
+  ASSERT_TRUE(InitDefaultLogger("hot_swap_a", LogLevel::kWarn).ok());
+
+  std::atomic<bool> stop{false};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&stop, t] {
+      for (int i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+        QXLOG_GLOBAL_DEBUG("filtered {} {}", t, i);
+        QXLOG_GLOBAL_INFO("filtered {} {}", t, i);
+      }
+    });
+  }
+
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_TRUE(InitDefaultLogger(i % 2 == 0 ? "hot_swap_b" : "hot_swap_a",
+                                  LogLevel::kWarn)
+                    .ok());
+  }
+  stop.store(true);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // 全部旧日志器都已回收
+  internal::EpochDomain::Global().synchronize();
+  EXPECT_EQ(internal::EpochDomain::Global().retired_count(), 0u);
+  EXPECT_EQ(GetDefaultLogger().get_level(), LogLevel::kWarn);
+}
+
+}  // namespace log
+}  // namespace qxcore
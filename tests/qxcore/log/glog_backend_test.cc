@@ -15,7 +15,10 @@
 #ifdef QXCORE_ENABLE_LOG_GLOG
 
 #include "qxcore/log/glog_backend.h"
+#include <glog/logging.h>
 #include <gtest/gtest.h>
+#include <string>
+#include <vector>
 #include <absl/status/status.h>
 
 namespace qxcore {
@@ -124,6 +127,62 @@ TEST_F(GlogBackendTest, FlushAndShutdown) {
   EXPECT_FALSE(backend_->is_enabled(LogLevel::kInfo));
 }
 
+TEST_F(GlogBackendTest, EmptyNameRejected) {
+  absl::Status status = backend_->init("", LogLevel::kInfo);
+  EXPECT_EQ(status.code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_FALSE(backend_->is_enabled(LogLevel::kCritical));
+}
+
+// 记录 glog 收到的消息
+class CapturingSink : public google::LogSink {
+ public:
+  void send(google::LogSeverity /*severity*/, const char* /*full_filename*/,
+            const char* /*base_filename*/, int /*line*/,
+            const google::LogMessageTime& /*time*/, const char* message,
+            size_t message_len) override {
+    messages.emplace_back(message, message_len);
+  }
+
+  std::vector<std::string> messages;
+};
+
+TEST_F(GlogBackendTest, VerboseLevelsRequireGlogVerbosity) {
+  const int saved_v = FLAGS_v;
+  CapturingSink sink;
+  google::AddLogSink(&sink);
+  ASSERT_TRUE(backend_->init("test_glog", LogLevel::kTrace).ok());
+
+  // set_level 不改写用户的 --v
+  FLAGS_v = 1;
+  ASSERT_TRUE(backend_->set_level(LogLevel::kTrace).ok());
+  EXPECT_EQ(FLAGS_v, 1);
+  backend_->log(LogLevel::kTrace, "trace hidden");
+  backend_->logf(LogLevel::kDebug, "debug {}", 1);
+
+  FLAGS_v = 0;
+  backend_->logf(LogLevel::kDebug, "debug {}", 2);
+  backend_->log(LogLevel::kInfo, "info shown");
+
+  // 日志器级别仍然先于 --v 过滤
+  FLAGS_v = 2;
+  ASSERT_TRUE(backend_->set_level(LogLevel::kDebug).ok());
+  EXPECT_EQ(FLAGS_v, 2);
+  backend_->log(LogLevel::kTrace, "trace filtered");
+  backend_->log(LogLevel::kDebug, "debug 3");
+
+  google::RemoveLogSink(&sink);
+  FLAGS_v = saved_v;
+  EXPECT_EQ(sink.messages,
+            (std::vector<std::string>{"debug 1", "info shown", "debug 3"}));
+}
+
+TEST_F(GlogBackendTest, CriticalDoesNotAbort) {
+  ASSERT_TRUE(backend_->init("test_glog", LogLevel::kInfo).ok());
+  backend_->log(LogLevel::kCritical, "Critical message");
+  backend_->logf(LogLevel::kCritical, "Critical {}", 2);
+  SUCCEED();
+}
+
 TEST_F(GlogBackendTest, LoggingWithoutInitialization) {
   // 测试未初始化时的日志记录
   EXPECT_NO_THROW(backend_->log(LogLevel::kInfo, "Should not crash"));
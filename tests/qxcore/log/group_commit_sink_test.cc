@@ -0,0 +1,280 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include <gtest/gtest.h>
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_split.h>
+#include <spdlog/details/log_msg.h>
+#include "qxcore/log/group_commit_sink.h"
+#include "qxcore/log/spdlog_backend.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// 每个用例使用独立的空目录
+std::string TestDir(const std::string& name) {
+  std::string dir = testing::TempDir() + "group_commit_" + name + "/";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  return dir;
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+std::vector<std::string> ReadLines(const std::string& path) {
+  return absl::StrSplit(ReadFile(path), '\n', absl::SkipEmpty());
+}
+
+std::shared_ptr<GroupCommitSink> OpenSink(const std::string& path,
+                                          GroupCommitOptions options) {
+  options.enabled = true;
+  auto sink = std::make_shared<GroupCommitSink>(options);
+  sink->set_pattern("%v");
+  EXPECT_TRUE(sink->open(path).ok());
+  return sink;
+}
+
+void Write(GroupCommitSink& sink, const std::string& text) {
+  spdlog::details::log_msg msg("app", spdlog::level::info, text);
+  sink.log(msg);
+}
+
+}  // anonymous namespace
+
+TEST(GroupCommitSinkTest, ValidateOptionsRejectsBadConfig) {
+  GroupCommitOptions options;
+  EXPECT_TRUE(GroupCommitSink::ValidateOptions(options).ok());
+  options.max_batch_bytes = 1024;
+  EXPECT_TRUE(absl::IsInvalidArgument(GroupCommitSink::ValidateOptions(options)));
+  options = GroupCommitOptions();
+  options.max_batch_delay_us = -1;
+  EXPECT_TRUE(absl::IsInvalidArgument(GroupCommitSink::ValidateOptions(options)));
+}
+
+TEST(GroupCommitSinkTest, WritesImmediatelyWhenIdle) {
+  std::string dir = TestDir("idle");
+  GroupCommitOptions options;
+  options.use_io_uring = false;
+  auto sink = OpenSink(dir + "app.log", options);
+
+  Write(*sink, "first");
+  Write(*sink, "second");
+  // 不在写线程批次内，每条记录立即写出，无需 flush
+  EXPECT_EQ(ReadFile(dir + "app.log"), "first\nsecond\n");
+
+  GroupCommitStats stats = sink->stats();
+  EXPECT_EQ(stats.records, 2u);
+  EXPECT_EQ(stats.batches, 2u);
+  EXPECT_EQ(stats.write_calls, 2u);
+  EXPECT_EQ(stats.bytes, 13u);
+  EXPECT_EQ(stats.errors, 0u);
+}
+
+TEST(GroupCommitSinkTest, CoalescesRecordsWithinWriterBatch) {
+  std::string dir = TestDir("batch");
+  GroupCommitOptions options;
+  options.use_io_uring = false;
+  options.max_batch_delay_us = 60 * 1000 * 1000;
+  auto sink = OpenSink(dir + "app.log", options);
+
+  sink->begin_batch();
+  for (int i = 0; i < 100; ++i) {
+    Write(*sink, absl::StrCat("record ", i));
+  }
+  EXPECT_EQ(ReadFile(dir + "app.log"), "");
+  sink->end_batch();
+
+  std::vector<std::string> lines = ReadLines(dir + "app.log");
+  ASSERT_EQ(lines.size(), 100u);
+  EXPECT_EQ(lines.front(), "record 0");
+  EXPECT_EQ(lines.back(), "record 99");
+  GroupCommitStats stats = sink->stats();
+  EXPECT_EQ(stats.records, 100u);
+  EXPECT_EQ(stats.batches, 1u);
+  EXPECT_EQ(stats.write_calls, 1u);
+}
+
+TEST(GroupCommitSinkTest, ByteBoundCommitsDuringBatch) {
+  std::string dir = TestDir("bytes");
+  GroupCommitOptions options;
+  options.use_io_uring = false;
+  options.max_batch_bytes = 4096;
+  options.max_batch_delay_us = 60 * 1000 * 1000;
+  auto sink = OpenSink(dir + "app.log", options);
+
+  std::string payload(99, 'x');
+  sink->begin_batch();
+  for (int i = 0; i < 100; ++i) {
+    Write(*sink, payload);
+  }
+  // 每 4096 字节提交一批，批次内尚未达到上限的尾部仍在暂存
+  GroupCommitStats stats = sink->stats();
+  EXPECT_EQ(stats.batches, 100u * 100u / 4096u);
+  EXPECT_EQ(ReadFile(dir + "app.log").size(), stats.bytes);
+  sink->end_batch();
+  EXPECT_EQ(ReadLines(dir + "app.log").size(), 100u);
+}
+
+TEST(GroupCommitSinkTest, TimeBoundCommitsDuringBatch) {
+  std::string dir = TestDir("delay");
+  GroupCommitOptions options;
+  options.use_io_uring = false;
+  options.max_batch_delay_us = 0;
+  auto sink = OpenSink(dir + "app.log", options);
+
+  sink->begin_batch();
+  Write(*sink, "a");
+  Write(*sink, "b");
+  EXPECT_EQ(ReadFile(dir + "app.log"), "a\nb\n");
+  sink->end_batch();
+  EXPECT_EQ(sink->stats().batches, 2u);
+}
+
+TEST(GroupCommitSinkTest, OtherThreadsDoNotWaitForWriterBatch) {
+  std::string dir = TestDir("bypass");
+  GroupCommitOptions options;
+  options.use_io_uring = false;
+  options.max_batch_delay_us = 60 * 1000 * 1000;
+  auto sink = OpenSink(dir + "app.log", options);
+
+  sink->begin_batch();
+  Write(*sink, "queued");
+  std::thread([&] { Write(*sink, "urgent"); }).join();
+  // 其他线程的记录连同已暂存的记录立即写出，顺序不变
+  EXPECT_EQ(ReadFile(dir + "app.log"), "queued\nurgent\n");
+  sink->end_batch();
+}
+
+TEST(GroupCommitSinkTest, FlushWritesStagedRecords) {
+  std::string dir = TestDir("flush");
+  GroupCommitOptions options;
+  options.max_batch_delay_us = 60 * 1000 * 1000;
+  auto sink = OpenSink(dir + "app.log", options);
+
+  sink->begin_batch();
+  Write(*sink, "staged");
+  sink->flush();
+  EXPECT_EQ(ReadFile(dir + "app.log"), "staged\n");
+  sink->end_batch();
+}
+
+class GroupCommitConcurrencyTest : public testing::TestWithParam<bool> {};
+
+TEST_P(GroupCommitConcurrencyTest, PreservesPerThreadOrder) {
+  std::string dir = TestDir(GetParam() ? "uring" : "writev");
+  GroupCommitOptions options;
+  options.use_io_uring = GetParam();
+  options.max_batch_bytes = 8192;
+  auto sink = OpenSink(dir + "app.log", options);
+  if (GetParam() && !sink->using_io_uring()) {
+    GTEST_SKIP() << "io_uring not available";
+  }
+
+  constexpr int kThreads = 4;
+  constexpr int kRecords = 2000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&sink, t] {
+      // 写线程模式与普通调用线程混合
+      if (t == 0) {
+        sink->begin_batch();
+      }
+      for (int i = 0; i < kRecords; ++i) {
+        Write(*sink, absl::StrCat(t, " ", i));
+      }
+      if (t == 0) {
+        sink->end_batch();
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  sink->flush();
+
+  std::vector<std::string> lines = ReadLines(dir + "app.log");
+  ASSERT_EQ(lines.size(), static_cast<size_t>(kThreads * kRecords));
+  std::vector<int> next(kThreads, 0);
+  for (const std::string& line : lines) {
+    std::vector<std::string> parts = absl::StrSplit(line, ' ');
+    ASSERT_EQ(parts.size(), 2u);
+    int t = std::stoi(parts[0]);
+    ASSERT_EQ(std::stoi(parts[1]), next[t]) << "thread " << t;
+    ++next[t];
+  }
+
+  GroupCommitStats stats = sink->stats();
+  EXPECT_EQ(stats.records, static_cast<uint64_t>(kThreads * kRecords));
+  EXPECT_LE(stats.batches, stats.records);
+  EXPECT_EQ(stats.errors, 0u);
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, GroupCommitConcurrencyTest,
+                         testing::Values(false, true),
+                         [](const testing::TestParamInfo<bool>& info) {
+                           return info.param ? "IoUring" : "Writev";
+                         });
+
+TEST(GroupCommitSinkTest, BackendWritesThroughGroupCommit) {
+  LogOptions options;
+  options.mode = LogMode::kAsync;
+  options.group_commit.enabled = true;
+  options.pattern = "%v";
+  {
+    SpdlogBackend backend;
+    ASSERT_TRUE(backend.init("group_commit_backend_test", LogLevel::kInfo,
+                             options)
+                    .ok());
+    backend.log(LogLevel::kInfo, "group commit one");
+    backend.log(LogLevel::kInfo, "group commit two");
+    backend.flush();
+    backend.shutdown();
+  }
+  EXPECT_EQ(ReadFile("group_commit_backend_test.log"),
+            "group commit one\ngroup commit two\n");
+  fs::remove("group_commit_backend_test.log");
+}
+
+TEST(GroupCommitSinkTest, BackendRejectsRotationCombination) {
+  LogOptions options;
+  options.group_commit.enabled = true;
+  options.rotation.max_file_size = 1 << 20;
+  SpdlogBackend backend;
+  EXPECT_TRUE(absl::IsInvalidArgument(
+      backend.init("group_commit_invalid_test", LogLevel::kInfo, options)));
+}
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_ENABLE_LOG_SPDLOG
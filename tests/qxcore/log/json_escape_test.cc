@@ -0,0 +1,152 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/json_escape.h"
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "qxcore/log/fmt.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+using internal::SimdLevel;
+
+std::string ToJson(absl::string_view text, SimdLevel level) {
+  std::string out(MaxJsonStringSize(text.size()), '\0');
+  char* end = internal::WriteJsonString(text, out.data(), level);
+  out.resize(static_cast<size_t>(end - out.data()));
+  return out;
+}
+
+// 当前 CPU 支持的全部实现
+std::vector<SimdLevel> SupportedLevels() {
+  std::vector<SimdLevel> levels;
+  for (SimdLevel level :
+       {SimdLevel::kScalar, SimdLevel::kSse2, SimdLevel::kAvx2}) {
+    if (level <= internal::DetectSimdLevel()) {
+      levels.push_back(level);
+    }
+  }
+  return levels;
+}
+
+// 由合法字符、边界字符与随机字节拼成的测试串，覆盖跨块的多字节序列
+std::string RandomText(std::mt19937& rng) {
+  static const char* const kPieces[] = {
+      "a", "quote\"", "\\", "\n", "\t", "\x01", "\x1f", "\x7f",
+      "\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80", "\xed\x9f\xbf",
+      "\xef\xbf\xbf", "\xf4\x8f\xbf\xbf", "abcdefghijklmnopqrstuvwxyz0123456789",
+  };
+  std::uniform_int_distribution<int> length(0, 80);
+  std::uniform_int_distribution<size_t> piece(0, std::size(kPieces) - 1);
+  std::uniform_int_distribution<int> byte(0, 255);
+  std::uniform_int_distribution<int> mutate(0, 9);
+  std::string text;
+  int pieces = length(rng);
+  for (int i = 0; i < pieces; ++i) {
+    if (mutate(rng) == 0) {
+      text.push_back(static_cast<char>(byte(rng)));
+    } else {
+      text += kPieces[piece(rng)];
+    }
+  }
+  return text;
+}
+
+}  // anonymous namespace
+
+TEST(JsonEscapeTest, EscapesSpecialCharacters) {
+  for (SimdLevel level : SupportedLevels()) {
+    EXPECT_EQ(ToJson("", level), "\"\"");
+    EXPECT_EQ(ToJson("plain text", level), "\"plain text\"");
+    EXPECT_EQ(ToJson("a\"b\\c", level), "\"a\\\"b\\\\c\"");
+    EXPECT_EQ(ToJson("\b\f\n\r\t", level), "\"\\b\\f\\n\\r\\t\"");
+    EXPECT_EQ(ToJson(absl::string_view("\x00\x1f", 2), level),
+              "\"\\u0000\\u001f\"");
+    EXPECT_EQ(ToJson("caf\xc3\xa9 \xe2\x82\xac", level),
+              "\"caf\xc3\xa9 \xe2\x82\xac\"");
+  }
+}
+
+TEST(JsonEscapeTest, FindsEscapesPastBlockBoundaries) {
+  for (SimdLevel level : SupportedLevels()) {
+    for (size_t position = 0; position < 70; ++position) {
+      std::string text(70, 'x');
+      text[position] = '"';
+      std::string expected = "\"" + text.substr(0, position) + "\\\"" +
+                             text.substr(position + 1) + "\"";
+      EXPECT_EQ(ToJson(text, level), expected) << "position " << position;
+    }
+  }
+}
+
+TEST(JsonEscapeTest, ReplacesInvalidUtf8) {
+  for (SimdLevel level : SupportedLevels()) {
+    // 孤立的延续字节、过长编码、代理区、超出范围与截断的序列
+    EXPECT_EQ(ToJson("a\x80z", level), "\"a\\ufffdz\"");
+    EXPECT_EQ(ToJson("\xc0\xaf", level), "\"\\ufffd\\ufffd\"");
+    EXPECT_EQ(ToJson("\xed\xa0\x80", level), "\"\\ufffd\\ufffd\\ufffd\"");
+    EXPECT_EQ(ToJson("\xf4\x90\x80\x80", level),
+              "\"\\ufffd\\ufffd\\ufffd\\ufffd\"");
+    EXPECT_EQ(ToJson("ok\xe2\x82", level), "\"ok\\ufffd\\ufffd\"");
+    EXPECT_EQ(ToJson("\"\xff\"", level), "\"\\\"\\ufffd\\\"\"");
+  }
+}
+
+TEST(JsonEscapeTest, ValidatesUtf8) {
+  for (SimdLevel level : SupportedLevels()) {
+    EXPECT_TRUE(internal::IsValidUtf8("", level));
+    EXPECT_TRUE(internal::IsValidUtf8("\xf0\x9f\x98\x80 ok", level));
+    EXPECT_FALSE(internal::IsValidUtf8("\xf0\x9f\x98", level));
+    EXPECT_FALSE(internal::IsValidUtf8("\xe0\x80\x80", level));
+    // 截断的序列恰好落在 32 字节块末尾
+    std::string text(31, 'a');
+    text += "\xe2";
+    EXPECT_FALSE(internal::IsValidUtf8(text, level));
+    text += "\x82\xac";
+    EXPECT_TRUE(internal::IsValidUtf8(text, level));
+  }
+}
+
+TEST(JsonEscapeTest, SimdMatchesScalar) {
+  std::mt19937 rng(20261016);
+  std::vector<SimdLevel> levels = SupportedLevels();
+  for (int i = 0; i < 20000; ++i) {
+    std::string text = RandomText(rng);
+    bool valid = internal::IsValidUtf8(text, SimdLevel::kScalar);
+    std::string expected = ToJson(text, SimdLevel::kScalar);
+    for (SimdLevel level : levels) {
+      ASSERT_EQ(internal::IsValidUtf8(text, level), valid)
+          << "level " << static_cast<int>(level) << " input "
+          << ToJson(text, SimdLevel::kScalar);
+      ASSERT_EQ(ToJson(text, level), expected);
+    }
+  }
+}
+
+TEST(JsonEscapeTest, AppendsToBuffer) {
+  fmt::memory_buffer buffer;
+  buffer.append(absl::string_view("{\"k\":"));
+  AppendJsonString("v\n", buffer);
+  EXPECT_EQ(fmt::to_string(buffer), "{\"k\":\"v\\n\"");
+  EXPECT_TRUE(IsValidUtf8("\xc3\xa9"));
+}
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,338 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/level_control.h"
+#include <gtest/gtest.h>
+#include <signal.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <absl/strings/str_cat.h>
+#include "qxcore/log/log.h"
+#include "qxcore/log/logger_registry.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+// 固定调用点，行号由 kDebugLine/kInfoLine 记录
+constexpr int kDebugLine = __LINE__ + 3;
+constexpr int kInfoLine = __LINE__ + 3;
+void LogBoth(DefaultLog& logger, int* evaluations) {
+  QXLOG_DEBUG(logger, "level control debug {}", ++*evaluations);
+  QXLOG_INFO(logger, "level control info {}", ++*evaluations);
+}
+
+// CallsiteRulesApplyToLaterCallsites 每次运行构造的调用点从该行号起编号，
+// 不与源文件中的真实调用点重合
+constexpr int kLateLineBase = 100000;
+
+const Callsite* FindCallsite(int line) {
+  const Callsite* found = nullptr;
+  CallsiteRegistry::Global().for_each([&](const Callsite& callsite) {
+    if (callsite.line() == line &&
+        absl::string_view(callsite.file()).find("level_control_test.cc") !=
+            absl::string_view::npos) {
+      found = &callsite;
+    }
+  });
+  return found;
+}
+
+void WriteFile(const std::string& path, const std::string& content) {
+  std::ofstream out(path, std::ios::trunc);
+  out << content;
+}
+
+// 等待控制线程处理完 count 个事件
+bool WaitForEvents(const LevelController& controller, uint64_t count) {
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (controller.handled_events() < count) {
+    if (std::chrono::steady_clock::now() > deadline) {
+      return false;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+LogLevel NamedLevel(absl::string_view name) {
+  LoggerId id = kNoLoggerId;
+  EXPECT_TRUE(LoggerRegistry::Global().get(name, &id).ok());
+  return LoggerRegistry::Global().get_level(id);
+}
+
+}  // anonymous namespace
+
+TEST(LevelControlTest, ParsesConfig) {
+  LevelConfig config;
+  ASSERT_TRUE(ParseLevelConfig("# 故障排查\n"
+                               "level = Debug\n"
+                               "logger.qx.md.feed = trace  # 行情\n"
+                               "\n"
+                               "callsite.feed_handler.cc = warn\n"
+                               "callsite.src/router.cc:42 = on\n"
+                               "callsite.router.cc:43 = default\n",
+                               &config)
+                  .ok());
+  EXPECT_TRUE(config.has_global);
+  EXPECT_EQ(config.global, LogLevel::kDebug);
+  ASSERT_EQ(config.loggers.size(), 1u);
+  EXPECT_EQ(config.loggers[0].first, "qx.md.feed");
+  EXPECT_EQ(config.loggers[0].second, LogLevel::kTrace);
+  ASSERT_EQ(config.callsites.size(), 3u);
+  EXPECT_EQ(config.callsites[0].file, "feed_handler.cc");
+  EXPECT_EQ(config.callsites[0].line, 0);
+  EXPECT_TRUE(config.callsites[0].has_level);
+  EXPECT_EQ(config.callsites[0].level, LogLevel::kWarn);
+  EXPECT_EQ(config.callsites[1].file, "src/router.cc");
+  EXPECT_EQ(config.callsites[1].line, 42);
+  EXPECT_EQ(config.callsites[1].value, CallsiteOverride::kForceOn);
+  EXPECT_EQ(config.callsites[2].value, CallsiteOverride::kNone);
+
+  EXPECT_TRUE(ParseLevelConfig("", &config).ok());
+  EXPECT_FALSE(config.has_global);
+
+  absl::Status status = ParseLevelConfig("level = info\nlevel = loud\n", &config);
+  EXPECT_TRUE(absl::IsInvalidArgument(status));
+  EXPECT_NE(status.message().find("Line 2"), absl::string_view::npos);
+  EXPECT_FALSE(ParseLevelConfig("verbose = on\n", &config).ok());
+  EXPECT_FALSE(ParseLevelConfig("level debug\n", &config).ok());
+  EXPECT_FALSE(ParseLevelConfig("logger. = debug\n", &config).ok());
+  EXPECT_FALSE(ParseLevelConfig("callsite.a.cc:x = on\n", &config).ok());
+  EXPECT_FALSE(ParseLevelConfig("callsite.a.cc = maybe\n", &config).ok());
+}
+
+TEST(LevelControlTest, ApplyIsDeclarative) {
+  // 每次运行使用新名字，不受之前运行遗留的注册表状态影响
+  static int run = 0;
+  const std::string name = absl::StrCat("level_control_apply", run++);
+  const std::string feed = name + ".feed";
+  const std::string router = name + ".router";
+  DefaultLog logger;
+  ASSERT_TRUE(logger.init("level_control_apply_test", LogLevel::kWarn).ok());
+  LogLevel root = LoggerRegistry::Global().get_level(kRootLoggerId);
+
+  LevelController controller;
+  controller.attach(&logger);
+  LevelConfig config;
+  ASSERT_TRUE(ParseLevelConfig(absl::StrCat("level = debug\n",
+                                            "logger.", feed, " = trace\n"),
+                               &config)
+                  .ok());
+  ASSERT_TRUE(controller.apply(config).ok());
+  EXPECT_EQ(logger.get_level(), LogLevel::kDebug);
+  EXPECT_EQ(LoggerRegistry::Global().get_level(kRootLoggerId), LogLevel::kDebug);
+  EXPECT_EQ(NamedLevel(feed), LogLevel::kTrace);
+  EXPECT_EQ(NamedLevel(router), LogLevel::kDebug);
+
+  // 不再出现的条目恢复原状
+  ASSERT_TRUE(controller.apply(LevelConfig()).ok());
+  EXPECT_EQ(logger.get_level(), LogLevel::kWarn);
+  EXPECT_EQ(LoggerRegistry::Global().get_level(kRootLoggerId), root);
+  EXPECT_EQ(NamedLevel(feed), root);
+  logger.shutdown();
+}
+
+TEST(LevelControlTest, RestoresPriorExplicitLoggerLevels) {
+  // 每次运行使用新名字，不受之前运行遗留的注册表状态影响
+  static int run = 0;
+  const std::string name = absl::StrCat("level_control_prior", run++);
+  const std::string owned = name + ".owned";
+  const std::string fresh = name + ".fresh";
+  LoggerRegistry& registry = LoggerRegistry::Global();
+  ASSERT_TRUE(registry.set_level(owned, LogLevel::kError).ok());
+
+  LevelController controller;
+  LevelConfig config;
+  ASSERT_TRUE(ParseLevelConfig(absl::StrCat("logger.", owned, " = trace\n",
+                                            "logger.", fresh, " = debug\n"),
+                               &config)
+                  .ok());
+  ASSERT_TRUE(controller.apply(config).ok());
+  EXPECT_EQ(NamedLevel(owned), LogLevel::kTrace);
+  EXPECT_EQ(NamedLevel(fresh), LogLevel::kDebug);
+
+  // 删除条目后恢复应用程序自己设置的级别，原本继承的恢复继承
+  ASSERT_TRUE(controller.apply(LevelConfig()).ok());
+  LogLevel level;
+  ASSERT_TRUE(registry.explicit_level(owned, &level));
+  EXPECT_EQ(level, LogLevel::kError);
+  EXPECT_FALSE(registry.explicit_level(fresh, &level));
+}
+
+TEST(LevelControlTest, KeepsRuntimeLevelsWithoutGlobalEntry) {
+  DefaultLog logger;
+  ASSERT_TRUE(logger.init("level_control_runtime_test", LogLevel::kWarn).ok());
+  LevelController controller;
+  controller.attach(&logger);
+
+  // 不含全局级别的配置不改动程序在挂接之后自己设置的级别
+  ASSERT_TRUE(logger.set_level(LogLevel::kError).ok());
+  LevelConfig config;
+  ASSERT_TRUE(controller.apply(config).ok());
+  EXPECT_EQ(logger.get_level(), LogLevel::kError);
+
+  // 全局级别按应用时的级别恢复，而不是挂接时的级别
+  ASSERT_TRUE(ParseLevelConfig("level = debug\n", &config).ok());
+  ASSERT_TRUE(controller.apply(config).ok());
+  EXPECT_EQ(logger.get_level(), LogLevel::kDebug);
+  ASSERT_TRUE(controller.apply(LevelConfig()).ok());
+  EXPECT_EQ(logger.get_level(), LogLevel::kError);
+
+  // 恢复后重新记录，之后的全局级别以当时的级别为恢复目标
+  ASSERT_TRUE(logger.set_level(LogLevel::kInfo).ok());
+  ASSERT_TRUE(controller.apply(config).ok());
+  ASSERT_TRUE(controller.apply(LevelConfig()).ok());
+  EXPECT_EQ(logger.get_level(), LogLevel::kInfo);
+  ASSERT_TRUE(controller.apply(LevelConfig()).ok());
+  EXPECT_EQ(logger.get_level(), LogLevel::kInfo);
+  logger.shutdown();
+}
+
+TEST(LevelControlTest, CallsiteLevelsIgnoreLoggerLevel) {
+  DefaultLog logger;
+  ASSERT_TRUE(logger.init("level_control_callsite_test", LogLevel::kError).ok());
+  int evaluations = 0;
+  LogBoth(logger, &evaluations);
+  const Callsite* debug = FindCallsite(kDebugLine);
+  const Callsite* info = FindCallsite(kInfoLine);
+  ASSERT_NE(debug, nullptr);
+  ASSERT_NE(info, nullptr);
+
+  LevelController controller;
+  LevelConfig config;
+  ASSERT_TRUE(
+      ParseLevelConfig("callsite.level_control_test.cc = info\n", &config)
+          .ok());
+  ASSERT_TRUE(controller.apply(config).ok());
+  EXPECT_EQ(debug->override_value(), CallsiteOverride::kForceOff);
+  EXPECT_EQ(info->override_value(), CallsiteOverride::kForceOn);
+  evaluations = 0;
+  LogBoth(logger, &evaluations);
+  EXPECT_EQ(evaluations, 1);
+
+  ASSERT_TRUE(controller.apply(LevelConfig()).ok());
+  EXPECT_EQ(debug->override_value(), CallsiteOverride::kNone);
+  EXPECT_EQ(info->override_value(), CallsiteOverride::kNone);
+  evaluations = 0;
+  LogBoth(logger, &evaluations);
+  EXPECT_EQ(evaluations, 0);
+  logger.shutdown();
+}
+
+TEST(LevelControlTest, CallsiteRulesApplyToLaterCallsites) {
+  // 调用点登记后一直留在全局注册表中，每次运行构造一个新行号的调用点并有意泄漏
+  static int run = 0;
+  const int line = kLateLineBase + run++;
+  Callsite* late = new Callsite(__FILE__, line, "late", "level control late",
+                                LogLevel::kDebug);
+  DefaultLog logger;
+  ASSERT_TRUE(logger.init("level_control_late_test", LogLevel::kInfo).ok());
+
+  LevelController controller;
+  LevelConfig config;
+  ASSERT_TRUE(ParseLevelConfig(absl::StrCat("callsite.level_control_test.cc:",
+                                            line, " = debug\n"),
+                               &config)
+                  .ok());
+  ASSERT_TRUE(controller.apply(config).ok());
+
+  // 调用点在规则设置之后才首次执行
+  EXPECT_EQ(late->state(), Callsite::kUnregistered);
+  EXPECT_TRUE(late->should_log(logger));
+  EXPECT_EQ(FindCallsite(line), late);
+  EXPECT_EQ(late->override_value(), CallsiteOverride::kForceOn);
+
+  ASSERT_TRUE(controller.apply(LevelConfig()).ok());
+  EXPECT_EQ(late->override_value(), CallsiteOverride::kNone);
+  EXPECT_FALSE(late->should_log(logger));
+  logger.shutdown();
+}
+
+#if defined(__linux__)
+TEST(LevelControlTest, ReloadsWhenFileChanges) {
+  const std::string path = "level_control_test.conf";
+  std::remove(path.c_str());
+  DefaultLog logger;
+  ASSERT_TRUE(logger.init("level_control_watch_test", LogLevel::kInfo).ok());
+
+  LevelController controller;
+  controller.attach(&logger);
+  LevelControlOptions options;
+  options.config_path = path;
+  // 文件尚不存在时也能启动
+  ASSERT_TRUE(controller.start(options).ok());
+  EXPECT_EQ(logger.get_level(), LogLevel::kInfo);
+
+  WriteFile(path, "level = trace\n");
+  ASSERT_TRUE(WaitForEvents(controller, 1));
+  EXPECT_TRUE(controller.last_status().ok());
+  EXPECT_EQ(logger.get_level(), LogLevel::kTrace);
+
+  // 解析失败时保留已应用的级别
+  WriteFile(path, "level = loud\n");
+  ASSERT_TRUE(WaitForEvents(controller, 2));
+  EXPECT_TRUE(absl::IsInvalidArgument(controller.last_status()));
+  EXPECT_EQ(logger.get_level(), LogLevel::kTrace);
+
+  // 以改名方式替换
+  WriteFile(path + ".tmp", "level = error\n");
+  ASSERT_EQ(std::rename((path + ".tmp").c_str(), path.c_str()), 0);
+  ASSERT_TRUE(WaitForEvents(controller, 3));
+  EXPECT_EQ(logger.get_level(), LogLevel::kError);
+
+  WriteFile(path, "");
+  ASSERT_TRUE(WaitForEvents(controller, 4));
+  EXPECT_EQ(logger.get_level(), LogLevel::kInfo);
+  controller.stop();
+  std::remove(path.c_str());
+  logger.shutdown();
+}
+
+TEST(LevelControlTest, SignalsRaiseAndRestoreVerbosity) {
+  DefaultLog logger;
+  ASSERT_TRUE(logger.init("level_control_signal_test", LogLevel::kWarn).ok());
+  LogLevel root = LoggerRegistry::Global().get_level(kRootLoggerId);
+
+  LevelController controller;
+  controller.attach(&logger);
+  LevelControlOptions options;
+  options.handle_signals = true;
+  ASSERT_TRUE(controller.start(options).ok());
+
+  LevelController other;
+  EXPECT_TRUE(absl::IsFailedPrecondition(other.start(options)));
+
+  ASSERT_EQ(::raise(SIGUSR1), 0);
+  ASSERT_TRUE(WaitForEvents(controller, 1));
+  EXPECT_EQ(logger.get_level(), LogLevel::kInfo);
+  ASSERT_EQ(::raise(SIGUSR1), 0);
+  ASSERT_TRUE(WaitForEvents(controller, 2));
+  EXPECT_EQ(logger.get_level(), LogLevel::kDebug);
+
+  ASSERT_EQ(::raise(SIGUSR2), 0);
+  ASSERT_TRUE(WaitForEvents(controller, 3));
+  EXPECT_EQ(logger.get_level(), LogLevel::kWarn);
+  EXPECT_EQ(LoggerRegistry::Global().get_level(kRootLoggerId), root);
+  controller.stop();
+  logger.shutdown();
+}
+#endif  // defined(__linux__)
+
+}  // namespace log
+}  // namespace qxcore
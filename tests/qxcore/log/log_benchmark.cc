@@ -15,16 +15,45 @@
 #include "qxcore/log/log.h"
 #include <benchmark/benchmark.h>
 #include <absl/status/status.h>
+#include <absl/strings/str_cat.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
+#include "qxcore/log/json_escape.h"
+#include "qxcore/log/latency_histogram.h"
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+#include <spdlog/pattern_formatter.h>
+#include "qxcore/log/group_commit_sink.h"
+#include "qxcore/log/pattern_formatter.h"
+#endif
+#ifdef QXCORE_ENABLE_LOG_GLOG
+#include "qxcore/log/glog_backend.h"
+#endif
 
 namespace qxcore {
 namespace log {
 
 // 基准测试辅助类
 class LogBenchmark {
- protected:
-  static void SetUpBackend(auto* backend, const std::string& name) {
-    absl::Status status = backend->init(name, LogLevel::kInfo);
+ public:
+  // 输出到 NullSink 的选项：测量前端开销，不受终端和磁盘影响
+  static LogOptions NullOutput(LogMode mode = LogMode::kSync) {
+    LogOptions options;
+    options.mode = mode;
+    options.output = LogOutput::kNull;
+    return options;
+  }
+
+  template<typename Backend>
+  static void SetUpBackend(Backend* backend, const std::string& name) {
+    absl::Status status = backend->init(name, LogLevel::kInfo, NullOutput());
     if (!status.ok()) {
       // 在基准测试中，我们假设初始化成功
       // 如果失败，测试会自动跳过
@@ -32,10 +61,179 @@ class LogBenchmark {
   }
 };
 
+namespace {
+
+// 每隔多少次调用采样一次延迟；采样本身的两次时钟读取计入吞吐量
+constexpr uint64_t kLatencySampleInterval = 8;
+
+// 合并各线程的直方图，由最后一个完成的线程写入 p50/p99/p99.9 计数器
+//
+// 框架对各线程的同名计数器求和，只有一个线程设置这些计数器，因此结果
+// 就是合并后的分位值。同一基准的各线程在下一轮开始前全部结束，静态
+// 合并状态不会跨轮混用。
+void ReportLatency(benchmark::State& state, const LatencyHistogram& local) {
+  static std::mutex mutex;
+  static LatencyHistogram* merged = new LatencyHistogram();
+  static int merged_threads = 0;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  merged->merge(local);
+  if (++merged_threads < state.threads()) {
+    return;
+  }
+  double nanos_per_tick = TscClock::Global().nanos_per_tick();
+  state.counters["p50_ns"] = merged->percentile(0.50) * nanos_per_tick;
+  state.counters["p99_ns"] = merged->percentile(0.99) * nanos_per_tick;
+  state.counters["p999_ns"] = merged->percentile(0.999) * nanos_per_tick;
+  merged->clear();
+  merged_threads = 0;
+}
+
+// 循环调用 fn，吞吐量由框架按迭代数统计，同时采样单次调用延迟
+template<typename Fn>
+void RunMeasured(benchmark::State& state, Fn&& fn) {
+  LatencyHistogram histogram;
+  uint64_t calls = 0;
+  for (auto _ : state) {
+    if (++calls % kLatencySampleInterval == 0) {
+      uint64_t start = TscClock::ReadTicks();
+      fn();
+      histogram.record(TscClock::ReadTicks() - start);
+    } else {
+      fn();
+    }
+  }
+  state.SetItemsProcessed(state.iterations());
+  ReportLatency(state, histogram);
+}
+
+// 输出到 NullSink 的共用日志器
+//
+// 每种工作模式在首次使用时初始化一次，同一基准的所有生产者线程共享
+// 同一实例；后端不支持的模式对应空指针。
+template<typename Backend>
+class NullLoggers {
+ public:
+  static Log<Backend>* Get(LogMode mode) {
+    static NullLoggers loggers;
+    return loggers.loggers_[static_cast<size_t>(mode)].get();
+  }
+
+ private:
+  NullLoggers() {
+    for (LogMode mode : {LogMode::kSync, LogMode::kAsync, LogMode::kDeferred}) {
+      auto logger = std::make_unique<Log<Backend>>();
+      absl::Status status = logger->init(
+          absl::StrCat("benchmark_null_", static_cast<int>(mode)),
+          LogLevel::kInfo, LogBenchmark::NullOutput(mode));
+      if (status.ok()) {
+        loggers_[static_cast<size_t>(mode)] = std::move(logger);
+      }
+    }
+  }
+
+  std::array<std::unique_ptr<Log<Backend>>, 3> loggers_;
+};
+
+// 取 range(0) 指定工作模式的日志器，不支持时标记跳过
+template<typename Backend>
+Log<Backend>* NullLoggerFor(benchmark::State& state) {
+  Log<Backend>* logger =
+      NullLoggers<Backend>::Get(static_cast<LogMode>(state.range(0)));
+  if (logger == nullptr) {
+    state.SkipWithError("Log mode not supported by backend");
+  }
+  return logger;
+}
+
+// 生产者线程数上限：至少 2，以覆盖多线程竞争路径
+int MaxProducerThreads() {
+  return std::max(2, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+// 参数类型扫描的负载
+struct NoArgs {
+  template<typename Backend>
+  static void Write(Log<Backend>& logger) {
+    logger.info("order accepted");
+  }
+};
+
+struct IntArgs {
+  template<typename Backend>
+  static void Write(Log<Backend>& logger) {
+    logger.info("order {} qty {} side {} venue {}", 1234567, 100, -1,
+                int64_t{7000000001});
+  }
+};
+
+struct DoubleArgs {
+  template<typename Backend>
+  static void Write(Log<Backend>& logger) {
+    logger.info("px {} bid {} ask {} mid {}", 101.25, 101.0, 101.5, 0.000125);
+  }
+};
+
+struct StringArgs {
+  template<typename Backend>
+  static void Write(Log<Backend>& logger) {
+    logger.info("sym {} acct {} venue {} tag {}", "AAPL", "ACC-001", "XNAS",
+                std::string_view("strategy-7"));
+  }
+};
+
+struct MixedArgs {
+  template<typename Backend>
+  static void Write(Log<Backend>& logger) {
+    logger.info("fill {} {} @ {} done={}", 42, "AAPL", 101.25, true);
+  }
+};
+
+}  // namespace
+
+// 多生产者吞吐量与延迟：range(0) 为 LogMode，线程数由 ThreadRange 指定
+template<typename Backend>
+static void BM_Threads(benchmark::State& state) {
+  Log<Backend>* logger = NullLoggerFor<Backend>(state);
+  if (logger == nullptr) {
+    return;
+  }
+  int64_t order_id = state.thread_index();
+  RunMeasured(state, [&] {
+    logger->info("order {} px {} qty {}", order_id, 101.25, 100);
+    order_id += state.threads();
+  });
+}
+
+// 消息长度扫描：range(0) 为 LogMode，range(1) 为负载字节数
+template<typename Backend>
+static void BM_MessageSize(benchmark::State& state) {
+  Log<Backend>* logger = NullLoggerFor<Backend>(state);
+  if (logger == nullptr) {
+    return;
+  }
+  std::string payload(static_cast<size_t>(state.range(1)), 'x');
+  RunMeasured(state, [&] { logger->info("{}", payload); });
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(payload.size()));
+}
+
+// 参数类型扫描：range(0) 为 LogMode
+template<typename Backend, typename Payload>
+static void BM_ArgType(benchmark::State& state) {
+  Log<Backend>* logger = NullLoggerFor<Backend>(state);
+  if (logger == nullptr) {
+    return;
+  }
+  RunMeasured(state, [&] { Payload::Write(*logger); });
+}
+
 // 默认日志器基准测试
 static void BM_DefaultLog_Info(benchmark::State& state) {
+  absl::Status status = InitDefaultLogger("benchmark_default", LogLevel::kInfo,
+                                          LogBenchmark::NullOutput());
+  // 替换全局日志器后再获取引用，之前的引用会在替换后失效
   DefaultLog& logger = GetDefaultLogger();
-  absl::Status status = InitDefaultLogger("benchmark_default", LogLevel::kInfo);
   
   if (!status.ok()) {
     state.SkipWithError("Failed to initialize default logger");
@@ -50,8 +248,9 @@ static void BM_DefaultLog_Info(benchmark::State& state) {
 }
 
 static void BM_DefaultLog_Formatted(benchmark::State& state) {
+  absl::Status status = InitDefaultLogger("benchmark_default", LogLevel::kInfo,
+                                          LogBenchmark::NullOutput());
   DefaultLog& logger = GetDefaultLogger();
-  absl::Status status = InitDefaultLogger("benchmark_default", LogLevel::kInfo);
   
   if (!status.ok()) {
     state.SkipWithError("Failed to initialize default logger");
@@ -65,8 +264,238 @@ static void BM_DefaultLog_Formatted(benchmark::State& state) {
   state.SetItemsProcessed(state.iterations());
 }
 
+// 与 BM_DefaultLog_Formatted 相同的消息，格式串在编译期解析
+static void BM_DefaultLog_FormattedCompiled(benchmark::State& state) {
+  absl::Status status = InitDefaultLogger("benchmark_default", LogLevel::kInfo,
+                                          LogBenchmark::NullOutput());
+  DefaultLog& logger = GetDefaultLogger();
+
+  if (!status.ok()) {
+    state.SkipWithError("Failed to initialize default logger");
+    return;
+  }
+
+  for (auto _ : state) {
+    logger.info(QXLOG_FMT("Benchmark test message with number: {}"), 42);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+// 级别未启用的宏调用：只读取一次调用点开关
+static void BM_DefaultLog_MacroDisabled(benchmark::State& state) {
+  absl::Status status = InitDefaultLogger("benchmark_default", LogLevel::kInfo,
+                                          LogBenchmark::NullOutput());
+  DefaultLog& logger = GetDefaultLogger();
+
+  if (!status.ok()) {
+    state.SkipWithError("Failed to initialize default logger");
+    return;
+  }
+
+  for (auto _ : state) {
+    QXLOG_DEBUG(logger, "Benchmark test message with number: {}", 42);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+// 被限流丢弃的宏调用：级别检查之后只有一次限流器原子操作
+static void BM_DefaultLog_MacroSuppressed(benchmark::State& state) {
+  absl::Status status = InitDefaultLogger("benchmark_default", LogLevel::kInfo,
+                                          LogBenchmark::NullOutput());
+  DefaultLog& logger = GetDefaultLogger();
+
+  if (!status.ok()) {
+    state.SkipWithError("Failed to initialize default logger");
+    return;
+  }
+
+  for (auto _ : state) {
+    QXLOG_WARN_EVERY_MS(logger, 60000, "Benchmark test message with number: {}",
+                        42);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+// 多线程经全局日志器宏写出级别未启用的记录：每次调用进入一次 epoch 读区间
+// 并读取全局日志器指针，线程数由 ThreadRange 指定
+static void BM_GlobalMacro_Filtered(benchmark::State& state) {
+  // 各线程在计时循环开始前同步，只由第一个线程替换全局日志器
+  if (state.thread_index() == 0) {
+    absl::Status status = InitDefaultLogger(
+        "benchmark_global", LogLevel::kWarn, LogBenchmark::NullOutput());
+    if (!status.ok()) {
+      state.SkipWithError("Failed to initialize default logger");
+    }
+  }
+
+  for (auto _ : state) {
+    QXLOG_GLOBAL_INFO("Benchmark test message with number: {}", 42);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+// 单独测量格式化开销，排除写出的干扰
+static void BM_FormatTo_Runtime(benchmark::State& state) {
+  fmt::memory_buffer buffer;
+  for (auto _ : state) {
+    buffer.clear();
+    FormatTo(buffer, "Benchmark test message with number: {} {}", 42, 3.5);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_FormatTo_Compiled(benchmark::State& state) {
+  fmt::memory_buffer buffer;
+  for (auto _ : state) {
+    buffer.clear();
+    FormatTo(buffer, QXLOG_FMT("Benchmark test message with number: {} {}"),
+             42, 3.5);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// 记录时间戳的读取开销：TSC 计数与系统时钟
+static void BM_Clock_ReadTicks(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(TscClock::ReadTicks());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_Clock_SystemNow(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(std::chrono::system_clock::now());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
 #ifdef QXCORE_ENABLE_LOG_SPDLOG
 
+// 默认格式的单条记录格式化开销：spdlog 原生格式化器与预编译格式化器，
+// 时间每次前进 1 微秒，大部分记录命中同一秒的缓存
+template<typename Formatter>
+static void RunPatternBenchmark(benchmark::State& state, Formatter& formatter) {
+  spdlog::details::log_msg msg(spdlog::source_loc{}, "benchmark",
+                               spdlog::level::info,
+                               "Benchmark test message with number: 42");
+  spdlog::memory_buf_t buffer;
+  for (auto _ : state) {
+    msg.time += std::chrono::microseconds(1);
+    buffer.clear();
+    formatter.format(msg, buffer);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_Pattern_Stock(benchmark::State& state) {
+  spdlog::pattern_formatter formatter(kDefaultLogPattern);
+  RunPatternBenchmark(state, formatter);
+}
+
+static void BM_Pattern_Compiled(benchmark::State& state) {
+  std::unique_ptr<PatternFormatter> formatter;
+  if (!PatternFormatter::Compile(kDefaultLogPattern, &formatter).ok()) {
+    state.SkipWithError("Failed to compile pattern");
+    return;
+  }
+  RunPatternBenchmark(state, *formatter);
+}
+
+// 每条记录带策略、账户与会话：range(0) 为 0 时作为格式参数逐条格式化，
+// 为 1 时放入 ScopedLogContext，由 %& 按字节拷贝
+static void BM_Pattern_Context(benchmark::State& state) {
+  std::unique_ptr<PatternFormatter> formatter;
+  if (!PatternFormatter::Compile("%& %v", &formatter).ok()) {
+    state.SkipWithError("Failed to compile pattern");
+    return;
+  }
+  const bool use_context = state.range(0) != 0;
+  const int strategy = 7;
+  const std::string account = "ACC-001";
+  const uint64_t session = 12345;
+  std::optional<ScopedLogContext> context;
+  if (use_context) {
+    context.emplace(kv("strategy", strategy), kv("account", account),
+                    kv("session", session));
+  }
+
+  spdlog::details::log_msg msg(spdlog::source_loc{}, "benchmark",
+                               spdlog::level::info, "");
+  fmt::memory_buffer payload;
+  spdlog::memory_buf_t buffer;
+  for (auto _ : state) {
+    payload.clear();
+    if (use_context) {
+      fmt::format_to(fmt::appender(payload), FMT_COMPILE("order {} sent"), 42);
+    } else {
+      fmt::format_to(fmt::appender(payload),
+                     FMT_COMPILE("strategy={} account={} session={} order {} sent"),
+                     strategy, account, session, 42);
+    }
+    msg.payload = spdlog::string_view_t(payload.data(), payload.size());
+    buffer.clear();
+    formatter->format(msg, buffer);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+// 写入 /dev/null 的批量提交 sink，每种参数组合在首次使用时创建，同一基准的
+// 所有线程共享
+static GroupCommitSink* GroupCommitSinkFor(size_t max_batch_bytes,
+                                           bool use_io_uring) {
+  static std::mutex mutex;
+  static auto* sinks =
+      new std::map<std::pair<size_t, bool>, std::unique_ptr<GroupCommitSink>>();
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& sink = (*sinks)[{max_batch_bytes, use_io_uring}];
+  if (sink == nullptr) {
+    GroupCommitOptions options;
+    options.enabled = true;
+    options.max_batch_bytes = max_batch_bytes;
+    options.use_io_uring = use_io_uring;
+    sink = std::make_unique<GroupCommitSink>(options);
+    sink->set_pattern(kDefaultLogPattern);
+    if (!sink->open("/dev/null", false).ok()) {
+      sink.reset();
+    }
+  }
+  return sink.get();
+}
+
+// 多线程经批量提交 sink 写出：range(0) 为 max_batch_bytes，range(1) 为是否
+// 使用 io_uring。写入 /dev/null，只计格式化与系统调用开销；records_per_write
+// 为平均每次系统调用写出的记录数，线程越多、批次上限越大，该值越高
+static void BM_GroupCommit(benchmark::State& state) {
+  GroupCommitSink* sink = GroupCommitSinkFor(
+      static_cast<size_t>(state.range(0)), state.range(1) != 0);
+  if (sink == nullptr) {
+    state.SkipWithError("Failed to open /dev/null");
+    return;
+  }
+  spdlog::details::log_msg msg(spdlog::source_loc{}, "benchmark",
+                               spdlog::level::info,
+                               "order 1234567 px 101.25 qty 100");
+  for (auto _ : state) {
+    sink->log(msg);
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    GroupCommitStats stats = sink->stats();
+    state.counters["records_per_write"] =
+        stats.write_calls == 0
+            ? 0.0
+            : static_cast<double>(stats.records) / stats.write_calls;
+  }
+}
+
 // SpdlogBackend 基准测试
 static void BM_SpdlogBackend_Info(benchmark::State& state) {
   SpdlogBackend backend;
@@ -93,7 +522,7 @@ static void BM_SpdlogBackend_Formatted(benchmark::State& state) {
 static void BM_SpdlogBackend_Disabled(benchmark::State& state) {
   SpdlogBackend backend;
   LogBenchmark::SetUpBackend(&backend, "benchmark_spdlog");
-  backend.set_level(LogLevel::kError);  // 禁用 INFO 级别
+  backend.set_level(LogLevel::kError).IgnoreError();  // 禁用 INFO 级别
   
   for (auto _ : state) {
     backend.log(LogLevel::kInfo, "This message should be filtered out");
@@ -102,6 +531,25 @@ static void BM_SpdlogBackend_Disabled(benchmark::State& state) {
   state.SetItemsProcessed(state.iterations());
 }
 
+// 同一调用点连续写出相同记录：range(0) 为是否启用重复折叠，启用后除首条外
+// 每条只做参数哈希与比较
+static void BM_SpdlogBackend_Duplicate(benchmark::State& state) {
+  Log<SpdlogBackend> logger;
+  LogOptions options = LogBenchmark::NullOutput();
+  options.dedup.enabled = state.range(0) != 0;
+  options.dedup.window_ms = 3600000;
+  if (!logger.init("benchmark_dedup", LogLevel::kInfo, options).ok()) {
+    state.SkipWithError("Failed to initialize logger");
+    return;
+  }
+
+  for (auto _ : state) {
+    QXLOG_ERROR(logger, "venue {} disconnected: {}", 7, "connection reset");
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
 #endif  // QXCORE_ENABLE_LOG_SPDLOG
 
 #ifdef QXCORE_ENABLE_LOG_GLOG
@@ -132,7 +580,7 @@ static void BM_GlogBackend_Formatted(benchmark::State& state) {
 static void BM_GlogBackend_Disabled(benchmark::State& state) {
   GlogBackend backend;
   LogBenchmark::SetUpBackend(&backend, "benchmark_glog");
-  backend.set_level(LogLevel::kError);  // 禁用 INFO 级别
+  backend.set_level(LogLevel::kError).IgnoreError();  // 禁用 INFO 级别
   
   for (auto _ : state) {
     backend.log(LogLevel::kInfo, "This message should be filtered out");
@@ -143,78 +591,120 @@ static void BM_GlogBackend_Disabled(benchmark::State& state) {
 
 #endif  // QXCORE_ENABLE_LOG_GLOG
 
-// 不同消息大小的基准测试
-static void BM_DefaultLog_SmallMessage(benchmark::State& state) {
-  DefaultLog& logger = GetDefaultLogger();
-  absl::Status status = InitDefaultLogger("benchmark_small", LogLevel::kInfo);
-  
-  if (!status.ok()) {
-    state.SkipWithError("Failed to initialize default logger");
+// JSON 字符串转义：range(0) 为实现（0 标量、1 SSE2、2 AVX2），range(1) 为字节数，
+// 输入为不含需转义字符的 UTF-8 文本，只在末尾带一个引号
+static void BM_JsonEscape(benchmark::State& state) {
+  auto level = static_cast<internal::SimdLevel>(state.range(0));
+  if (level > internal::DetectSimdLevel()) {
+    state.SkipWithError("SIMD level not supported");
     return;
   }
-  
-  std::string small_msg(50, 'x');  // 50 字符消息
-  
-  for (auto _ : state) {
-    logger.info("{}", small_msg);
+  std::string text;
+  while (text.size() + 1 < static_cast<size_t>(state.range(1))) {
+    text += "venue XNAS caf\xc3\xa9 ";
   }
-  
-  state.SetBytesProcessed(state.iterations() * small_msg.size());
-}
-
-static void BM_DefaultLog_MediumMessage(benchmark::State& state) {
-  DefaultLog& logger = GetDefaultLogger();
-  absl::Status status = InitDefaultLogger("benchmark_medium", LogLevel::kInfo);
-  
-  if (!status.ok()) {
-    state.SkipWithError("Failed to initialize default logger");
-    return;
-  }
-  
-  std::string medium_msg(500, 'x');  // 500 字符消息
-  
-  for (auto _ : state) {
-    logger.info("{}", medium_msg);
+  text.resize(static_cast<size_t>(state.range(1)) - 1);
+  // 截断处不能落在多字节序列中间，否则会走替换非法字节的慢路径
+  while (!text.empty() && (static_cast<unsigned char>(text.back()) & 0x80)) {
+    text.pop_back();
   }
-  
-  state.SetBytesProcessed(state.iterations() * medium_msg.size());
-}
+  text.resize(static_cast<size_t>(state.range(1)) - 1, ' ');
+  text += '"';
+  std::string out(MaxJsonStringSize(text.size()), '\0');
 
-static void BM_DefaultLog_LargeMessage(benchmark::State& state) {
-  DefaultLog& logger = GetDefaultLogger();
-  absl::Status status = InitDefaultLogger("benchmark_large", LogLevel::kInfo);
-  
-  if (!status.ok()) {
-    state.SkipWithError("Failed to initialize default logger");
-    return;
-  }
-  
-  std::string large_msg(5000, 'x');  // 5000 字符消息
-  
   for (auto _ : state) {
-    logger.info("{}", large_msg);
+    benchmark::DoNotOptimize(internal::WriteJsonString(text, out.data(), level));
   }
-  
-  state.SetBytesProcessed(state.iterations() * large_msg.size());
+
+  state.SetBytesProcessed(state.iterations() * state.range(1));
 }
 
 // 注册基准测试
 BENCHMARK(BM_DefaultLog_Info);
 BENCHMARK(BM_DefaultLog_Formatted);
-BENCHMARK(BM_DefaultLog_SmallMessage);
-BENCHMARK(BM_DefaultLog_MediumMessage);
-BENCHMARK(BM_DefaultLog_LargeMessage);
+BENCHMARK(BM_DefaultLog_FormattedCompiled);
+BENCHMARK(BM_DefaultLog_MacroDisabled);
+BENCHMARK(BM_DefaultLog_MacroSuppressed);
+BENCHMARK(BM_GlobalMacro_Filtered)
+    ->ThreadRange(1, MaxProducerThreads())
+    ->UseRealTime();
+BENCHMARK(BM_FormatTo_Runtime);
+BENCHMARK(BM_FormatTo_Compiled);
+BENCHMARK(BM_Clock_ReadTicks);
+BENCHMARK(BM_Clock_SystemNow);
+BENCHMARK(BM_JsonEscape)
+    ->ArgNames({"simd", "bytes"})
+    ->ArgsProduct({{0, 1, 2}, {16, 256, 4096}});
 
 #ifdef QXCORE_ENABLE_LOG_SPDLOG
+BENCHMARK(BM_Pattern_Stock);
+BENCHMARK(BM_Pattern_Compiled);
+BENCHMARK(BM_Pattern_Context)->ArgName("context")->Arg(0)->Arg(1);
 BENCHMARK(BM_SpdlogBackend_Info);
 BENCHMARK(BM_SpdlogBackend_Formatted);
 BENCHMARK(BM_SpdlogBackend_Disabled);
+BENCHMARK(BM_SpdlogBackend_Duplicate)->ArgName("dedup")->Arg(0)->Arg(1);
+BENCHMARK(BM_GroupCommit)
+    ->ArgNames({"batch_bytes", "io_uring"})
+    ->ArgsProduct({{4096, 64 * 1024, 1024 * 1024}, {0, 1}})
+    ->ThreadRange(1, MaxProducerThreads())
+    ->UseRealTime();
+
+static void AllModes(benchmark::internal::Benchmark* bench) {
+  bench->ArgName("mode");
+  for (LogMode mode : {LogMode::kSync, LogMode::kAsync, LogMode::kDeferred}) {
+    bench->Arg(static_cast<int64_t>(mode));
+  }
+}
+
+static void AllModesBySize(benchmark::internal::Benchmark* bench) {
+  bench->ArgNames({"mode", "bytes"});
+  for (LogMode mode : {LogMode::kSync, LogMode::kAsync, LogMode::kDeferred}) {
+    for (int64_t size : {16, 64, 256, 1024, 4096}) {
+      bench->Args({static_cast<int64_t>(mode), size});
+    }
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_Threads, SpdlogBackend)
+    ->Apply(AllModes)
+    ->ThreadRange(1, MaxProducerThreads())
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MessageSize, SpdlogBackend)->Apply(AllModesBySize);
+BENCHMARK_TEMPLATE2(BM_ArgType, SpdlogBackend, NoArgs)->Apply(AllModes);
+BENCHMARK_TEMPLATE2(BM_ArgType, SpdlogBackend, IntArgs)->Apply(AllModes);
+BENCHMARK_TEMPLATE2(BM_ArgType, SpdlogBackend, DoubleArgs)->Apply(AllModes);
+BENCHMARK_TEMPLATE2(BM_ArgType, SpdlogBackend, StringArgs)->Apply(AllModes);
+BENCHMARK_TEMPLATE2(BM_ArgType, SpdlogBackend, MixedArgs)->Apply(AllModes);
 #endif
 
 #ifdef QXCORE_ENABLE_LOG_GLOG
 BENCHMARK(BM_GlogBackend_Info);
 BENCHMARK(BM_GlogBackend_Formatted);
 BENCHMARK(BM_GlogBackend_Disabled);
+
+// glog 后端只支持同步模式
+static void SyncMode(benchmark::internal::Benchmark* bench) {
+  bench->ArgName("mode")->Arg(static_cast<int64_t>(LogMode::kSync));
+}
+
+static void SyncModeBySize(benchmark::internal::Benchmark* bench) {
+  bench->ArgNames({"mode", "bytes"});
+  for (int64_t size : {16, 64, 256, 1024, 4096}) {
+    bench->Args({static_cast<int64_t>(LogMode::kSync), size});
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_Threads, GlogBackend)
+    ->Apply(SyncMode)
+    ->ThreadRange(1, MaxProducerThreads())
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_MessageSize, GlogBackend)->Apply(SyncModeBySize);
+BENCHMARK_TEMPLATE2(BM_ArgType, GlogBackend, NoArgs)->Apply(SyncMode);
+BENCHMARK_TEMPLATE2(BM_ArgType, GlogBackend, IntArgs)->Apply(SyncMode);
+BENCHMARK_TEMPLATE2(BM_ArgType, GlogBackend, DoubleArgs)->Apply(SyncMode);
+BENCHMARK_TEMPLATE2(BM_ArgType, GlogBackend, StringArgs)->Apply(SyncMode);
+BENCHMARK_TEMPLATE2(BM_ArgType, GlogBackend, MixedArgs)->Apply(SyncMode);
 #endif
 
 // 性能对比基准测试（如果两个后端都可用）
@@ -226,6 +716,7 @@ static void BM_Comparison_Spdlog_vs_Glog(benchmark::State& state) {
   // 实际的比较结果会在基准测试输出中显示
   state.SkipWithError("Use individual backend benchmarks for comparison");
 }
+BENCHMARK(BM_Comparison_Spdlog_vs_Glog);
 
 #endif  // QXCORE_ENABLE_LOG_GLOG
 #endif  // QXCORE_ENABLE_LOG_SPDLOG
@@ -0,0 +1,165 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/log_context.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <absl/strings/match.h>
+#include <absl/strings/str_split.h>
+#include "qxcore/log/log.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  std::stringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+}  // anonymous namespace
+
+TEST(LogContextTest, PushesAndPopsScopes) {
+  EXPECT_EQ(CurrentLogContext(), "");
+  {
+    ScopedLogContext outer(kv("strategy", 7), kv("account", "A1"));
+    EXPECT_EQ(CurrentLogContext(), "strategy=7 account=A1");
+    {
+      std::string session = "s 1";
+      ScopedLogContext inner(kv("session", session));
+      EXPECT_EQ(CurrentLogContext(), "strategy=7 account=A1 session=\"s 1\"");
+    }
+    EXPECT_EQ(CurrentLogContext(), "strategy=7 account=A1");
+  }
+  EXPECT_EQ(CurrentLogContext(), "");
+}
+
+TEST(LogContextTest, IsThreadLocal) {
+  ScopedLogContext context(kv("strategy", 7));
+  std::string other;
+  std::thread thread([&] {
+    ScopedLogContext local(kv("strategy", 8));
+    other = std::string(CurrentLogContext());
+  });
+  thread.join();
+  EXPECT_EQ(other, "strategy=8");
+  EXPECT_EQ(CurrentLogContext(), "strategy=7");
+}
+
+TEST(LogContextTest, RecordScopeOverridesThreadContext) {
+  ScopedLogContext context(kv("strategy", 7));
+  {
+    internal::RecordContextScope record("strategy=8");
+    EXPECT_EQ(internal::RecordLogContext(), "strategy=8");
+    {
+      internal::RecordContextScope empty("");
+      EXPECT_EQ(internal::RecordLogContext(), "");
+    }
+    EXPECT_EQ(internal::RecordLogContext(), "strategy=8");
+  }
+  EXPECT_EQ(internal::RecordLogContext(), "strategy=7");
+}
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+
+class LogContextLogTest : public ::testing::TestWithParam<LogMode> {
+ protected:
+  void SetUp() override {
+    std::remove(TextPath().c_str());
+    std::remove(JsonPath().c_str());
+    LogOptions options;
+    options.mode = GetParam();
+    options.pattern = "[%&] %v";
+    options.json_lines_path = JsonPath();
+    ASSERT_TRUE(logger_.init(kName, LogLevel::kInfo, options).ok());
+  }
+
+  void TearDown() override {
+    logger_.shutdown();
+    std::remove(JsonPath().c_str());
+  }
+
+  static std::string TextPath() { return kName + std::string(".log"); }
+  static std::string JsonPath() { return kName + std::string(".jsonl"); }
+
+  static std::vector<std::string> Lines(const std::string& path) {
+    return absl::StrSplit(ReadFile(path), '\n', absl::SkipEmpty());
+  }
+
+  static constexpr const char* kName = "log_context_test";
+  Log<SpdlogBackend> logger_;
+};
+
+TEST_P(LogContextLogTest, RendersContextOfProducingThread) {
+  logger_.info("no context");
+  {
+    ScopedLogContext context(kv("strategy", 7), kv("account", "A1"));
+    QXLOG_INFO(logger_, "order {} sent", 1);
+    // 写线程在另一个线程上格式化，上下文必须随记录一起传递
+    std::thread thread([this] {
+      ScopedLogContext local(kv("strategy", 8));
+      QXLOG_INFO(logger_, "order {} sent", 2);
+    });
+    thread.join();
+    logger_.flush();
+    logger_.warn("plain");
+  }
+  logger_.info("after");
+  logger_.flush();
+
+  std::vector<std::string> text = Lines(TextPath());
+  ASSERT_EQ(text.size(), 5u);
+  EXPECT_EQ(text[0], "[] no context");
+  EXPECT_EQ(text[1], "[strategy=7 account=A1] order 1 sent");
+  EXPECT_EQ(text[2], "[strategy=8] order 2 sent");
+  EXPECT_EQ(text[3], "[strategy=7 account=A1] plain");
+  EXPECT_EQ(text[4], "[] after");
+
+  std::vector<std::string> json = Lines(JsonPath());
+  ASSERT_EQ(json.size(), 5u);
+  EXPECT_FALSE(absl::StrContains(json[0], "\"context\""));
+  EXPECT_TRUE(absl::StrContains(
+      json[1], "\"context\":\"strategy=7 account=A1\",\"msg\":\"order 1 sent\""));
+  EXPECT_TRUE(absl::StrContains(json[2], "\"context\":\"strategy=8\""));
+}
+
+TEST_P(LogContextLogTest, CarriesLongContext) {
+  // 超过异步模式内联槽位的上下文走溢出存储
+  std::string account(4096, 'a');
+  ScopedLogContext context(kv("account", account));
+  logger_.info("long");
+  logger_.flush();
+
+  std::vector<std::string> text = Lines(TextPath());
+  ASSERT_EQ(text.size(), 1u);
+  EXPECT_EQ(text[0], "[account=" + account + "] long");
+}
+
+INSTANTIATE_TEST_SUITE_P(Modes, LogContextLogTest,
+                         ::testing::Values(LogMode::kSync, LogMode::kAsync,
+                                           LogMode::kDeferred));
+
+#endif  // QXCORE_ENABLE_LOG_SPDLOG
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,103 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// 本文件以 INFO 作为编译期级别，验证 TRACE/DEBUG 调用被整体移除
+#undef QXCORE_LOG_ACTIVE_LEVEL
+#define QXCORE_LOG_ACTIVE_LEVEL QXLOG_LEVEL_INFO
+
+#include "qxcore/log/log.h"
+#include <gtest/gtest.h>
+#include <string>
+
+namespace qxcore {
+namespace log {
+
+class LogMacroTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ASSERT_TRUE(logger_.init("macro_test", LogLevel::kTrace).ok());
+  }
+
+  void TearDown() override { logger_.shutdown(); }
+
+  int next() { return ++evaluations_; }
+
+  DefaultLog logger_;
+  int evaluations_ = 0;
+};
+
+TEST_F(LogMacroTest, StrippedLevelsDoNotEvaluateArguments) {
+  QXLOG_TRACE(logger_, "trace {}", next());
+  QXLOG_DEBUG(logger_, "debug {}", next());
+  QXLOG_DEBUG_FN(logger_, [&] { return std::to_string(next()); });
+  QXLOG_GLOBAL_DEBUG("global debug {}", next());
+  EXPECT_EQ(evaluations_, 0);
+
+  QXLOG_INFO(logger_, "info {}", next());
+  EXPECT_EQ(evaluations_, 1);
+}
+
+TEST_F(LogMacroTest, RuntimeDisabledLevelsDoNotEvaluateArguments) {
+  ASSERT_TRUE(logger_.set_level(LogLevel::kError).ok());
+  QXLOG_INFO(logger_, "info {}", next());
+  QXLOG_WARN(logger_, "warn {}", next());
+  EXPECT_EQ(evaluations_, 0);
+
+  QXLOG_ERROR(logger_, "error {}", next());
+  QXLOG_CRITICAL(logger_, "critical {}", next());
+  EXPECT_EQ(evaluations_, 2);
+}
+
+TEST_F(LogMacroTest, LazyFormRunsOnlyWhenEnabled) {
+  ASSERT_TRUE(logger_.set_level(LogLevel::kWarn).ok());
+  QXLOG_INFO_FN(logger_, [&] { return std::to_string(next()); });
+  EXPECT_EQ(evaluations_, 0);
+
+  QXLOG_WARN_FN(logger_, [&] { return "lazy " + std::to_string(next()); });
+  EXPECT_EQ(evaluations_, 1);
+
+  logger_.log_lazy(LogLevel::kError, [&] { return std::to_string(next()); });
+  EXPECT_EQ(evaluations_, 2);
+}
+
+TEST_F(LogMacroTest, SafeInUnbracedIfElse) {
+  bool else_taken = false;
+  bool condition = false;
+  if (condition)
+    QXLOG_INFO(logger_, "not logged");
+  else
+    else_taken = true;
+  EXPECT_TRUE(else_taken);
+
+  // 被移除的级别同样可以用在不带花括号的分支中
+  else_taken = false;
+  if (condition)
+    QXLOG_DEBUG(logger_, "stripped");
+  else
+    else_taken = true;
+  EXPECT_TRUE(else_taken);
+}
+
+TEST_F(LogMacroTest, LoggerExpressionEvaluatedOnce) {
+  int lookups = 0;
+  auto get_logger = [&]() -> DefaultLog& {
+    ++lookups;
+    return logger_;
+  };
+  QXLOG_INFO(get_logger(), "once {}", 1);
+  EXPECT_EQ(lookups, 1);
+}
+
+}  // namespace log
+}  // namespace qxcore
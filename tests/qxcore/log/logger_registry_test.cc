@@ -0,0 +1,165 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/logger_registry.h"
+#include <gtest/gtest.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "qxcore/log/named_logger.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path);
+  std::stringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+}  // anonymous namespace
+
+TEST(LoggerRegistryTest, CreatesAncestorsAndInternsNames) {
+  LoggerRegistry registry;
+  EXPECT_EQ(registry.size(), 1u);
+
+  LoggerId feed = kNoLoggerId;
+  ASSERT_TRUE(registry.get("qx.md.feed", &feed).ok());
+  EXPECT_EQ(registry.size(), 4u);
+  EXPECT_EQ(registry.name(feed), "qx.md.feed");
+
+  LoggerId md = registry.parent(feed);
+  EXPECT_EQ(registry.name(md), "qx.md");
+  EXPECT_EQ(registry.name(registry.parent(md)), "qx");
+  EXPECT_EQ(registry.parent(registry.parent(md)), kRootLoggerId);
+  EXPECT_EQ(registry.parent(kRootLoggerId), kNoLoggerId);
+
+  LoggerId again = kNoLoggerId;
+  ASSERT_TRUE(registry.get("qx.md.feed", &again).ok());
+  EXPECT_EQ(again, feed);
+  EXPECT_EQ(registry.size(), 4u);
+
+  LoggerId router = kNoLoggerId;
+  ASSERT_TRUE(registry.get("qx.oms.router", &router).ok());
+  EXPECT_EQ(registry.size(), 6u);
+}
+
+TEST(LoggerRegistryTest, RejectsInvalidNames) {
+  LoggerRegistry registry;
+  LoggerId id = kNoLoggerId;
+  EXPECT_EQ(registry.get("", &id).code(), absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(registry.get(".qx", &id).code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(registry.get("qx.", &id).code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(registry.get("qx..md", &id).code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(registry.size(), 1u);
+  EXPECT_FALSE(registry.is_enabled(kNoLoggerId, LogLevel::kCritical));
+}
+
+TEST(LoggerRegistryTest, LevelsInheritDownTheHierarchy) {
+  LoggerRegistry registry;
+  LoggerId feed = kNoLoggerId;
+  LoggerId router = kNoLoggerId;
+  ASSERT_TRUE(registry.get("qx.md.feed", &feed).ok());
+  ASSERT_TRUE(registry.get("qx.oms.router", &router).ok());
+  EXPECT_EQ(registry.get_level(feed), LogLevel::kInfo);
+
+  ASSERT_TRUE(registry.set_level("qx", LogLevel::kDebug).ok());
+  EXPECT_EQ(registry.get_level(feed), LogLevel::kDebug);
+  EXPECT_EQ(registry.get_level(router), LogLevel::kDebug);
+
+  ASSERT_TRUE(registry.set_level("qx.md", LogLevel::kWarn).ok());
+  EXPECT_EQ(registry.get_level(feed), LogLevel::kWarn);
+  EXPECT_EQ(registry.get_level(router), LogLevel::kDebug);
+  EXPECT_FALSE(registry.is_enabled(feed, LogLevel::kInfo));
+  EXPECT_TRUE(registry.is_enabled(router, LogLevel::kDebug));
+
+  // 子节点创建时继承当前级别
+  LoggerId venue = kNoLoggerId;
+  ASSERT_TRUE(registry.get("qx.md.feed.venue1", &venue).ok());
+  EXPECT_EQ(registry.get_level(venue), LogLevel::kWarn);
+
+  ASSERT_TRUE(registry.reset_level("qx.md").ok());
+  EXPECT_EQ(registry.get_level(venue), LogLevel::kDebug);
+
+  ASSERT_TRUE(registry.set_level("", LogLevel::kError).ok());
+  ASSERT_TRUE(registry.reset_level("qx").ok());
+  EXPECT_EQ(registry.get_level(feed), LogLevel::kError);
+  ASSERT_TRUE(registry.reset_level("").ok());
+  EXPECT_EQ(registry.get_level(feed), LogLevel::kInfo);
+}
+
+TEST(LoggerRegistryTest, NamedLoggersShareDefaultSinks) {
+  const std::string name = "named_logger_test";
+  ASSERT_TRUE(InitDefaultLogger(name, LogLevel::kInfo).ok());
+
+  NamedLogger feed = GetLogger("test.md.feed");
+  NamedLogger router = GetLogger("test.oms.router");
+  ASSERT_TRUE(LoggerRegistry::Global().set_level("test", LogLevel::kInfo).ok());
+  ASSERT_TRUE(router.set_level(LogLevel::kDebug).ok());
+
+  feed.info("feed {}", 1);
+  feed.debug("feed debug {}", 2);
+  QXLOG_DEBUG(router, "router debug {}", 3);
+  QXLOG_INFO_FN(router, [] { return std::string("router lazy"); });
+  NamedLogger invalid = GetLogger("bad..name");
+  EXPECT_FALSE(invalid.is_enabled(LogLevel::kCritical));
+  invalid.critical("never written");
+
+  {
+    EpochGuard guard;
+    GetDefaultLogger().flush();
+  }
+  std::string content = ReadFile(name + ".log");
+  EXPECT_NE(content.find("[test.md.feed] [info] feed 1"), std::string::npos)
+      << content;
+  EXPECT_EQ(content.find("feed debug"), std::string::npos);
+  EXPECT_NE(content.find("[test.oms.router] [debug] router debug 3"),
+            std::string::npos);
+  EXPECT_NE(content.find("[test.oms.router] [info] router lazy"),
+            std::string::npos);
+  EXPECT_EQ(content.find("never written"), std::string::npos);
+}
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+TEST(LoggerRegistryTest, NamedLoggersInDeferredMode) {
+  const std::string name = "named_logger_deferred_test";
+  LogOptions options;
+  options.mode = LogMode::kDeferred;
+  ASSERT_TRUE(InitDefaultLogger(name, LogLevel::kInfo, options).ok());
+
+  NamedLogger logger = GetLogger("test.deferred");
+  QXLOG_INFO(logger, "deferred {}", 7);
+  logger.info("plain");
+  {
+    EpochGuard guard;
+    GetDefaultLogger().flush();
+  }
+  std::string content = ReadFile(name + ".log");
+  EXPECT_NE(content.find("[test.deferred] [info] deferred 7"),
+            std::string::npos)
+      << content;
+  EXPECT_NE(content.find("[test.deferred] [info] plain"), std::string::npos);
+  ASSERT_TRUE(InitDefaultLogger(name + "_sync", LogLevel::kInfo).ok());
+}
+#endif  // QXCORE_ENABLE_LOG_SPDLOG
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,259 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <absl/strings/str_cat.h>
+#include <absl/strings/str_split.h>
+#include <spdlog/details/log_msg.h>
+#include "qxcore/log/mmap_file_sink.h"
+#include "qxcore/log/spdlog_backend.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr size_t kSegmentSize = 64 * 1024;
+
+// 每个用例使用独立的空目录
+std::string TestDir(const std::string& name) {
+  std::string dir = testing::TempDir() + "mmap_" + name + "/";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  return dir;
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string& path, const std::string& content) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(content.data(), content.size());
+}
+
+// 目录下按序号排列的分段内容
+std::vector<std::string> Segments(const std::string& dir) {
+  std::vector<std::string> paths;
+  for (const auto& entry : fs::directory_iterator(dir)) {
+    paths.push_back(entry.path().string());
+  }
+  std::sort(paths.begin(), paths.end());
+  std::vector<std::string> contents;
+  for (const std::string& path : paths) {
+    contents.push_back(ReadFile(path));
+  }
+  return contents;
+}
+
+std::shared_ptr<MmapFileSink> OpenSink(const std::string& dir) {
+  auto sink = std::make_shared<MmapFileSink>(kSegmentSize);
+  sink->set_pattern("%v");
+  EXPECT_TRUE(sink->open(dir + "app.log").ok());
+  return sink;
+}
+
+void Write(MmapFileSink& sink, const std::string& text) {
+  spdlog::details::log_msg msg("app", spdlog::level::info, text);
+  sink.log(msg);
+}
+
+}  // anonymous namespace
+
+TEST(MmapFileSinkTest, TruncatesUnusedTailOnClose) {
+  std::string dir = TestDir("tail");
+  std::string expected;
+  {
+    auto sink = OpenSink(dir);
+    EXPECT_EQ(sink->filename(), dir + "app.000001.log");
+    for (int i = 0; i < 10; ++i) {
+      Write(*sink, absl::StrCat("record ", i));
+      absl::StrAppend(&expected, "record ", i, "\n");
+    }
+  }
+  EXPECT_EQ(Segments(dir), std::vector<std::string>{expected});
+}
+
+TEST(MmapFileSinkTest, RollsOverWithoutSplittingRecords) {
+  std::string dir = TestDir("rollover");
+  std::string line(999, 'r');
+  uint64_t completed = 0;
+  {
+    auto sink = OpenSink(dir);
+    for (int i = 0; i < 200; ++i) {
+      Write(*sink, line);
+    }
+    sink->flush();
+    // 每个分段放 65 条记录，前两个分段已写满
+    for (int i = 0; i < 1000 && sink->completed_segments() < 2; ++i) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    completed = sink->completed_segments();
+  }
+  EXPECT_GE(completed, 2u);
+
+  std::vector<std::string> segments = Segments(dir);
+  ASSERT_EQ(segments.size(), 4u);
+  size_t records = 0;
+  for (const std::string& segment : segments) {
+    ASSERT_LE(segment.size(), kSegmentSize);
+    ASSERT_EQ(segment.size() % (line.size() + 1), 0u);
+    for (absl::string_view record : absl::StrSplit(segment, '\n')) {
+      if (!record.empty()) {
+        EXPECT_EQ(record, line);
+        ++records;
+      }
+    }
+  }
+  EXPECT_EQ(records, 200u);
+}
+
+TEST(MmapFileSinkTest, ConcurrentProducersKeepRecordsIntact) {
+  std::string dir = TestDir("concurrent");
+  constexpr int kThreads = 4;
+  constexpr int kRecords = 5000;
+  {
+    auto sink = OpenSink(dir);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&sink, t] {
+        for (int i = 0; i < kRecords; ++i) {
+          Write(*sink, absl::StrCat("thread ", t, " record ", i));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  std::vector<int> next(kThreads, 0);
+  for (const std::string& segment : Segments(dir)) {
+    ASSERT_EQ(segment.find('\0'), std::string::npos);
+    for (absl::string_view record : absl::StrSplit(segment, '\n')) {
+      if (record.empty()) {
+        continue;
+      }
+      std::vector<std::string> parts = absl::StrSplit(record, ' ');
+      ASSERT_EQ(parts.size(), 4u) << record;
+      int t = std::stoi(parts[1]);
+      ASSERT_GE(t, 0);
+      ASSERT_LT(t, kThreads);
+      // 同一线程的记录保持顺序
+      EXPECT_EQ(std::stoi(parts[3]), next[t]++);
+    }
+  }
+  for (int t = 0; t < kThreads; ++t) {
+    EXPECT_EQ(next[t], kRecords);
+  }
+}
+
+TEST(MmapFileSinkTest, RestartContinuesSequenceAndTrimsCrashedSegment) {
+  std::string dir = TestDir("restart");
+  const std::string data = "before crash\n";
+  WriteFile(dir + "app.000002.log", "earlier\n");
+  // 崩溃时有数据的分段保留全长，其后是提前映射的全零预备分段
+  WriteFile(dir + "app.000003.log",
+            data + std::string(kSegmentSize - data.size(), '\0'));
+  WriteFile(dir + "app.000004.log", std::string(kSegmentSize, '\0'));
+  WriteFile(dir + "app.000005.log", std::string(kSegmentSize, '\0'));
+  {
+    auto sink = OpenSink(dir);
+    EXPECT_EQ(sink->filename(), dir + "app.000004.log");
+    Write(*sink, "after restart");
+  }
+  EXPECT_EQ(Segments(dir), (std::vector<std::string>{
+                               "earlier\n", data, "after restart\n"}));
+  EXPECT_FALSE(fs::exists(dir + "app.000005.log"));
+}
+
+TEST(MmapFileSinkTest, RestartTrimsEveryPartlyFilledSegment) {
+  std::string dir = TestDir("restart_partial");
+  const std::string older = "not yet retired\n";
+  const std::string newer = "current\n";
+  // 上一分段写满后还没来得及回收，和当前分段一起保留全长
+  WriteFile(dir + "app.000001.log",
+            older + std::string(kSegmentSize - older.size(), '\0'));
+  WriteFile(dir + "app.000002.log",
+            newer + std::string(kSegmentSize - newer.size(), '\0'));
+  WriteFile(dir + "app.000003.log", std::string(kSegmentSize, '\0'));
+  {
+    auto sink = OpenSink(dir);
+    EXPECT_EQ(sink->filename(), dir + "app.000003.log");
+    Write(*sink, "after restart");
+  }
+  EXPECT_EQ(Segments(dir), (std::vector<std::string>{older, newer,
+                                                     "after restart\n"}));
+}
+
+TEST(MmapFileSinkTest, DropsRecordsLargerThanSegment) {
+  std::string dir = TestDir("oversized");
+  {
+    auto sink = OpenSink(dir);
+    Write(*sink, std::string(kSegmentSize + 1, 'x'));
+    Write(*sink, "small");
+    EXPECT_EQ(sink->dropped(), 1u);
+  }
+  EXPECT_EQ(Segments(dir), std::vector<std::string>{"small\n"});
+}
+
+TEST(MmapFileSinkTest, DropsRecordsWhenSegmentCannotBeMapped) {
+  std::string dir = TestDir("map_failure");
+  auto sink = OpenSink(dir);
+  // 目录被删除后后台线程无法创建后续分段，生产者不能因此阻塞
+  fs::remove_all(dir);
+  std::string line(999, 'm');
+  constexpr int kRecords = 200;
+  for (int i = 0; i < kRecords; ++i) {
+    Write(*sink, line);
+  }
+  EXPECT_GT(sink->dropped(), 0u);
+  EXPECT_LT(sink->dropped(), static_cast<uint64_t>(kRecords));
+  // 析构同样不能阻塞
+  sink.reset();
+}
+
+TEST(MmapFileSinkTest, BackendValidatesSegmentOptions) {
+  LogOptions too_small;
+  too_small.mmap_segment_size = 1024;
+  SpdlogBackend backend;
+  EXPECT_TRUE(absl::IsInvalidArgument(
+      backend.init("mmap_invalid_test", LogLevel::kInfo, too_small)));
+
+  LogOptions with_rotation;
+  with_rotation.mmap_segment_size = kSegmentSize;
+  with_rotation.rotation.max_file_size = 1 << 20;
+  EXPECT_TRUE(absl::IsInvalidArgument(
+      backend.init("mmap_invalid_test", LogLevel::kInfo, with_rotation)));
+}
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_ENABLE_LOG_SPDLOG
@@ -0,0 +1,135 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/pattern_formatter.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <spdlog/details/log_msg.h>
+#include <spdlog/pattern_formatter.h>
+#include "qxcore/log/log.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path);
+  std::stringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+spdlog::log_clock::time_point TimeAt(int64_t unix_nanos) {
+  return spdlog::log_clock::time_point(
+      std::chrono::duration_cast<spdlog::log_clock::duration>(
+          std::chrono::nanoseconds(unix_nanos)));
+}
+
+std::string Format(spdlog::formatter& formatter,
+                   const spdlog::details::log_msg& msg) {
+  spdlog::memory_buf_t buffer;
+  formatter.format(msg, buffer);
+  return std::string(buffer.data(), buffer.size());
+}
+
+// 与 spdlog 原生格式化器逐条比较输出和着色范围
+void ExpectSameAsSpdlog(const std::string& pattern) {
+  std::unique_ptr<PatternFormatter> compiled;
+  ASSERT_TRUE(PatternFormatter::Compile(pattern, &compiled).ok()) << pattern;
+  spdlog::pattern_formatter stock(pattern);
+
+  const int64_t kBase = 1700000000123456789;
+  const int64_t kOffsets[] = {0, 1000, 999999999, 1000000000, 86400000000000,
+                              -5000000000};
+  spdlog::source_loc source{"src/qxcore/log/order_book.cc", 120, "Match"};
+  for (int64_t offset : kOffsets) {
+    for (int level = 0; level < spdlog::level::n_levels - 1; ++level) {
+      spdlog::details::log_msg msg(
+          TimeAt(kBase + offset), offset == 0 ? spdlog::source_loc{} : source,
+          "qx.md", static_cast<spdlog::level::level_enum>(level),
+          "payload 42");
+      msg.thread_id = 4242;
+      std::string expected = Format(stock, msg);
+      size_t expected_start = msg.color_range_start;
+      size_t expected_end = msg.color_range_end;
+      EXPECT_EQ(Format(*compiled, msg), expected) << pattern;
+      EXPECT_EQ(msg.color_range_start, expected_start);
+      EXPECT_EQ(msg.color_range_end, expected_end);
+    }
+  }
+}
+
+}  // anonymous namespace
+
+TEST(PatternFormatterTest, MatchesSpdlogForDefaultPattern) {
+  ExpectSameAsSpdlog(kDefaultLogPattern);
+}
+
+TEST(PatternFormatterTest, MatchesSpdlogForSupportedFlags) {
+  ExpectSameAsSpdlog("%Y/%m/%d %T.%f %L [%t] %v");
+  ExpectSameAsSpdlog("%D %H:%M:%S.%F |%n| %^%l%$ %s:%# %! %g %@ 100%% %v");
+  ExpectSameAsSpdlog("%v");
+  ExpectSameAsSpdlog("plain text only");
+}
+
+TEST(PatternFormatterTest, RejectsUnsupportedFlags) {
+  std::unique_ptr<PatternFormatter> formatter;
+  EXPECT_EQ(PatternFormatter::Compile("%-8l %v", &formatter).code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(PatternFormatter::Compile("%E %v", &formatter).code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(PatternFormatter::Compile("%v %", &formatter).code(),
+            absl::StatusCode::kInvalidArgument);
+  EXPECT_EQ(formatter, nullptr);
+
+  // 不支持的 pattern 退回 spdlog 原生格式化器
+  EXPECT_EQ(dynamic_cast<PatternFormatter*>(MakeLogFormatter("%-8l %v").get()),
+            nullptr);
+  EXPECT_NE(dynamic_cast<PatternFormatter*>(MakeLogFormatter("%l %v").get()),
+            nullptr);
+}
+
+TEST(PatternFormatterTest, CloneKeepsPattern) {
+  std::unique_ptr<PatternFormatter> formatter;
+  ASSERT_TRUE(PatternFormatter::Compile("%l|%v", &formatter).ok());
+  std::unique_ptr<spdlog::formatter> clone = formatter->clone();
+  spdlog::details::log_msg msg(TimeAt(0), spdlog::source_loc{}, "x",
+                               spdlog::level::warn, "hi");
+  EXPECT_EQ(Format(*clone, msg), Format(*formatter, msg));
+  EXPECT_EQ(Format(*clone, msg),
+            std::string("warning|hi") + spdlog::details::os::default_eol);
+}
+
+TEST(PatternFormatterTest, PatternConfiguredThroughOptions) {
+  const std::string name = "pattern_option_test";
+  LogOptions options;
+  options.pattern = "%l|%n|%v";
+  {
+    Log<SpdlogBackend> logger;
+    ASSERT_TRUE(logger.init(name, LogLevel::kInfo, options).ok());
+    logger.info("value {}", 5);
+    logger.flush();
+  }
+  EXPECT_EQ(ReadFile(name + ".log"),
+            std::string("info|pattern_option_test|value 5") +
+                spdlog::details::os::default_eol);
+}
+
+}  // namespace log
+}  // namespace qxcore
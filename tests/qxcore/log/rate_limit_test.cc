@@ -0,0 +1,294 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/rate_limit.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <absl/strings/match.h>
+#include <absl/strings/str_split.h>
+#include "qxcore/log/log.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  std::stringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+// 放行的次数与放行时报告的丢弃总数
+struct Tally {
+  uint64_t allowed = 0;
+  uint64_t suppressed = 0;
+};
+
+template<typename Limiter>
+Tally Drive(Limiter& limiter, int calls) {
+  Tally tally;
+  for (int i = 0; i < calls; ++i) {
+    RatePermit permit = limiter.acquire();
+    if (permit) {
+      ++tally.allowed;
+      tally.suppressed += permit.suppressed;
+    }
+  }
+  return tally;
+}
+
+}  // anonymous namespace
+
+TEST(RateLimitTest, LimitersAreConstantInitializable) {
+  // 宏展开处的静态限流器依赖常量初始化，不需要初始化守卫
+  static_assert(std::is_trivially_destructible_v<EveryNLimiter>);
+  static_assert(std::is_trivially_destructible_v<TokenBucketLimiter>);
+  constexpr EveryNLimiter every_n(4);
+  constexpr FirstNLimiter first_n(4);
+  constexpr EveryMsLimiter every_ms(10);
+  constexpr TokenBucketLimiter bucket(100.0, 5);
+  (void)every_n;
+  (void)first_n;
+  (void)every_ms;
+  (void)bucket;
+}
+
+TEST(RateLimitTest, EveryNAllowsFirstAndEveryNth) {
+  EveryNLimiter limiter(3);
+  std::vector<RatePermit> permits;
+  for (int i = 0; i < 7; ++i) {
+    permits.push_back(limiter.acquire());
+  }
+  EXPECT_TRUE(permits[0].allowed);
+  EXPECT_EQ(permits[0].suppressed, 0u);
+  EXPECT_FALSE(permits[1].allowed);
+  EXPECT_FALSE(permits[2].allowed);
+  EXPECT_TRUE(permits[3].allowed);
+  EXPECT_EQ(permits[3].suppressed, 2u);
+  EXPECT_TRUE(permits[6].allowed);
+  EXPECT_EQ(permits[6].suppressed, 2u);
+
+  EveryNLimiter every_call(0);
+  EXPECT_EQ(Drive(every_call, 5).allowed, 5u);
+}
+
+TEST(RateLimitTest, FirstNStopsAfterN) {
+  FirstNLimiter limiter(3);
+  Tally tally = Drive(limiter, 100);
+  EXPECT_EQ(tally.allowed, 3u);
+  EXPECT_EQ(tally.suppressed, 0u);
+
+  FirstNLimiter none(0);
+  EXPECT_FALSE(none.acquire());
+}
+
+TEST(RateLimitTest, EveryMsReportsSuppressedCount) {
+  EveryMsLimiter limiter(50);
+  EXPECT_TRUE(limiter.acquire());
+  Tally burst = Drive(limiter, 10);
+  EXPECT_EQ(burst.allowed, 0u);
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(60));
+  RatePermit permit = limiter.acquire();
+  ASSERT_TRUE(permit.allowed);
+  EXPECT_EQ(permit.suppressed, 10u);
+  EXPECT_FALSE(limiter.acquire());
+}
+
+TEST(RateLimitTest, TokenBucketAllowsBurstThenRefills) {
+  TokenBucketLimiter limiter(20.0, 5);
+  Tally burst = Drive(limiter, 50);
+  EXPECT_EQ(burst.allowed, 5u);
+
+  // 20 条/秒即每 50ms 补充一条
+  std::this_thread::sleep_for(std::chrono::milliseconds(120));
+  Tally refill = Drive(limiter, 50);
+  EXPECT_GE(refill.allowed, 2u);
+  EXPECT_LE(refill.allowed, 4u);
+  EXPECT_EQ(refill.suppressed, 45u);
+
+  TokenBucketLimiter closed(0.0, 5);
+  EXPECT_TRUE(closed.acquire());
+  EXPECT_FALSE(closed.acquire());
+}
+
+TEST(RateLimitTest, ConcurrentCallersShareOneBudget) {
+  constexpr int kThreads = 4;
+  constexpr int kCallsPerThread = 10000;
+  EveryNLimiter every_n(100);
+  FirstNLimiter first_n(10);
+  std::atomic<uint64_t> every_n_allowed{0};
+  std::atomic<uint64_t> every_n_reported{0};
+  std::atomic<uint64_t> first_n_allowed{0};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&] {
+      Tally every = Drive(every_n, kCallsPerThread);
+      Tally first = Drive(first_n, kCallsPerThread);
+      every_n_allowed += every.allowed;
+      every_n_reported += every.allowed + every.suppressed;
+      first_n_allowed += first.allowed;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  uint64_t total = kThreads * kCallsPerThread;
+  EXPECT_EQ(every_n_allowed.load(), total / 100);
+  // 最后一批被丢弃的调用要等下一次放行才报告
+  EXPECT_EQ(every_n_reported.load(), total - 99);
+  EXPECT_EQ(first_n_allowed.load(), 10u);
+}
+
+class RateLimitMacroTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::remove((kName + std::string(".log")).c_str());
+    LogOptions options;
+    options.pattern = "%v";
+    ASSERT_TRUE(logger_.init(kName, LogLevel::kInfo, options).ok());
+  }
+
+  void TearDown() override { logger_.shutdown(); }
+
+  std::vector<std::string> Lines() {
+    logger_.flush();
+    return absl::StrSplit(ReadFile(kName + std::string(".log")), '\n',
+                          absl::SkipEmpty());
+  }
+
+  int next() { return ++evaluations_; }
+
+  static constexpr const char* kName = "rate_limit_test";
+  DefaultLog logger_;
+  int evaluations_ = 0;
+};
+
+// 宏的限流器是调用点上的函数静态变量，重复运行时沿用上次的状态。EVERY_N
+// 的调用次数取 n 的整数倍，每次运行的放行位置相同；FIRST_N、EVERY_MS 和
+// 令牌桶只在第一次运行时放行
+TEST_F(RateLimitMacroTest, SuppressedCallsDoNotEvaluateArguments) {
+  static int runs = 0;
+  const bool first_run = runs++ == 0;
+  for (int i = 0; i < 12; ++i) {
+    QXLOG_WARN_EVERY_N(logger_, 4, "every n {}", next());
+  }
+  EXPECT_EQ(evaluations_, 3);
+
+  evaluations_ = 0;
+  for (int i = 0; i < 10; ++i) {
+    QXLOG_WARN_FIRST_N(logger_, 2, "first n {}", next());
+  }
+  EXPECT_EQ(evaluations_, first_run ? 2 : 0);
+
+  evaluations_ = 0;
+  int bucket_evaluations = 0;
+  for (int i = 0; i < 10; ++i) {
+    QXLOG_WARN_EVERY_MS(logger_, 60000, "every ms {}", next());
+    QXLOG_WARN_RATE_LIMITED(logger_, 0.001, 2, "bucket {}",
+                            ++bucket_evaluations);
+  }
+  if (first_run) {
+    EXPECT_EQ(evaluations_, 1);
+    EXPECT_EQ(bucket_evaluations, 2);
+  } else {
+    // 距上次放行可能已超过 60 秒
+    EXPECT_LE(evaluations_, 1);
+    EXPECT_EQ(bucket_evaluations, 0);
+  }
+
+  // 级别未启用时不消耗限流额度
+  evaluations_ = 0;
+  for (int i = 0; i < 10; ++i) {
+    QXLOG_DEBUG_EVERY_N(logger_, 1, "debug {}", next());
+  }
+  EXPECT_EQ(evaluations_, 0);
+}
+
+TEST_F(RateLimitMacroTest, EmittedLinesReportSuppressedCount) {
+  static int runs = 0;
+  const bool first_run = runs++ == 0;
+  for (int i = 0; i < 9; ++i) {
+    QXLOG_ERROR_EVERY_N(logger_, 3, "tick {}", i);
+  }
+  for (int i = 0; i < 4; ++i) {
+    QXLOG_INFO_EVERY_N(logger_, 2, "no args");
+  }
+  for (int i = 0; i < 5; ++i) {
+    QXLOG_INFO_FIRST_N(logger_, 1, "first {} of {}", i, 5);
+  }
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+  // 重复运行时第一条还报告上次运行末尾被丢弃的调用
+  std::vector<std::string> expected = {
+      first_run ? "tick 0" : "tick 0 [suppressed 2]",
+      "tick 3 [suppressed 2]",
+      "tick 6 [suppressed 2]",
+      first_run ? "no args" : "no args [suppressed 1]",
+      "no args [suppressed 1]",
+  };
+  if (first_run) {
+    expected.push_back("first 0 of 5");
+  }
+  EXPECT_EQ(Lines(), expected);
+#else
+  (void)first_run;
+#endif
+}
+
+TEST_F(RateLimitMacroTest, EachCallsiteHasItsOwnState) {
+  static int runs = 0;
+  const bool first_run = runs++ == 0;
+  for (int i = 0; i < 3; ++i) {
+    QXLOG_INFO_FIRST_N(logger_, 1, "site a");
+    QXLOG_INFO_FIRST_N(logger_, 1, "site b");
+  }
+
+  // 不带花括号的 if/else 中使用
+  bool noisy = true;
+  for (int i = 0; i < 2; ++i) {
+    if (noisy)
+      QXLOG_INFO_EVERY_N(logger_, 2, "branch {}", 1);
+    else
+      QXLOG_INFO(logger_, "unreachable");
+  }
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+  std::vector<std::string> expected;
+  if (first_run) {
+    expected = {"site a", "site b", "branch 1"};
+  } else {
+    expected = {"branch 1 [suppressed 1]"};
+  }
+  EXPECT_EQ(Lines(), expected);
+#else
+  (void)first_run;
+#endif
+}
+
+}  // namespace log
+}  // namespace qxcore
@@ -0,0 +1,235 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gtest/gtest.h>
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <absl/time/civil_time.h>
+#include <spdlog/details/log_msg.h>
+#include "qxcore/log/rotating_file_sink.h"
+#include "qxcore/log/spdlog_backend.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// 每个用例使用独立的空目录
+std::string TestDir(const std::string& name) {
+  std::string dir = testing::TempDir() + "rotating_" + name + "/";
+  fs::remove_all(dir);
+  fs::create_directories(dir);
+  return dir;
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string& path, const std::string& content) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(content.data(), content.size());
+}
+
+// 目录下的归档文件名（不含当前文件和备用文件），按名称排序
+std::vector<std::string> Archives(const std::string& dir) {
+  std::vector<std::string> names;
+  for (const auto& entry : fs::directory_iterator(dir)) {
+    std::string name = entry.path().filename().string();
+    if (name != "app.log" && name != "app.log.next") {
+      names.push_back(name);
+    }
+  }
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+void Write(RotatingFileSink& sink, absl::Time time, const std::string& text) {
+  spdlog::details::log_msg msg(absl::ToChronoTime(time), spdlog::source_loc{},
+                               "app", spdlog::level::info, text);
+  sink.log(msg);
+}
+
+RotationOptions UtcOptions() {
+  RotationOptions options;
+  options.time_zone = "UTC";
+  return options;
+}
+
+absl::Time Utc(int hour, int minute) {
+  return absl::FromCivil(absl::CivilMinute(2026, 10, 16, hour, minute),
+                         absl::UTCTimeZone());
+}
+
+}  // anonymous namespace
+
+TEST(RotatingFileSinkTest, NextRotationFollowsIntervalAndBoundaries) {
+  absl::TimeZone utc = absl::UTCTimeZone();
+  RotationOptions options = UtcOptions();
+  EXPECT_EQ(RotatingFileSink::NextRotation(Utc(10, 20), options, utc),
+            absl::InfiniteFuture());
+
+  options.interval_seconds = 3600;
+  EXPECT_EQ(RotatingFileSink::NextRotation(Utc(10, 20), options, utc),
+            Utc(11, 0));
+  // 恰好位于轮转点时取下一个
+  EXPECT_EQ(RotatingFileSink::NextRotation(Utc(11, 0), options, utc),
+            Utc(12, 0));
+
+  options.interval_seconds = 0;
+  options.session_boundaries = {"08:45", "15:30"};
+  EXPECT_EQ(RotatingFileSink::NextRotation(Utc(10, 20), options, utc),
+            Utc(15, 30));
+  EXPECT_EQ(RotatingFileSink::NextRotation(Utc(16, 0), options, utc),
+            Utc(8, 45) + absl::Hours(24));
+
+  options.interval_seconds = 3600;
+  EXPECT_EQ(RotatingFileSink::NextRotation(Utc(15, 10), options, utc),
+            Utc(15, 30));
+}
+
+TEST(RotatingFileSinkTest, ValidateOptionsRejectsBadConfig) {
+  RotationOptions options = UtcOptions();
+  options.session_boundaries = {"08:45"};
+  EXPECT_TRUE(RotatingFileSink::ValidateOptions(options).ok());
+
+  RotationOptions bad_zone = options;
+  bad_zone.time_zone = "Nowhere/Atlantis";
+  EXPECT_TRUE(absl::IsInvalidArgument(
+      RotatingFileSink::ValidateOptions(bad_zone)));
+
+  for (const char* boundary : {"24:00", "8:5", "08-45", ""}) {
+    RotationOptions bad_boundary = options;
+    bad_boundary.session_boundaries = {boundary};
+    EXPECT_TRUE(absl::IsInvalidArgument(
+        RotatingFileSink::ValidateOptions(bad_boundary)))
+        << boundary;
+  }
+
+  RotationOptions bad_interval = options;
+  bad_interval.interval_seconds = 7;
+  EXPECT_TRUE(absl::IsInvalidArgument(
+      RotatingFileSink::ValidateOptions(bad_interval)));
+}
+
+TEST(RotatingFileSinkTest, RotatesBySize) {
+  std::string dir = TestDir("size");
+  RotationOptions options = UtcOptions();
+  options.max_file_size = 100;
+  auto sink = std::make_shared<RotatingFileSink>(options);
+  sink->set_pattern("%v");
+  ASSERT_TRUE(sink->open(dir + "app.log").ok());
+  sink->wait_idle();
+
+  absl::Time now = absl::Now();
+  std::string line(49, 'a');
+  Write(*sink, now, line);
+  Write(*sink, now, line);
+  Write(*sink, now, "third");
+  sink->flush();
+  sink->wait_idle();
+
+  EXPECT_EQ(sink->rotations(), 1u);
+  EXPECT_EQ(ReadFile(dir + "app.log"), "third\n");
+  std::vector<std::string> archives = Archives(dir);
+  ASSERT_EQ(archives.size(), 1u);
+  EXPECT_EQ(ReadFile(dir + archives[0]), line + "\n" + line + "\n");
+}
+
+TEST(RotatingFileSinkTest, RotatesAtSessionBoundary) {
+  std::string dir = TestDir("session");
+  RotationOptions options = UtcOptions();
+  options.session_boundaries = {"08:45", "15:30", "21:00"};
+  auto sink = std::make_shared<RotatingFileSink>(options);
+  sink->set_pattern("%v");
+  ASSERT_TRUE(sink->open(dir + "app.log").ok());
+  sink->wait_idle();
+
+  absl::Time now = absl::Now();
+  absl::Time boundary =
+      RotatingFileSink::NextRotation(now, options, absl::UTCTimeZone());
+  Write(*sink, now, "before");
+  Write(*sink, boundary + absl::Seconds(1), "after");
+  sink->flush();
+  sink->wait_idle();
+
+  EXPECT_EQ(ReadFile(dir + "app.log"), "after\n");
+  std::string archive = RotatingFileSink::ArchiveName(
+      dir + "app", boundary, absl::UTCTimeZone());
+  EXPECT_EQ(ReadFile(archive), "before\n");
+}
+
+TEST(RotatingFileSinkTest, RestartArchivesPreviousFile) {
+  std::string dir = TestDir("restart");
+  WriteFile(dir + "app.log", "previous run\n");
+
+  RotationOptions options = UtcOptions();
+  options.max_file_size = 1 << 20;
+  {
+    auto sink = std::make_shared<RotatingFileSink>(options);
+    sink->set_pattern("%v");
+    ASSERT_TRUE(sink->open(dir + "app.log").ok());
+    Write(*sink, absl::Now(), "this run");
+  }
+
+  EXPECT_EQ(ReadFile(dir + "app.log"), "this run\n");
+  std::vector<std::string> archives = Archives(dir);
+  ASSERT_EQ(archives.size(), 1u);
+  EXPECT_EQ(ReadFile(dir + archives[0]), "previous run\n");
+}
+
+TEST(RotatingFileSinkTest, RetentionKeepsTotalSizeWithinBudget) {
+  std::string dir = TestDir("retention");
+  std::string content(100, 'x');
+  WriteFile(dir + "app.20260101-000000.log", content);
+  WriteFile(dir + "app.20260102-000000.log", content);
+  WriteFile(dir + "app.20260103-000000.log", content);
+  WriteFile(dir + "other.20260101-000000.log", content);
+
+  RotationOptions options = UtcOptions();
+  options.max_file_size = 1 << 20;
+  options.max_total_size = 250;
+  auto sink = std::make_shared<RotatingFileSink>(options);
+  ASSERT_TRUE(sink->open(dir + "app.log").ok());
+  sink->wait_idle();
+
+  EXPECT_EQ(Archives(dir),
+            (std::vector<std::string>{"app.20260102-000000.log",
+                                      "app.20260103-000000.log",
+                                      "other.20260101-000000.log"}));
+}
+
+TEST(RotatingFileSinkTest, BackendRejectsInvalidRotation) {
+  LogOptions options;
+  options.rotation.session_boundaries = {"25:00"};
+  SpdlogBackend backend;
+  EXPECT_TRUE(absl::IsInvalidArgument(
+      backend.init("rotating_invalid_test", LogLevel::kInfo, options)));
+}
+
+}  // namespace log
+}  // namespace qxcore
+
+#endif  // QXCORE_ENABLE_LOG_SPDLOG
@@ -0,0 +1,386 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/shm_backend.h"
+#include <gtest/gtest.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <absl/strings/str_cat.h>
+#include "qxcore/log/log.h"
+#include "qxcore/log/logger_registry.h"
+#include "qxcore/log/shm_collector.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+struct CapturedRecord {
+  std::string client;
+  LogLevel level = LogLevel::kInfo;
+  std::string message;
+  std::string file;
+  int line = 0;
+  std::string logger;
+};
+
+struct DetachEvent {
+  std::string client;
+  int pid = 0;
+  bool clean = false;
+  uint64_t dropped = 0;
+};
+
+// 记录收集器交来的全部回调
+class CapturingHandler : public ShmRecordHandler {
+ public:
+  void write(absl::string_view client, LogLevel level, const Callsite* callsite,
+             LoggerId logger_id, RecordTime, absl::string_view message) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    CapturedRecord record;
+    record.client = std::string(client);
+    record.level = level;
+    record.message = std::string(message);
+    if (callsite != nullptr) {
+      record.file = callsite->file();
+      record.line = callsite->line();
+    }
+    if (logger_id != kNoLoggerId) {
+      record.logger = std::string(LoggerRegistry::Global().name(logger_id));
+    }
+    records_.push_back(std::move(record));
+  }
+
+  void flush(absl::string_view) override { flushes_.fetch_add(1); }
+
+  void detach(absl::string_view client, int pid, bool clean,
+              uint64_t dropped) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    detaches_.push_back({std::string(client), pid, clean, dropped});
+  }
+
+  std::vector<std::string> messages() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> result;
+    for (const CapturedRecord& record : records_) {
+      result.push_back(record.message);
+    }
+    return result;
+  }
+
+  std::vector<CapturedRecord> records() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return records_;
+  }
+
+  std::vector<DetachEvent> detaches() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return detaches_;
+  }
+
+  int flushes() const { return flushes_.load(); }
+
+ private:
+  std::mutex mutex_;
+  std::vector<CapturedRecord> records_;
+  std::vector<DetachEvent> detaches_;
+  std::atomic<int> flushes_{0};
+};
+
+class ShmBackendTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    directory_ = (std::filesystem::temp_directory_path() /
+                  absl::StrCat("qxlog_shm_test_", getpid(), "_",
+                               ::testing::UnitTest::GetInstance()
+                                   ->current_test_info()
+                                   ->name()))
+                     .string();
+    std::filesystem::remove_all(directory_);
+    options_.output = LogOutput::kNull;
+    options_.shm.directory = directory_;
+    options_.shm.ring_size = 64 * 1024;
+    options_.shm.max_threads = 4;
+    options_.shm.dictionary_size = 64 * 1024;
+    options_.shm.flush_timeout_ms = 2000;
+  }
+
+  void TearDown() override { std::filesystem::remove_all(directory_); }
+
+  // 反复 poll 直到没有新记录
+  static void Drain(ShmLogCollector& collector) {
+    while (collector.poll() != 0) {
+    }
+  }
+
+  int CountSegments() const {
+    int count = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory_)) {
+      if (entry.path().extension() == shm_format::kSegmentSuffix) {
+        ++count;
+      }
+    }
+    return count;
+  }
+
+  std::string directory_;
+  LogOptions options_;
+};
+
+TEST_F(ShmBackendTest, DeliversRecordsToCollector) {
+  Log<ShmBackend> logger;
+  ASSERT_TRUE(logger.init("shm_app", LogLevel::kInfo, options_).ok());
+
+  CapturingHandler handler;
+  ShmLogCollector collector(directory_, &handler);
+  ASSERT_TRUE(collector.open().ok());
+
+  logger.logf(LogLevel::kInfo, "value {} {} {}", 42, 2.5, std::string("text"));
+  logger.log(LogLevel::kWarn, "verbatim {}");
+  logger.logf(LogLevel::kDebug, "filtered {}", 1);
+  QXLOG_ERROR(logger, "callsite {}", 7);
+
+  LoggerId id = kNoLoggerId;
+  ASSERT_TRUE(LoggerRegistry::Global().get("shm.child", &id).ok());
+  logger.backend().logf_named(id, LogLevel::kInfo, nullptr, RecordTime::Now(),
+                              "named {}", "x");
+
+  Drain(collector);
+  std::vector<CapturedRecord> records = handler.records();
+  ASSERT_EQ(records.size(), 4u);
+  EXPECT_EQ(records[0].client, "shm_app");
+  EXPECT_EQ(records[0].level, LogLevel::kInfo);
+  EXPECT_EQ(records[0].message, "value 42 2.5 text");
+  EXPECT_EQ(records[1].message, "verbatim {}");
+  EXPECT_EQ(records[1].level, LogLevel::kWarn);
+  EXPECT_EQ(records[2].message, "callsite 7");
+  EXPECT_EQ(records[2].level, LogLevel::kError);
+  EXPECT_NE(records[2].file.find("shm_backend_test.cc"), std::string::npos);
+  EXPECT_GT(records[2].line, 0);
+  EXPECT_EQ(records[3].message, "named x");
+  EXPECT_EQ(records[3].logger, "shm.child");
+
+  ShmStats stats = logger.backend().stats();
+  EXPECT_EQ(stats.committed, 4u);
+  EXPECT_EQ(stats.dropped, 0u);
+  EXPECT_EQ(stats.pending(), 0u);
+}
+
+TEST_F(ShmBackendTest, MergesThreadsByTimestamp) {
+  Log<ShmBackend> logger;
+  ASSERT_TRUE(logger.init("shm_threads", LogLevel::kInfo, options_).ok());
+
+  CapturingHandler handler;
+  ShmLogCollector collector(directory_, &handler);
+  ASSERT_TRUE(collector.open().ok());
+
+  constexpr int kThreads = 3;
+  constexpr int kRecords = 200;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&logger, t] {
+      for (int i = 0; i < kRecords; ++i) {
+        logger.logf(LogLevel::kInfo, "t{} {}", t, i);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  Drain(collector);
+  std::vector<std::string> messages = handler.messages();
+  ASSERT_EQ(messages.size(), static_cast<size_t>(kThreads * kRecords));
+  // 同一线程内的记录保持顺序
+  std::vector<int> next(kThreads, 0);
+  for (const std::string& message : messages) {
+    int t = message[1] - '0';
+    EXPECT_EQ(message, absl::StrCat("t", t, " ", next[t]));
+    ++next[t];
+  }
+}
+
+TEST_F(ShmBackendTest, FlushWaitsForCollector) {
+  Log<ShmBackend> logger;
+  ASSERT_TRUE(logger.init("shm_flush", LogLevel::kInfo, options_).ok());
+  EXPECT_FALSE(logger.backend().daemon_alive());
+
+  CapturingHandler handler;
+  ShmLogCollector collector(directory_, &handler);
+  ASSERT_TRUE(collector.open().ok());
+
+  std::atomic<bool> stop{false};
+  std::thread daemon([&] {
+    while (!stop.load()) {
+      if (collector.poll() == 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    }
+  });
+
+  // 收集器线程扫描到段文件后才会写心跳
+  for (int i = 0; i < 200 && !logger.backend().daemon_alive(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+  EXPECT_TRUE(logger.backend().daemon_alive());
+
+  for (int i = 0; i < 100; ++i) {
+    logger.logf(LogLevel::kInfo, "flush {}", i);
+  }
+  logger.flush();
+  EXPECT_EQ(handler.messages().size(), 100u);
+  EXPECT_GE(handler.flushes(), 1);
+
+  stop.store(true);
+  daemon.join();
+}
+
+TEST_F(ShmBackendTest, RestartedCollectorResumesWithoutDuplicates) {
+  Log<ShmBackend> logger;
+  ASSERT_TRUE(logger.init("shm_restart", LogLevel::kInfo, options_).ok());
+
+  CapturingHandler first;
+  {
+    ShmLogCollector collector(directory_, &first);
+    ASSERT_TRUE(collector.open().ok());
+    logger.logf(LogLevel::kInfo, "before {}", 1);
+    Drain(collector);
+  }
+  EXPECT_EQ(first.messages(), std::vector<std::string>{"before 1"});
+
+  // 守护进程离线期间的记录留在段内
+  logger.logf(LogLevel::kInfo, "offline {}", 2);
+
+  CapturingHandler second;
+  ShmLogCollector collector(directory_, &second);
+  ASSERT_TRUE(collector.open().ok());
+  logger.logf(LogLevel::kInfo, "after {}", 3);
+  Drain(collector);
+  EXPECT_EQ(second.messages(),
+            (std::vector<std::string>{"offline 2", "after 3"}));
+}
+
+TEST_F(ShmBackendTest, OnlyOneCollectorPerDirectory) {
+  CapturingHandler handler;
+  ShmLogCollector first(directory_, &handler);
+  ASSERT_TRUE(first.open().ok());
+  ShmLogCollector second(directory_, &handler);
+  EXPECT_EQ(second.open().code(), absl::StatusCode::kAlreadyExists);
+  first.close();
+  EXPECT_TRUE(second.open().ok());
+}
+
+TEST_F(ShmBackendTest, CleanShutdownRemovesSegment) {
+  CapturingHandler handler;
+  ShmLogCollector collector(directory_, &handler);
+  ASSERT_TRUE(collector.open().ok());
+
+  std::string path;
+  {
+    Log<ShmBackend> logger;
+    ASSERT_TRUE(logger.init("shm_clean", LogLevel::kInfo, options_).ok());
+    path = logger.backend().segment_path();
+    logger.logf(LogLevel::kInfo, "last {}", 1);
+  }
+  EXPECT_TRUE(std::filesystem::exists(path));
+
+  Drain(collector);
+  EXPECT_EQ(handler.messages(), std::vector<std::string>{"last 1"});
+  std::vector<DetachEvent> detaches = handler.detaches();
+  ASSERT_EQ(detaches.size(), 1u);
+  EXPECT_EQ(detaches[0].client, "shm_clean");
+  EXPECT_TRUE(detaches[0].clean);
+  EXPECT_FALSE(std::filesystem::exists(path));
+  EXPECT_EQ(collector.clients(), 0u);
+}
+
+TEST_F(ShmBackendTest, DetectsDeadProducer) {
+  CapturingHandler handler;
+  ShmLogCollector collector(directory_, &handler);
+  ASSERT_TRUE(collector.open().ok());
+
+  pid_t child = fork();
+  ASSERT_GE(child, 0);
+  if (child == 0) {
+    Log<ShmBackend> logger;
+    if (!logger.init("shm_crash", LogLevel::kInfo, options_).ok()) {
+      _exit(1);
+    }
+    logger.logf(LogLevel::kError, "dying {}", 1);
+    // 不调用 shutdown 直接退出
+    _exit(0);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(child, &status, 0), child);
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(WEXITSTATUS(status), 0);
+
+  Drain(collector);
+  EXPECT_EQ(handler.messages(), std::vector<std::string>{"dying 1"});
+  std::vector<DetachEvent> detaches = handler.detaches();
+  ASSERT_EQ(detaches.size(), 1u);
+  EXPECT_EQ(detaches[0].pid, child);
+  EXPECT_FALSE(detaches[0].clean);
+  EXPECT_EQ(CountSegments(), 0);
+  EXPECT_EQ(collector.clients(), 0u);
+}
+
+TEST_F(ShmBackendTest, FullRingDropsNewest) {
+  Log<ShmBackend> logger;
+  ASSERT_TRUE(logger.init("shm_full", LogLevel::kInfo, options_).ok());
+
+  // 没有收集器消费，64KB 的环很快写满
+  std::string payload(1000, 'x');
+  constexpr int kRecords = 200;
+  for (int i = 0; i < kRecords; ++i) {
+    logger.logf(LogLevel::kInfo, "{} {}", i, payload);
+  }
+  ShmStats stats = logger.backend().stats();
+  EXPECT_GT(stats.dropped, 0u);
+  EXPECT_EQ(stats.committed + stats.dropped, static_cast<uint64_t>(kRecords));
+
+  CapturingHandler handler;
+  ShmLogCollector collector(directory_, &handler);
+  ASSERT_TRUE(collector.open().ok());
+  Drain(collector);
+  EXPECT_EQ(handler.messages().size(), stats.committed);
+}
+
+TEST_F(ShmBackendTest, RejectsUnsupportedOptions) {
+  ShmOptions options;
+  EXPECT_TRUE(ShmProducer::ValidateOptions(options).ok());
+  options.overflow_policy = OverflowPolicy::kDropOldest;
+  EXPECT_FALSE(ShmProducer::ValidateOptions(options).ok());
+  options = ShmOptions();
+  options.max_threads = 0;
+  EXPECT_FALSE(ShmProducer::ValidateOptions(options).ok());
+
+  Log<ShmBackend> logger;
+  options_.shm.overflow_policy = OverflowPolicy::kDropOldest;
+  EXPECT_FALSE(logger.init("shm_invalid", LogLevel::kInfo, options_).ok());
+}
+
+}  // anonymous namespace
+
+}  // namespace log
+}  // namespace qxcore
@@ -17,6 +17,46 @@
 #include "qxcore/log/spdlog_backend.h"
 #include <gtest/gtest.h>
 #include <absl/status/status.h>
+#include <spdlog/spdlog.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <absl/strings/str_split.h>
+#include "qxcore/log/null_sink.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+// 被格式化时计数的参数
+struct CountedArg {
+  static int formatted;
+};
+int CountedArg::formatted = 0;
+
+std::vector<std::string> ReadLines(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  std::stringstream content;
+  content << in.rdbuf();
+  return absl::StrSplit(content.str(), '\n', absl::SkipEmpty());
+}
+
+}  // anonymous namespace
+
+}  // namespace log
+}  // namespace qxcore
+
+template<>
+struct fmt::formatter<qxcore::log::CountedArg> : fmt::formatter<int> {
+  template<typename FormatContext>
+  auto format(const qxcore::log::CountedArg&, FormatContext& ctx) const {
+    return fmt::formatter<int>::format(++qxcore::log::CountedArg::formatted,
+                                       ctx);
+  }
+};
 
 namespace qxcore {
 namespace log {
@@ -124,6 +164,86 @@ TEST_F(SpdlogBackendTest, FlushAndShutdown) {
   EXPECT_FALSE(backend_->is_enabled(LogLevel::kInfo));
 }
 
+TEST_F(SpdlogBackendTest, NullOutputDiscardsRecords) {
+  std::remove("test_spdlog_null.log");
+  LogOptions options;
+  options.output = LogOutput::kNull;
+  ASSERT_TRUE(backend_->init("test_spdlog_null", LogLevel::kInfo, options).ok());
+
+  backend_->log(LogLevel::kInfo, "discarded");
+  backend_->logf(LogLevel::kWarn, "discarded {}", 42);
+  backend_->log(LogLevel::kDebug, "filtered");
+  backend_->flush();
+
+  // 只有一个 NullSink，收到级别过滤后的记录，不创建日志文件
+  auto logger = spdlog::get("test_spdlog_null");
+  ASSERT_NE(logger, nullptr);
+  ASSERT_EQ(logger->sinks().size(), 1u);
+  auto* sink = dynamic_cast<NullSink*>(logger->sinks()[0].get());
+  ASSERT_NE(sink, nullptr);
+  EXPECT_EQ(sink->records(), 2u);
+
+  FILE* file = std::fopen("test_spdlog_null.log", "r");
+  EXPECT_EQ(file, nullptr);
+  if (file != nullptr) {
+    std::fclose(file);
+  }
+}
+
+TEST_F(SpdlogBackendTest, PerSinkLevels) {
+  std::remove("test_spdlog_levels.log");
+  std::remove("test_spdlog_levels.jsonl");
+  LogOptions options;
+  options.pattern = "%l %v";
+  options.console.level = LogLevel::kError;
+  options.file_level = LogLevel::kDebug;
+  options.json_lines_path = "test_spdlog_levels.jsonl";
+  options.json_lines_level = LogLevel::kWarn;
+  ASSERT_TRUE(
+      backend_->init("test_spdlog_levels", LogLevel::kTrace, options).ok());
+
+  // 没有输出需要 TRACE，日志器级别不变但不再放行
+  EXPECT_EQ(backend_->get_level(), LogLevel::kTrace);
+  EXPECT_FALSE(backend_->is_enabled(LogLevel::kTrace));
+  EXPECT_TRUE(backend_->is_enabled(LogLevel::kDebug));
+
+  CountedArg::formatted = 0;
+  backend_->logf(LogLevel::kTrace, "trace {}", CountedArg());
+  backend_->logf(LogLevel::kDebug, "debug {}", CountedArg());
+  backend_->logf(LogLevel::kWarn, "warn {}", CountedArg());
+  EXPECT_EQ(CountedArg::formatted, 2);
+
+  // 日志器级别高于各输出阈值时以日志器级别为准
+  ASSERT_TRUE(backend_->set_level(LogLevel::kInfo).ok());
+  EXPECT_FALSE(backend_->is_enabled(LogLevel::kDebug));
+  backend_->log(LogLevel::kDebug, "debug 3");
+  backend_->log(LogLevel::kInfo, "info 4");
+  backend_->flush();
+
+  EXPECT_EQ(ReadLines("test_spdlog_levels.log"),
+            (std::vector<std::string>{"debug debug 1", "warning warn 2",
+                                      "info info 4"}));
+  std::vector<std::string> json = ReadLines("test_spdlog_levels.jsonl");
+  ASSERT_EQ(json.size(), 1u);
+  EXPECT_NE(json[0].find("\"msg\":\"warn 2\""), std::string::npos);
+  std::remove("test_spdlog_levels.jsonl");
+}
+
+TEST_F(SpdlogBackendTest, NonBlockingConsole) {
+  LogOptions options;
+  options.console.non_blocking = true;
+  ASSERT_TRUE(backend_->init("test_spdlog_console", LogLevel::kInfo, options).ok());
+  backend_->log(LogLevel::kInfo, "non-blocking console");
+  backend_->flush();
+  EXPECT_EQ(backend_->console_dropped(), 0u);
+
+  SpdlogBackend invalid;
+  options.console.buffer_size = 0;
+  EXPECT_EQ(invalid.init("test_spdlog_console_invalid", LogLevel::kInfo, options)
+                .code(),
+            absl::StatusCode::kInvalidArgument);
+}
+
 TEST_F(SpdlogBackendTest, LoggingWithoutInitialization) {
   // 测试未初始化时的日志记录
   EXPECT_NO_THROW(backend_->log(LogLevel::kInfo, "Should not crash"));
@@ -0,0 +1,224 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/structured.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <absl/strings/match.h>
+#include <absl/strings/str_split.h>
+#include "qxcore/log/log.h"
+#include "qxcore/log/named_logger.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  std::stringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+template<typename... Fields>
+std::string Encode(absl::string_view event, const Fields&... fields) {
+  std::string payload(EncodedStructuredSize(event, fields...), '\0');
+  char* end = EncodeStructured(payload.data(), event, fields...);
+  EXPECT_EQ(end, payload.data() + payload.size());
+  return payload;
+}
+
+}  // anonymous namespace
+
+TEST(StructuredTest, DetectsKeyValueArguments) {
+  int id = 1;
+  EXPECT_TRUE((kIsStructured<KeyValue<int>>));
+  EXPECT_TRUE((kIsStructured<KeyValue<int>, KeyValue<std::string>>));
+  EXPECT_FALSE((kIsStructured<KeyValue<int>, int>));
+  EXPECT_FALSE(kIsStructured<>);
+  EXPECT_EQ(fmt::format("{}", kv("id", id)), "id=1");
+}
+
+TEST(StructuredTest, RoundTripsTypedFields) {
+  int id = -42;
+  uint64_t seq = 18446744073709551615ull;
+  double px = 101.25;
+  std::string venue = "XNAS";
+  std::string payload = Encode("order_ack", kv("id", id), kv("seq", seq),
+                               kv("px", px), kv("venue", venue),
+                               kv("ok", true));
+  ASSERT_TRUE(IsStructuredPayload(payload));
+
+  StructuredRecord record;
+  ASSERT_TRUE(ParseStructured(payload, &record));
+  EXPECT_EQ(record.event, "order_ack");
+  ASSERT_EQ(record.fields.size(), 5u);
+  EXPECT_EQ(record.fields[0].key, "id");
+  EXPECT_EQ(record.fields[0].type, ArgType::kInt32);
+  EXPECT_EQ(record.fields[0].int_value, -42);
+  EXPECT_EQ(record.fields[1].type, ArgType::kUInt64);
+  EXPECT_EQ(record.fields[1].uint_value, seq);
+  EXPECT_EQ(record.fields[2].type, ArgType::kDouble);
+  EXPECT_EQ(record.fields[2].double_value, 101.25);
+  EXPECT_EQ(record.fields[3].type, ArgType::kString);
+  EXPECT_EQ(record.fields[3].text, "XNAS");
+  EXPECT_EQ(record.fields[4].type, ArgType::kBool);
+  EXPECT_EQ(record.fields[4].int_value, 1);
+}
+
+TEST(StructuredTest, RejectsCorruptPayload) {
+  StructuredRecord record;
+  EXPECT_FALSE(ParseStructured("plain text", &record));
+  int id = 7;
+  std::string payload = Encode("e", kv("id", id));
+  for (size_t size = 0; size < payload.size(); ++size) {
+    EXPECT_FALSE(ParseStructured(payload.substr(0, size), &record)) << size;
+  }
+  EXPECT_FALSE(ParseStructured(payload + "x", &record));
+}
+
+TEST(StructuredTest, RendersText) {
+  int id = 1;
+  double px = 101.25;
+  EXPECT_EQ(StructuredPayloadText(Encode("order_ack", kv("id", id),
+                                         kv("px", px))),
+            "order_ack id=1 px=101.25");
+  EXPECT_EQ(StructuredPayloadText(Encode("e", kv("s", "a b"),
+                                         kv("empty", ""),
+                                         kv("q", "x\"y"))),
+            "e s=\"a b\" empty=\"\" q=\"x\\\"y\"");
+  EXPECT_EQ(StructuredPayloadText(Encode("e")), "e");
+  EXPECT_EQ(StructuredPayloadText("not structured"), "not structured");
+}
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+
+class StructuredLogTest : public ::testing::TestWithParam<LogMode> {
+ protected:
+  void SetUp() override {
+    std::remove(TextPath().c_str());
+    std::remove(JsonPath().c_str());
+    LogOptions options;
+    options.mode = GetParam();
+    options.pattern = "%l %v";
+    options.json_lines_path = JsonPath();
+    ASSERT_TRUE(logger_.init(kName, LogLevel::kInfo, options).ok());
+  }
+
+  void TearDown() override {
+    logger_.shutdown();
+    std::remove(JsonPath().c_str());
+  }
+
+  static std::string TextPath() { return kName + std::string(".log"); }
+  static std::string JsonPath() { return kName + std::string(".jsonl"); }
+
+  static std::vector<std::string> Lines(const std::string& path) {
+    return absl::StrSplit(ReadFile(path), '\n', absl::SkipEmpty());
+  }
+
+  static constexpr const char* kName = "structured_test";
+  Log<SpdlogBackend> logger_;
+};
+
+TEST_P(StructuredLogTest, WritesTextAndJsonLines) {
+  int id = 1;
+  double px = 101.25;
+  logger_.info("order_ack", kv("id", id), kv("px", px));
+  QXLOG_WARN(logger_, "reject", kv("reason", "price band"), kv("id", 2));
+  logger_.info("plain {}", 3);
+  logger_.flush();
+
+  std::vector<std::string> text = Lines(TextPath());
+  ASSERT_EQ(text.size(), 3u);
+  EXPECT_EQ(text[0], "info order_ack id=1 px=101.25");
+  EXPECT_EQ(text[1], "warning reject reason=\"price band\" id=2");
+  EXPECT_EQ(text[2], "info plain 3");
+
+  std::vector<std::string> json = Lines(JsonPath());
+  ASSERT_EQ(json.size(), 3u);
+  EXPECT_TRUE(absl::StartsWith(json[0], "{\"ts\":"));
+  EXPECT_TRUE(absl::StrContains(json[0], "\"level\":\"info\""));
+  EXPECT_TRUE(absl::StrContains(json[0], "\"logger\":\"structured_test\""));
+  EXPECT_TRUE(absl::EndsWith(
+      json[0], "\"msg\":\"order_ack\",\"id\":1,\"px\":101.25}"));
+  EXPECT_TRUE(absl::StrContains(json[1], "\"level\":\"warning\""));
+  EXPECT_TRUE(absl::StrContains(json[1], "\"line\":"));
+  EXPECT_TRUE(absl::EndsWith(
+      json[1], "\"msg\":\"reject\",\"reason\":\"price band\",\"id\":2}"));
+  EXPECT_TRUE(absl::EndsWith(json[2], "\"msg\":\"plain 3\"}"));
+}
+
+TEST_P(StructuredLogTest, EscapesJsonStrings) {
+  std::string note = "line\n\"quoted\"\t\xff";
+  logger_.error("bad", kv("note", note));
+  logger_.flush();
+
+  std::vector<std::string> json = Lines(JsonPath());
+  ASSERT_EQ(json.size(), 1u);
+  EXPECT_TRUE(absl::EndsWith(
+      json[0],
+      "\"msg\":\"bad\",\"note\":\"line\\n\\\"quoted\\\"\\t\\ufffd\"}"));
+}
+
+TEST_P(StructuredLogTest, NamedLoggerWritesFields) {
+  const std::string name = "structured_named_test";
+  const std::string json_path = name + ".jsonl";
+  std::remove((name + ".log").c_str());
+  std::remove(json_path.c_str());
+  LogOptions options;
+  options.mode = GetParam();
+  options.pattern = "%n %l %v";
+  options.json_lines_path = json_path;
+  ASSERT_TRUE(InitDefaultLogger(name, LogLevel::kInfo, options).ok());
+
+  NamedLogger named = GetLogger("test.structured.orders");
+  named.info("order_ack", kv("id", 7), kv("px", 1.5));
+  QXLOG_INFO(named, "order_ack2", kv("id", 8));
+  {
+    EpochGuard guard;
+    GetDefaultLogger().flush();
+  }
+
+  std::vector<std::string> text = Lines(name + ".log");
+  ASSERT_EQ(text.size(), 2u);
+  EXPECT_EQ(text[0], "test.structured.orders info order_ack id=7 px=1.5");
+  EXPECT_EQ(text[1], "test.structured.orders info order_ack2 id=8");
+
+  std::vector<std::string> json = Lines(json_path);
+  ASSERT_EQ(json.size(), 2u);
+  EXPECT_TRUE(
+      absl::StrContains(json[0], "\"logger\":\"test.structured.orders\""));
+  EXPECT_TRUE(
+      absl::EndsWith(json[0], "\"msg\":\"order_ack\",\"id\":7,\"px\":1.5}"));
+  EXPECT_TRUE(absl::EndsWith(json[1], "\"msg\":\"order_ack2\",\"id\":8}"));
+
+  ASSERT_TRUE(InitDefaultLogger(name + "_sync", LogLevel::kInfo).ok());
+  std::remove(json_path.c_str());
+}
+
+INSTANTIATE_TEST_SUITE_P(Modes, StructuredLogTest,
+                         ::testing::Values(LogMode::kSync, LogMode::kAsync,
+                                           LogMode::kDeferred));
+
+#endif  // QXCORE_ENABLE_LOG_SPDLOG
+
+}  // namespace log
+}  // namespace qxcore
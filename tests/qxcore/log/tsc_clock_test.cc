@@ -0,0 +1,126 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+
+#include "qxcore/log/tsc_clock.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "qxcore/log/log.h"
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+int64_t WallNanos() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path);
+  std::stringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+// 与默认格式 [%Y-%m-%d %H:%M:%S.%e] 一致的本地时间文本
+std::string FormatLocalMillis(int64_t unix_nanos) {
+  std::time_t seconds = static_cast<std::time_t>(unix_nanos / 1000000000);
+  std::tm local;
+  localtime_r(&seconds, &local);
+  char text[64];
+  size_t size = std::strftime(text, sizeof(text), "%Y-%m-%d %H:%M:%S", &local);
+  char millis[8];
+  std::snprintf(millis, sizeof(millis), ".%03d",
+                static_cast<int>(unix_nanos / 1000000 % 1000));
+  return std::string(text, size) + millis;
+}
+
+// 2020-01-02 03:04:05.678 UTC
+constexpr int64_t kEventNanos = 1577934245678000000;
+
+}  // anonymous namespace
+
+TEST(TscClockTest, ConvertsTicksToWallTime) {
+  TscClock& clock = TscClock::Global();
+  EXPECT_GT(clock.nanos_per_tick(), 0.0);
+
+  int64_t before = WallNanos();
+  uint64_t ticks = TscClock::ReadTicks();
+  int64_t after = WallNanos();
+  int64_t converted = clock.to_unix_nanos(ticks);
+  // 允许初始校准误差
+  EXPECT_GT(converted, before - 1000000);
+  EXPECT_LT(converted, after + 1000000);
+}
+
+TEST(TscClockTest, ConversionIsMonotonicBetweenCalibrations) {
+  TscClock& clock = TscClock::Global();
+  clock.calibrate();
+  uint64_t first = TscClock::ReadTicks();
+  uint64_t second = first + 1000;
+  EXPECT_LE(clock.to_unix_nanos(first), clock.to_unix_nanos(second));
+}
+
+TEST(TscClockTest, EventTimePassesThrough) {
+  RecordTime time = RecordTime::Event(EventTime(kEventNanos));
+  EXPECT_TRUE(time.is_event);
+  EXPECT_EQ(TscClock::Global().to_unix_nanos(time), kEventNanos);
+  EXPECT_FALSE(RecordTime::Now().is_event);
+}
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+class EventTimeLogTest : public ::testing::TestWithParam<LogMode> {};
+
+TEST_P(EventTimeLogTest, RecordsUseCallerSuppliedTime) {
+  const std::string name =
+      "event_time_test_" + std::to_string(static_cast<int>(GetParam()));
+  LogOptions options;
+  options.mode = GetParam();
+  {
+    Log<SpdlogBackend> logger;
+    ASSERT_TRUE(logger.init(name, LogLevel::kInfo, options).ok());
+    logger.logf(LogLevel::kInfo, EventTime(kEventNanos), "fill {} @ {}", 7,
+                101.5);
+    logger.info(EventTime(kEventNanos + 1000000), "helper {}", 8);
+    logger.info("now {}", 9);
+    logger.flush();
+  }
+
+  std::string content = ReadFile(name + ".log");
+  std::string expected = FormatLocalMillis(kEventNanos);
+  EXPECT_NE(content.find("[" + expected + "] [" + name +
+                         "] [info] fill 7 @ 101.5"),
+            std::string::npos)
+      << content;
+  EXPECT_NE(content.find("[" + FormatLocalMillis(kEventNanos + 1000000) +
+                         "] [" + name + "] [info] helper 8"),
+            std::string::npos)
+      << content;
+  EXPECT_NE(content.find("now 9"), std::string::npos);
+}
+
+INSTANTIATE_TEST_SUITE_P(Modes, EventTimeLogTest,
+                         ::testing::Values(LogMode::kSync, LogMode::kAsync,
+                                           LogMode::kDeferred));
+#endif  // QXCORE_ENABLE_LOG_SPDLOG
+
+}  // namespace log
+}  // namespace qxcore
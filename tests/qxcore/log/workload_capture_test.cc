@@ -0,0 +1,197 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "qxcore/log/workload_capture.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+#include "qxcore/log/log.h"
+#include "qxcore/log/spdlog_backend.h"
+#endif
+
+namespace qxcore {
+namespace log {
+
+namespace {
+
+std::string TestPath(const std::string& name) {
+  return testing::TempDir() + name;
+}
+
+std::string ReadFile(const std::string& path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+}
+
+void WriteFile(const std::string& path, const std::string& content) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(content.data(), content.size());
+}
+
+}  // namespace
+
+TEST(WorkloadCaptureTest, RecordsCallShapes) {
+  std::string path = TestPath("capture_shapes.qxcap");
+  WorkloadCapture capture;
+  ASSERT_TRUE(capture.open(path).ok());
+
+  capture.record(LogLevel::kInfo, nullptr, kNoLoggerId, "fill {} {} @ {}",
+                 42, std::string("AAPL"), 101.25);
+  std::thread([&] {
+    capture.record_plain(LogLevel::kWarn, nullptr, kNoLoggerId, 17);
+  }).join();
+  capture.record(LogLevel::kError, nullptr, kNoLoggerId, "fill {} {} @ {}",
+                 int64_t{7}, "MSFT-X", 3.5f);
+  EXPECT_EQ(capture.events(), 3u);
+  ASSERT_TRUE(capture.close().ok());
+
+  WorkloadTrace trace;
+  ASSERT_TRUE(trace.load(path).ok());
+  ASSERT_EQ(trace.sites().size(), 2u);
+  EXPECT_EQ(trace.sites()[0].format, "fill {} {} @ {}");
+  EXPECT_FALSE(trace.sites()[0].plain);
+  EXPECT_TRUE(trace.sites()[1].plain);
+  EXPECT_EQ(trace.thread_count(), 2u);
+
+  const auto& events = trace.events();
+  ASSERT_EQ(events.size(), 3u);
+  EXPECT_EQ(events[0].time_ns, 0);
+  EXPECT_LE(events[0].time_ns, events[1].time_ns);
+  EXPECT_LE(events[1].time_ns, events[2].time_ns);
+
+  EXPECT_EQ(events[0].level, LogLevel::kInfo);
+  EXPECT_EQ(events[0].site, 0u);
+  EXPECT_EQ(events[0].thread, 0u);
+  auto args = trace.args(events[0]);
+  ASSERT_EQ(args.size(), 3u);
+  EXPECT_EQ(args[0].type, ArgType::kInt32);
+  EXPECT_EQ(args[0].size, 4u);
+  EXPECT_EQ(args[1].type, ArgType::kString);
+  EXPECT_EQ(args[1].size, 4u);
+  EXPECT_EQ(args[2].type, ArgType::kDouble);
+  EXPECT_EQ(args[2].size, 8u);
+
+  EXPECT_EQ(events[1].level, LogLevel::kWarn);
+  EXPECT_EQ(events[1].site, 1u);
+  EXPECT_EQ(events[1].thread, 1u);
+  ASSERT_EQ(trace.args(events[1]).size(), 1u);
+  EXPECT_EQ(trace.args(events[1])[0].size, 17u);
+
+  EXPECT_EQ(events[2].site, 0u);
+  args = trace.args(events[2]);
+  ASSERT_EQ(args.size(), 3u);
+  EXPECT_EQ(args[0].type, ArgType::kInt64);
+  EXPECT_EQ(args[1].size, 6u);
+  EXPECT_EQ(args[2].type, ArgType::kFloat);
+}
+
+TEST(WorkloadCaptureTest, CallsitesAndLoggersAreInterned) {
+  static Callsite site_a(__FILE__, 100, "Fn", "a {}", LogLevel::kInfo);
+  static Callsite site_b(__FILE__, 200, "Fn", "a {}", LogLevel::kDebug);
+  LoggerId logger_id;
+  ASSERT_TRUE(LoggerRegistry::Global().get("capture.test", &logger_id).ok());
+
+  std::string path = TestPath("capture_interned.qxcap");
+  WorkloadCapture capture;
+  ASSERT_TRUE(capture.open(path).ok());
+  // 同一格式串的不同调用点分别定义，同一调用点只定义一次
+  for (int i = 0; i < 3; ++i) {
+    capture.record(LogLevel::kInfo, &site_a, kNoLoggerId, "a {}", i);
+    capture.record(LogLevel::kDebug, &site_b, logger_id, "a {}", i);
+  }
+  ASSERT_TRUE(capture.close().ok());
+
+  WorkloadTrace trace;
+  ASSERT_TRUE(trace.load(path).ok());
+  ASSERT_EQ(trace.sites().size(), 2u);
+  EXPECT_EQ(trace.sites()[0].line, 100);
+  EXPECT_EQ(trace.sites()[1].line, 200);
+  EXPECT_EQ(trace.sites()[1].file, __FILE__);
+  ASSERT_EQ(trace.loggers().size(), 2u);
+  EXPECT_EQ(trace.loggers()[1], "capture.test");
+
+  ASSERT_EQ(trace.events().size(), 6u);
+  for (size_t i = 0; i < trace.events().size(); ++i) {
+    const CapturedEvent& event = trace.events()[i];
+    EXPECT_EQ(event.site, i % 2);
+    EXPECT_EQ(event.logger, i % 2);
+  }
+}
+
+TEST(WorkloadCaptureTest, TruncatedTailIsIgnored) {
+  std::string path = TestPath("capture_truncated.qxcap");
+  WorkloadCapture capture;
+  ASSERT_TRUE(capture.open(path).ok());
+  for (int i = 0; i < 10; ++i) {
+    capture.record(LogLevel::kInfo, nullptr, kNoLoggerId, "n {} {}", i,
+                   std::string(static_cast<size_t>(i), 'x'));
+  }
+  ASSERT_TRUE(capture.close().ok());
+
+  std::string content = ReadFile(path);
+  WriteFile(path, content.substr(0, content.size() - 3));
+
+  WorkloadTrace trace;
+  ASSERT_TRUE(trace.load(path).ok());
+  EXPECT_EQ(trace.events().size(), 9u);
+}
+
+TEST(WorkloadCaptureTest, RejectsForeignFile) {
+  std::string path = TestPath("capture_foreign.qxcap");
+  WriteFile(path, "not a capture file");
+  WorkloadTrace trace;
+  EXPECT_TRUE(absl::IsDataLoss(trace.load(path)));
+  EXPECT_TRUE(absl::IsNotFound(trace.load(TestPath("capture_missing.qxcap"))));
+}
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+
+TEST(WorkloadCaptureTest, SpdlogBackendCapturesEnabledCalls) {
+  std::string path = TestPath("capture_backend.qxcap");
+  LogOptions options;
+  options.output = LogOutput::kNull;
+  options.capture_path = path;
+  Log<SpdlogBackend> logger;
+  ASSERT_TRUE(logger.init("test_capture", LogLevel::kInfo, options).ok());
+
+  logger.info("order {} qty {}", 1, 100);
+  logger.debug("filtered {}", 2);
+  logger.log(LogLevel::kWarn, "plain message");
+  QXLOG_ERROR(logger, "macro {}", 3.5);
+  logger.shutdown();
+
+  WorkloadTrace trace;
+  ASSERT_TRUE(trace.load(path).ok());
+  ASSERT_EQ(trace.events().size(), 3u);
+  EXPECT_EQ(trace.sites()[trace.events()[0].site].format, "order {} qty {}");
+  EXPECT_EQ(trace.events()[0].arg_count, 2u);
+  const CapturedSite& plain = trace.sites()[trace.events()[1].site];
+  EXPECT_TRUE(plain.plain);
+  EXPECT_EQ(trace.args(trace.events()[1])[0].size, 13u);
+  const CapturedSite& macro = trace.sites()[trace.events()[2].site];
+  EXPECT_EQ(macro.format, "macro {}");
+  EXPECT_GT(macro.line, 0);
+  EXPECT_EQ(trace.events()[2].level, LogLevel::kError);
+}
+
+#endif  // QXCORE_ENABLE_LOG_SPDLOG
+
+}  // namespace log
+}  // namespace qxcore
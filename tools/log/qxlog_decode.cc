@@ -0,0 +1,103 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// qxlog_decode：把二进制日志还原为文本
+//
+// 用法：qxlog_decode [--pattern=<spdlog 模式>] <文件>...
+// 默认模式与 SpdlogBackend 的文本输出一致。遇到截断或损坏的块时
+// 输出已成功解码的部分，在标准错误上报告位置并以非零状态退出。
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <absl/strings/match.h>
+#include <spdlog/details/log_msg.h>
+#include <spdlog/pattern_formatter.h>
+#include "qxcore/log/binary_log.h"
+
+namespace {
+
+constexpr char kDefaultPattern[] = "[%Y-%m-%d %H:%M:%S.%e] [%n] [%^%l%$] %v";
+
+void PrintUsage(const char* program) {
+  std::cerr << "Usage: " << program << " [--pattern=<pattern>] <file>..."
+            << std::endl;
+}
+
+// 解码单个文件，返回是否完整读完
+bool DecodeFile(const std::string& path, spdlog::formatter& formatter) {
+  qxcore::log::BinaryLogReader reader;
+  absl::Status status = reader.open(path);
+  if (!status.ok()) {
+    std::cerr << path << ": " << status << std::endl;
+    return false;
+  }
+
+  qxcore::log::BinaryLogEntry entry;
+  spdlog::memory_buf_t line;
+  while ((status = reader.next(&entry)).ok()) {
+    auto time = spdlog::log_clock::time_point(
+        std::chrono::duration_cast<spdlog::log_clock::duration>(
+            std::chrono::nanoseconds(entry.time_ns)));
+    spdlog::details::log_msg msg(
+        time, spdlog::source_loc{}, entry.logger_name,
+        static_cast<spdlog::level::level_enum>(
+            qxcore::log::LogLevelToInt(entry.level)),
+        entry.message);
+    msg.thread_id = entry.thread_id;
+    line.clear();
+    formatter.format(msg, line);
+    std::fwrite(line.data(), 1, line.size(), stdout);
+  }
+
+  if (absl::IsOutOfRange(status)) {
+    return true;
+  }
+  std::cerr << path << ": " << status << " (after " << reader.blocks_read()
+            << " valid blocks)" << std::endl;
+  return false;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  std::string pattern = kDefaultPattern;
+  std::vector<std::string> files;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (absl::StartsWith(arg, "--pattern=")) {
+      pattern = arg.substr(sizeof("--pattern=") - 1);
+    } else if (arg == "-h" || arg == "--help") {
+      PrintUsage(argv[0]);
+      return 0;
+    } else {
+      files.push_back(arg);
+    }
+  }
+  if (files.empty()) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  auto formatter = std::make_unique<spdlog::pattern_formatter>(pattern);
+  bool ok = true;
+  for (const auto& file : files) {
+    ok = DecodeFile(file, *formatter) && ok;
+  }
+  std::fflush(stdout);
+  return ok ? 0 : 2;
+}
@@ -0,0 +1,42 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// qxlog_flight：输出飞行记录器留在共享内存文件中的记录
+//
+// 用法：qxlog_flight <文件>...
+// 文件为 FlightRecorderOptions::shm_path 指定的记录区（如 /dev/shm 下），
+// 进程崩溃或被强制结束后仍可读取。记录按时间顺序输出，参数按默认形式
+// 渲染，格式说明符被忽略。
+
+#include <unistd.h>
+#include <iostream>
+#include <string>
+#include "qxcore/log/flight_recorder.h"
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <file>..." << std::endl;
+    return 2;
+  }
+  int result = 0;
+  for (int i = 1; i < argc; ++i) {
+    absl::Status status =
+        qxcore::log::FlightRecorder::DumpFile(argv[i], STDOUT_FILENO);
+    if (!status.ok()) {
+      std::cerr << argv[i] << ": " << status << std::endl;
+      result = 1;
+    }
+  }
+  return result;
+}
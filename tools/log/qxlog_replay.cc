@@ -0,0 +1,510 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// qxlog_replay：按采集文件回放日志负载，报告调用延迟与积压
+//
+// 用法：qxlog_replay [选项] <采集文件>
+//   --backend=spdlog|glog                   回放目标后端（默认 spdlog）
+//   --mode=sync|async|deferred              工作模式（默认 sync）
+//   --output=null|file                      输出目标（默认 null）
+//   --speed=<倍数>                          1 为原速，0 为不等待全速回放（默认 1）
+//   --queue_capacity=<条数>                 异步队列容量
+//   --overflow=block|drop_newest|drop_oldest  队列满时的策略
+//   --pattern=<spdlog 模式>                 文本输出格式
+//   --interval_ms=<毫秒>                    积压采样间隔（默认 100）
+//
+// 采集文件由 LogOptions::capture_path 生成。每个采集线程对应一个回放线程，
+// 按原到达时间（除以 speed）发起调用，参数按采集到的类型与长度合成，
+// 日志器名称统一为 "replay"。超过 kMaxReplayArgs 个参数的调用被跳过并计数。
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <absl/status/status.h>
+#include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_format.h>
+#include "qxcore/log/latency_histogram.h"
+#include "qxcore/log/log.h"
+#include "qxcore/log/tsc_clock.h"
+#include "qxcore/log/workload_capture.h"
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+#include "qxcore/log/spdlog_backend.h"
+#endif
+#ifdef QXCORE_ENABLE_LOG_GLOG
+#include "qxcore/log/glog_backend.h"
+#endif
+
+namespace {
+
+using qxcore::log::ArgType;
+using qxcore::log::CapturedArg;
+using qxcore::log::CapturedEvent;
+using qxcore::log::LatencyHistogram;
+using qxcore::log::LogLevel;
+using qxcore::log::LogMode;
+using qxcore::log::LogOptions;
+using qxcore::log::LogOutput;
+using qxcore::log::OverflowPolicy;
+using qxcore::log::TscClock;
+using qxcore::log::WorkloadTrace;
+
+constexpr size_t kMaxReplayArgs = 8;
+
+// 按采集到的形状合成的参数
+struct ReplayArg {
+  ArgType type = ArgType::kString;
+  int64_t int_value = 0;
+  double double_value = 0;
+  absl::string_view string_value;
+};
+
+}  // anonymous namespace
+
+// 按参数类型转发格式说明符，使 {:.2f}、{:>8} 等原格式串保持有效
+template<>
+struct fmt::formatter<ReplayArg> {
+  constexpr auto parse(fmt::format_parse_context& ctx) {
+    auto it = ctx.begin();
+    auto begin = it;
+    while (it != ctx.end() && *it != '}') {
+      ++it;
+    }
+    spec_ = fmt::string_view(begin, static_cast<size_t>(it - begin));
+    return it;
+  }
+
+  template<typename Context>
+  auto format(const ReplayArg& arg, Context& ctx) const {
+    char pattern[64] = "{}";
+    size_t size = 2;
+    if (spec_.size() != 0 && spec_.size() + 3 <= sizeof(pattern)) {
+      pattern[0] = '{';
+      pattern[1] = ':';
+      std::copy(spec_.begin(), spec_.end(), pattern + 2);
+      pattern[spec_.size() + 2] = '}';
+      size = spec_.size() + 3;
+    }
+    fmt::string_view view(pattern, size);
+    switch (arg.type) {
+      case ArgType::kBool:
+        return fmt::format_to(ctx.out(), fmt::runtime(view), arg.int_value != 0);
+      case ArgType::kChar:
+        return fmt::format_to(ctx.out(), fmt::runtime(view), 'x');
+      case ArgType::kInt32:
+      case ArgType::kInt64:
+        return fmt::format_to(ctx.out(), fmt::runtime(view), arg.int_value);
+      case ArgType::kUInt32:
+      case ArgType::kUInt64:
+        return fmt::format_to(ctx.out(), fmt::runtime(view),
+                              static_cast<uint64_t>(arg.int_value));
+      case ArgType::kFloat:
+      case ArgType::kDouble:
+        return fmt::format_to(ctx.out(), fmt::runtime(view), arg.double_value);
+      case ArgType::kPointer:
+        return fmt::format_to(ctx.out(), fmt::runtime(view),
+                              reinterpret_cast<const void*>(arg.int_value));
+      default:
+        return fmt::format_to(ctx.out(), fmt::runtime(view),
+                              fmt::string_view(arg.string_value.data(),
+                                               arg.string_value.size()));
+    }
+  }
+
+  fmt::string_view spec_;
+};
+
+namespace {
+
+struct ReplayConfig {
+  std::string backend = "spdlog";
+  std::string trace_path;
+  LogOptions options;
+  double speed = 1.0;
+  int interval_ms = 100;
+};
+
+// 回放过程中的一次积压采样
+struct BacklogSample {
+  int64_t time_ms = 0;
+  uint64_t issued = 0;
+  uint64_t pending = 0;
+  uint64_t dropped = 0;
+};
+
+struct Backlog {
+  uint64_t pending = 0;
+  uint64_t dropped = 0;
+};
+
+template<typename Backend>
+Backlog BacklogOf(const Backend&) {
+  return Backlog();
+}
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+Backlog BacklogOf(const qxcore::log::SpdlogBackend& backend) {
+  qxcore::log::AsyncStats stats = backend.async_stats();
+  return Backlog{stats.pending(), stats.dropped()};
+}
+#endif
+
+// 每个回放线程的进度，按缓存行对齐避免监控线程读取时的伪共享
+struct alignas(64) ThreadProgress {
+  std::atomic<uint64_t> issued{0};
+  uint64_t unsupported = 0;
+  std::chrono::steady_clock::time_point finished;
+  LatencyHistogram latency;
+};
+
+void PrintUsage(const char* program) {
+  std::cerr
+      << "Usage: " << program << " [options] <capture file>\n"
+      << "  --backend=spdlog|glog\n"
+      << "  --mode=sync|async|deferred\n"
+      << "  --output=null|file\n"
+      << "  --speed=<factor>      1 = original pace, 0 = as fast as possible\n"
+      << "  --queue_capacity=<records>\n"
+      << "  --overflow=block|drop_newest|drop_oldest\n"
+      << "  --pattern=<spdlog pattern>\n"
+      << "  --interval_ms=<ms>    backlog sampling interval\n";
+}
+
+bool ParseArgs(int argc, char* argv[], ReplayConfig* config) {
+  for (int i = 1; i < argc; ++i) {
+    absl::string_view arg = argv[i];
+    absl::string_view value = arg.substr(std::min(arg.find('=') + 1, arg.size()));
+    if (absl::StartsWith(arg, "--backend=")) {
+      config->backend = std::string(value);
+    } else if (absl::StartsWith(arg, "--mode=")) {
+      if (value == "sync") {
+        config->options.mode = LogMode::kSync;
+      } else if (value == "async") {
+        config->options.mode = LogMode::kAsync;
+      } else if (value == "deferred") {
+        config->options.mode = LogMode::kDeferred;
+      } else {
+        return false;
+      }
+    } else if (absl::StartsWith(arg, "--output=")) {
+      if (value == "null") {
+        config->options.output = LogOutput::kNull;
+      } else if (value == "file") {
+        config->options.output = LogOutput::kConsoleAndFile;
+      } else {
+        return false;
+      }
+    } else if (absl::StartsWith(arg, "--speed=")) {
+      if (!absl::SimpleAtod(value, &config->speed) || config->speed < 0) {
+        return false;
+      }
+    } else if (absl::StartsWith(arg, "--queue_capacity=")) {
+      if (!absl::SimpleAtoi(value, &config->options.async.queue_capacity)) {
+        return false;
+      }
+    } else if (absl::StartsWith(arg, "--overflow=")) {
+      if (value == "block") {
+        config->options.async.overflow_policy = OverflowPolicy::kBlock;
+      } else if (value == "drop_newest") {
+        config->options.async.overflow_policy = OverflowPolicy::kDropNewest;
+      } else if (value == "drop_oldest") {
+        config->options.async.overflow_policy = OverflowPolicy::kDropOldest;
+      } else {
+        return false;
+      }
+    } else if (absl::StartsWith(arg, "--pattern=")) {
+      config->options.pattern = std::string(value);
+    } else if (absl::StartsWith(arg, "--interval_ms=")) {
+      if (!absl::SimpleAtoi(value, &config->interval_ms) ||
+          config->interval_ms <= 0) {
+        return false;
+      }
+    } else if (absl::StartsWith(arg, "--") || !config->trace_path.empty()) {
+      return false;
+    } else {
+      config->trace_path = std::string(arg);
+    }
+  }
+  return !config->trace_path.empty();
+}
+
+// 按形状合成参数：数值取固定的代表值，字符串取对应长度的填充字节
+std::vector<ReplayArg> SynthesizeArgs(const WorkloadTrace& trace,
+                                      std::string* filler) {
+  size_t longest = 0;
+  for (const CapturedEvent& event : trace.events()) {
+    for (const CapturedArg& arg : trace.args(event)) {
+      if (arg.type == ArgType::kString) {
+        longest = std::max<size_t>(longest, arg.size);
+      }
+    }
+  }
+  filler->assign(longest, 'x');
+
+  std::vector<ReplayArg> args;
+  for (const CapturedEvent& event : trace.events()) {
+    for (const CapturedArg& arg : trace.args(event)) {
+      ReplayArg replay;
+      replay.type = arg.type;
+      switch (arg.type) {
+        case ArgType::kBool:
+          replay.int_value = 1;
+          break;
+        case ArgType::kInt32:
+        case ArgType::kUInt32:
+          replay.int_value = 1234567;
+          break;
+        case ArgType::kInt64:
+        case ArgType::kUInt64:
+          replay.int_value = 1234567890123;
+          break;
+        case ArgType::kFloat:
+        case ArgType::kDouble:
+          replay.double_value = 101.25;
+          break;
+        case ArgType::kPointer:
+          replay.int_value = 0x7f0000001000;
+          break;
+        default:
+          replay.type = ArgType::kString;
+          replay.string_value = absl::string_view(*filler).substr(0, arg.size);
+          break;
+      }
+      args.push_back(replay);
+    }
+  }
+  return args;
+}
+
+// 以 count 个合成参数发起一次格式化调用，参数过多时返回 false
+template<typename Logger>
+bool InvokeFormatted(Logger& logger, LogLevel level, absl::string_view format,
+                     const ReplayArg* a, size_t count) {
+  switch (count) {
+    case 0: logger.logf(level, format); return true;
+    case 1: logger.logf(level, format, a[0]); return true;
+    case 2: logger.logf(level, format, a[0], a[1]); return true;
+    case 3: logger.logf(level, format, a[0], a[1], a[2]); return true;
+    case 4: logger.logf(level, format, a[0], a[1], a[2], a[3]); return true;
+    case 5:
+      logger.logf(level, format, a[0], a[1], a[2], a[3], a[4]);
+      return true;
+    case 6:
+      logger.logf(level, format, a[0], a[1], a[2], a[3], a[4], a[5]);
+      return true;
+    case 7:
+      logger.logf(level, format, a[0], a[1], a[2], a[3], a[4], a[5], a[6]);
+      return true;
+    case 8:
+      logger.logf(level, format, a[0], a[1], a[2], a[3], a[4], a[5], a[6],
+                  a[7]);
+      return true;
+    default:
+      return false;
+  }
+}
+
+// 等待到 deadline；剩余时间较长时睡眠，临近时让出 CPU 以保持到达间隔精度
+void WaitUntil(std::chrono::steady_clock::time_point deadline) {
+  constexpr auto kSpinWindow = std::chrono::microseconds(200);
+  for (;;) {
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) {
+      return;
+    }
+    if (deadline - now > kSpinWindow) {
+      std::this_thread::sleep_for(deadline - now - kSpinWindow / 2);
+    } else {
+      std::this_thread::yield();
+    }
+  }
+}
+
+int64_t ElapsedMs(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+template<typename Backend>
+int Replay(const ReplayConfig& config, const WorkloadTrace& trace) {
+  qxcore::log::Log<Backend> logger;
+  absl::Status status = logger.init("replay", LogLevel::kTrace, config.options);
+  if (!status.ok()) {
+    std::cerr << "Failed to initialize " << config.backend << ": " << status
+              << std::endl;
+    return 1;
+  }
+
+  std::string filler;
+  std::vector<ReplayArg> args = SynthesizeArgs(trace, &filler);
+  std::vector<std::vector<uint32_t>> schedule(trace.thread_count());
+  for (uint32_t i = 0; i < trace.events().size(); ++i) {
+    schedule[trace.events()[i].thread].push_back(i);
+  }
+
+  std::vector<std::unique_ptr<ThreadProgress>> progress;
+  for (size_t i = 0; i < schedule.size(); ++i) {
+    progress.push_back(std::make_unique<ThreadProgress>());
+  }
+  std::atomic<size_t> running{schedule.size()};
+
+  // 留出线程启动时间，所有回放线程从同一时刻开始计时
+  auto start = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < schedule.size(); ++t) {
+    threads.emplace_back([&, t] {
+      ThreadProgress& mine = *progress[t];
+      WaitUntil(start);
+      for (uint32_t index : schedule[t]) {
+        const CapturedEvent& event = trace.events()[index];
+        if (config.speed > 0) {
+          WaitUntil(start + std::chrono::nanoseconds(static_cast<int64_t>(
+                                static_cast<double>(event.time_ns) /
+                                config.speed)));
+        }
+        const qxcore::log::CapturedSite& site = trace.sites()[event.site];
+        const ReplayArg* event_args = args.data() + event.first_arg;
+        uint64_t begin = TscClock::ReadTicks();
+        bool issued = true;
+        if (site.plain) {
+          logger.log(event.level, event_args[0].string_value);
+        } else {
+          issued = InvokeFormatted(logger, event.level, site.format, event_args,
+                                   event.arg_count);
+        }
+        uint64_t end = TscClock::ReadTicks();
+        if (issued) {
+          mine.latency.record(end - begin);
+          mine.issued.store(mine.issued.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+        } else {
+          ++mine.unsupported;
+        }
+      }
+      mine.finished = std::chrono::steady_clock::now();
+      running.fetch_sub(1, std::memory_order_release);
+    });
+  }
+
+  // 主线程按间隔采样积压，直到全部回放线程结束
+  std::vector<BacklogSample> samples;
+  auto sample = [&] {
+    BacklogSample s;
+    s.time_ms = ElapsedMs(start);
+    for (const auto& p : progress) {
+      s.issued += p->issued.load(std::memory_order_relaxed);
+    }
+    Backlog backlog = BacklogOf(logger.backend());
+    s.pending = backlog.pending;
+    s.dropped = backlog.dropped;
+    samples.push_back(s);
+  };
+  while (running.load(std::memory_order_acquire) != 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(config.interval_ms));
+    sample();
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto issue_end = start;
+  for (const auto& p : progress) {
+    issue_end = std::max(issue_end, p->finished);
+  }
+  int64_t issue_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                         issue_end - start)
+                         .count();
+  auto drain_start = std::chrono::steady_clock::now();
+  logger.flush();
+  int64_t drain_ms = ElapsedMs(drain_start);
+  sample();
+  logger.shutdown();
+
+  LatencyHistogram latency;
+  uint64_t unsupported = 0;
+  for (const auto& p : progress) {
+    latency.merge(p->latency);
+    unsupported += p->unsupported;
+  }
+  double nanos_per_tick = TscClock::Global().nanos_per_tick();
+  int64_t span_ms =
+      trace.events().empty() ? 0 : trace.events().back().time_ns / 1000000;
+
+  std::printf("trace    %s: %zu calls, %u threads, %zu sites, %lld ms\n",
+              config.trace_path.c_str(), trace.events().size(),
+              trace.thread_count(), trace.sites().size(),
+              static_cast<long long>(span_ms));
+  std::printf("replay   backend=%s speed=%g: %llu calls (%llu skipped) in "
+              "%lld ms, drain %lld ms\n",
+              config.backend.c_str(), config.speed,
+              static_cast<unsigned long long>(latency.count()),
+              static_cast<unsigned long long>(unsupported),
+              static_cast<long long>(issue_ms),
+              static_cast<long long>(drain_ms));
+  std::printf("latency  p50=%.0fns p90=%.0fns p99=%.0fns p99.9=%.0fns "
+              "p99.99=%.0fns\n",
+              latency.percentile(0.50) * nanos_per_tick,
+              latency.percentile(0.90) * nanos_per_tick,
+              latency.percentile(0.99) * nanos_per_tick,
+              latency.percentile(0.999) * nanos_per_tick,
+              latency.percentile(0.9999) * nanos_per_tick);
+  std::printf("%10s %12s %10s %10s\n", "time_ms", "issued", "pending",
+              "dropped");
+  for (const BacklogSample& s : samples) {
+    std::printf("%10lld %12llu %10llu %10llu\n",
+                static_cast<long long>(s.time_ms),
+                static_cast<unsigned long long>(s.issued),
+                static_cast<unsigned long long>(s.pending),
+                static_cast<unsigned long long>(s.dropped));
+  }
+  return 0;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  ReplayConfig config;
+  config.options.output = LogOutput::kNull;
+  if (!ParseArgs(argc, argv, &config)) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  WorkloadTrace trace;
+  absl::Status status = trace.load(config.trace_path);
+  if (!status.ok()) {
+    std::cerr << config.trace_path << ": " << status << std::endl;
+    return 2;
+  }
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+  if (config.backend == "spdlog") {
+    return Replay<qxcore::log::SpdlogBackend>(config, trace);
+  }
+#endif
+#ifdef QXCORE_ENABLE_LOG_GLOG
+  if (config.backend == "glog") {
+    return Replay<qxcore::log::GlogBackend>(config, trace);
+  }
+#endif
+  std::cerr << "Backend not available: " << config.backend << std::endl;
+  return 1;
+}
@@ -0,0 +1,244 @@
+// Copyright 2024 QXCore Team
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// qxlogd：共享内存日志守护进程
+//
+// 用法：qxlogd [选项]
+//   --dir=<目录>              段文件目录，与 ShmOptions::directory 一致
+//                             （默认 /dev/shm/qxlog）
+//   --backend=spdlog|glog     写出后端（默认 spdlog）
+//   --output=file|null        输出目标（默认 file）
+//   --pattern=<spdlog 模式>   文本输出格式
+//   --poll_us=<微秒>          空闲时的轮询间隔，0 为忙等（默认 200）
+//   --once                    写完目录中已有的记录后退出
+//
+// 每个客户端名字（ShmBackend::init 的 name）对应一个同名的后端日志器，
+// spdlog 后端在当前目录写出 <name>.log。级别过滤已在生产者进程完成，这里
+// 的日志器按 kTrace 初始化。收到 SIGINT 或 SIGTERM 时写完已提交的记录后
+// 退出，段文件保留给下一次启动的 qxlogd。
+
+#include <csignal>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <absl/container/flat_hash_map.h>
+#include <absl/status/status.h>
+#include <absl/strings/match.h>
+#include <absl/strings/numbers.h>
+#include <absl/strings/str_format.h>
+#include "qxcore/log/log.h"
+#include "qxcore/log/shm_collector.h"
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+#include "qxcore/log/spdlog_backend.h"
+#endif
+#ifdef QXCORE_ENABLE_LOG_GLOG
+#include "qxcore/log/glog_backend.h"
+#endif
+
+namespace {
+
+using qxcore::log::Callsite;
+using qxcore::log::LogLevel;
+using qxcore::log::LogOptions;
+using qxcore::log::LogOutput;
+using qxcore::log::LoggerId;
+using qxcore::log::RecordTime;
+
+volatile std::sig_atomic_t g_stop = 0;
+
+void HandleSignal(int /*signal*/) {
+  g_stop = 1;
+}
+
+struct DaemonConfig {
+  std::string directory = "/dev/shm/qxlog";
+  std::string backend = "spdlog";
+  LogOptions options;
+  int poll_us = 200;
+  bool once = false;
+};
+
+void PrintUsage(const char* program) {
+  std::cerr << "Usage: " << program << " [options]\n"
+            << "  --dir=<directory>\n"
+            << "  --backend=spdlog|glog\n"
+            << "  --output=file|null\n"
+            << "  --pattern=<spdlog pattern>\n"
+            << "  --poll_us=<us>      idle poll interval, 0 = busy poll\n"
+            << "  --once              drain existing records and exit\n";
+}
+
+bool ParseArgs(int argc, char* argv[], DaemonConfig* config) {
+  for (int i = 1; i < argc; ++i) {
+    absl::string_view arg = argv[i];
+    absl::string_view value = arg.substr(std::min(arg.find('=') + 1, arg.size()));
+    if (absl::StartsWith(arg, "--dir=")) {
+      config->directory = std::string(value);
+    } else if (absl::StartsWith(arg, "--backend=")) {
+      config->backend = std::string(value);
+    } else if (absl::StartsWith(arg, "--output=")) {
+      if (value == "null") {
+        config->options.output = LogOutput::kNull;
+      } else if (value == "file") {
+        config->options.output = LogOutput::kConsoleAndFile;
+      } else {
+        return false;
+      }
+    } else if (absl::StartsWith(arg, "--pattern=")) {
+      config->options.pattern = std::string(value);
+    } else if (absl::StartsWith(arg, "--poll_us=")) {
+      if (!absl::SimpleAtoi(value, &config->poll_us) || config->poll_us < 0) {
+        return false;
+      }
+    } else if (arg == "--once") {
+      config->once = true;
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+// 按客户端名字把记录交给对应的后端日志器
+template<typename Backend>
+class BackendHandler : public qxcore::log::ShmRecordHandler {
+ public:
+  explicit BackendHandler(const LogOptions& options) : options_(options) {}
+
+  void write(absl::string_view client, LogLevel level, const Callsite* callsite,
+             LoggerId logger_id, RecordTime time,
+             absl::string_view message) override {
+    qxcore::log::Log<Backend>* logger = find(client);
+    if (logger != nullptr) {
+      logger->backend().log_named(logger_id, level, callsite, time, message);
+    }
+  }
+
+  void flush(absl::string_view client) override {
+    qxcore::log::Log<Backend>* logger = find(client);
+    if (logger != nullptr) {
+      logger->flush();
+    }
+  }
+
+  void detach(absl::string_view client, int pid, bool clean,
+              uint64_t dropped) override {
+    qxcore::log::Log<Backend>* logger = find(client);
+    if (logger == nullptr) {
+      return;
+    }
+    if (!clean) {
+      logger->backend().log_named(
+          qxcore::log::kNoLoggerId, LogLevel::kWarn, nullptr,
+          RecordTime::Now(),
+          absl::StrFormat("[qxlogd] producer pid %d exited without shutdown",
+                          pid));
+    }
+    if (dropped != 0) {
+      logger->backend().log_named(
+          qxcore::log::kNoLoggerId, LogLevel::kWarn, nullptr,
+          RecordTime::Now(),
+          absl::StrFormat("[qxlogd] producer pid %d dropped %d records", pid,
+                          dropped));
+    }
+    logger->flush();
+  }
+
+  void shutdown() {
+    for (auto& [name, logger] : loggers_) {
+      logger->shutdown();
+    }
+  }
+
+ private:
+  // 首次出现的客户端名字创建同名日志器，初始化失败时记为空并不再重试
+  qxcore::log::Log<Backend>* find(absl::string_view client) {
+    auto it = loggers_.find(client);
+    if (it != loggers_.end()) {
+      return it->second.get();
+    }
+    auto logger = std::make_unique<qxcore::log::Log<Backend>>();
+    absl::Status status =
+        logger->init(std::string(client), LogLevel::kTrace, options_);
+    if (!status.ok()) {
+      std::cerr << "Failed to initialize logger " << client << ": " << status
+                << std::endl;
+      logger.reset();
+    }
+    return loggers_.emplace(std::string(client), std::move(logger))
+        .first->second.get();
+  }
+
+  LogOptions options_;
+  absl::flat_hash_map<std::string, std::unique_ptr<qxcore::log::Log<Backend>>>
+      loggers_;
+};
+
+template<typename Backend>
+int Run(const DaemonConfig& config) {
+  BackendHandler<Backend> handler(config.options);
+  qxcore::log::ShmLogCollector collector(config.directory, &handler);
+  absl::Status status = collector.open();
+  if (!status.ok()) {
+    std::cerr << status << std::endl;
+    return 1;
+  }
+
+  while (!g_stop) {
+    size_t written = collector.poll();
+    if (written != 0) {
+      continue;
+    }
+    if (config.once) {
+      break;
+    }
+    if (config.poll_us > 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(config.poll_us));
+    }
+  }
+
+  // 写完停止前已提交的记录
+  while (collector.poll() != 0) {
+  }
+  collector.close();
+  handler.shutdown();
+  return 0;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  DaemonConfig config;
+  if (!ParseArgs(argc, argv, &config)) {
+    PrintUsage(argv[0]);
+    return 2;
+  }
+  std::signal(SIGINT, HandleSignal);
+  std::signal(SIGTERM, HandleSignal);
+
+#ifdef QXCORE_ENABLE_LOG_SPDLOG
+  if (config.backend == "spdlog") {
+    return Run<qxcore::log::SpdlogBackend>(config);
+  }
+#endif
+#ifdef QXCORE_ENABLE_LOG_GLOG
+  if (config.backend == "glog") {
+    return Run<qxcore::log::GlogBackend>(config);
+  }
+#endif
+  std::cerr << "Backend not available: " << config.backend << std::endl;
+  return 1;
+}